@@ -22,38 +22,35 @@
  */
 
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <cassert>
 
 #include "ns3/flow-monitor-module.h"
-#include "ns3/bridge-helper.h"
-#include "ns3/bridge-net-device.h"
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
-#include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/csma-module.h"
+#include "ns3/dcn-layout-module.h"
 #include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-cache.h"
 #include "ns3/random-variable.h"
 
 /*
 	- This work goes along with the paper "Towards Reproducible Performance Studies of Datacenter Network Architectures Using An Open-Source Simulation Approach"
 
 	- The code is constructed in the following order:
-		1. Creation of Node Containers 
+		1. Creation of the fat-tree (FatTreeHelper)
 		2. Initialize settings for On/Off Application
-		3. Connect hosts to edge switches
-		4. Connect edge switches to aggregate switches
-		5. Connect aggregate switches to core switches
-		6. Start Simulation
-
-	- Addressing scheme:
-		1. Address of host: 10.pod.switch.0 /24
-		2. Address of edge and aggregation switch: 10.pod.switch.0 /16
-		3. Address of core switch: 10.(group number + k).switch.0 /8
+		3. Start Simulation
+
+	- Addressing scheme (see FatTreeHelper):
+		1. Hosts and edge switch of edge switch e in pod p: 10.p.e.0 /24
+		   (edge switch on .1, host h on .(h+2))
+		2. Link between aggregation switch a and edge switch e of pod p:
+		   10.p.(a+k/2).(2e+1) and 10.p.(a+k/2).(2e+2) /24
+		3. Link between core switch c of group g and pod p:
+		   10.(k+g).c.(2p+1) and 10.(k+g).c.(2p+2) /24
 		   (Note: there are k/2 group of core switch)
 
 	- On/Off Traffic of the simulation: addresses of client and server are randomly selected everytime
@@ -65,54 +62,23 @@
 		- Packet size: 1024 bytes
 		- Data rate for packet sending: 96 Mbps
 		- Data rate for device channel: 1536 Mbps
+		- Max bytes per flow: 70,000 bytes
 		- Delay time for device: 0.001 ms
 		- Communication pairs selection: Random Selection with uniform probability
 		- Traffic flow pattern: Exponential random traffic
 		- Routing protocol: Nix-Vector
 
-
         - Statistics Output:
                 - Flowmonitor XML output file: Fat-tree-AlFares.xml is located in the /statistics folder
-                 
-
 
+	- Every setting above can be changed from the command line, eg.
+		./waf --run "Fat-tree-AlFares --k=8 --hostsPerEdge=8"
 */
 
 using namespace ns3;
 using namespace std;
 NS_LOG_COMPONENT_DEFINE ("Fat-Tree-Architecture");
 
-// Function to create address string from numbers
-//
-char * toString(int a,int b, int c, int d){
-
-	int first = a;
-	int second = b;
-	int third = c;
-	int fourth = d;
-
-	char *address =  new char[30];
-	char firstOctet[30], secondOctet[30], thirdOctet[30], fourthOctet[30];	
-	//address = firstOctet.secondOctet.thirdOctet.fourthOctet;
-
-	bzero(address,30);
-
-	snprintf(firstOctet,10,"%d",first);
-	strcat(firstOctet,".");
-	snprintf(secondOctet,10,"%d",second);
-	strcat(secondOctet,".");
-	snprintf(thirdOctet,10,"%d",third);
-	strcat(thirdOctet,".");
-	snprintf(fourthOctet,10,"%d",fourth);
-
-	strcat(thirdOctet,fourthOctet);
-	strcat(secondOctet,thirdOctet);
-	strcat(firstOctet,secondOctet);
-	strcat(address,firstOctet);
-
-	return address;
-}
-
 // Main function
 //
 int 
@@ -120,113 +86,102 @@ int
 {
 //=========== Define parameters based on value of k ===========//
 //
-	int k = 4;			// number of ports per switch
-	int num_pod = k;		// number of pod
-	int num_host = (k/2);		// number of hosts under a switch
-	int num_edge = (k/2);		// number of edge switch in a pod
-	int num_bridge = num_edge;	// number of bridge in a pod
-	int num_agg = (k/2);		// number of aggregation switch in a pod
-	int num_group = k/2;		// number of group of core switches
-        int num_core = (k/2);		// number of core switch in a group
-	int total_host = k*k*k/4;	// number of hosts in the entire network	
-	char filename [] = "statistics/Fat-tree-AlFares.xml";// filename for Flow Monitor xml output file
-
-// Define variables for On/Off Application
-// These values will be used to serve the purpose that addresses of server and client are selected randomly
-// Note: the format of host's address is 10.pod.switch.(host+2)
-//
-	int podRand = 0;	//	
-	int swRand = 0;		// Random values for servers' address
-	int hostRand = 0;	//
-
-	int rand1 =0;		//
-	int rand2 =0;		// Random values for clients' address	
-	int rand3 =0;		//
-
-// Initialize other variables
-//
-	int i = 0;	
-	int j = 0;	
-	int h = 0;
+	uint32_t k = 4;			// number of ports per switch
+	uint32_t hostsPerEdge = 0;	// number of hosts under a switch, 0 means k/2
+	std::string filename = "statistics/Fat-tree-AlFares.xml";// filename for Flow Monitor xml output file
 
 // Initialize parameters for On/Off application
 //
 	int port = 9;
-	int packetSize = 1024;		// 1024 bytes
-	char dataRate_OnOff [] = "96Mbps";
-	char maxBytes [] = "70000";	// 70,000 bytes
+	uint32_t packetSize = 1024;		// 1024 bytes
+	std::string dataRate_OnOff = "96Mbps";
+	std::string maxBytes = "70000";
 
 // Initialize parameters for Csma and PointToPoint protocol
 //
-	char dataRate [] = "1536Mbps";	// 1Gbps
-	int delay = 0.001;		// 0.001 ms
-
-	
-// Output some useful information
-//	
-	std::cout << "Value of k =  "<< k<<"\n";
-	std::cout << "Total number of hosts =  "<< total_host<<"\n";
-	std::cout << "Number of hosts under each switch =  "<< num_host<<"\n";
-	std::cout << "Number of edge switch under each pod =  "<< num_edge<<"\n";
-	std::cout << "------------- "<<"\n";
+	std::string dataRate = "1536Mbps";
+	double delay = 0.001;		// 0.001 ms
+	double stopTime = 100.0;
+	bool oracle = true;		// closed-form nix paths instead of a BFS
+	std::string ecmp = "None";	// how nix routing spreads flows over equal-cost paths
+
+	CommandLine cmd;
+	cmd.AddValue ("k", "Number of ports per switch", k);
+	cmd.AddValue ("hostsPerEdge", "Number of hosts under each edge switch (oversubscription), 0 for k/2", hostsPerEdge);
+	cmd.AddValue ("packetSize", "On/Off packet size in bytes", packetSize);
+	cmd.AddValue ("onOffRate", "On/Off data rate", dataRate_OnOff);
+	cmd.AddValue ("maxBytes", "On/Off max bytes per flow, 0 for unlimited", maxBytes);
+	cmd.AddValue ("dataRate", "Data rate of every link", dataRate);
+	cmd.AddValue ("delay", "Delay of every link in ms", delay);
+	cmd.AddValue ("stopTime", "Simulated time in seconds", stopTime);
+	cmd.AddValue ("output", "Flow Monitor xml output file", filename);
+	cmd.AddValue ("oracle", "Compute nix-vector paths from the topology instead of a BFS", oracle);
+	cmd.AddValue ("ecmp", "Nix-vector multipath mode: None, PerFlow or PerPacket", ecmp);
+	cmd.Parse (argc, argv);
+	Config::SetDefault ("ns3::Ipv4NixVectorRouting::EcmpMode", StringValue (ecmp));
+
+	FatTreeHelper fatTree (k);
 
 // Initialize Internet Stack and Routing Protocols
 //	
 	InternetStackHelper internet;
 	Ipv4NixVectorHelper nixRouting; 
 	Ipv4StaticRoutingHelper staticRouting;
+	if (oracle)
+	  {
+		nixRouting.SetPathOracle (fatTree.GetNixPathOracle ());
+	  }
 	Ipv4ListRoutingHelper list;
 	list.Add (staticRouting, 0);	
 	list.Add (nixRouting, 10);	
 	internet.SetRoutingHelper(list);
 
-//=========== Creation of Node Containers ===========//
+//=========== Creation of the fat-tree ===========//
 //
-	NodeContainer core[num_group];				// NodeContainer for core switches
-	for (i=0; i<num_group;i++){  	
-		core[i].Create (num_core);
-		internet.Install (core[i]);		
-	}
-	NodeContainer agg[num_pod];				// NodeContainer for aggregation switches
-	for (i=0; i<num_pod;i++){  	
-		agg[i].Create (num_agg);
-		internet.Install (agg[i]);
-	}
-	NodeContainer edge[num_pod];				// NodeContainer for edge switches
-  	for (i=0; i<num_pod;i++){  	
-		edge[i].Create (num_bridge);
-		internet.Install (edge[i]);
-	}
-	NodeContainer bridge[num_pod];				// NodeContainer for edge bridges
-  	for (i=0; i<num_pod;i++){  	
-		bridge[i].Create (num_bridge);
-		internet.Install (bridge[i]);
-	}
-	NodeContainer host[num_pod][num_bridge];		// NodeContainer for hosts
-  	for (i=0; i<k;i++){
-		for (j=0;j<num_bridge;j++){  	
-			host[i][j].Create (num_host);		
-			internet.Install (host[i][j]);
-		}
-	}
+	if (hostsPerEdge != 0)
+	  {
+		fatTree.SetHostsPerEdge (hostsPerEdge);
+	  }
+	fatTree.SetCsmaChannelAttribute ("DataRate", StringValue (dataRate));
+	fatTree.SetCsmaChannelAttribute ("Delay", TimeValue (MicroSeconds (delay * 1000)));
+	fatTree.SetPointToPointDeviceAttribute ("DataRate", StringValue (dataRate));
+	fatTree.SetPointToPointChannelAttribute ("Delay", TimeValue (MicroSeconds (delay * 1000)));
+
+	uint32_t num_pod = fatTree.GetNPods ();		// number of pod
+	uint32_t num_edge = k/2;			// number of edge switch in a pod
+	uint32_t num_host = fatTree.GetHostsPerEdge ();	// number of hosts under a switch
+	uint32_t total_host = fatTree.HostCount ();	// number of hosts in the entire network	
+
+// Output some useful information
+//	
+	std::cout << "Value of k =  "<< k<<"\n";
+	std::cout << "Total number of hosts =  "<< total_host<<"\n";
+	std::cout << "Number of hosts under each switch =  "<< num_host<<"\n";
+	std::cout << "Number of edge switch under each pod =  "<< num_edge<<"\n";
+	std::cout << "Oversubscription ratio =  "<< fatTree.GetOversubscription ()<<"\n";
+	std::cout << "------------- "<<"\n";
+
+	fatTree.Create ();
+	fatTree.InstallStack (internet);
+	fatTree.AssignIpv4Addresses ();
+	std::cout << "Finished creating the fat-tree  "<< "\n";
 
 //=========== Initialize settings for On/Off Application ===========//
 //
 
 // Generate traffics for the simulation
+// Servers and clients are picked with the same sequence of rand() calls 
+// as the original program, so the traffic matrix is unchanged
 //	
-	ApplicationContainer app[total_host];
-	for (i=0;i<total_host;i++){	
+	ApplicationContainer app;
+	for (uint32_t i=0;i<total_host;i++){	
 	// Randomly select a server
-		podRand = rand() % num_pod + 0;
-		swRand = rand() % num_edge + 0;
-		hostRand = rand() % num_host + 0;
-		hostRand = hostRand+2;
-		char *add;
-		add = toString(10, podRand, swRand, hostRand);
+		uint32_t podRand = rand() % num_pod + 0;
+		uint32_t swRand = rand() % num_edge + 0;
+		uint32_t hostRand = rand() % num_host + 0;
 
 	// Initialize On/Off Application with addresss of server
-		OnOffHelper oo = OnOffHelper("ns3::UdpSocketFactory",Address(InetSocketAddress(Ipv4Address(add), port))); // ip address of server
+		OnOffHelper oo = OnOffHelper("ns3::UdpSocketFactory",Address(InetSocketAddress(fatTree.GetHostIpv4Address (podRand, swRand, hostRand), port))); // ip address of server
 	        oo.SetAttribute("OnTime",RandomVariableValue(ExponentialVariable(1)));  
 	        oo.SetAttribute("OffTime",RandomVariableValue(ExponentialVariable(1))); 
  	        oo.SetAttribute("PacketSize",UintegerValue (packetSize));
@@ -234,133 +189,29 @@ int
 	        oo.SetAttribute("MaxBytes",StringValue (maxBytes));
 
 	// Randomly select a client
-		rand1 = rand() % num_pod + 0;
-		rand2 = rand() % num_edge + 0;
-		rand3 = rand() % num_host + 0;
+		uint32_t rand1 = rand() % num_pod + 0;
+		uint32_t rand2 = rand() % num_edge + 0;
+		uint32_t rand3 = rand() % num_host + 0;
 
-		while (rand1== podRand && swRand == rand2 && (rand3+2) == hostRand){
+		while (rand1== podRand && swRand == rand2 && rand3 == hostRand){
 			rand1 = rand() % num_pod + 0;
 			rand2 = rand() % num_edge + 0;
 			rand3 = rand() % num_host + 0;
 		} // to make sure that client and server are different
 
 	// Install On/Off Application to the client
-		NodeContainer onoff;
-		onoff.Add(host[rand1][rand2].Get(rand3));
-	     	app[i] = oo.Install (onoff);
+		app.Add (oo.Install (fatTree.GetHost (rand1, rand2, rand3)));
 	}
 	std::cout << "Finished creating On/Off traffic"<<"\n";
-
-// Inintialize Address Helper
-//	
-  	Ipv4AddressHelper address;
-
-// Initialize PointtoPoint helper
-//	
-	PointToPointHelper p2p;
-  	p2p.SetDeviceAttribute ("DataRate", StringValue (dataRate));
-  	p2p.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (delay)));
-
-// Initialize Csma helper
-//
-  	CsmaHelper csma;
-  	csma.SetChannelAttribute ("DataRate", StringValue (dataRate));
-  	csma.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (delay)));
-
-//=========== Connect edge switches to hosts ===========//
-//	
-	NetDeviceContainer hostSw[num_pod][num_bridge];		
-	NetDeviceContainer bridgeDevices[num_pod][num_bridge];	
-	Ipv4InterfaceContainer ipContainer[num_pod][num_bridge];
-
-	for (i=0;i<num_pod;i++){
-		for (j=0;j<num_bridge; j++){
-			NetDeviceContainer link1 = csma.Install(NodeContainer (edge[i].Get(j), bridge[i].Get(j)));
-			hostSw[i][j].Add(link1.Get(0));				
-			bridgeDevices[i][j].Add(link1.Get(1));			
-
-			for (h=0; h< num_host;h++){			
-				NetDeviceContainer link2 = csma.Install (NodeContainer (host[i][j].Get(h), bridge[i].Get(j)));
-				hostSw[i][j].Add(link2.Get(0));			
-				bridgeDevices[i][j].Add(link2.Get(1));						
-			}
-
-			BridgeHelper bHelper;
-			bHelper.Install (bridge[i].Get(j), bridgeDevices[i][j]);
-			//Assign address
-			char *subnet;
-			subnet = toString(10, i, j, 0);
-			address.SetBase (subnet, "255.255.255.0");
-			ipContainer[i][j] = address.Assign(hostSw[i][j]);			
-		}
-	}
-	std::cout << "Finished connecting edge switches and hosts  "<< "\n";
-
-//=========== Connect aggregate switches to edge switches ===========//
-//
-	NetDeviceContainer ae[num_pod][num_agg][num_edge]; 	
-	Ipv4InterfaceContainer ipAeContainer[num_pod][num_agg][num_edge];
-	for (i=0;i<num_pod;i++){
-		for (j=0;j<num_agg;j++){
-			for (h=0;h<num_edge;h++){
-				ae[i][j][h] = p2p.Install(agg[i].Get(j), edge[i].Get(h));
-
-				int second_octet = i;		
-				int third_octet = j+(k/2);	
-				int fourth_octet;
-				if (h==0) fourth_octet = 1;
-				else fourth_octet = h*2+1;
-				//Assign subnet
-				char *subnet;
-				subnet = toString(10, second_octet, third_octet, 0);
-				//Assign base
-				char *base;
-				base = toString(0, 0, 0, fourth_octet);
-				address.SetBase (subnet, "255.255.255.0",base);
-				ipAeContainer[i][j][h] = address.Assign(ae[i][j][h]);
-			}			
-		}		
-	}
-	std::cout << "Finished connecting aggregation switches and edge switches  "<< "\n";
-
-//=========== Connect core switches to aggregate switches ===========//
-//
-	NetDeviceContainer ca[num_group][num_core][num_pod]; 		
-	Ipv4InterfaceContainer ipCaContainer[num_group][num_core][num_pod];
-	int fourth_octet =1;
-	
-	for (i=0; i<num_group; i++){		
-		for (j=0; j < num_core; j++){
-			fourth_octet = 1;
-			for (h=0; h < num_pod; h++){			
-				ca[i][j][h] = p2p.Install(core[i].Get(j), agg[h].Get(i)); 	
-
-				int second_octet = k+i;		
-				int third_octet = j;
-				//Assign subnet
-				char *subnet;
-				subnet = toString(10, second_octet, third_octet, 0);
-				//Assign base
-				char *base;
-				base = toString(0, 0, 0, fourth_octet);
-				address.SetBase (subnet, "255.255.255.0",base);
-				ipCaContainer[i][j][h] = address.Assign(ca[i][j][h]);
-				fourth_octet +=2;
-			}
-		}
-	}
-	std::cout << "Finished connecting core switches and aggregation switches  "<< "\n";
 	std::cout << "------------- "<<"\n";
 
 //=========== Start the simulation ===========//
 //
 
 	std::cout << "Start Simulation.. "<<"\n";
-	for (i=0;i<total_host;i++){
-		app[i].Start (Seconds (0.0));
-  		app[i].Stop (Seconds (100.0));
-	}
-  	Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+	app.Start (Seconds (0.0));
+	app.Stop (Seconds (stopTime));
+
 // Calculate Throughput using Flowmonitor
 //
   	FlowMonitorHelper flowmon;
@@ -368,20 +219,18 @@ int
 // Run simulation.
 //
   	NS_LOG_INFO ("Run Simulation.");
-  	Simulator::Stop (Seconds(101.0));
+  	Simulator::Stop (Seconds(stopTime + 1.0));
   	Simulator::Run ();
 
   	monitor->CheckForLostPackets ();
   	monitor->SerializeToXmlFile(filename, true, true);
 
 	std::cout << "Simulation finished "<<"\n";
+	Ipv4NixVectorCache::Get ()->PrintStatistics (std::cout);
+	EventImpl::PrintStatistics (std::cout);
 
   	Simulator::Destroy ();
   	NS_LOG_INFO ("Done.");
 
 	return 0;
 }
-
-
-
-
@@ -50,7 +50,14 @@ BridgeNetDevice::GetTypeId (void)
     .AddAttribute ("ExpirationTime",
                    "Time it takes for learned MAC state entry to expire.",
                    TimeValue (Seconds (300)),
-                   MakeTimeAccessor (&BridgeNetDevice::m_expirationTime),
+                   MakeTimeAccessor (&BridgeNetDevice::SetExpirationTime,
+                                     &BridgeNetDevice::GetExpirationTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("SweepInterval",
+                   "Minimum time between two removals of the expired learned MAC state entries.",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&BridgeNetDevice::SetSweepInterval,
+                                     &BridgeNetDevice::GetSweepInterval),
                    MakeTimeChecker ())
   ;
   return tid;
@@ -58,7 +65,8 @@ BridgeNetDevice::GetTypeId (void)
 
 
 BridgeNetDevice::BridgeNetDevice ()
-  : m_node (0),
+  : m_nFlooded (0),
+    m_node (0),
     m_ifIndex (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -146,6 +154,7 @@ BridgeNetDevice::ForwardUnicast (Ptr<NetDevice> incomingPort, Ptr<const Packet>
   else
     {
       NS_LOG_LOGIC ("No learned state: send through all ports");
+      m_nFlooded++;
       for (std::vector< Ptr<NetDevice> >::iterator iter = m_ports.begin ();
            iter != m_ports.end (); iter++)
         {
@@ -171,6 +180,7 @@ BridgeNetDevice::ForwardBroadcast (Ptr<NetDevice> incomingPort, Ptr<const Packet
                                                        << ", packet=" << packet << ", protocol="<<protocol
                                                        << ", src=" << src << ", dst=" << dst << ")");
   Learn (src, incomingPort);
+  m_nFlooded++;
 
   for (std::vector< Ptr<NetDevice> >::iterator iter = m_ports.begin ();
        iter != m_ports.end (); iter++)
@@ -192,36 +202,74 @@ void BridgeNetDevice::Learn (Mac48Address source, Ptr<NetDevice> port)
   NS_LOG_FUNCTION_NOARGS ();
   if (m_enableLearning)
     {
-      LearnedState &state = m_learnState[source];
-      state.associatedPort = port;
-      state.expirationTime = Simulator::Now () + m_expirationTime;
+      m_learnState.Learn (source, port->GetIfIndex (), Simulator::Now ());
     }
 }
 
 Ptr<NetDevice> BridgeNetDevice::GetLearnedState (Mac48Address source)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_enableLearning)
+  uint32_t port;
+  if (m_enableLearning && m_learnState.Lookup (source, port, Simulator::Now ()))
     {
-      Time now = Simulator::Now ();
-      std::map<Mac48Address, LearnedState>::iterator iter =
-        m_learnState.find (source);
-      if (iter != m_learnState.end ())
-        {
-          LearnedState &state = iter->second;
-          if (state.expirationTime > now)
-            {
-              return state.associatedPort;
-            }
-          else
-            {
-              m_learnState.erase (iter);
-            }
-        }
+      return m_node->GetDevice (port);
     }
   return NULL;
 }
 
+void
+BridgeNetDevice::SetExpirationTime (Time expirationTime)
+{
+  m_expirationTime = expirationTime;
+  m_learnState.SetExpirationTime (expirationTime);
+}
+
+Time
+BridgeNetDevice::GetExpirationTime (void) const
+{
+  return m_expirationTime;
+}
+
+void
+BridgeNetDevice::SetSweepInterval (Time sweepInterval)
+{
+  m_sweepInterval = sweepInterval;
+  m_learnState.SetSweepInterval (sweepInterval);
+}
+
+Time
+BridgeNetDevice::GetSweepInterval (void) const
+{
+  return m_sweepInterval;
+}
+
+uint64_t
+BridgeNetDevice::GetNLearned (void) const
+{
+  return m_learnState.GetNLearned ();
+}
+
+uint64_t
+BridgeNetDevice::GetNAgedOut (void) const
+{
+  return m_learnState.GetNAgedOut ();
+}
+
+uint64_t
+BridgeNetDevice::GetNFlooded (void) const
+{
+  return m_nFlooded;
+}
+
+void
+BridgeNetDevice::PrintStatistics (std::ostream &os) const
+{
+  os << "Bridge: " << GetNLearned () << " learned, "
+     << GetNAgedOut () << " aged out, "
+     << GetNFlooded () << " flooded, "
+     << m_learnState.GetNEntries () << " entries" << std::endl;
+}
+
 uint32_t
 BridgeNetDevice::GetNBridgePorts (void) const
 {
@@ -398,6 +446,7 @@ BridgeNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address
 
   // data was not unicast or no state has been learned for that mac
   // address => flood through all ports.
+  m_nFlooded++;
   for (std::vector< Ptr<NetDevice> >::iterator iter = m_ports.begin ();
        iter != m_ports.end (); iter++)
     {
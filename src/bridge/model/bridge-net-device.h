@@ -21,10 +21,11 @@
 #include "ns3/net-device.h"
 #include "ns3/mac48-address.h"
 #include "ns3/nstime.h"
+#include "ns3/mac-learning-table.h"
 #include "ns3/bridge-channel.h"
 #include <stdint.h>
 #include <string>
-#include <map>
+#include <ostream>
 
 namespace ns3 {
 
@@ -88,6 +89,31 @@ public:
 
   Ptr<NetDevice> GetBridgePort (uint32_t n) const;
 
+  /**
+   * \returns the number of source addresses learned while unknown or
+   *          expired
+   */
+  uint64_t GetNLearned (void) const;
+
+  /**
+   * \returns the number of learned entries which expired
+   */
+  uint64_t GetNAgedOut (void) const;
+
+  /**
+   * \returns the number of frames sent through all ports but the
+   *          incoming one: broadcast, multicast, and unicast to an
+   *          address with no learned state
+   */
+  uint64_t GetNFlooded (void) const;
+
+  /**
+   * \param os the output stream
+   *
+   * Print the counters on a single line.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
   // inherited from NetDevice base class.
   virtual void SetIfIndex (const uint32_t index);
   virtual uint32_t GetIfIndex (void) const;
@@ -130,17 +156,20 @@ private:
   BridgeNetDevice (const BridgeNetDevice &);
   BridgeNetDevice &operator = (const BridgeNetDevice &);
 
+  void SetExpirationTime (Time expirationTime);
+  Time GetExpirationTime (void) const;
+  void SetSweepInterval (Time sweepInterval);
+  Time GetSweepInterval (void) const;
+
   NetDevice::ReceiveCallback m_rxCallback;
   NetDevice::PromiscReceiveCallback m_promiscRxCallback;
 
   Mac48Address m_address;
   Time m_expirationTime; // time it takes for learned MAC state to expire
-  struct LearnedState
-  {
-    Ptr<NetDevice> associatedPort;
-    Time expirationTime;
-  };
-  std::map<Mac48Address, LearnedState> m_learnState;
+  Time m_sweepInterval;
+  // the learned ports, as the interface index of the port on the node
+  MacLearningTable m_learnState;
+  uint64_t m_nFlooded;
   Ptr<Node> m_node;
   Ptr<BridgeChannel> m_channel;
   std::vector< Ptr<NetDevice> > m_ports;
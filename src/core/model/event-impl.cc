@@ -19,9 +19,311 @@
  */
 
 #include "event-impl.h"
+#include "global-value.h"
+#include "enum.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "system-mutex.h"
+#include <pthread.h>
+#endif
+#include <map>
 
 namespace ns3 {
 
+namespace {
+
+enum PoolType
+{
+  POOL_NONE,
+  POOL_SHARED,
+  POOL_PER_THREAD
+};
+
+GlobalValue g_eventImplPool ("EventImplPool",
+                             "How the events are allocated: None, Shared (a single free list, "
+                             "only from the simulation thread) or PerThread (a free list per thread)",
+#ifdef HAVE_PTHREAD_H
+                             EnumValue (POOL_PER_THREAD),
+#else
+                             EnumValue (POOL_SHARED),
+#endif
+                             MakeEnumChecker (POOL_NONE, "None",
+                                              POOL_SHARED, "Shared",
+                                              POOL_PER_THREAD, "PerThread"));
+
+// events are grouped by size in classes of GRANULARITY bytes, and events
+// larger than the last class are not pooled
+const size_t GRANULARITY = 16;
+const size_t N_CLASSES = 16;
+// number of events allocated at once when a free list is empty, and moved
+// at once between a pool and the global free lists
+const size_t CHUNK_EVENTS = 64;
+// a pool keeps up to CACHE_EVENTS free events of each class, and gives the
+// others to the global free lists, where any pool takes them back
+const size_t CACHE_EVENTS = 4 * CHUNK_EVENTS;
+
+struct FreeEvent
+{
+  FreeEvent *next;
+};
+
+struct FreeList
+{
+  FreeEvent *head;
+  size_t n;
+};
+
+struct EventPool
+{
+  EventPool ();
+  void *Allocate (size_t size);
+  void Deallocate (void *p, size_t size);
+
+  bool m_enabled;
+  FreeList m_free[N_CLASSES];
+  uint64_t m_nCreated;
+  uint64_t m_nRecycled;
+  uint64_t m_nDeleted;
+  // false once given back, so that the next thread needing a pool takes it
+  bool m_inUse;
+  // the next pool in the list of all pools
+  EventPool *m_next;
+};
+
+// every pool created, whose counters are summed by the statistics
+EventPool *g_pools = 0;
+// the free events given back by the pools
+FreeList g_global[N_CLASSES];
+// the pool of every thread, unless the pools are per thread
+EventPool *g_sharedPool = 0;
+#ifdef HAVE_PTHREAD_H
+// the initial-exec model avoids a call to look the pool up
+__thread EventPool *t_pool __attribute__ ((tls_model ("initial-exec"))) = 0;
+pthread_key_t g_poolKey;
+
+SystemMutex &
+GetPoolsMutex (void)
+{
+  // never destroyed, as events may be deleted by static destructors
+  static SystemMutex *mutex = new SystemMutex ();
+  return *mutex;
+}
+#endif
+
+// the chunks of events, by address, so that a pool of type None tells the
+// events it must not give back to operator delete
+std::map<char *, size_t> &
+GetChunks (void)
+{
+  static std::map<char *, size_t> *chunks = new std::map<char *, size_t> ();
+  return *chunks;
+}
+
+bool
+IsChunkEvent (void *p)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetPoolsMutex ());
+#endif
+  char *event = static_cast<char *> (p);
+  std::map<char *, size_t>::const_iterator i = GetChunks ().upper_bound (event);
+  if (i == GetChunks ().begin ())
+    {
+      return false;
+    }
+  i--;
+  return event < i->first + i->second;
+}
+
+// move up to n events from the head of one list to another
+void
+MoveEvents (FreeList &from, FreeList &to, size_t n)
+{
+  while (n > 0 && from.head != 0)
+    {
+      FreeEvent *event = from.head;
+      from.head = event->next;
+      from.n--;
+      event->next = to.head;
+      to.head = event;
+      to.n++;
+      n--;
+    }
+}
+
+EventPool::EventPool ()
+  : m_enabled (true),
+    m_nCreated (0),
+    m_nRecycled (0),
+    m_nDeleted (0),
+    m_inUse (true),
+    m_next (0)
+{
+  for (size_t i = 0; i < N_CLASSES; i++)
+    {
+      m_free[i].head = 0;
+      m_free[i].n = 0;
+    }
+}
+
+void *
+EventPool::Allocate (size_t size)
+{
+  m_nCreated++;
+  size_t c = (size - 1) / GRANULARITY;
+  if (c >= N_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  size_t eventSize = (c + 1) * GRANULARITY;
+  FreeList &list = m_free[c];
+  char *chunk = 0;
+  if (list.head == 0 && m_enabled)
+    {
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetPoolsMutex ());
+#endif
+      MoveEvents (g_global[c], list, CHUNK_EVENTS);
+      if (list.head == 0)
+        {
+          // the chunks are never released, their events are kept in the
+          // free lists
+          chunk = static_cast<char *> (::operator new (CHUNK_EVENTS * eventSize));
+          GetChunks ()[chunk] = CHUNK_EVENTS * eventSize;
+        }
+    }
+  if (chunk != 0)
+    {
+      for (size_t i = CHUNK_EVENTS - 1; i > 0; i--)
+        {
+          FreeEvent *event = reinterpret_cast<FreeEvent *> (chunk + i * eventSize);
+          event->next = list.head;
+          list.head = event;
+          list.n++;
+        }
+      return chunk;
+    }
+  if (list.head != 0)
+    {
+      FreeEvent *event = list.head;
+      list.head = event->next;
+      list.n--;
+      m_nRecycled++;
+      return event;
+    }
+  // a pool of type None still allocates whole classes, so that its events
+  // may join the free lists of another pool
+  return ::operator new (eventSize);
+}
+
+void
+EventPool::Deallocate (void *p, size_t size)
+{
+  m_nDeleted++;
+  size_t c = (size - 1) / GRANULARITY;
+  if (c >= N_CLASSES || (!m_enabled && !IsChunkEvent (p)))
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeList &list = m_free[c];
+  FreeEvent *event = static_cast<FreeEvent *> (p);
+  event->next = list.head;
+  list.head = event;
+  list.n++;
+  if (list.n > CACHE_EVENTS)
+    {
+      // the events a thread deletes for another do not pile up in its pool
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetPoolsMutex ());
+#endif
+      MoveEvents (list, g_global[c], CHUNK_EVENTS);
+    }
+}
+
+void
+ReturnPool (void *p)
+{
+  EventPool *pool = static_cast<EventPool *> (p);
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetPoolsMutex ());
+#endif
+  for (size_t c = 0; c < N_CLASSES; c++)
+    {
+      MoveEvents (pool->m_free[c], g_global[c], pool->m_free[c].n);
+    }
+  pool->m_inUse = false;
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+CreatePoolKey (void)
+{
+  pthread_key_create (&g_poolKey, &ReturnPool);
+}
+#endif
+
+EventPool *
+CreatePool (void)
+{
+  // the type is read whenever a thread takes a pool, so that it applies
+  // from the next simulation on
+  EnumValue type (POOL_SHARED);
+  GlobalValue::GetValueByNameFailSafe ("EventImplPool", type);
+  EventPool *pool = 0;
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (GetPoolsMutex ());
+#endif
+    for (pool = g_pools; pool != 0; pool = pool->m_next)
+      {
+        if (!pool->m_inUse)
+          {
+            break;
+          }
+      }
+    if (pool == 0)
+      {
+        pool = new EventPool ();
+        pool->m_next = g_pools;
+        g_pools = pool;
+      }
+    pool->m_inUse = true;
+    pool->m_enabled = type.Get () != POOL_NONE;
+  }
+#ifdef HAVE_PTHREAD_H
+  if (type.Get () == POOL_PER_THREAD)
+    {
+      // the pool is given back when its thread exits
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      pthread_once (&once, &CreatePoolKey);
+      pthread_setspecific (g_poolKey, pool);
+      t_pool = pool;
+      return pool;
+    }
+#endif
+  g_sharedPool = pool;
+  return pool;
+}
+
+inline EventPool *
+GetPool (void)
+{
+  if (g_sharedPool != 0)
+    {
+      return g_sharedPool;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (t_pool != 0)
+    {
+      return t_pool;
+    }
+#endif
+  return CreatePool ();
+}
+
+} // anonymous namespace
+
 EventImpl::~EventImpl ()
 {
 }
@@ -52,4 +354,78 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (size_t size)
+{
+  return GetPool ()->Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, size_t size)
+{
+  // with a pool per thread, an event deleted by another thread joins the
+  // free list of that thread, which passes its excess to the other pools
+  GetPool ()->Deallocate (p, size);
+}
+
+void
+EventImpl::ReleasePool (void)
+{
+  EventPool *pool = g_sharedPool;
+  g_sharedPool = 0;
+#ifdef HAVE_PTHREAD_H
+  if (pool == 0 && t_pool != 0)
+    {
+      pool = t_pool;
+      t_pool = 0;
+      pthread_setspecific (g_poolKey, 0);
+    }
+#endif
+  if (pool != 0)
+    {
+      ReturnPool (pool);
+    }
+}
+
+uint64_t
+EventImpl::GetNCreated (void)
+{
+  uint64_t n = 0;
+  for (EventPool *pool = g_pools; pool != 0; pool = pool->m_next)
+    {
+      n += pool->m_nCreated;
+    }
+  return n;
+}
+
+uint64_t
+EventImpl::GetNRecycled (void)
+{
+  uint64_t n = 0;
+  for (EventPool *pool = g_pools; pool != 0; pool = pool->m_next)
+    {
+      n += pool->m_nRecycled;
+    }
+  return n;
+}
+
+uint64_t
+EventImpl::GetNLive (void)
+{
+  uint64_t n = 0;
+  for (EventPool *pool = g_pools; pool != 0; pool = pool->m_next)
+    {
+      n += pool->m_nCreated - pool->m_nDeleted;
+    }
+  return n;
+}
+
+void
+EventImpl::PrintStatistics (std::ostream &os)
+{
+  os << "Events: " << GetNCreated () << " created, "
+     << GetNRecycled () << " recycled, "
+     << GetNLive () << " live" << std::endl;
+}
+
 } // namespace ns3
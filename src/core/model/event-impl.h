@@ -21,6 +21,8 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <ostream>
 #include "simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +37,16 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from free lists of recycled events of the same
+ * size, so that scheduling an event does not usually call malloc.  The
+ * "EventImplPool" global value selects a single pool (Shared), a pool per
+ * thread (PerThread, the default when threads are available, required
+ * when events are scheduled from several threads, as with the realtime
+ * simulator) or plain allocation (None), whenever a thread takes a pool.
+ * A thread gives its pool back when it exits, or when the simulator is
+ * destroyed, and a pool keeps a bounded number of free events: the others
+ * go to global free lists shared by all the pools.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -58,6 +70,36 @@ public:
    */
   bool IsCancelled (void);
 
+  static void *operator new (size_t size);
+  static void operator delete (void *p, size_t size);
+
+  /**
+   * Give back the pool of the calling thread, so that the events it
+   * creates next come from a pool of the type then selected by
+   * "EventImplPool".  Called by Simulator::Destroy.
+   */
+  static void ReleasePool (void);
+
+  /**
+   * \returns the number of events created
+   */
+  static uint64_t GetNCreated (void);
+  /**
+   * \returns the number of events created in the memory of a deleted
+   *          event
+   */
+  static uint64_t GetNRecycled (void);
+  /**
+   * \returns the number of events not deleted yet
+   */
+  static uint64_t GetNLive (void);
+  /**
+   * \param os the output stream
+   *
+   * Print the counters of all threads on a single line.
+   */
+  static void PrintStatistics (std::ostream &os);
+
 protected:
   virtual void Notify (void) = 0;
 
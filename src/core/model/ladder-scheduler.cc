@@ -0,0 +1,310 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+namespace ns3 {
+
+namespace {
+
+// a bucket with at most this number of events is sorted into the bottom
+// instead of being split into a new rung
+const uint32_t THRESHOLD = 20;
+// the bottom is split into a new rung when it grows past this size
+const uint32_t BOTTOM_THRESHOLD = 4 * THRESHOLD;
+const uint32_t MAX_RUNGS = 8;
+
+} // anonymous namespace
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_nEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+  // the references to the rungs stay valid when a rung is added
+  m_rungs.reserve (MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint32_t
+LadderScheduler::GetBucket (const Rung &rung, uint64_t ts) const
+{
+  uint32_t i = (ts - rung.start) / rung.width;
+  NS_ASSERT (i >= rung.current && i < rung.nBuckets);
+  return i;
+}
+
+void
+LadderScheduler::SpawnRung (uint64_t min, uint64_t max, const Bucket &events, uint32_t first)
+{
+  NS_LOG_FUNCTION (this << min << max << events.size () - first);
+  NS_ASSERT (m_nRungs < MAX_RUNGS && max >= min);
+  if (m_rungs.size () == m_nRungs)
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  // about one event per bucket, with buckets which cover [min, max]
+  uint32_t n = events.size () - first;
+  rung.start = min;
+  rung.width = (max - min) / n + 1;
+  rung.nBuckets = (max - min) / rung.width + 1;
+  rung.current = 0;
+  rung.nEvents = n;
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin () + first; i != events.end (); i++)
+    {
+      rung.buckets[GetBucket (rung, i->key.m_ts)].push_back (*i);
+    }
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottomHead == m_bottom.size ());
+  m_bottom.clear ();
+  m_bottomHead = 0;
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          m_topStart = m_topMax + 1;
+          if (m_top.size () <= THRESHOLD || m_topMin == m_topMax)
+            {
+              m_bottom.swap (m_top);
+              std::sort (m_bottom.begin (), m_bottom.end ());
+              return;
+            }
+          SpawnRung (m_topMin, m_topMax, m_top, 0);
+          m_top.clear ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = GetCurrentStart (rung);
+      rung.current++;
+      rung.nEvents -= bucket.size ();
+      if (bucket.size () <= THRESHOLD || rung.width == 1 || m_nRungs == MAX_RUNGS)
+        {
+          // the bucket keeps the capacity of the bottom
+          m_bottom.swap (bucket);
+          std::sort (m_bottom.begin (), m_bottom.end ());
+          return;
+        }
+      SpawnRung (start, start + rung.width - 1, bucket, 0);
+      bucket.clear ();
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  if (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+    }
+  // new events are usually later than most of the bottom, so that the
+  // insertion moves few of them
+  m_bottom.insert (std::upper_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev), ev);
+  if (m_bottom.size () - m_bottomHead > BOTTOM_THRESHOLD && m_nRungs < MAX_RUNGS
+      && m_bottom[m_bottomHead].key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      SpawnBottom ();
+    }
+}
+
+void
+LadderScheduler::SpawnBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  // the new rung covers the timestamps up to the first event of the rung
+  // above it, or of the top
+  uint64_t end = m_topStart;
+  if (m_nRungs > 0)
+    {
+      end = GetCurrentStart (m_rungs[m_nRungs - 1]);
+    }
+  SpawnRung (m_bottom[m_bottomHead].key.m_ts, end - 1, m_bottom, m_bottomHead);
+  m_bottom.clear ();
+  m_bottomHead = 0;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_nEvents++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= GetCurrentStart (rung))
+        {
+          rung.buckets[GetBucket (rung, ts)].push_back (ev);
+          rung.nEvents++;
+          return;
+        }
+    }
+  InsertBottom (ev);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_nEvents == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      // moving the earliest events to the bottom does not change the
+      // content of the queue
+      const_cast<LadderScheduler *> (this)->FillBottom ();
+    }
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+  m_nEvents--;
+  return m_bottom[m_bottomHead++];
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  m_nEvents--;
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket = &m_bottom;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= GetCurrentStart (rung))
+            {
+              bucket = &rung.buckets[GetBucket (rung, ts)];
+              rung.nEvents--;
+              break;
+            }
+        }
+    }
+  if (bucket == &m_bottom)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      m_bottom.erase (i);
+      return;
+    }
+  // the other tiers are not sorted
+  for (Bucket::iterator i = bucket->begin (); i != bucket->end (); i++)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          *i = bucket->back ();
+          bucket->pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Event not found");
+}
+
+} // namespace ns3
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of "Ladder Queue: An
+ * O(1) Priority Queue Structure for Large-Scale Discrete Event
+ * Simulation" by Tang, Goh and Thng (2005).  Events are kept in three
+ * tiers:
+ *  - the top, an unsorted array of the events later than every event of
+ *    the other tiers;
+ *  - the rungs, arrays of buckets of unsorted events, where each rung
+ *    splits a single bucket of the rung above it into finer buckets;
+ *  - the bottom, a short sorted array of the earliest events.
+ *
+ * The earliest event is removed from the bottom.  When the bottom is
+ * empty, the first non-empty bucket of the lowest rung becomes the bottom
+ * if it is small enough, or is split into a new rung otherwise, and the
+ * top is split into the first rung when there is no rung left.  Each
+ * event is thus moved a bounded number of times, whatever the number of
+ * events, which suits the many near-future events of a datacenter
+ * network: link delays and transmission times of a few microseconds.
+ *
+ * Events are stored by value in arrays which keep their capacity when
+ * emptied, so that once the queue has reached its steady size,
+ * scheduling an event does not allocate memory.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  struct Rung
+  {
+    // timestamp of the start of the first bucket
+    uint64_t start;
+    // duration of a bucket
+    uint64_t width;
+    // number of buckets used, buckets.size () can be larger
+    uint32_t nBuckets;
+    // index of the first bucket which was not moved to a lower tier yet
+    uint32_t current;
+    // number of events in the buckets
+    uint32_t nEvents;
+    std::vector<Bucket> buckets;
+  };
+
+  /* Return the timestamp before which events belong to a lower tier. */
+  inline uint64_t GetCurrentStart (const Rung &rung) const;
+  /* Return the index of the bucket of the rung for the timestamp. */
+  inline uint32_t GetBucket (const Rung &rung, uint64_t ts) const;
+  /* Create a rung below the others, for the timestamps from min to max,
+   * with the events from index first of the array. */
+  void SpawnRung (uint64_t min, uint64_t max, const Bucket &events, uint32_t first);
+  /* Move the earliest events to the bottom, which must be empty. */
+  void FillBottom (void);
+  void InsertBottom (const Event &ev);
+  void SpawnBottom (void);
+
+  Bucket m_top;
+  // bounds of the timestamps of the events in the top
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  // timestamp from which events belong to the top
+  uint64_t m_topStart;
+  // the rungs, from the top one, only the first m_nRungs are used
+  std::vector<Rung> m_rungs;
+  uint32_t m_nRungs;
+  // the bottom, sorted, whose events before m_bottomHead were removed
+  Bucket m_bottom;
+  uint32_t m_bottomHead;
+  uint32_t m_nEvents;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
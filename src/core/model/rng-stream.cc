@@ -23,6 +23,7 @@
 #include "rng-stream.h"
 #include "global-value.h"
 #include "integer.h"
+#include "ns3/core-config.h"
 using namespace std;
 
 namespace
@@ -38,6 +39,15 @@ const double two17 =      131072.0;
 const double two53 =      9007199254740992.0;
 const double fact =       5.9604644775390625e-8;     /* 1 / 2^24  */
 
+// the state from which the streams created by a thread come, when it
+// runs a partition of a multithreaded simulation, or 0 to take them from
+// the sequence of the package
+#ifdef HAVE_PTHREAD_H
+__thread double *t_nextSeed __attribute__ ((tls_model ("initial-exec"))) = 0;
+#else
+double *t_nextSeed = 0;
+#endif
+
 // The following are the transition matrices of the two MRG components
 // (in matrix form), raised to the powers -1, 1, 2^76, and 2^127, resp.
 
@@ -372,12 +382,13 @@ void RngStream::InitializeStream ()
      bits if machine follows IEEE 754 standard) if incPrec = true. nextSeed
      will be the seed of the next declared RngStream. */
 
+  double *seed = t_nextSeed != 0 ? t_nextSeed : nextSeed;
   for (int i = 0; i < 6; ++i) {
-      Bg[i] = Cg[i] = Ig[i] = nextSeed[i];
+      Bg[i] = Cg[i] = Ig[i] = seed[i];
     }
 
-  MatVecModM (A1p127, nextSeed, nextSeed, m1);
-  MatVecModM (A2p127, &nextSeed[3], &nextSeed[3], m2);
+  MatVecModM (A1p127, seed, seed, m1);
+  MatVecModM (A2p127, &seed[3], &seed[3], m2);
 }
 
 //-------------------------------------------------------------------------
@@ -453,6 +464,30 @@ RngStream::GetPackageSeed (uint32_t seed[6])
       seed[i] = static_cast<uint32_t> (theSeed);
     }
 }
+void
+RngStream::GetPartitionSeed (uint32_t partition, double seed[6])
+{
+  EnsureGlobalInitialized ();
+  uint32_t packageSeed[6];
+  GetPackageSeed (packageSeed);
+  // the sequence of the partition starts 2^40 (partition + 1) streams
+  // after the first stream of the package, so that it never meets the
+  // streams of the package or of the other partitions
+  double B1[3][3], C1[3][3], B2[3][3], C2[3][3];
+  MatTwoPowModM (A1p127, B1, m1, 40);
+  MatPowModM (B1, C1, m1, partition + 1);
+  MatTwoPowModM (A2p127, B2, m2, 40);
+  MatPowModM (B2, C2, m2, partition + 1);
+  for (int i = 0; i < 6; ++i)
+    seed[i] = packageSeed[i];
+  MatVecModM (C1, seed, seed, m1);
+  MatVecModM (C2, &seed[3], &seed[3], m2);
+}
+void
+RngStream::SetThreadSeed (double seed[6])
+{
+  t_nextSeed = seed;
+}
 void 
 RngStream::SetPackageRun (uint32_t run)
 {
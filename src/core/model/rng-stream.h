@@ -56,6 +56,25 @@ public: //public static api
   static bool SetPackageSeed (uint32_t seed);
   static bool SetPackageSeed (const uint32_t seed[6]);
   static void GetPackageSeed (uint32_t seed[6]);
+  /**
+   * \param partition the index of a partition of a multithreaded
+   *        simulation
+   * \param seed the first state of the sequence of streams of the
+   *        partition, disjoint from the sequence of the package and from
+   *        the sequences of the other partitions
+   */
+  static void GetPartitionSeed (uint32_t partition, double seed[6]);
+  /**
+   * \param seed the state from which the streams created next by the
+   *        calling thread come, and which they update, or 0 to take them
+   *        from the sequence of the package again
+   *
+   * The streams are created when the random variables are first used:
+   * each thread of a multithreaded simulation takes them from the
+   * sequence of its partition, so that they do not depend on the order
+   * in which the threads run.
+   */
+  static void SetThreadSeed (double seed[6]);
   static void SetPackageRun (uint32_t run);
   static uint32_t GetPackageRun (void);
   static bool CheckSeed (const uint32_t seed[6]);
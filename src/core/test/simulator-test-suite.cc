@@ -24,6 +24,13 @@
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
 #include "ns3/ns2-calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/random-variable.h"
+#include "ns3/global-value.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -169,6 +176,127 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of many events and removals with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<Scheduler::EventKey> reference;
+  std::vector<Scheduler::Event> pending;
+  UniformVariable rand;
+  SeedManager::SetSeed (1);
+  SeedManager::SetRun (1);
+
+  // near-future events, many at the same time, mixed with far ones and
+  // with removals, so that every tier of the schedulers is used
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  for (uint32_t n = 0; n < 200000; n++)
+    {
+      uint32_t op = rand.GetInteger (0, 9);
+      if (op < 5 || reference.empty ())
+        {
+          uint64_t delay = rand.GetInteger (0, 9) < 8 ? rand.GetInteger (0, 2000) : rand.GetInteger (0, 1000000000);
+          Scheduler::Event ev = { 0, { now + delay, uid++, 0}};
+          scheduler->Insert (ev);
+          reference.insert (ev.key);
+          pending.push_back (ev);
+        }
+      else if (op < 9)
+        {
+          Scheduler::Event ev = scheduler->PeekNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, reference.begin ()->m_uid, "Wrong next event");
+          ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, reference.begin ()->m_uid, "Wrong removed event");
+          now = ev.key.m_ts;
+          reference.erase (reference.begin ());
+        }
+      else
+        {
+          // the pending events which were already removed are skipped
+          uint32_t i = rand.GetInteger (0, pending.size () - 1);
+          Scheduler::Event ev = pending[i];
+          pending[i] = pending.back ();
+          pending.pop_back ();
+          if (reference.erase (ev.key) == 1)
+            {
+              scheduler->Remove (ev);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), reference.empty (), "Wrong emptiness");
+    }
+  while (!reference.empty ())
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, reference.begin ()->m_uid, "Wrong removed event");
+      reference.erase (reference.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "Every event was removed");
+}
+
+class EventImplPoolTestCase : public TestCase
+{
+public:
+  EventImplPoolTestCase ();
+  virtual void DoRun (void);
+  void Event (uint32_t n);
+};
+
+EventImplPoolTestCase::EventImplPoolTestCase ()
+  : TestCase ("Check that the memory of the events is recycled")
+{
+}
+
+void
+EventImplPoolTestCase::Event (uint32_t n)
+{
+  if (n > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::Event, this, n - 1);
+    }
+}
+
+void
+EventImplPoolTestCase::DoRun (void)
+{
+  uint64_t live = EventImpl::GetNLive ();
+  uint64_t created = EventImpl::GetNCreated ();
+  uint64_t recycled = EventImpl::GetNRecycled ();
+  Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::Event, this, 1000);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetNCreated () - created, 1001, "Wrong number of created events");
+  // each event is created once the previous one is invoked and deleted
+  NS_TEST_ASSERT_MSG_GT (EventImpl::GetNRecycled () - recycled, 990, "The events were not recycled");
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetNLive (), live, "Every event was deleted");
+  Simulator::Destroy ();
+
+  // the pool type applies from the next simulation on
+  EnumValue type;
+  GlobalValue::GetValueByName ("EventImplPool", type);
+  GlobalValue::Bind ("EventImplPool", StringValue ("None"));
+  recycled = EventImpl::GetNRecycled ();
+  Simulator::Schedule (MicroSeconds (1), &EventImplPoolTestCase::Event, this, 1000);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetNRecycled (), recycled, "The events were recycled without a pool");
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetNLive (), live, "Every event was deleted");
+  Simulator::Destroy ();
+  GlobalValue::Bind ("EventImplPool", type);
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -478,6 +606,13 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (Ns2CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory));
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory));
+    AddTestCase (new EventImplPoolTestCase ());
   }
 } g_simulatorTestSuite;
 
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Linh Vu <linhvnl89@gmail.com>, Daji Wong <wong0204@e.ntu.edu.sg>
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/ipv4.h"
+#include "ns3/bcube-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("BCubeHelper");
+
+namespace ns3 {
+
+BCubeHelper::BCubeHelper (uint32_t n, uint32_t k)
+  : m_n (n),
+    m_levels (k + 1),
+    m_useSwitch (false)
+{
+  // the switch takes .1 and port p takes .(p+2) of its /24
+  NS_ABORT_MSG_UNLESS (n >= 2 && n <= 253, "BCubeHelper: n must be in [2, 253]");
+
+  m_power.push_back (1);
+  for (uint32_t l = 1; l <= m_levels; ++l)
+    {
+      NS_ABORT_MSG_UNLESS (m_power.back () <= 0xffffffffU / n, "BCubeHelper: BCube(" << n << "," << k << ") is too large");
+      m_power.push_back (m_power.back () * n);
+    }
+  m_switchesPerLevel = m_power[k];
+  m_blocksPerLevel = (m_switchesPerLevel + 255) / 256;
+  NS_ABORT_MSG_UNLESS (m_levels * m_blocksPerLevel <= 256,
+                       "BCubeHelper: BCube(" << n << "," << k << ") is too large for the 10.0.0.0/8 addressing scheme");
+  m_oracle = CreateObject<BCubeNixPathOracle> ();
+}
+
+BCubeHelper::~BCubeHelper ()
+{
+}
+
+void
+BCubeHelper::SetCsmaChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_csma.SetChannelAttribute (n1, v1);
+}
+
+void
+BCubeHelper::SetCsmaDeviceAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_csma.SetDeviceAttribute (n1, v1);
+}
+
+void
+BCubeHelper::UseSwitchChannel (bool use)
+{
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () == 0, "BCubeHelper: UseSwitchChannel called after Create");
+  m_useSwitch = use;
+}
+
+void
+BCubeHelper::SetSwitchChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_switch.SetChannelAttribute (n1, v1);
+}
+
+uint32_t
+BCubeHelper::GetSwitchIndex (uint32_t host, uint32_t level) const
+{
+  // drop digit 'level' of the host index
+  return (host / m_power[level + 1]) * m_power[level] + host % m_power[level];
+}
+
+uint32_t
+BCubeHelper::GetSwitchPort (uint32_t host, uint32_t level) const
+{
+  return (host / m_power[level]) % m_n;
+}
+
+void
+BCubeHelper::Create (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () == 0, "BCubeHelper::Create called twice");
+
+  // same creation order as the original scratch program: hosts, then
+  // the switches and bridges of each level
+  m_hosts.Create (HostCount ());
+  for (uint32_t l = 0; l < m_levels; ++l)
+    {
+      NodeContainer switches;
+      switches.Create (m_switchesPerLevel);
+      m_switches.Add (switches);
+      if (!m_useSwitch)
+        {
+          NodeContainer bridges;
+          bridges.Create (m_switchesPerLevel);
+          m_bridges.Add (bridges);
+        }
+    }
+  // the path oracle locates hosts by id
+  NS_ABORT_MSG_UNLESS (m_hosts.Get (m_hosts.GetN () - 1)->GetId () - m_hosts.Get (0)->GetId () == m_hosts.GetN () - 1,
+                       "BCubeHelper::Create: nodes were created concurrently");
+  m_oracle->SetTopology (m_n, m_levels, m_blocksPerLevel, m_hosts.Get (0)->GetId ());
+
+  for (uint32_t l = 0; l < m_levels; ++l)
+    {
+      for (uint32_t i = 0; i < m_switchesPerLevel; ++i)
+        {
+          uint32_t s = l * m_switchesPerLevel + i;
+          // the hosts of switch i are i with digit l set to 0..n-1
+          uint32_t first = (i / m_power[l]) * m_power[l + 1] + i % m_power[l];
+          if (m_useSwitch)
+            {
+              NodeContainer ports (m_switches.Get (s));
+              for (uint32_t p = 0; p < m_n; ++p)
+                {
+                  ports.Add (m_hosts.Get (first + p * m_power[l]));
+                }
+              m_lanDevices.Add (m_switch.Install (ports));
+              continue;
+            }
+
+          Ptr<Node> bridge = m_bridges.Get (s);
+          NetDeviceContainer bridgePorts;
+
+          NetDeviceContainer link = m_csma.Install (NodeContainer (m_switches.Get (s), bridge));
+          m_lanDevices.Add (link.Get (0));
+          bridgePorts.Add (link.Get (1));
+
+          for (uint32_t p = 0; p < m_n; ++p)
+            {
+              link = m_csma.Install (NodeContainer (m_hosts.Get (first + p * m_power[l]), bridge));
+              m_lanDevices.Add (link.Get (0));
+              bridgePorts.Add (link.Get (1));
+            }
+          m_bridge.Install (bridge, bridgePorts);
+        }
+    }
+}
+
+void
+BCubeHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_hosts);
+  stack.Install (m_switches);
+  stack.Install (m_bridges);
+}
+
+Ipv4Address
+BCubeHelper::MakeAddress (uint32_t level, uint32_t sw, uint32_t port) const
+{
+  uint32_t second = level * m_blocksPerLevel + sw / 256;
+  uint32_t third = sw % 256;
+  return Ipv4Address ((10U << 24) | (second << 16) | (third << 8) | port);
+}
+
+void
+BCubeHelper::AssignAddress (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask)
+{
+  Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, "BCubeHelper::AssignIpv4Addresses(): node without IPv4 stack "
+                 "(maybe need to call InstallStack?)");
+
+  int32_t interface = ipv4->GetInterfaceForDevice (device);
+  if (interface == -1)
+    {
+      interface = ipv4->AddInterface (device);
+    }
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, mask));
+  ipv4->SetMetric (interface, 1);
+  ipv4->SetUp (interface);
+}
+
+void
+BCubeHelper::AssignIpv4Addresses (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () != 0, "BCubeHelper::AssignIpv4Addresses called before Create");
+
+  Ipv4Mask mask ("255.255.255.0");
+  uint32_t lanSize = m_n + 1;
+  for (uint32_t l = 0; l < m_levels; ++l)
+    {
+      for (uint32_t i = 0; i < m_switchesPerLevel; ++i)
+        {
+          uint32_t base = (l * m_switchesPerLevel + i) * lanSize;
+          for (uint32_t port = 0; port < lanSize; ++port)
+            {
+              AssignAddress (m_lanDevices.Get (base + port), MakeAddress (l, i, port + 1), mask);
+            }
+        }
+    }
+}
+
+uint32_t
+BCubeHelper::GetN (void) const
+{
+  return m_n;
+}
+
+uint32_t
+BCubeHelper::GetNLevels (void) const
+{
+  return m_levels;
+}
+
+uint32_t
+BCubeHelper::SwitchCountPerLevel (void) const
+{
+  return m_switchesPerLevel;
+}
+
+uint32_t
+BCubeHelper::HostCount (void) const
+{
+  return m_power[m_levels];
+}
+
+Ptr<Node>
+BCubeHelper::GetHost (uint32_t i) const
+{
+  return m_hosts.Get (i);
+}
+
+Ptr<Node>
+BCubeHelper::GetSwitch (uint32_t level, uint32_t i) const
+{
+  NS_ASSERT (level < m_levels && i < m_switchesPerLevel);
+  return m_switches.Get (level * m_switchesPerLevel + i);
+}
+
+Ipv4Address
+BCubeHelper::GetHostIpv4Address (uint32_t i) const
+{
+  return GetHostIpv4Address (i, 0);
+}
+
+Ipv4Address
+BCubeHelper::GetHostIpv4Address (uint32_t i, uint32_t level) const
+{
+  NS_ASSERT (i < HostCount () && level < m_levels);
+  return MakeAddress (level, GetSwitchIndex (i, level), GetSwitchPort (i, level) + 2);
+}
+
+NodeContainer
+BCubeHelper::GetHosts (void) const
+{
+  return m_hosts;
+}
+
+NodeContainer
+BCubeHelper::GetSwitches (void) const
+{
+  return m_switches;
+}
+
+NodeContainer
+BCubeHelper::GetBridges (void) const
+{
+  return m_bridges;
+}
+
+Ptr<Ipv4NixPathOracle>
+BCubeHelper::GetNixPathOracle (void) const
+{
+  return m_oracle;
+}
+
+} // namespace ns3
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Linh Vu <linhvnl89@gmail.com>, Daji Wong <wong0204@e.ntu.edu.sg>
+ */
+
+// Define an object to create a BCube(n,k) topology.
+
+#ifndef BCUBE_HELPER_H
+#define BCUBE_HELPER_H
+
+#include <string>
+#include <vector>
+
+#include "ns3/csma-helper.h"
+#include "ns3/bridge-helper.h"
+#include "ns3/switch-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/dcn-nix-path-oracle.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup dcnlayout
+ *
+ * \brief A helper to make it easier to create a BCube(n,k) topology
+ *
+ * BCube(n,k) has k+1 levels of n^k switches with n ports each, and n^(k+1)
+ * hosts with one port per level.  Writing the host index h in base n as
+ * a_k...a_1a_0, the level l switch of h is the one whose index is h with
+ * digit a_l removed, and h sits on port a_l of that switch.
+ *
+ * As in the original BCube scratch program, every switch is an IP node
+ * attached by a Csma link to its own bridge node, and each of its n hosts
+ * has its own Csma link to that bridge.  With UseSwitchChannel, each
+ * switch and its hosts are instead the ports of one SwitchChannel, and no
+ * bridge node is created.
+ *
+ * Switch i of level l owns one /24: 10.(l*b + i/256).(i%256).0, where b
+ * is the number of /24 blocks a level needs (n^k/256 rounded up).  The
+ * switch takes .1 and the host on port p takes .(p+2).  For n^k <= 256
+ * this is the 10.level.switch.0 scheme of the original program.
+ */
+class BCubeHelper
+{
+public:
+  /**
+   * Create a BCubeHelper in order to easily create BCube topologies
+   *
+   * \param n the number of ports per switch, which is the number of
+   *          hosts in a BCube0
+   * \param k the highest level; the topology has k+1 levels
+   */
+  BCubeHelper (uint32_t n, uint32_t k);
+
+  ~BCubeHelper ();
+
+  /**
+   * Set an attribute on each ns3::CsmaChannel of the topology.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetCsmaChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Set an attribute on each ns3::CsmaNetDevice of the topology.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetCsmaDeviceAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \param use whether each switch and its hosts are connected by a
+   *            SwitchChannel instead of Csma links to a bridge node.  The
+   *            default is false, as in the original scratch program.
+   */
+  void UseSwitchChannel (bool use);
+
+  /**
+   * Set an attribute on each ns3::SwitchChannel of the topology, when
+   * UseSwitchChannel is set.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetSwitchChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Create all the nodes of the topology and connect them.  Must be
+   * called once, after the attributes have been set.
+   */
+  void Create (void);
+
+  /**
+   * \param stack an InternetStackHelper which is used to install
+   *              on every node in the BCube
+   */
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * Assign the Ipv4 addresses of every switch and host interface, as
+   * described in the class documentation.
+   */
+  void AssignIpv4Addresses (void);
+
+  /**
+   * \returns the number of ports per switch
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * \returns the number of levels, which is k+1
+   */
+  uint32_t GetNLevels (void) const;
+
+  /**
+   * \returns the number of switches in each level, n^k
+   */
+  uint32_t SwitchCountPerLevel (void) const;
+
+  /**
+   * \returns total number of hosts, n^(k+1)
+   */
+  uint32_t HostCount (void) const;
+
+  /**
+   * \param i an index into the hosts, in the range [0, HostCount ())
+   *
+   * \returns a node pointer to the i'th host
+   */
+  Ptr<Node> GetHost (uint32_t i) const;
+
+  /**
+   * \param level the level of the switch
+   * \param i the index of the switch within its level
+   *
+   * \returns a node pointer to the switch
+   */
+  Ptr<Node> GetSwitch (uint32_t level, uint32_t i) const;
+
+  /**
+   * \param host an index into the hosts
+   * \param level a level of the BCube
+   *
+   * \returns the index within its level of the switch the host is
+   *          attached to at that level
+   */
+  uint32_t GetSwitchIndex (uint32_t host, uint32_t level) const;
+
+  /**
+   * \param host an index into the hosts
+   * \param level a level of the BCube
+   *
+   * \returns the port of the level switch the host is attached to
+   */
+  uint32_t GetSwitchPort (uint32_t host, uint32_t level) const;
+
+  /**
+   * \param i an index into the hosts, in the range [0, HostCount ())
+   *
+   * \returns the level 0 Ipv4Address of the i'th host
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t i) const;
+
+  /**
+   * \param i an index into the hosts, in the range [0, HostCount ())
+   * \param level a level of the BCube
+   *
+   * \returns the Ipv4Address of the i'th host on the given level
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t i, uint32_t level) const;
+
+  /**
+   * \returns a container of all the hosts
+   */
+  NodeContainer GetHosts (void) const;
+
+  /**
+   * \returns a container of all the switches, level by level
+   */
+  NodeContainer GetSwitches (void) const;
+
+  /**
+   * \returns a container of the bridge nodes, one per switch, or none
+   *          with UseSwitchChannel
+   */
+  NodeContainer GetBridges (void) const;
+
+  /**
+   * The oracle knows the topology once Create has been called, but
+   * can be passed to Ipv4NixVectorHelper::SetPathOracle before that.
+   *
+   * \returns a path oracle giving nix-vector routing the host-to-host
+   *          paths of this topology without a BFS
+   */
+  Ptr<Ipv4NixPathOracle> GetNixPathOracle (void) const;
+
+private:
+  Ipv4Address MakeAddress (uint32_t level, uint32_t sw, uint32_t port) const;
+  void AssignAddress (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask);
+
+  uint32_t m_n;
+  uint32_t m_levels;
+  uint32_t m_switchesPerLevel;
+  uint32_t m_blocksPerLevel;
+  // m_power[l] = n^l, for l in [0, k+1]
+  std::vector<uint32_t> m_power;
+  bool m_useSwitch;
+
+  CsmaHelper m_csma;
+  SwitchHelper m_switch;
+  BridgeHelper m_bridge;
+  Ptr<BCubeNixPathOracle> m_oracle;
+
+  NodeContainer m_hosts;
+  NodeContainer m_switches;
+  NodeContainer m_bridges;
+
+  // one device per Csma link end or switch port, indexed by switch (level by level)
+  // then by port: port 0 is the switch, port p+1 is the host on port p
+  NetDeviceContainer m_lanDevices;
+};
+
+} // namespace ns3
+
+#endif /* BCUBE_HELPER_H */
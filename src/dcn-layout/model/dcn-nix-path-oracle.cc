@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/node-list.h"
+#include "ns3/dcn-nix-path-oracle.h"
+
+NS_LOG_COMPONENT_DEFINE ("DcnNixPathOracle");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FatTreeNixPathOracle);
+
+TypeId
+FatTreeNixPathOracle::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FatTreeNixPathOracle")
+    .SetParent<Ipv4NixPathOracle> ()
+    .AddConstructor<FatTreeNixPathOracle> ()
+  ;
+  return tid;
+}
+
+FatTreeNixPathOracle::FatTreeNixPathOracle ()
+  : m_k (0),
+    m_half (0),
+    m_hostsPerEdge (0),
+    m_coreBase (0),
+    m_aggBase (0),
+    m_edgeBase (0),
+    m_hostBase (0)
+{
+}
+
+FatTreeNixPathOracle::~FatTreeNixPathOracle ()
+{
+}
+
+void
+FatTreeNixPathOracle::SetTopology (uint32_t k, uint32_t hostsPerEdge,
+                                   uint32_t coreBase, uint32_t aggBase, uint32_t edgeBase, uint32_t hostBase)
+{
+  m_k = k;
+  m_half = k / 2;
+  m_hostsPerEdge = hostsPerEdge;
+  m_coreBase = coreBase;
+  m_aggBase = aggBase;
+  m_edgeBase = edgeBase;
+  m_hostBase = hostBase;
+}
+
+bool
+FatTreeNixPathOracle::Locate (Ptr<Node> source, Ipv4Address dest, uint32_t &srcEdge, uint32_t &dstEdge, uint32_t &host) const
+{
+  if (m_k == 0)
+    {
+      return false;
+    }
+  uint32_t nHosts = m_k * m_half * m_hostsPerEdge;
+
+  // source must be a host
+  uint32_t srcId = source->GetId ();
+  if (srcId < m_hostBase || srcId >= m_hostBase + nHosts)
+    {
+      return false;
+    }
+  srcEdge = (srcId - m_hostBase) / m_hostsPerEdge;
+
+  // dest must be a host address, 10.pod.edge.(host+2)
+  uint32_t addr = dest.Get ();
+  uint32_t pod = (addr >> 16) & 0xff;
+  uint32_t edge = (addr >> 8) & 0xff;
+  host = addr & 0xff;
+  if ((addr >> 24) != 10 || pod >= m_k || edge >= m_half || host < 2 || host - 2 >= m_hostsPerEdge)
+    {
+      return false;
+    }
+  host -= 2;
+  dstEdge = pod * m_half + edge;
+  return true;
+}
+
+bool
+FatTreeNixPathOracle::GetPath (Ptr<Node> source, Ipv4Address dest, std::vector< Ptr<Node> > &path)
+{
+  return GetEqualCostPath (source, dest, 0, path);
+}
+
+uint32_t
+FatTreeNixPathOracle::GetNEqualCostPaths (Ptr<Node> source, Ipv4Address dest)
+{
+  uint32_t srcEdge, dstEdge, host;
+  if (!Locate (source, dest, srcEdge, dstEdge, host))
+    {
+      return 0;
+    }
+  if (srcEdge == dstEdge)
+    {
+      return 1;
+    }
+  if (srcEdge / m_half == dstEdge / m_half)
+    {
+      return m_half;
+    }
+  return m_half * m_half;
+}
+
+bool
+FatTreeNixPathOracle::GetEqualCostPath (Ptr<Node> source, Ipv4Address dest, uint32_t index, std::vector< Ptr<Node> > &path)
+{
+  uint32_t srcEdge, dstEdge, host;
+  if (!Locate (source, dest, srcEdge, dstEdge, host))
+    {
+      return false;
+    }
+  uint32_t pod = dstEdge / m_half;
+
+  path.clear ();
+  path.push_back (source);
+  if (srcEdge != dstEdge)
+    {
+      // path 0 takes the uplinks given by the destination
+      // index, path i shifts them by the digits of i
+      uint32_t srcPod = srcEdge / m_half;
+      uint32_t agg = (host + srcEdge % m_half + index % m_half) % m_half;
+      path.push_back (NodeList::GetNode (m_edgeBase + srcEdge));
+      path.push_back (NodeList::GetNode (m_aggBase + srcPod * m_half + agg));
+      if (srcPod != pod)
+        {
+          // core switches of group 'agg' reach aggregation switch 'agg'
+          // of every pod
+          uint32_t core = (host + agg + index / m_half) % m_half;
+          path.push_back (NodeList::GetNode (m_coreBase + agg * m_half + core));
+          path.push_back (NodeList::GetNode (m_aggBase + pod * m_half + agg));
+        }
+      path.push_back (NodeList::GetNode (m_edgeBase + dstEdge));
+    }
+  path.push_back (NodeList::GetNode (m_hostBase + dstEdge * m_hostsPerEdge + host));
+  return true;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (BCubeNixPathOracle);
+
+TypeId
+BCubeNixPathOracle::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BCubeNixPathOracle")
+    .SetParent<Ipv4NixPathOracle> ()
+    .AddConstructor<BCubeNixPathOracle> ()
+  ;
+  return tid;
+}
+
+BCubeNixPathOracle::BCubeNixPathOracle ()
+  : m_n (0),
+    m_levels (0),
+    m_blocksPerLevel (0),
+    m_hostBase (0)
+{
+}
+
+BCubeNixPathOracle::~BCubeNixPathOracle ()
+{
+}
+
+void
+BCubeNixPathOracle::SetTopology (uint32_t n, uint32_t levels, uint32_t blocksPerLevel, uint32_t hostBase)
+{
+  m_n = n;
+  m_levels = levels;
+  m_blocksPerLevel = blocksPerLevel;
+  m_hostBase = hostBase;
+  m_power.clear ();
+  m_power.push_back (1);
+  for (uint32_t l = 0; l < levels; ++l)
+    {
+      m_power.push_back (m_power.back () * n);
+    }
+}
+
+bool
+BCubeNixPathOracle::Locate (Ptr<Node> source, Ipv4Address dest, uint32_t &src, uint32_t &dst, std::vector<uint32_t> &levels) const
+{
+  if (m_levels == 0)
+    {
+      return false;
+    }
+  uint32_t nHosts = m_power[m_levels];
+  uint32_t nSwitches = m_power[m_levels - 1];
+
+  uint32_t srcId = source->GetId ();
+  if (srcId < m_hostBase || srcId >= m_hostBase + nHosts)
+    {
+      return false;
+    }
+  src = srcId - m_hostBase;
+
+  // dest must be a host address: switch sw of level l owns
+  // 10.(l*b + sw/256).(sw%256).0/24 and port p is .(p+2)
+  uint32_t addr = dest.Get ();
+  uint32_t second = (addr >> 16) & 0xff;
+  uint32_t level = second / m_blocksPerLevel;
+  uint32_t sw = (second % m_blocksPerLevel) * 256 + ((addr >> 8) & 0xff);
+  uint32_t port = addr & 0xff;
+  if ((addr >> 24) != 10 || level >= m_levels || sw >= nSwitches || port < 2 || port - 2 >= m_n)
+    {
+      return false;
+    }
+  port -= 2;
+  // put digit 'level' back into the switch index
+  dst = (sw / m_power[level]) * m_power[level + 1] + port * m_power[level] + sw % m_power[level];
+
+  levels.clear ();
+  for (uint32_t l = m_levels; l-- > 0; )
+    {
+      if ((src / m_power[l]) % m_n != (dst / m_power[l]) % m_n)
+        {
+          levels.push_back (l);
+        }
+    }
+  return true;
+}
+
+bool
+BCubeNixPathOracle::GetPath (Ptr<Node> source, Ipv4Address dest, std::vector< Ptr<Node> > &path)
+{
+  return GetEqualCostPath (source, dest, 0, path);
+}
+
+uint32_t
+BCubeNixPathOracle::GetNEqualCostPaths (Ptr<Node> source, Ipv4Address dest)
+{
+  uint32_t src, dst;
+  std::vector<uint32_t> levels;
+  if (!Locate (source, dest, src, dst, levels))
+    {
+      return 0;
+    }
+  // d!, saturated
+  uint64_t nPaths = 1;
+  for (uint32_t d = 2; d <= levels.size (); d++)
+    {
+      nPaths = std::min<uint64_t> (nPaths * d, 0xffffffff);
+    }
+  return nPaths;
+}
+
+bool
+BCubeNixPathOracle::GetEqualCostPath (Ptr<Node> source, Ipv4Address dest, uint32_t index, std::vector< Ptr<Node> > &path)
+{
+  uint32_t src, dst;
+  std::vector<uint32_t> levels;
+  if (!Locate (source, dest, src, dst, levels))
+    {
+      return false;
+    }
+
+  // the index, written in the factorial number system, gives the
+  // order of the corrections; path 0 goes from the highest level down
+  path.clear ();
+  path.push_back (source);
+  uint32_t current = src;
+  while (!levels.empty ())
+    {
+      uint32_t i = index % levels.size ();
+      index /= levels.size ();
+      uint32_t l = levels[i];
+      levels.erase (levels.begin () + i);
+
+      uint32_t currentDigit = (current / m_power[l]) % m_n;
+      uint32_t dstDigit = (dst / m_power[l]) % m_n;
+      current = current - currentDigit * m_power[l] + dstDigit * m_power[l];
+      path.push_back (NodeList::GetNode (m_hostBase + current));
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DCN_NIX_PATH_ORACLE_H
+#define DCN_NIX_PATH_ORACLE_H
+
+#include <vector>
+
+#include "ns3/ipv4-nix-path-oracle.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup dcnlayout
+ *
+ * \brief Closed-form host-to-host paths of a fat-tree built by
+ * FatTreeHelper
+ *
+ * Hosts under the same edge switch talk directly through their bridge.
+ * Otherwise the path goes up to the aggregation layer, and to the core
+ * layer if the hosts are in different pods.  As in the two-level routing
+ * of Al-Fares et al., the uplinks are picked from the index of the
+ * destination host, so that different destinations spread over the
+ * aggregation and core switches.
+ *
+ * Hosts in the same pod have k/2 equal-cost paths, one per aggregation
+ * switch, and hosts in different pods have (k/2)^2, one per core switch.
+ * Equal-cost path 0 is the one GetPath returns.
+ *
+ * Only paths between two hosts are answered; anything else is left to
+ * the BFS of nix-vector routing.
+ */
+class FatTreeNixPathOracle : public Ipv4NixPathOracle
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FatTreeNixPathOracle ();
+  virtual ~FatTreeNixPathOracle ();
+
+  /**
+   * Called by FatTreeHelper::Create once the nodes exist.
+   *
+   * \param k the number of ports per switch
+   * \param hostsPerEdge the number of hosts under each edge switch
+   * \param coreBase the node id of the first core switch
+   * \param aggBase the node id of the first aggregation switch
+   * \param edgeBase the node id of the first edge switch
+   * \param hostBase the node id of the first host
+   */
+  void SetTopology (uint32_t k, uint32_t hostsPerEdge,
+                    uint32_t coreBase, uint32_t aggBase, uint32_t edgeBase, uint32_t hostBase);
+
+  virtual bool GetPath (Ptr<Node> source, Ipv4Address dest, std::vector< Ptr<Node> > &path);
+  virtual uint32_t GetNEqualCostPaths (Ptr<Node> source, Ipv4Address dest);
+  virtual bool GetEqualCostPath (Ptr<Node> source, Ipv4Address dest, uint32_t index, std::vector< Ptr<Node> > &path);
+
+private:
+  // finds the edge switch indices of the source and of the
+  // destination, and the destination index under its edge switch
+  bool Locate (Ptr<Node> source, Ipv4Address dest, uint32_t &srcEdge, uint32_t &dstEdge, uint32_t &host) const;
+
+  uint32_t m_k;
+  uint32_t m_half;
+  uint32_t m_hostsPerEdge;
+  uint32_t m_coreBase;
+  uint32_t m_aggBase;
+  uint32_t m_edgeBase;
+  uint32_t m_hostBase;
+};
+
+/**
+ * \ingroup dcnlayout
+ *
+ * \brief Closed-form host-to-host paths of a BCube built by BCubeHelper
+ *
+ * This is the BCubeRouting of Guo et al.: the digits in which the source
+ * and destination indices differ are corrected one by one, from the
+ * highest level down, each correction being one hop through the bridge
+ * of the switch of that level.
+ *
+ * Correcting the d differing digits in any order gives the d! equal-cost
+ * paths.  Equal-cost path 0 is the one GetPath returns.
+ *
+ * Only paths between two hosts are answered; anything else is left to
+ * the BFS of nix-vector routing.
+ */
+class BCubeNixPathOracle : public Ipv4NixPathOracle
+{
+public:
+  static TypeId GetTypeId (void);
+
+  BCubeNixPathOracle ();
+  virtual ~BCubeNixPathOracle ();
+
+  /**
+   * Called by BCubeHelper::Create once the nodes exist.
+   *
+   * \param n the number of ports per switch
+   * \param levels the number of levels, k+1
+   * \param blocksPerLevel the number of /24 blocks of each level
+   * \param hostBase the node id of the first host
+   */
+  void SetTopology (uint32_t n, uint32_t levels, uint32_t blocksPerLevel, uint32_t hostBase);
+
+  virtual bool GetPath (Ptr<Node> source, Ipv4Address dest, std::vector< Ptr<Node> > &path);
+  virtual uint32_t GetNEqualCostPaths (Ptr<Node> source, Ipv4Address dest);
+  virtual bool GetEqualCostPath (Ptr<Node> source, Ipv4Address dest, uint32_t index, std::vector< Ptr<Node> > &path);
+
+private:
+  // finds the host indices of the source and of the destination,
+  // and the levels at which they differ, highest first
+  bool Locate (Ptr<Node> source, Ipv4Address dest, uint32_t &src, uint32_t &dst, std::vector<uint32_t> &levels) const;
+
+  uint32_t m_n;
+  uint32_t m_levels;
+  uint32_t m_blocksPerLevel;
+  uint32_t m_hostBase;
+  // m_power[l] = n^l, for l in [0, levels]
+  std::vector<uint32_t> m_power;
+};
+
+} // namespace ns3
+
+#endif /* DCN_NIX_PATH_ORACLE_H */
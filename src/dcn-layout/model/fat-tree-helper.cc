@@ -0,0 +1,367 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Linh Vu <linhvnl89@gmail.com>, Daji Wong <wong0204@e.ntu.edu.sg>
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/ipv4.h"
+#include "ns3/fat-tree-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("FatTreeHelper");
+
+namespace ns3 {
+
+FatTreeHelper::FatTreeHelper (uint32_t k)
+  : m_k (k),
+    m_half (k / 2),
+    m_hostsPerEdge (k / 2),
+    m_useSwitch (false)
+{
+  NS_ABORT_MSG_UNLESS (k >= 2 && k % 2 == 0, "FatTreeHelper: k must be even and at least 2");
+  // the pod number and the core group number (k + group) both have
+  // to fit in the second octet, and the core-aggregation host numbers
+  // (2 * pod + 2) in the fourth
+  NS_ABORT_MSG_UNLESS (k + k / 2 <= 255 && 2 * k <= 254,
+                       "FatTreeHelper: k is too large for the 10.0.0.0/8 addressing scheme (k must be at most 126)");
+  m_oracle = CreateObject<FatTreeNixPathOracle> ();
+}
+
+FatTreeHelper::~FatTreeHelper ()
+{
+}
+
+void
+FatTreeHelper::SetHostsPerEdge (uint32_t n)
+{
+  // the edge switch takes .1 and host h takes .(h+2) of its /24
+  NS_ABORT_MSG_UNLESS (n >= 1 && n <= 253, "FatTreeHelper: hosts per edge switch must be in [1, 253]");
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () == 0, "FatTreeHelper: SetHostsPerEdge called after Create");
+  m_hostsPerEdge = n;
+}
+
+void
+FatTreeHelper::SetCsmaChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_csma.SetChannelAttribute (n1, v1);
+}
+
+void
+FatTreeHelper::UseSwitchChannel (bool use)
+{
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () == 0, "FatTreeHelper: UseSwitchChannel called after Create");
+  m_useSwitch = use;
+}
+
+void
+FatTreeHelper::SetSwitchChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_switch.SetChannelAttribute (n1, v1);
+}
+
+void
+FatTreeHelper::SetPointToPointDeviceAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_p2p.SetDeviceAttribute (n1, v1);
+}
+
+void
+FatTreeHelper::SetPointToPointChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_p2p.SetChannelAttribute (n1, v1);
+}
+
+void
+FatTreeHelper::Create (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () == 0, "FatTreeHelper::Create called twice");
+
+  uint32_t nEdge = m_k * m_half;
+
+  // each layer in one block, in the same order as the original
+  // scratch programs so node ids are unchanged
+  m_core.Create (m_half * m_half);
+  m_agg.Create (nEdge);
+  m_edge.Create (nEdge);
+  if (!m_useSwitch)
+    {
+      m_bridges.Create (nEdge);
+    }
+  m_hosts.Create (nEdge * m_hostsPerEdge);
+
+  // the path oracle locates nodes by id, so each layer must be a
+  // single run of ids
+  NS_ABORT_MSG_UNLESS (m_hosts.Get (m_hosts.GetN () - 1)->GetId () - m_core.Get (0)->GetId ()
+                       == m_core.GetN () + 2 * nEdge + m_bridges.GetN () + m_hosts.GetN () - 1,
+                       "FatTreeHelper::Create: nodes were created concurrently");
+  m_oracle->SetTopology (m_k, m_hostsPerEdge, m_core.Get (0)->GetId (), m_agg.Get (0)->GetId (),
+                         m_edge.Get (0)->GetId (), m_hosts.Get (0)->GetId ());
+
+  // Connect edge switches and hosts through the edge bridges, or through
+  // one switch channel per edge switch
+  for (uint32_t e = 0; e < nEdge; ++e)
+    {
+      if (m_useSwitch)
+        {
+          NodeContainer ports (m_edge.Get (e));
+          for (uint32_t h = 0; h < m_hostsPerEdge; ++h)
+            {
+              ports.Add (m_hosts.Get (e * m_hostsPerEdge + h));
+            }
+          m_edgeLanDevices.Add (m_switch.Install (ports));
+          continue;
+        }
+
+      Ptr<Node> bridge = m_bridges.Get (e);
+      NetDeviceContainer bridgePorts;
+
+      NetDeviceContainer link = m_csma.Install (NodeContainer (m_edge.Get (e), bridge));
+      m_edgeLanDevices.Add (link.Get (0));
+      bridgePorts.Add (link.Get (1));
+
+      for (uint32_t h = 0; h < m_hostsPerEdge; ++h)
+        {
+          link = m_csma.Install (NodeContainer (m_hosts.Get (e * m_hostsPerEdge + h), bridge));
+          m_edgeLanDevices.Add (link.Get (0));
+          bridgePorts.Add (link.Get (1));
+        }
+      m_bridge.Install (bridge, bridgePorts);
+    }
+
+  // Connect aggregation switches to edge switches
+  for (uint32_t pod = 0; pod < m_k; ++pod)
+    {
+      for (uint32_t a = 0; a < m_half; ++a)
+        {
+          for (uint32_t e = 0; e < m_half; ++e)
+            {
+              NetDeviceContainer link = m_p2p.Install (m_agg.Get (pod * m_half + a),
+                                                       m_edge.Get (pod * m_half + e));
+              m_aggDownDevices.Add (link.Get (0));
+              m_edgeUpDevices.Add (link.Get (1));
+            }
+        }
+    }
+
+  // Connect core switches to aggregation switches: every core switch
+  // of group g reaches aggregation switch g of each pod
+  for (uint32_t g = 0; g < m_half; ++g)
+    {
+      for (uint32_t c = 0; c < m_half; ++c)
+        {
+          for (uint32_t pod = 0; pod < m_k; ++pod)
+            {
+              NetDeviceContainer link = m_p2p.Install (m_core.Get (g * m_half + c),
+                                                       m_agg.Get (pod * m_half + g));
+              m_coreDownDevices.Add (link.Get (0));
+              m_aggUpDevices.Add (link.Get (1));
+            }
+        }
+    }
+}
+
+void
+FatTreeHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_core);
+  stack.Install (m_agg);
+  stack.Install (m_edge);
+  stack.Install (m_bridges);
+  stack.Install (m_hosts);
+}
+
+Ipv4Address
+FatTreeHelper::MakeAddress (uint32_t second, uint32_t third, uint32_t fourth)
+{
+  return Ipv4Address ((10U << 24) | (second << 16) | (third << 8) | fourth);
+}
+
+void
+FatTreeHelper::AssignAddress (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask)
+{
+  Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, "FatTreeHelper::AssignIpv4Addresses(): node without IPv4 stack "
+                 "(maybe need to call InstallStack?)");
+
+  int32_t interface = ipv4->GetInterfaceForDevice (device);
+  if (interface == -1)
+    {
+      interface = ipv4->AddInterface (device);
+    }
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, mask));
+  ipv4->SetMetric (interface, 1);
+  ipv4->SetUp (interface);
+}
+
+void
+FatTreeHelper::AssignIpv4Addresses (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ABORT_MSG_UNLESS (m_hosts.GetN () != 0, "FatTreeHelper::AssignIpv4Addresses called before Create");
+
+  Ipv4Mask mask ("255.255.255.0");
+  uint32_t lanSize = m_hostsPerEdge + 1;
+
+  // Edge LANs: 10.pod.edge.0/24, the edge switch first
+  for (uint32_t pod = 0; pod < m_k; ++pod)
+    {
+      for (uint32_t e = 0; e < m_half; ++e)
+        {
+          uint32_t base = (pod * m_half + e) * lanSize;
+          for (uint32_t port = 0; port < lanSize; ++port)
+            {
+              AssignAddress (m_edgeLanDevices.Get (base + port), MakeAddress (pod, e, port + 1), mask);
+            }
+        }
+    }
+
+  // Aggregation-edge links: 10.pod.(agg+k/2).(2*edge+1)
+  for (uint32_t pod = 0; pod < m_k; ++pod)
+    {
+      for (uint32_t a = 0; a < m_half; ++a)
+        {
+          for (uint32_t e = 0; e < m_half; ++e)
+            {
+              uint32_t i = (pod * m_half + a) * m_half + e;
+              AssignAddress (m_aggDownDevices.Get (i), MakeAddress (pod, a + m_half, 2 * e + 1), mask);
+              AssignAddress (m_edgeUpDevices.Get (i), MakeAddress (pod, a + m_half, 2 * e + 2), mask);
+            }
+        }
+    }
+
+  // Core-aggregation links: 10.(k+group).core.(2*pod+1)
+  for (uint32_t g = 0; g < m_half; ++g)
+    {
+      for (uint32_t c = 0; c < m_half; ++c)
+        {
+          for (uint32_t pod = 0; pod < m_k; ++pod)
+            {
+              uint32_t i = (g * m_half + c) * m_k + pod;
+              AssignAddress (m_coreDownDevices.Get (i), MakeAddress (m_k + g, c, 2 * pod + 1), mask);
+              AssignAddress (m_aggUpDevices.Get (i), MakeAddress (m_k + g, c, 2 * pod + 2), mask);
+            }
+        }
+    }
+}
+
+uint32_t
+FatTreeHelper::GetK (void) const
+{
+  return m_k;
+}
+
+uint32_t
+FatTreeHelper::GetNPods (void) const
+{
+  return m_k;
+}
+
+uint32_t
+FatTreeHelper::GetHostsPerEdge (void) const
+{
+  return m_hostsPerEdge;
+}
+
+double
+FatTreeHelper::GetOversubscription (void) const
+{
+  return static_cast<double> (m_hostsPerEdge) / m_half;
+}
+
+uint32_t
+FatTreeHelper::HostCount (void) const
+{
+  return m_k * m_half * m_hostsPerEdge;
+}
+
+Ptr<Node>
+FatTreeHelper::GetHost (uint32_t i) const
+{
+  return m_hosts.Get (i);
+}
+
+Ptr<Node>
+FatTreeHelper::GetHost (uint32_t pod, uint32_t edge, uint32_t host) const
+{
+  NS_ASSERT (pod < m_k && edge < m_half && host < m_hostsPerEdge);
+  return m_hosts.Get ((pod * m_half + edge) * m_hostsPerEdge + host);
+}
+
+Ptr<Node>
+FatTreeHelper::GetEdgeSwitch (uint32_t pod, uint32_t i) const
+{
+  NS_ASSERT (pod < m_k && i < m_half);
+  return m_edge.Get (pod * m_half + i);
+}
+
+Ptr<Node>
+FatTreeHelper::GetAggregationSwitch (uint32_t pod, uint32_t i) const
+{
+  NS_ASSERT (pod < m_k && i < m_half);
+  return m_agg.Get (pod * m_half + i);
+}
+
+Ptr<Node>
+FatTreeHelper::GetCoreSwitch (uint32_t group, uint32_t i) const
+{
+  NS_ASSERT (group < m_half && i < m_half);
+  return m_core.Get (group * m_half + i);
+}
+
+Ipv4Address
+FatTreeHelper::GetHostIpv4Address (uint32_t i) const
+{
+  NS_ASSERT (i < HostCount ());
+  uint32_t edge = i / m_hostsPerEdge;
+  return MakeAddress (edge / m_half, edge % m_half, i % m_hostsPerEdge + 2);
+}
+
+Ipv4Address
+FatTreeHelper::GetHostIpv4Address (uint32_t pod, uint32_t edge, uint32_t host) const
+{
+  NS_ASSERT (pod < m_k && edge < m_half && host < m_hostsPerEdge);
+  return MakeAddress (pod, edge, host + 2);
+}
+
+NodeContainer
+FatTreeHelper::GetHosts (void) const
+{
+  return m_hosts;
+}
+
+NodeContainer
+FatTreeHelper::GetSwitches (void) const
+{
+  return NodeContainer (m_edge, m_agg, m_core);
+}
+
+NodeContainer
+FatTreeHelper::GetBridges (void) const
+{
+  return m_bridges;
+}
+
+Ptr<Ipv4NixPathOracle>
+FatTreeHelper::GetNixPathOracle (void) const
+{
+  return m_oracle;
+}
+
+} // namespace ns3
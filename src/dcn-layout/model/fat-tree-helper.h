@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Linh Vu <linhvnl89@gmail.com>, Daji Wong <wong0204@e.ntu.edu.sg>
+ */
+
+// Define an object to create a k-ary fat-tree topology.
+
+#ifndef FAT_TREE_HELPER_H
+#define FAT_TREE_HELPER_H
+
+#include <string>
+
+#include "ns3/csma-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/bridge-helper.h"
+#include "ns3/switch-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/dcn-nix-path-oracle.h"
+
+namespace ns3 {
+
+/**
+ * \defgroup dcnlayout Data Center Network Layout Helpers
+ *
+ */
+
+/**
+ * \ingroup dcnlayout
+ *
+ * \brief A helper to make it easier to create a k-ary fat-tree topology
+ *
+ * The topology has k pods of k/2 edge and k/2 aggregation switches each,
+ * plus (k/2)^2 core switches split into k/2 groups.  Every edge switch is
+ * an IP node attached by a Csma link to its own bridge node, and every
+ * host under that edge switch has its own Csma link to the same bridge.
+ * Switch-to-switch links are point-to-point.  With UseSwitchChannel, the
+ * edge switch and its hosts are instead the ports of one SwitchChannel,
+ * and no bridge node is created.
+ *
+ * Nodes of one layer are created in a single block, so the node for a
+ * given (pod, switch, host) coordinate is found by index arithmetic.
+ * Addresses are computed directly from the coordinates:
+ *
+ * - hosts and edge switch of edge switch e in pod p: 10.p.e.0/24, with the
+ *   edge switch on .1 and host h on .(h+2)
+ * - link between aggregation switch a and edge switch e of pod p:
+ *   10.p.(a+k/2).(2e+1) on the aggregation side and 10.p.(a+k/2).(2e+2)
+ *   on the edge side, /24
+ * - link between core switch c of group g and the aggregation switch g of
+ *   pod p: 10.(k+g).c.(2p+1) on the core side and 10.(k+g).c.(2p+2) on
+ *   the aggregation side, /24
+ *
+ * This is the addressing scheme of the original Fat-tree scratch programs,
+ * so results stay comparable with earlier runs.
+ */
+class FatTreeHelper
+{
+public:
+  /**
+   * Create a FatTreeHelper in order to easily create fat-tree topologies
+   *
+   * \param k the number of ports per switch; must be even
+   */
+  FatTreeHelper (uint32_t k);
+
+  ~FatTreeHelper ();
+
+  /**
+   * \param n the number of hosts attached to each edge switch.  The
+   *          default is k/2, which gives a non-blocking fat-tree; any
+   *          larger value oversubscribes the edge layer by n/(k/2).
+   */
+  void SetHostsPerEdge (uint32_t n);
+
+  /**
+   * Set an attribute on each ns3::CsmaChannel between a host or an edge
+   * switch and its edge bridge.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetCsmaChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \param use whether each edge switch and its hosts are connected by a
+   *            SwitchChannel instead of Csma links to a bridge node.  The
+   *            default is false, which keeps the node ids of the original
+   *            scratch programs; a SwitchChannel costs about half the
+   *            events per host packet at the edge layer.
+   */
+  void UseSwitchChannel (bool use);
+
+  /**
+   * Set an attribute on each ns3::SwitchChannel of the edge layer, when
+   * UseSwitchChannel is set.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetSwitchChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Set an attribute on each ns3::PointToPointNetDevice of the switch
+   * fabric.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetPointToPointDeviceAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Set an attribute on each ns3::PointToPointChannel of the switch
+   * fabric.
+   *
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   */
+  void SetPointToPointChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Create all the nodes of the topology and connect them.  Must be
+   * called once, after the attributes have been set.
+   */
+  void Create (void);
+
+  /**
+   * \param stack an InternetStackHelper which is used to install
+   *              on every node in the fat-tree
+   */
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * Assign the Ipv4 addresses of every switch and host interface, as
+   * described in the class documentation.
+   */
+  void AssignIpv4Addresses (void);
+
+  /**
+   * \returns the number of ports per switch
+   */
+  uint32_t GetK (void) const;
+
+  /**
+   * \returns the number of pods, which is k
+   */
+  uint32_t GetNPods (void) const;
+
+  /**
+   * \returns the number of hosts attached to each edge switch
+   */
+  uint32_t GetHostsPerEdge (void) const;
+
+  /**
+   * \returns the ratio of host bandwidth to uplink bandwidth at
+   *          the edge layer, 1.0 for a non-blocking fat-tree
+   */
+  double GetOversubscription (void) const;
+
+  /**
+   * \returns total number of hosts in the fat-tree
+   */
+  uint32_t HostCount (void) const;
+
+  /**
+   * \param i an index into the hosts, in the range [0, HostCount ())
+   *
+   * \returns a node pointer to the i'th host
+   */
+  Ptr<Node> GetHost (uint32_t i) const;
+
+  /**
+   * \param pod the pod of the host
+   * \param edge the edge switch of the host within its pod
+   * \param host the index of the host under its edge switch
+   *
+   * \returns a node pointer to the host
+   */
+  Ptr<Node> GetHost (uint32_t pod, uint32_t edge, uint32_t host) const;
+
+  /**
+   * \param pod the pod of the switch
+   * \param i the index of the switch within its pod
+   *
+   * \returns a node pointer to the edge switch
+   */
+  Ptr<Node> GetEdgeSwitch (uint32_t pod, uint32_t i) const;
+
+  /**
+   * \param pod the pod of the switch
+   * \param i the index of the switch within its pod
+   *
+   * \returns a node pointer to the aggregation switch
+   */
+  Ptr<Node> GetAggregationSwitch (uint32_t pod, uint32_t i) const;
+
+  /**
+   * \param group the group of the switch
+   * \param i the index of the switch within its group
+   *
+   * \returns a node pointer to the core switch
+   */
+  Ptr<Node> GetCoreSwitch (uint32_t group, uint32_t i) const;
+
+  /**
+   * \param i an index into the hosts, in the range [0, HostCount ())
+   *
+   * \returns the Ipv4Address of the i'th host
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t i) const;
+
+  /**
+   * \param pod the pod of the host
+   * \param edge the edge switch of the host within its pod
+   * \param host the index of the host under its edge switch
+   *
+   * \returns the Ipv4Address of the host
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t pod, uint32_t edge, uint32_t host) const;
+
+  /**
+   * \returns a container of all the hosts
+   */
+  NodeContainer GetHosts (void) const;
+
+  /**
+   * \returns a container of every edge, aggregation and core switch
+   */
+  NodeContainer GetSwitches (void) const;
+
+  /**
+   * \returns a container of the bridge nodes of the edge layer, which
+   *          is empty with UseSwitchChannel
+   */
+  NodeContainer GetBridges (void) const;
+
+  /**
+   * The oracle knows the topology once Create has been called, but
+   * can be passed to Ipv4NixVectorHelper::SetPathOracle before that.
+   *
+   * \returns a path oracle giving nix-vector routing the host-to-host
+   *          paths of this topology without a BFS
+   */
+  Ptr<Ipv4NixPathOracle> GetNixPathOracle (void) const;
+
+private:
+  static Ipv4Address MakeAddress (uint32_t second, uint32_t third, uint32_t fourth);
+  void AssignAddress (Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask);
+
+  uint32_t m_k;
+  uint32_t m_half;
+  uint32_t m_hostsPerEdge;
+  bool m_useSwitch;
+
+  CsmaHelper m_csma;
+  SwitchHelper m_switch;
+  PointToPointHelper m_p2p;
+  BridgeHelper m_bridge;
+  Ptr<FatTreeNixPathOracle> m_oracle;
+
+  NodeContainer m_core;
+  NodeContainer m_agg;
+  NodeContainer m_edge;
+  NodeContainer m_bridges;
+  NodeContainer m_hosts;
+
+  // one device per Csma link end or switch port, indexed by edge switch
+  // then by port:
+  // port 0 is the edge switch, port h+1 is host h
+  NetDeviceContainer m_edgeLanDevices;
+  // switch-side devices of the aggregation-edge links, indexed
+  // (pod, agg, edge), and the peer devices on the edge switches
+  NetDeviceContainer m_aggDownDevices;
+  NetDeviceContainer m_edgeUpDevices;
+  // indexed (group, core, pod)
+  NetDeviceContainer m_coreDownDevices;
+  NetDeviceContainer m_aggUpDevices;
+};
+
+} // namespace ns3
+
+#endif /* FAT_TREE_HELPER_H */
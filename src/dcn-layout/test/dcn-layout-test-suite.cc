@@ -0,0 +1,406 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <set>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/ipv4.h"
+#include "ns3/channel.h"
+#include "ns3/udp-header.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+#include "ns3/ipv4-nix-vector-cache.h"
+#include "ns3/fat-tree-helper.h"
+#include "ns3/bcube-helper.h"
+#include "ns3/dcn-nix-path-oracle.h"
+
+namespace ns3 {
+
+class FatTreeTestCase : public TestCase
+{
+public:
+  FatTreeTestCase (uint32_t k, uint32_t hostsPerEdge, bool useSwitch = false);
+  virtual void DoRun (void);
+private:
+  bool HasAddress (Ptr<Node> node, Ipv4Address address);
+  uint32_t m_k;
+  uint32_t m_hostsPerEdge;
+  bool m_useSwitch;
+};
+
+FatTreeTestCase::FatTreeTestCase (uint32_t k, uint32_t hostsPerEdge, bool useSwitch)
+  : TestCase ("Fat-tree nodes, links and addresses"),
+    m_k (k),
+    m_hostsPerEdge (hostsPerEdge),
+    m_useSwitch (useSwitch)
+{
+}
+
+bool
+FatTreeTestCase::HasAddress (Ptr<Node> node, Ipv4Address address)
+{
+  return node->GetObject<Ipv4> ()->GetInterfaceForAddress (address) != -1;
+}
+
+void
+FatTreeTestCase::DoRun (void)
+{
+  uint32_t half = m_k / 2;
+
+  FatTreeHelper fatTree (m_k);
+  fatTree.SetHostsPerEdge (m_hostsPerEdge);
+  fatTree.UseSwitchChannel (m_useSwitch);
+  fatTree.Create ();
+  InternetStackHelper stack;
+  fatTree.InstallStack (stack);
+  fatTree.AssignIpv4Addresses ();
+
+  NS_TEST_ASSERT_MSG_EQ (fatTree.HostCount (), m_k * half * m_hostsPerEdge, "Wrong number of hosts");
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetHosts ().GetN (), fatTree.HostCount (), "Wrong number of host nodes");
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetSwitches ().GetN (), 2 * m_k * half + half * half, "Wrong number of switches");
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetBridges ().GetN (), (m_useSwitch ? 0 : m_k * half), "Wrong number of bridges");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fatTree.GetOversubscription (), double (m_hostsPerEdge) / half, 1e-9,
+                             "Wrong oversubscription");
+
+  // loopback + one device per port
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetCoreSwitch (0, 0)->GetNDevices (), m_k + 1, "Core switch must use k ports");
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetAggregationSwitch (0, 0)->GetNDevices (), m_k + 1, "Agg switch must use k ports");
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetEdgeSwitch (0, 0)->GetNDevices (), half + 2, "Edge switch: k/2 uplinks and a LAN");
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetHost (0)->GetNDevices (), 2, "Host has a single LAN device");
+  // a switch port per host and for the edge switch, or a Csma link to the bridge
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetHost (0)->GetDevice (0)->GetChannel ()->GetNDevices (),
+                         (m_useSwitch ? m_hostsPerEdge + 1 : 2), "Wrong number of devices on the host LAN");
+
+  // the host addressing matches the indexing
+  for (uint32_t i = 0; i < fatTree.HostCount (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetHost (i), fatTree.GetHostIpv4Address (i)), true,
+                             "Host " << i << " does not own " << fatTree.GetHostIpv4Address (i));
+    }
+  uint32_t lastPod = m_k - 1;
+  uint32_t lastHost = m_hostsPerEdge - 1;
+  Ptr<Node> host = fatTree.GetHost (lastPod, half - 1, lastHost);
+  NS_TEST_EXPECT_MSG_EQ (host, fatTree.GetHost (fatTree.HostCount () - 1), "Coordinates and index disagree");
+  NS_TEST_EXPECT_MSG_EQ (fatTree.GetHostIpv4Address (lastPod, half - 1, lastHost),
+                         Ipv4Address ((10U << 24) | (lastPod << 16) | ((half - 1) << 8) | (lastHost + 2)),
+                         "Wrong host address");
+
+  // edge switch on .1 of its LAN, and on the agg side of its uplinks
+  NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetEdgeSwitch (1, 1), Ipv4Address ("10.1.1.1")), true, "Edge LAN address");
+  std::ostringstream oss;
+  oss << "10.1." << half << ".4";
+  NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetEdgeSwitch (1, 1), Ipv4Address (oss.str ().c_str ())), true,
+                         "Edge uplink address");
+  oss.str ("");
+  oss << "10.1." << half << ".3";
+  NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetAggregationSwitch (1, 0), Ipv4Address (oss.str ().c_str ())), true,
+                         "Agg downlink address");
+
+  // core switch c of group g on 10.(k+g).c.(2*pod+1)
+  oss.str ("");
+  oss << "10." << m_k + half - 1 << "." << half - 1 << "." << 2 * lastPod + 1;
+  NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetCoreSwitch (half - 1, half - 1), Ipv4Address (oss.str ().c_str ())), true,
+                         "Core downlink address");
+  oss.str ("");
+  oss << "10." << m_k + half - 1 << "." << half - 1 << "." << 2 * lastPod + 2;
+  NS_TEST_EXPECT_MSG_EQ (HasAddress (fatTree.GetAggregationSwitch (lastPod, half - 1), Ipv4Address (oss.str ().c_str ())), true,
+                         "Agg uplink address");
+
+  Simulator::Destroy ();
+}
+
+class BCubeTestCase : public TestCase
+{
+public:
+  BCubeTestCase (uint32_t n, uint32_t k);
+  virtual void DoRun (void);
+private:
+  uint32_t m_n;
+  uint32_t m_k;
+};
+
+BCubeTestCase::BCubeTestCase (uint32_t n, uint32_t k)
+  : TestCase ("BCube nodes, wiring and addresses"),
+    m_n (n),
+    m_k (k)
+{
+}
+
+void
+BCubeTestCase::DoRun (void)
+{
+  BCubeHelper bcube (m_n, m_k);
+  bcube.Create ();
+  InternetStackHelper stack;
+  bcube.InstallStack (stack);
+  bcube.AssignIpv4Addresses ();
+
+  uint32_t nSwitches = 1;
+  for (uint32_t l = 0; l < m_k; ++l)
+    {
+      nSwitches *= m_n;
+    }
+  NS_TEST_ASSERT_MSG_EQ (bcube.GetNLevels (), m_k + 1, "Wrong number of levels");
+  NS_TEST_ASSERT_MSG_EQ (bcube.SwitchCountPerLevel (), nSwitches, "Wrong number of switches per level");
+  NS_TEST_ASSERT_MSG_EQ (bcube.HostCount (), nSwitches * m_n, "Wrong number of hosts");
+  NS_TEST_ASSERT_MSG_EQ (bcube.GetSwitches ().GetN (), nSwitches * (m_k + 1), "Wrong number of switch nodes");
+
+  // a host has one port per level, a switch n hosts behind its bridge
+  NS_TEST_EXPECT_MSG_EQ (bcube.GetHost (0)->GetNDevices (), m_k + 2, "Host must have one port per level");
+  NS_TEST_EXPECT_MSG_EQ (bcube.GetBridges ().Get (0)->GetNDevices (), m_n + 3, "Bridge: n+1 ports, the bridge device and loopback");
+
+  for (uint32_t h = 0; h < bcube.HostCount (); ++h)
+    {
+      Ptr<Ipv4> ipv4 = bcube.GetHost (h)->GetObject<Ipv4> ();
+      for (uint32_t l = 0; l <= m_k; ++l)
+        {
+          Ipv4Address address = bcube.GetHostIpv4Address (h, l);
+          NS_TEST_EXPECT_MSG_EQ ((ipv4->GetInterfaceForAddress (address) != -1), true,
+                                 "Host " << h << " does not own " << address);
+
+          // the level l device of the host leads to the bridge of its
+          // level l switch
+          Ptr<Channel> channel = bcube.GetHost (h)->GetDevice (l)->GetChannel ();
+          Ptr<Node> bridge = bcube.GetBridges ().Get (l * nSwitches + bcube.GetSwitchIndex (h, l));
+          NS_TEST_EXPECT_MSG_EQ (channel->GetDevice (1)->GetNode (), bridge,
+                                 "Host " << h << " is not wired to its level " << l << " switch");
+        }
+    }
+
+  // switch i of level l owns 10.l.i.1 while n^k <= 256
+  if (nSwitches <= 256)
+    {
+      std::ostringstream oss;
+      oss << "10." << m_k << "." << nSwitches - 1 << ".1";
+      NS_TEST_EXPECT_MSG_EQ ((bcube.GetSwitch (m_k, nSwitches - 1)->GetObject<Ipv4> ()->GetInterfaceForAddress (Ipv4Address (oss.str ().c_str ())) != -1),
+                             true, "Wrong switch address");
+      NS_TEST_EXPECT_MSG_EQ (bcube.GetHostIpv4Address (m_n + 1), Ipv4Address ("10.0.1.3"), "Wrong level 0 host address");
+    }
+
+  Simulator::Destroy ();
+}
+
+class NixPathOracleTestCase : public TestCase
+{
+public:
+  NixPathOracleTestCase ();
+  virtual void DoRun (void);
+};
+
+NixPathOracleTestCase::NixPathOracleTestCase ()
+  : TestCase ("Fat-tree and BCube nix path oracles")
+{
+}
+
+void
+NixPathOracleTestCase::DoRun (void)
+{
+  std::vector< Ptr<Node> > path;
+
+  FatTreeHelper fatTree (4);
+  fatTree.Create ();
+  Ptr<Ipv4NixPathOracle> oracle = fatTree.GetNixPathOracle ();
+
+  // same edge, same pod, other pod
+  NS_TEST_ASSERT_MSG_EQ (oracle->GetPath (fatTree.GetHost (0, 0, 0), fatTree.GetHostIpv4Address (0, 0, 1), path), true,
+                         "Host to host path expected");
+  NS_TEST_EXPECT_MSG_EQ (path.size (), 2, "Hosts on the same edge switch are one hop apart");
+  NS_TEST_EXPECT_MSG_EQ (path.back (), fatTree.GetHost (0, 0, 1), "Wrong destination");
+  oracle->GetPath (fatTree.GetHost (0, 0, 0), fatTree.GetHostIpv4Address (0, 1, 1), path);
+  NS_TEST_EXPECT_MSG_EQ (path.size (), 5, "Hosts of one pod go through an aggregation switch");
+  NS_TEST_EXPECT_MSG_EQ (path[1], fatTree.GetEdgeSwitch (0, 0), "Wrong edge switch");
+  NS_TEST_EXPECT_MSG_EQ (path[2], fatTree.GetAggregationSwitch (0, 1), "Uplink must depend on the destination");
+  oracle->GetPath (fatTree.GetHost (0, 0, 0), fatTree.GetHostIpv4Address (3, 1, 0), path);
+  NS_TEST_EXPECT_MSG_EQ (path.size (), 7, "Hosts of different pods go through a core switch");
+  NS_TEST_EXPECT_MSG_EQ (path[3], fatTree.GetCoreSwitch (0, 0), "Wrong core switch");
+  NS_TEST_EXPECT_MSG_EQ (path[4], fatTree.GetAggregationSwitch (3, 0), "Wrong destination aggregation switch");
+  NS_TEST_EXPECT_MSG_EQ (path.back (), fatTree.GetHost (3, 1, 0), "Wrong destination");
+
+  // switch addresses and switch sources are left to the BFS
+  NS_TEST_EXPECT_MSG_EQ (oracle->GetPath (fatTree.GetHost (0), Ipv4Address ("10.0.0.1"), path), false,
+                         "Switch address must not be answered");
+  NS_TEST_EXPECT_MSG_EQ (oracle->GetPath (fatTree.GetEdgeSwitch (0, 0), fatTree.GetHostIpv4Address (1), path), false,
+                         "Switch source must not be answered");
+  Simulator::Destroy ();
+
+  // BCube(3,2): one hop per differing digit, highest level first
+  BCubeHelper bcube (3, 2);
+  bcube.Create ();
+  oracle = bcube.GetNixPathOracle ();
+  NS_TEST_ASSERT_MSG_EQ (oracle->GetPath (bcube.GetHost (0), bcube.GetHostIpv4Address (22, 1), path), true,
+                         "Host to host path expected");
+  NS_TEST_ASSERT_MSG_EQ (path.size (), 4, "0 and 22 differ in every digit");
+  NS_TEST_EXPECT_MSG_EQ (path[1], bcube.GetHost (18), "Level 2 digit must be corrected first");
+  NS_TEST_EXPECT_MSG_EQ (path[2], bcube.GetHost (21), "Then the level 1 digit");
+  NS_TEST_EXPECT_MSG_EQ (path[3], bcube.GetHost (22), "Wrong destination");
+  oracle->GetPath (bcube.GetHost (4), bcube.GetHostIpv4Address (7, 2), path);
+  NS_TEST_EXPECT_MSG_EQ (path.size (), 2, "4 and 7 share a level 1 switch");
+  Simulator::Destroy ();
+}
+
+class NixEcmpTestCase : public TestCase
+{
+public:
+  NixEcmpTestCase ();
+  virtual void DoRun (void);
+private:
+  // nix-vector of a UDP packet from sourcePort, as a string
+  std::string Route (Ptr<Node> source, Ipv4Address dest, uint16_t sourcePort);
+};
+
+NixEcmpTestCase::NixEcmpTestCase ()
+  : TestCase ("Nix-vector routing over equal-cost paths")
+{
+}
+
+std::string
+NixEcmpTestCase::Route (Ptr<Node> source, Ipv4Address dest, uint16_t sourcePort)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (sourcePort);
+  udpHeader.SetDestinationPort (9);
+  packet->AddHeader (udpHeader);
+  Ipv4Header header;
+  header.SetDestination (dest);
+  header.SetProtocol (17);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = source->GetObject<Ipv4> ()->GetRoutingProtocol ()->RouteOutput (packet, header, 0, sockerr);
+  NS_TEST_EXPECT_MSG_NE (route, 0, "Route expected");
+  std::ostringstream oss;
+  if (packet->GetNixVector ())
+    {
+      oss << *packet->GetNixVector ();
+    }
+  return oss.str ();
+}
+
+void
+NixEcmpTestCase::DoRun (void)
+{
+  Ipv4NixVectorHelper nixRouting;
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (nixRouting);
+
+  FatTreeHelper fatTree (4);
+  fatTree.Create ();
+  fatTree.InstallStack (stack);
+  fatTree.AssignIpv4Addresses ();
+  Ptr<Node> source = fatTree.GetHost (0, 0, 0);
+  Ipv4Address dest = fatTree.GetHostIpv4Address (3, 1, 0);
+  Ptr<Ipv4NixVectorRouting> nix = source->GetObject<Ipv4NixVectorRouting> ();
+  Ptr<Ipv4NixPathOracle> oracle = fatTree.GetNixPathOracle ();
+
+  // a single path by default
+  std::set<std::string> paths;
+  for (uint16_t port = 1000; port < 1100; port++)
+    {
+      paths.insert (Route (source, dest, port));
+    }
+  NS_TEST_EXPECT_MSG_EQ (paths.size (), 1, "Multipath must be off by default");
+
+  // per flow: (k/2)^2 paths between pods, stable for a flow
+  nix->SetAttribute ("EcmpMode", EnumValue (Ipv4NixVectorRouting::ECMP_PER_FLOW));
+  paths.clear ();
+  for (uint16_t port = 1000; port < 1100; port++)
+    {
+      paths.insert (Route (source, dest, port));
+      NS_TEST_EXPECT_MSG_EQ (Route (source, dest, port), Route (source, dest, port), "A flow must keep its path");
+    }
+  NS_TEST_EXPECT_MSG_EQ (paths.size (), 4, "Every core switch must be used");
+  const Ipv4NixVectorCache::ParentGraph *tree = Ipv4NixVectorCache::Get ()->LookupTree (source->GetId ());
+  NS_TEST_ASSERT_MSG_NE (tree, 0, "The BFS must have been cached");
+  NS_TEST_EXPECT_MSG_EQ (tree->nPaths[fatTree.GetHost (3, 1, 0)->GetId ()], 4, "Wrong number of shortest paths");
+  NS_TEST_EXPECT_MSG_EQ (tree->nPaths[fatTree.GetHost (0, 1, 0)->GetId ()], 2, "Wrong number of shortest paths");
+  NS_TEST_EXPECT_MSG_EQ (tree->nPaths[fatTree.GetHost (0, 0, 1)->GetId ()], 1, "Wrong number of shortest paths");
+
+  // the oracle knows the same paths
+  NS_TEST_EXPECT_MSG_EQ (oracle->GetNEqualCostPaths (source, dest), 4, "Wrong number of oracle paths");
+  NS_TEST_EXPECT_MSG_EQ (oracle->GetNEqualCostPaths (source, fatTree.GetHostIpv4Address (0, 1, 0)), 2,
+                         "Wrong number of oracle paths");
+  nix->SetPathOracle (oracle);
+  std::set<std::string> oraclePaths;
+  for (uint16_t port = 1000; port < 1100; port++)
+    {
+      oraclePaths.insert (Route (fatTree.GetHost (0, 0, 0), dest, port));
+    }
+  NS_TEST_EXPECT_MSG_EQ ((oraclePaths == paths), true, "The oracle and the BFS must agree on the paths");
+
+  // per packet: one flow over every path
+  nix->SetAttribute ("EcmpMode", EnumValue (Ipv4NixVectorRouting::ECMP_PER_PACKET));
+  paths.clear ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      paths.insert (Route (source, dest, 1000));
+    }
+  NS_TEST_EXPECT_MSG_EQ (paths.size (), 4, "Packets of a flow must be sprayed");
+  Simulator::Destroy ();
+
+  // BCube(3,2): the oracle counts the orders of the digit corrections
+  BCubeHelper bcube (3, 2);
+  bcube.Create ();
+  bcube.InstallStack (stack);
+  bcube.AssignIpv4Addresses ();
+  source = bcube.GetHost (0);
+  nix = source->GetObject<Ipv4NixVectorRouting> ();
+  nix->SetAttribute ("EcmpMode", EnumValue (Ipv4NixVectorRouting::ECMP_PER_FLOW));
+  oracle = bcube.GetNixPathOracle ();
+  paths.clear ();
+  for (uint16_t port = 1000; port < 1100; port++)
+    {
+      paths.insert (Route (source, bcube.GetHostIpv4Address (26), port));
+    }
+  NS_TEST_EXPECT_MSG_EQ (paths.size (), 6, "0 and 26 differ in three digits");
+  tree = Ipv4NixVectorCache::Get ()->LookupTree (source->GetId ());
+  NS_TEST_ASSERT_MSG_NE (tree, 0, "The BFS must have been cached");
+  for (uint32_t i = 1; i < bcube.HostCount (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (oracle->GetNEqualCostPaths (source, bcube.GetHostIpv4Address (i)),
+                             tree->nPaths[bcube.GetHost (i)->GetId ()], "The oracle and the BFS disagree");
+    }
+  nix->SetPathOracle (oracle);
+  oraclePaths.clear ();
+  for (uint16_t port = 1000; port < 1100; port++)
+    {
+      oraclePaths.insert (Route (source, bcube.GetHostIpv4Address (26), port));
+    }
+  NS_TEST_EXPECT_MSG_EQ ((oraclePaths == paths), true, "The oracle and the BFS must agree on the paths");
+  Simulator::Destroy ();
+}
+
+static class DcnLayoutTestSuite : public TestSuite
+{
+public:
+  DcnLayoutTestSuite ()
+    : TestSuite ("dcn-layout", UNIT)
+  {
+    AddTestCase (new FatTreeTestCase (4, 2));
+    AddTestCase (new FatTreeTestCase (6, 5));
+    AddTestCase (new FatTreeTestCase (4, 3, true));
+    AddTestCase (new BCubeTestCase (4, 1));
+    AddTestCase (new BCubeTestCase (3, 3));
+    AddTestCase (new BCubeTestCase (2, 8));
+    AddTestCase (new NixPathOracleTestCase);
+    AddTestCase (new NixEcmpTestCase);
+  }
+} g_dcnLayoutTestSuite;
+
+} // namespace ns3
@@ -31,6 +31,8 @@
 namespace ns3 {
 
 FlowMonitorHelper::FlowMonitorHelper ()
+  : m_systemId (0),
+    m_installed (false)
 {
   m_monitorFactory.SetTypeId ("ns3::FlowMonitor");
 }
@@ -70,10 +72,17 @@ Ptr<FlowMonitor>
 FlowMonitorHelper::Install (Ptr<Node> node)
 {
   Ptr<FlowMonitor> monitor = GetMonitor ();
-  Ptr<FlowClassifier> classifier = GetClassifier ();
-  Ptr<Ipv4FlowProbe> probe = Create<Ipv4FlowProbe> (monitor,
-                                                    DynamicCast<Ipv4FlowClassifier> (classifier),
-                                                    node);
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (GetClassifier ());
+  if (!m_installed)
+    {
+      m_systemId = node->GetSystemId ();
+      m_installed = true;
+    }
+  else if (node->GetSystemId () != m_systemId)
+    {
+      classifier->SetLocked (true);
+    }
+  Ptr<Ipv4FlowProbe> probe = Create<Ipv4FlowProbe> (monitor, classifier, node);
   return m_flowMonitor;
 }
 
@@ -47,6 +47,9 @@ public:
   Ptr<FlowMonitor> Install (NodeContainer nodes);
   /// \brief Enable flow monitoring on a single node
   /// \param node A Ptr<Node> to the node on which to enable flow monitoring.
+  ///
+  /// Once nodes of several system ids are monitored, the classifier is
+  /// locked, as their partitions may run in threads.
   Ptr<FlowMonitor> Install (Ptr<Node> node);
   /// \brief Enable flow monitoring on all nodes
   Ptr<FlowMonitor> InstallAll ();
@@ -61,6 +64,9 @@ private:
   ObjectFactory m_monitorFactory;
   Ptr<FlowMonitor> m_flowMonitor;
   Ptr<FlowClassifier> m_flowClassifier;
+  /// the system id of the first node installed, if any
+  uint32_t m_systemId;
+  bool m_installed;
 };
 
 } // namespace ns3
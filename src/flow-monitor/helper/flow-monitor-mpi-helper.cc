@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-monitor-mpi-helper.h"
+
+#include "ns3/mpi-interface.h"
+#include <sstream>
+
+namespace ns3 {
+
+void
+FlowMonitorMpiHelper::SetDistributed (Ptr<FlowMonitor> monitor)
+{
+  monitor->SetDistributed (MpiInterface::IsEnabled () && MpiInterface::GetSize () > 1);
+}
+
+void
+FlowMonitorMpiHelper::ReduceAcrossRanks (Ptr<FlowMonitor> monitor)
+{
+  // match here what can be, the packets of the other ranks being unknown
+  monitor->CheckForLostPackets ();
+  if (!MpiInterface::IsEnabled () || MpiInterface::GetSize () == 1)
+    {
+      return;
+    }
+  std::ostringstream os (std::ios::out|std::ios::binary);
+  monitor->SerializeState (os);
+  std::vector<std::string> states = MpiInterface::Gather (os.str ());
+  if (MpiInterface::GetSystemId () == 0)
+    {
+      monitor->MergeRanks (states);
+    }
+}
+
+} // namespace ns3
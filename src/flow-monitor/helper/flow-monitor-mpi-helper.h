@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_MONITOR_MPI_HELPER_H
+#define FLOW_MONITOR_MPI_HELPER_H
+
+#include "ns3/flow-monitor.h"
+
+namespace ns3 {
+
+/// \brief Helper to merge the flow monitors of the ranks of a distributed
+/// simulation
+///
+/// It is only built with MPI, so that the flow monitor does not depend
+/// on the mpi module otherwise.
+class FlowMonitorMpiHelper
+{
+public:
+  /// \brief Keep in the monitor of this rank the packets which another
+  /// rank may report on, if several ranks run; to call before
+  /// Simulator::Run
+  static void SetDistributed (Ptr<FlowMonitor> monitor);
+
+  /// \brief Merge the state of the monitors of every rank into the
+  /// monitor of the rank 0, which then holds the statistics of the whole
+  /// simulation, including the packets which crossed ranks.  It must be
+  /// called by every rank after Simulator::Run, the probes being
+  /// installed in the same order everywhere, and only the rank 0 should
+  /// serialize the results; without MPI it only checks for lost packets.
+  static void ReduceAcrossRanks (Ptr<FlowMonitor> monitor);
+};
+
+} // namespace ns3
+
+#endif /* FLOW_MONITOR_MPI_HELPER_H */
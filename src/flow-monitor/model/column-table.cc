@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "column-table.h"
+#include "ns3/assert.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+static const char COLUMN_TABLE_MAGIC[8] = { 'N', 'S', '3', 'C', 'O', 'L', 'S', '1' };
+static const uint32_t COLUMN_TABLE_BYTE_ORDER = 0x01020304;
+
+static void
+WriteUint32 (std::ostream &os, uint32_t value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+static void
+WriteString (std::ostream &os, const std::string &value)
+{
+  WriteUint32 (os, value.size ());
+  os.write (value.data (), value.size ());
+}
+
+static bool
+ReadUint32 (std::istream &is, uint32_t &value)
+{
+  is.read (reinterpret_cast<char *> (&value), sizeof (value));
+  return is.good ();
+}
+
+static bool
+ReadString (std::istream &is, std::string &value)
+{
+  uint32_t size;
+  if (!ReadUint32 (is, size))
+    {
+      return false;
+    }
+  value.resize (size);
+  if (size > 0)
+    {
+      is.read (&value[0], size);
+    }
+  return is.good ();
+}
+
+ColumnTable::ColumnTable ()
+{
+}
+
+ColumnTable::ColumnTable (std::string name)
+  : m_name (name)
+{
+}
+
+std::string
+ColumnTable::GetName () const
+{
+  return m_name;
+}
+
+uint32_t
+ColumnTable::GetSize (enum Type type)
+{
+  switch (type)
+    {
+    case UINT8:
+      return 1;
+    case UINT16:
+      return 2;
+    case UINT32:
+      return 4;
+    default:
+      return 8;
+    }
+}
+
+uint32_t
+ColumnTable::AddColumn (std::string name, enum Type type)
+{
+  Column column;
+  column.name = name;
+  column.type = type;
+  m_columns.push_back (column);
+  return m_columns.size () - 1;
+}
+
+void
+ColumnTable::AppendUnsigned (uint32_t column, uint64_t value)
+{
+  Column &c = m_columns[column];
+  uint32_t offset = c.data.size ();
+  c.data.resize (offset + GetSize (c.type));
+  uint8_t *p = &c.data[offset];
+  switch (c.type)
+    {
+    case UINT8:
+      *p = value;
+      break;
+    case UINT16:
+      {
+        uint16_t v = value;
+        std::memcpy (p, &v, sizeof (v));
+        break;
+      }
+    case UINT32:
+      {
+        uint32_t v = value;
+        std::memcpy (p, &v, sizeof (v));
+        break;
+      }
+    case UINT64:
+      std::memcpy (p, &value, sizeof (value));
+      break;
+    default:
+      NS_ASSERT_MSG (false, "Column " << c.name << " is not unsigned");
+    }
+}
+
+void
+ColumnTable::AppendSigned (uint32_t column, int64_t value)
+{
+  Column &c = m_columns[column];
+  NS_ASSERT_MSG (c.type == INT64, "Column " << c.name << " is not signed");
+  uint32_t offset = c.data.size ();
+  c.data.resize (offset + sizeof (value));
+  std::memcpy (&c.data[offset], &value, sizeof (value));
+}
+
+void
+ColumnTable::AppendDouble (uint32_t column, double value)
+{
+  Column &c = m_columns[column];
+  NS_ASSERT_MSG (c.type == DOUBLE, "Column " << c.name << " is not a double");
+  uint32_t offset = c.data.size ();
+  c.data.resize (offset + sizeof (value));
+  std::memcpy (&c.data[offset], &value, sizeof (value));
+}
+
+uint32_t
+ColumnTable::GetNColumns () const
+{
+  return m_columns.size ();
+}
+
+uint64_t
+ColumnTable::GetNRows () const
+{
+  if (m_columns.empty ())
+    {
+      return 0;
+    }
+  return m_columns[0].data.size () / GetSize (m_columns[0].type);
+}
+
+std::string
+ColumnTable::GetColumnName (uint32_t column) const
+{
+  return m_columns[column].name;
+}
+
+enum ColumnTable::Type
+ColumnTable::GetColumnType (uint32_t column) const
+{
+  return m_columns[column].type;
+}
+
+uint32_t
+ColumnTable::FindColumn (std::string name) const
+{
+  for (uint32_t i = 0; i < m_columns.size (); i++)
+    {
+      if (m_columns[i].name == name)
+        {
+          return i;
+        }
+    }
+  return m_columns.size ();
+}
+
+uint64_t
+ColumnTable::GetUnsigned (uint32_t column, uint64_t row) const
+{
+  const Column &c = m_columns[column];
+  const uint8_t *p = &c.data[row * GetSize (c.type)];
+  switch (c.type)
+    {
+    case UINT8:
+      return *p;
+    case UINT16:
+      {
+        uint16_t v;
+        std::memcpy (&v, p, sizeof (v));
+        return v;
+      }
+    case UINT32:
+      {
+        uint32_t v;
+        std::memcpy (&v, p, sizeof (v));
+        return v;
+      }
+    case UINT64:
+      {
+        uint64_t v;
+        std::memcpy (&v, p, sizeof (v));
+        return v;
+      }
+    default:
+      NS_ASSERT_MSG (false, "Column " << c.name << " is not unsigned");
+      return 0;
+    }
+}
+
+int64_t
+ColumnTable::GetSigned (uint32_t column, uint64_t row) const
+{
+  const Column &c = m_columns[column];
+  NS_ASSERT_MSG (c.type == INT64, "Column " << c.name << " is not signed");
+  int64_t v;
+  std::memcpy (&v, &c.data[row * sizeof (v)], sizeof (v));
+  return v;
+}
+
+double
+ColumnTable::GetDouble (uint32_t column, uint64_t row) const
+{
+  const Column &c = m_columns[column];
+  NS_ASSERT_MSG (c.type == DOUBLE, "Column " << c.name << " is not a double");
+  double v;
+  std::memcpy (&v, &c.data[row * sizeof (v)], sizeof (v));
+  return v;
+}
+
+double
+ColumnTable::GetValue (uint32_t column, uint64_t row) const
+{
+  switch (m_columns[column].type)
+    {
+    case INT64:
+      return GetSigned (column, row);
+    case DOUBLE:
+      return GetDouble (column, row);
+    default:
+      return GetUnsigned (column, row);
+    }
+}
+
+void
+ColumnTable::Write (std::ostream &os) const
+{
+  WriteString (os, m_name);
+  uint64_t nRows = GetNRows ();
+  os.write (reinterpret_cast<const char *> (&nRows), sizeof (nRows));
+  WriteUint32 (os, m_columns.size ());
+  for (std::vector<Column>::const_iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      NS_ASSERT_MSG (i->data.size () == nRows * GetSize (i->type),
+                     "Column " << i->name << " of table " << m_name << " has a wrong number of rows");
+      WriteString (os, i->name);
+      WriteUint32 (os, i->type);
+      if (!i->data.empty ())
+        {
+          os.write (reinterpret_cast<const char *> (&i->data[0]), i->data.size ());
+        }
+    }
+}
+
+bool
+ColumnTable::Read (std::istream &is)
+{
+  uint64_t nRows;
+  uint32_t nColumns;
+  if (!ReadString (is, m_name))
+    {
+      return false;
+    }
+  is.read (reinterpret_cast<char *> (&nRows), sizeof (nRows));
+  if (!ReadUint32 (is, nColumns))
+    {
+      return false;
+    }
+  m_columns.resize (nColumns);
+  for (std::vector<Column>::iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      uint32_t type;
+      if (!ReadString (is, i->name) || !ReadUint32 (is, type) || type > DOUBLE)
+        {
+          return false;
+        }
+      i->type = static_cast<enum Type> (type);
+      i->data.resize (nRows * GetSize (i->type));
+      if (!i->data.empty ())
+        {
+          is.read (reinterpret_cast<char *> (&i->data[0]), i->data.size ());
+        }
+      if (is.fail ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+ColumnTable::WriteFile (std::ostream &os, const std::vector<ColumnTable> &tables)
+{
+  os.write (COLUMN_TABLE_MAGIC, sizeof (COLUMN_TABLE_MAGIC));
+  WriteUint32 (os, COLUMN_TABLE_BYTE_ORDER);
+  WriteUint32 (os, tables.size ());
+  for (std::vector<ColumnTable>::const_iterator i = tables.begin (); i != tables.end (); i++)
+    {
+      i->Write (os);
+    }
+}
+
+bool
+ColumnTable::ReadFile (std::istream &is, std::vector<ColumnTable> &tables)
+{
+  char magic[sizeof (COLUMN_TABLE_MAGIC)];
+  is.read (magic, sizeof (magic));
+  uint32_t byteOrder;
+  uint32_t nTables;
+  if (!is.good () || std::memcmp (magic, COLUMN_TABLE_MAGIC, sizeof (magic)) != 0
+      || !ReadUint32 (is, byteOrder) || byteOrder != COLUMN_TABLE_BYTE_ORDER
+      || !ReadUint32 (is, nTables))
+    {
+      return false;
+    }
+  tables.resize (nTables);
+  for (std::vector<ColumnTable>::iterator i = tables.begin (); i != tables.end (); i++)
+    {
+      if (!i->Read (is))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // namespace ns3
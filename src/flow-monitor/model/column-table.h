@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COLUMN_TABLE_H
+#define COLUMN_TABLE_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/// \brief A table of typed columns, stored and written column by column
+///
+/// A file holds a sequence of tables after a header with a magic string
+/// and a byte order mark.  Each table is written as its name, its number
+/// of rows and of columns, then each column as its name, its type and
+/// its values packed in the byte order of the host, so that a column is
+/// read back with a single copy.  The strings are written as their
+/// length on 32 bits followed by their characters.
+class ColumnTable
+{
+public:
+  enum Type
+  {
+    UINT8 = 0,
+    UINT16,
+    UINT32,
+    UINT64,
+    INT64,
+    DOUBLE
+  };
+
+  ColumnTable ();
+  /// \param name the name of the table
+  ColumnTable (std::string name);
+
+  std::string GetName () const;
+
+  /// \param name the name of the column
+  /// \param type the type of the values of the column
+  /// \returns the index of the new column
+  uint32_t AddColumn (std::string name, enum Type type);
+
+  /// Append a value to an unsigned integer column
+  void AppendUnsigned (uint32_t column, uint64_t value);
+  /// Append a value to an INT64 column
+  void AppendSigned (uint32_t column, int64_t value);
+  /// Append a value to a DOUBLE column
+  void AppendDouble (uint32_t column, double value);
+
+  uint32_t GetNColumns () const;
+  /// \returns the number of values of the first column, which all the
+  /// columns should have
+  uint64_t GetNRows () const;
+  std::string GetColumnName (uint32_t column) const;
+  enum Type GetColumnType (uint32_t column) const;
+  /// \returns the index of the column, or GetNColumns () if there is
+  /// no such column
+  uint32_t FindColumn (std::string name) const;
+
+  uint64_t GetUnsigned (uint32_t column, uint64_t row) const;
+  int64_t GetSigned (uint32_t column, uint64_t row) const;
+  double GetDouble (uint32_t column, uint64_t row) const;
+  /// \returns a value of any column converted to a double
+  double GetValue (uint32_t column, uint64_t row) const;
+
+  /// Write a file made of the tables
+  static void WriteFile (std::ostream &os, const std::vector<ColumnTable> &tables);
+  /// Read the tables of a file
+  /// \returns false if the stream is not a file of tables written on a
+  /// host with the same byte order
+  static bool ReadFile (std::istream &is, std::vector<ColumnTable> &tables);
+
+private:
+  struct Column
+  {
+    std::string name;
+    enum Type type;
+    std::vector<uint8_t> data;
+  };
+
+  static uint32_t GetSize (enum Type type);
+  void Write (std::ostream &os) const;
+  bool Read (std::istream &is);
+
+  std::string m_name;
+  std::vector<Column> m_columns;
+};
+
+} // namespace ns3
+
+#endif /* COLUMN_TABLE_H */
@@ -32,6 +32,16 @@ FlowClassifier::~FlowClassifier ()
 {
 }
 
+void
+FlowClassifier::SerializeToTable (ColumnTable &table) const
+{
+}
+
+void
+FlowClassifier::MergeTable (const ColumnTable &table, std::map<FlowId, FlowId> &flowIds)
+{
+}
+
 FlowId
 FlowClassifier::GetNewFlowId ()
 {
@@ -23,9 +23,12 @@
 
 #include "ns3/simple-ref-count.h"
 #include <ostream>
+#include <map>
 
 namespace ns3 {
 
+class ColumnTable;
+
 typedef uint32_t FlowId;
 typedef uint32_t FlowPacketId;
 
@@ -53,6 +56,16 @@ public:
   virtual ~FlowClassifier ();
 
   virtual void SerializeToXmlStream (std::ostream &os, int indent) const = 0;
+  /// Fills a table of the binary output of FlowMonitor with the
+  /// identifiers of the flows; the table is left without columns, and
+  /// is not written, by classifiers which do not implement it
+  virtual void SerializeToTable (ColumnTable &table) const;
+  /// Adds the flows of a table written by SerializeToTable, such as the
+  /// table of the classifier of another MPI rank, and maps their
+  /// identifiers to the identifiers of the same flows here; the
+  /// identifiers are left unmapped by classifiers which do not
+  /// implement it
+  virtual void MergeTable (const ColumnTable &table, std::map<FlowId, FlowId> &flowIds);
 
 protected:
   FlowId GetNewFlowId ();
@@ -19,11 +19,15 @@
 //
 
 #include "flow-monitor.h"
+#include "column-table.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
@@ -71,6 +75,26 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of packets in flight which are tracked, "
+                                         "or 0 for no limit.  The packets beyond are ignored."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LogLinearBins", ("The number of bins of the default width of log-linear histograms, "
+                                     "a power of two, or 0 for linear histograms."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_logLinearBins),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("StreamFileName", ("The CSV file to write the changes of the flow counters to "
+                                      "periodically, with the times in nanoseconds, or empty to write nothing.  "
+                                      "The histograms are only in the final serialization."),
+                   StringValue (""),
+                   MakeStringAccessor (&FlowMonitor::m_streamFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("StreamInterval", ("The interval between two writes to the stream file."),
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&FlowMonitor::m_streamInterval),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -81,34 +105,59 @@ FlowMonitor::GetInstanceTypeId (void) const
   return GetTypeId ();
 }
 
+FlowMonitor::Shard::Shard ()
+  : nTrackedPackets (0),
+    nUntrackedPackets (0),
+    checkScheduled (false),
+    matched (NanoSeconds (-1))
+{
+}
+
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_distributed (false),
+    m_ranksReduced (false),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
 
 
+void
+FlowMonitor::InitFlowStats (FlowStats &stats) const
+{
+  stats.delaySum = Seconds (0);
+  stats.jitterSum = Seconds (0);
+  stats.lastDelay = Seconds (0);
+  stats.txBytes = 0;
+  stats.rxBytes = 0;
+  stats.txPackets = 0;
+  stats.rxPackets = 0;
+  stats.lostPackets = 0;
+  stats.timesForwarded = 0;
+  stats.untrackedTxPackets = 0;
+  stats.untrackedRxPackets = 0;
+  stats.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
+  stats.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
+  stats.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
+  stats.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+  if (m_logLinearBins > 0)
+    {
+      stats.delayHistogram.SetLogLinear (m_logLinearBins);
+      stats.jitterHistogram.SetLogLinear (m_logLinearBins);
+      stats.packetSizeHistogram.SetLogLinear (m_logLinearBins);
+      stats.flowInterruptionsHistogram.SetLogLinear (m_logLinearBins);
+    }
+}
+
 inline FlowMonitor::FlowStats&
-FlowMonitor::GetStatsForFlow (FlowId flowId)
+FlowMonitor::GetStatsForFlow (Shard &shard, FlowId flowId)
 {
   std::map<FlowId, FlowStats>::iterator iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
-    {
-      FlowMonitor::FlowStats &ref = m_flowStats[flowId];
-      ref.delaySum = Seconds (0);
-      ref.jitterSum = Seconds (0);
-      ref.lastDelay = Seconds (0);
-      ref.txBytes = 0;
-      ref.rxBytes = 0;
-      ref.txPackets = 0;
-      ref.rxPackets = 0;
-      ref.lostPackets = 0;
-      ref.timesForwarded = 0;
-      ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
-      ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
-      ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
-      ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+  iter = shard.flowStats.find (flowId);
+  if (iter == shard.flowStats.end ())
+    {
+      FlowMonitor::FlowStats &ref = shard.flowStats[flowId];
+      InitFlowStats (ref);
       return ref;
     }
   else
@@ -117,6 +166,207 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
     }
 }
 
+static void
+MergeHistogram (Histogram &histogram, const Histogram &other)
+{
+  for (uint32_t index = 0; index < other.GetNBins (); index++)
+    {
+      if (other.GetBinCount (index))
+        {
+          histogram.AddBinCount (index, other.GetBinCount (index));
+        }
+    }
+}
+
+void
+FlowMonitor::MergeFlowStats (FlowStats &stats, const FlowStats &other)
+{
+  if (other.txPackets > 0)
+    {
+      if (stats.txPackets == 0 || other.timeFirstTxPacket < stats.timeFirstTxPacket)
+        {
+          stats.timeFirstTxPacket = other.timeFirstTxPacket;
+        }
+      if (stats.txPackets == 0 || other.timeLastTxPacket > stats.timeLastTxPacket)
+        {
+          stats.timeLastTxPacket = other.timeLastTxPacket;
+        }
+    }
+  if (other.rxPackets > 0)
+    {
+      if (stats.rxPackets == 0 || other.timeFirstRxPacket < stats.timeFirstRxPacket)
+        {
+          stats.timeFirstRxPacket = other.timeFirstRxPacket;
+        }
+      if (stats.rxPackets == 0 || other.timeLastRxPacket > stats.timeLastRxPacket)
+        {
+          stats.timeLastRxPacket = other.timeLastRxPacket;
+          stats.lastDelay = other.lastDelay;
+        }
+    }
+  stats.delaySum += other.delaySum;
+  stats.jitterSum += other.jitterSum;
+  stats.txBytes += other.txBytes;
+  stats.rxBytes += other.rxBytes;
+  stats.txPackets += other.txPackets;
+  stats.rxPackets += other.rxPackets;
+  stats.lostPackets += other.lostPackets;
+  stats.timesForwarded += other.timesForwarded;
+  stats.untrackedTxPackets += other.untrackedTxPackets;
+  stats.untrackedRxPackets += other.untrackedRxPackets;
+  if (stats.packetsDropped.size () < other.packetsDropped.size ())
+    {
+      stats.packetsDropped.resize (other.packetsDropped.size (), 0);
+      stats.bytesDropped.resize (other.packetsDropped.size (), 0);
+    }
+  for (uint32_t reasonCode = 0; reasonCode < other.packetsDropped.size (); reasonCode++)
+    {
+      stats.packetsDropped[reasonCode] += other.packetsDropped[reasonCode];
+      if (reasonCode < other.bytesDropped.size ())
+        {
+          stats.bytesDropped[reasonCode] += other.bytesDropped[reasonCode];
+        }
+    }
+  MergeHistogram (stats.delayHistogram, other.delayHistogram);
+  MergeHistogram (stats.jitterHistogram, other.jitterHistogram);
+  MergeHistogram (stats.packetSizeHistogram, other.packetSizeHistogram);
+  MergeHistogram (stats.flowInterruptionsHistogram, other.flowInterruptionsHistogram);
+}
+
+uint32_t
+FlowMonitor::GetTrackedSlot (const Shard &shard, FlowId flowId, FlowPacketId packetId) const
+{
+  // Fibonacci hashing of the pair, keeping the high bits of the product
+  uint64_t key = (static_cast<uint64_t> (flowId) << 32) | packetId;
+  uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+  return static_cast<uint32_t> (hash >> 32) & (shard.trackedPackets.size () - 1);
+}
+
+uint32_t
+FlowMonitor::FindTrackedPacket (const Shard &shard, FlowId flowId, FlowPacketId packetId) const
+{
+  if (shard.trackedPackets.empty ())
+    {
+      return 0;
+    }
+  uint32_t mask = shard.trackedPackets.size () - 1;
+  for (uint32_t i = GetTrackedSlot (shard, flowId, packetId); shard.trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      if (shard.trackedPackets[i].flowId == flowId && shard.trackedPackets[i].packetId == packetId)
+        {
+          return i;
+        }
+    }
+  return shard.trackedPackets.size ();
+}
+
+FlowMonitor::TrackedPacket*
+FlowMonitor::AddTrackedPacket (Shard &shard, FlowId flowId, FlowPacketId packetId)
+{
+  uint32_t slot = FindTrackedPacket (shard, flowId, packetId);
+  if (slot < shard.trackedPackets.size ())
+    {
+      return &shard.trackedPackets[slot].packet;
+    }
+  if (m_maxTrackedPackets > 0 && shard.nTrackedPackets >= m_maxTrackedPackets)
+    {
+      shard.nUntrackedPackets++;
+      return 0;
+    }
+  // keep the table at most half full, so that the probes stay short
+  if (2 * (shard.nTrackedPackets + 1) > shard.trackedPackets.size ())
+    {
+      ResizeTrackedPackets (shard, std::max<uint32_t> (16, 2 * shard.trackedPackets.size ()));
+    }
+  uint32_t mask = shard.trackedPackets.size () - 1;
+  slot = GetTrackedSlot (shard, flowId, packetId);
+  while (shard.trackedPackets[slot].used)
+    {
+      slot = (slot + 1) & mask;
+    }
+  TrackedSlot &tracked = shard.trackedPackets[slot];
+  tracked.used = true;
+  tracked.flowId = flowId;
+  tracked.packetId = packetId;
+  shard.nTrackedPackets++;
+  return &tracked.packet;
+}
+
+void
+FlowMonitor::RemoveTrackedPacket (Shard &shard, uint32_t slot)
+{
+  // shift back the packets of the cluster which may take the free slot,
+  // so that no probe sequence is broken
+  uint32_t mask = shard.trackedPackets.size () - 1;
+  uint32_t next = slot;
+  while (true)
+    {
+      next = (next + 1) & mask;
+      if (!shard.trackedPackets[next].used)
+        {
+          break;
+        }
+      uint32_t home = GetTrackedSlot (shard, shard.trackedPackets[next].flowId, shard.trackedPackets[next].packetId);
+      if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+          shard.trackedPackets[slot] = shard.trackedPackets[next];
+          slot = next;
+        }
+    }
+  shard.trackedPackets[slot].used = false;
+  shard.nTrackedPackets--;
+}
+
+void
+FlowMonitor::ResizeTrackedPackets (Shard &shard, uint32_t nSlots)
+{
+  std::vector<TrackedSlot> old;
+  old.swap (shard.trackedPackets);
+  TrackedSlot empty;
+  empty.used = false;
+  empty.flowId = 0;
+  empty.packetId = 0;
+  empty.packet.timesForwarded = 0;
+  shard.trackedPackets.resize (nSlots, empty);
+  uint32_t mask = nSlots - 1;
+  for (std::vector<TrackedSlot>::const_iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (i->used)
+        {
+          uint32_t slot = GetTrackedSlot (shard, i->flowId, i->packetId);
+          while (shard.trackedPackets[slot].used)
+            {
+              slot = (slot + 1) & mask;
+            }
+          shard.trackedPackets[slot] = *i;
+        }
+    }
+}
+
+uint64_t
+FlowMonitor::GetNUntrackedPackets () const
+{
+  uint64_t nUntrackedPackets = 0;
+  for (std::vector<Shard>::const_iterator shard = m_shards.begin (); shard != m_shards.end (); shard++)
+    {
+      nUntrackedPackets += shard->nUntrackedPackets;
+    }
+  return nUntrackedPackets;
+}
+
+void
+FlowMonitor::AddForeignReport (Shard &shard, Ptr<FlowProbe> probe, FlowId flowId, FlowPacketId packetId,
+                               uint32_t packetSize, uint8_t kind)
+{
+  ForeignReport report;
+  report.time = Simulator::Now ();
+  report.probe = probe;
+  report.flowId = flowId;
+  report.packetId = packetId;
+  report.packetSize = packetSize;
+  report.kind = kind;
+  shard.foreignReports.push_back (report);
+}
 
 void
 FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
@@ -125,19 +375,32 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
     {
       return;
     }
+  Shard &shard = m_shards[probe->GetShard ()];
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
+  TrackedPacket *tracked = AddTrackedPacket (shard, flowId, packetId);
+  if (tracked != 0)
+    {
+      tracked->firstSeenTime = now;
+      tracked->lastSeenTime = tracked->firstSeenTime;
+      tracked->timesForwarded = 0;
+    }
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowStats &stats = GetStatsForFlow (shard, flowId);
   stats.txBytes += packetSize;
   stats.txPackets++;
+  if (tracked == 0)
+    {
+      stats.untrackedTxPackets++;
+      if (m_shards.size () > 1)
+        {
+          // another shard may receive it
+          shard.untrackedPackets[flowId]++;
+        }
+    }
   if (stats.txPackets == 1)
     {
       stats.timeFirstTxPacket = now;
@@ -153,46 +416,36 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  Shard &shard = m_shards[probe->GetShard ()];
+  uint32_t slot = FindTrackedPacket (shard, flowId, packetId);
+  if (slot == shard.trackedPackets.size ())
     {
+      if (m_shards.size () > 1)
+        {
+          // the packet may come from another shard
+          AddForeignReport (shard, probe, flowId, packetId, packetSize, REPORT_FORWARD);
+          return;
+        }
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
+  TrackedPacket *tracked = &shard.trackedPackets[slot].packet;
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->timesForwarded++;
+  tracked->lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
 
 void
-FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
+FlowMonitor::RecordRx (FlowStats &stats, Time now, Time delay, uint32_t packetSize, uint32_t timesForwarded)
 {
-  if (!m_enabled)
-    {
-      return;
-    }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
-    {
-      NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
-                                                             << ") but not known to be transmitted.");
-      return;
-    }
-
-  Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
-  probe->AddPacketStats (flowId, packetSize, delay);
-
-  FlowStats &stats = GetStatsForFlow (flowId);
   stats.delaySum += delay;
   stats.delayHistogram.AddValue (delay.GetSeconds ());
-  if (stats.rxPackets > 0 )
+  if (stats.rxPackets > stats.untrackedRxPackets)
     {
       Time jitter = stats.lastDelay - delay;
       if (jitter > Seconds (0))
@@ -225,12 +478,82 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += timesForwarded;
+}
+
+void
+FlowMonitor::RecordUntrackedRx (FlowStats &stats, Time now, uint32_t packetSize)
+{
+  // the delay of the packet is unknown, only count it
+  stats.rxBytes += packetSize;
+  stats.packetSizeHistogram.AddValue ((double) packetSize);
+  stats.rxPackets++;
+  stats.untrackedRxPackets++;
+  if (stats.rxPackets == 1)
+    {
+      stats.timeFirstRxPacket = now;
+    }
+  else if (now - stats.timeLastRxPacket > m_flowInterruptionsMinTime)
+    {
+      stats.flowInterruptionsHistogram.AddValue ((now - stats.timeLastRxPacket).GetSeconds ());
+    }
+  stats.timeLastRxPacket = now;
+}
+
+void
+FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  Shard &shard = m_shards[probe->GetShard ()];
+  uint32_t slot = FindTrackedPacket (shard, flowId, packetId);
+  if (slot == shard.trackedPackets.size ())
+    {
+      if (m_shards.size () > 1)
+        {
+          AddForeignReport (shard, probe, flowId, packetId, packetSize, REPORT_LAST_RX);
+          return;
+        }
+      std::map<FlowId, FlowStats>::iterator flow = shard.flowStats.find (flowId);
+      if (flow != shard.flowStats.end ()
+          && flow->second.untrackedRxPackets < flow->second.untrackedTxPackets)
+        {
+          // the packet was sent while the tracking limit was reached
+          RecordUntrackedRx (flow->second, Simulator::Now (), packetSize);
+          return;
+        }
+      NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
+                                                             << ") but not known to be transmitted.");
+      return;
+    }
+  TrackedPacket *tracked = &shard.trackedPackets[slot].packet;
+
+  Time now = Simulator::Now ();
+  Time delay = (now - tracked->firstSeenTime);
+  probe->AddPacketStats (flowId, packetSize, delay);
+
+  RecordRx (GetStatsForFlow (shard, flowId), now, delay, packetSize, tracked->timesForwarded);
+
+  if (m_shards.size () > 1)
+    {
+      // the packet may have been forwarded by another shard too
+      SentPacket sent;
+      sent.shard = probe->GetShard ();
+      sent.flowId = flowId;
+      sent.packetId = packetId;
+      sent.packet = *tracked;
+      sent.packet.lastSeenTime = now;
+      sent.packet.timesForwarded = 0;
+      sent.received = true;
+      shard.sentPackets.push_back (sent);
+    }
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (shard, slot); // we don't need to track this packet anymore
 }
 
 void
@@ -241,10 +564,11 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
     {
       return;
     }
+  Shard &shard = m_shards[probe->GetShard ()];
 
   probe->AddPacketDropStats (flowId, packetSize, reasonCode);
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowStats &stats = GetStatsForFlow (shard, flowId);
   stats.lostPackets++;
   if (stats.packetsDropped.size () < reasonCode + 1)
     {
@@ -255,48 +579,331 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  uint32_t slot = FindTrackedPacket (shard, flowId, packetId);
+  if (slot != shard.trackedPackets.size ())
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (shard, slot);
+    }
+  else if (m_shards.size () > 1)
+    {
+      AddForeignReport (shard, probe, flowId, packetId, packetSize, REPORT_DROP);
     }
 }
 
 std::map<FlowId, FlowMonitor::FlowStats>
 FlowMonitor::GetFlowStats () const
 {
-  return m_flowStats;
+  if (m_shards.size () == 1)
+    {
+      return m_shards[0].flowStats;
+    }
+  std::map<FlowId, FlowStats> flowStats;
+  for (std::vector<Shard>::const_iterator shard = m_shards.begin (); shard != m_shards.end (); shard++)
+    {
+      for (std::map<FlowId, FlowStats>::const_iterator flowI = shard->flowStats.begin ();
+           flowI != shard->flowStats.end (); flowI++)
+        {
+          std::map<FlowId, FlowStats>::iterator merged = flowStats.find (flowI->first);
+          if (merged == flowStats.end ())
+            {
+              flowStats.insert (*flowI);
+            }
+          else
+            {
+              MergeFlowStats (merged->second, flowI->second);
+            }
+        }
+    }
+  return flowStats;
 }
 
 
 void
-FlowMonitor::CheckForLostPackets (Time maxDelay)
+FlowMonitor::ExpireTrackedPackets (Shard &shard, Time maxDelay, bool lost)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  for (uint32_t slot = 0; slot < shard.trackedPackets.size (); )
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      const TrackedSlot &tracked = shard.trackedPackets[slot];
+      if (tracked.used && now - tracked.packet.lastSeenTime >= maxDelay)
+        {
+          if (lost)
+            {
+              // packet is considered lost, add it to the loss statistics
+              std::map<FlowId, FlowStats>::iterator
+                flow = shard.flowStats.find (tracked.flowId);
+              NS_ASSERT (flow != shard.flowStats.end ());
+              flow->second.lostPackets++;
+            }
+          else
+            {
+              // another shard may still report it
+              SentPacket sent;
+              sent.shard = &shard - &m_shards[0];
+              sent.flowId = tracked.flowId;
+              sent.packetId = tracked.packetId;
+              sent.packet = tracked.packet;
+              sent.received = false;
+              shard.sentPackets.push_back (sent);
+            }
+
+          // we won't track it anymore, and another packet may take its
+          // slot
+          RemoveTrackedPacket (shard, slot);
+        }
+      else
         {
-          // packet is considered lost, add it to the loss statistics
-          std::map<FlowId, FlowStats>::iterator
-            flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
+          slot++;
+        }
+    }
+}
+
+bool
+FlowMonitor::IsComplete () const
+{
+  return m_ranksReduced || !m_distributed;
+}
 
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
+bool
+FlowMonitor::SentBefore (const SentPacket &a, const SentPacket &b)
+{
+  if (a.flowId != b.flowId)
+    {
+      return a.flowId < b.flowId;
+    }
+  if (a.packetId != b.packetId)
+    {
+      return a.packetId < b.packetId;
+    }
+  return a.packet.firstSeenTime < b.packet.firstSeenTime;
+}
+
+bool
+FlowMonitor::ReportBefore (const ForeignReport &a, const ForeignReport &b)
+{
+  return a.time < b.time;
+}
+
+void
+FlowMonitor::PublishShard (uint32_t shard)
+{
+  Shard &state = m_shards[shard];
+  std::vector<SentPacket>::difference_type nSent = m_sentPackets.size ();
+  m_sentPackets.insert (m_sentPackets.end (), state.sentPackets.begin (), state.sentPackets.end ());
+  state.sentPackets.clear ();
+  std::sort (m_sentPackets.begin () + nSent, m_sentPackets.end (), SentBefore);
+  std::inplace_merge (m_sentPackets.begin (), m_sentPackets.begin () + nSent, m_sentPackets.end (), SentBefore);
+  m_foreignReports.insert (m_foreignReports.end (), state.foreignReports.begin (), state.foreignReports.end ());
+  state.foreignReports.clear ();
+  for (std::map<FlowId, uint32_t>::const_iterator flow = state.untrackedPackets.begin ();
+       flow != state.untrackedPackets.end (); flow++)
+    {
+      m_untrackedPackets[flow->first] += flow->second;
+    }
+  state.untrackedPackets.clear ();
+  state.published = Simulator::Now ();
+}
+
+void
+FlowMonitor::MatchReports (uint32_t shard, Time until, bool resolve)
+{
+  bool all = shard == m_shards.size ();
+  std::vector<ForeignReport> due;
+  std::vector<ForeignReport> kept;
+  for (std::vector<ForeignReport>::const_iterator report = m_foreignReports.begin ();
+       report != m_foreignReports.end (); report++)
+    {
+      if ((all || report->probe->GetShard () == shard) && report->time <= until)
+        {
+          due.push_back (*report);
         }
       else
         {
-          iter++;
+          kept.push_back (*report);
+        }
+    }
+  std::stable_sort (due.begin (), due.end (), ReportBefore);
+
+  for (std::vector<ForeignReport>::const_iterator report = due.begin (); report != due.end (); report++)
+    {
+      // the last packet of the flow with this identifier sent before the
+      // report, since the identifiers wrap around
+      SentPacket key;
+      key.flowId = report->flowId;
+      key.packetId = report->packetId;
+      key.packet.firstSeenTime = report->time;
+      std::vector<SentPacket>::iterator sent =
+        std::upper_bound (m_sentPackets.begin (), m_sentPackets.end (), key, SentBefore);
+      if (sent == m_sentPackets.begin ()
+          || (sent - 1)->flowId != report->flowId || (sent - 1)->packetId != report->packetId)
+        {
+          std::map<FlowId, uint32_t>::iterator untracked = m_untrackedPackets.find (report->flowId);
+          if (!resolve)
+            {
+              kept.push_back (*report);
+            }
+          else if (report->kind == REPORT_LAST_RX && untracked != m_untrackedPackets.end () && untracked->second > 0)
+            {
+              // the packet was sent while the tracking limit was reached
+              untracked->second--;
+              RecordUntrackedRx (GetStatsForFlow (m_shards[report->probe->GetShard ()], report->flowId),
+                                 report->time, report->packetSize);
+            }
+          continue;
+        }
+      sent--;
+      Time delay = report->time - sent->packet.firstSeenTime;
+      switch (report->kind)
+        {
+        case REPORT_FORWARD:
+          sent->packet.timesForwarded++;
+          if (report->time > sent->packet.lastSeenTime)
+            {
+              sent->packet.lastSeenTime = report->time;
+            }
+          report->probe->AddPacketStats (report->flowId, report->packetSize, delay);
+          break;
+        case REPORT_LAST_RX:
+          if (!sent->received)
+            {
+              report->probe->AddPacketStats (report->flowId, report->packetSize, delay);
+              RecordRx (GetStatsForFlow (m_shards[report->probe->GetShard ()], report->flowId),
+                        report->time, delay, report->packetSize, sent->packet.timesForwarded);
+              sent->packet.timesForwarded = 0;
+              sent->packet.lastSeenTime = report->time;
+              sent->received = true;
+            }
+          break;
+        case REPORT_DROP:
+          if (!sent->received)
+            {
+              sent->packet.timesForwarded = 0;
+              sent->packet.lastSeenTime = report->time;
+              sent->received = true;
+            }
+          break;
+        }
+    }
+  m_foreignReports.swap (kept);
+}
+
+void
+FlowMonitor::ReleaseSentPackets (uint32_t shard, Time until, Time maxDelay)
+{
+  bool all = shard == m_shards.size ();
+  std::vector<SentPacket>::iterator end = m_sentPackets.begin ();
+  for (std::vector<SentPacket>::const_iterator sent = m_sentPackets.begin ();
+       sent != m_sentPackets.end (); sent++)
+    {
+      if (all || sent->shard == shard)
+        {
+          // the forwards are reported before the reception
+          if (sent->received && sent->packet.lastSeenTime <= until)
+            {
+              GetStatsForFlow (m_shards[sent->shard], sent->flowId).timesForwarded += sent->packet.timesForwarded;
+              continue;
+            }
+          if (!sent->received && sent->packet.lastSeenTime + maxDelay <= until)
+            {
+              GetStatsForFlow (m_shards[sent->shard], sent->flowId).lostPackets++;
+              continue;
+            }
+        }
+      *end = *sent;
+      end++;
+    }
+  m_sentPackets.erase (end, m_sentPackets.end ());
+}
+
+void
+FlowMonitor::MatchShard (uint32_t shard)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_mutex);
+#endif
+  PublishShard (shard);
+  if (!IsComplete ())
+    {
+      // the other ranks may report on any packet
+      return;
+    }
+  // a shard publishes a packet at most a check interval after it leaves
+  // its tracked packets, which is at most MaxPerHopDelay after a report
+  // of another shard on it: the older reports have all their packets
+  Time published = m_shards[shard].published;
+  for (uint32_t i = 0; i < m_shards.size (); i++)
+    {
+      if (i == 0 || m_shards[i].checkScheduled)
+        {
+          published = std::min (published, m_shards[i].published);
+        }
+    }
+  Time until = published - m_maxPerHopDelay - PERIODIC_CHECK_INTERVAL - PERIODIC_CHECK_INTERVAL;
+  MatchReports (shard, until, true);
+  m_shards[shard].matched = until;
+
+  Time matched = until;
+  for (uint32_t i = 0; i < m_shards.size (); i++)
+    {
+      if (i == 0 || m_shards[i].checkScheduled)
+        {
+          matched = std::min (matched, m_shards[i].matched);
         }
     }
+  ReleaseSentPackets (shard, matched, m_maxPerHopDelay);
+}
+
+void
+FlowMonitor::MatchForeignReports (Time maxDelay)
+{
+  for (uint32_t shard = 0; shard < m_shards.size (); shard++)
+    {
+      // nothing is tracked anymore: the reports to come are matched later
+      ExpireTrackedPackets (m_shards[shard], Seconds (0), false);
+      PublishShard (shard);
+    }
+  // the merged states of other ranks are not sorted
+  std::sort (m_sentPackets.begin (), m_sentPackets.end (), SentBefore);
+
+  bool complete = IsComplete ();
+  if (complete)
+    {
+      // the untracked packets of every flow not yet received, counting
+      // those of the merged ranks
+      m_untrackedPackets.clear ();
+      for (std::vector<Shard>::const_iterator shard = m_shards.begin (); shard != m_shards.end (); shard++)
+        {
+          for (std::map<FlowId, FlowStats>::const_iterator flow = shard->flowStats.begin ();
+               flow != shard->flowStats.end (); flow++)
+            {
+              m_untrackedPackets[flow->first] += flow->second.untrackedTxPackets - flow->second.untrackedRxPackets;
+            }
+        }
+    }
+  Time now = Simulator::Now ();
+  MatchReports (m_shards.size (), now, complete);
+  if (complete)
+    {
+      ReleaseSentPackets (m_shards.size (), now, maxDelay);
+    }
+}
+
+void
+FlowMonitor::CheckForLostPackets (Time maxDelay)
+{
+  if (m_shards.size () > 1)
+    {
+      MatchForeignReports (maxDelay);
+    }
+  else if (m_shards.size () == 1)
+    {
+      ExpireTrackedPackets (m_shards[0], maxDelay, true);
+    }
 }
 
 void
@@ -306,23 +913,139 @@ FlowMonitor::CheckForLostPackets ()
 }
 
 void
-FlowMonitor::PeriodicCheckForLostPackets ()
+FlowMonitor::PeriodicCheckForLostPackets (uint32_t shard)
 {
-  CheckForLostPackets ();
-  Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
+  if (m_shards.size () == 1)
+    {
+      CheckForLostPackets ();
+    }
+  else if (shard < m_shards.size ())
+    {
+      // only the partition of the shard may touch it while running, and
+      // the packets and reports published by the shards are locked
+      ExpireTrackedPackets (m_shards[shard], m_maxPerHopDelay, false);
+      MatchShard (shard);
+    }
+  Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this, shard);
+}
+
+void
+FlowMonitor::FlushStream ()
+{
+  if (!m_stream.is_open ())
+    {
+      return;
+    }
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  std::map<FlowId, FlowStats> flowStats = GetFlowStats ();
+  for (std::map<FlowId, FlowStats>::const_iterator flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
+    {
+      const FlowStats &stats = flowI->second;
+      StreamedStats &streamed = m_streamedStats[flowI->first];
+      if (stats.txPackets == streamed.txPackets && stats.rxPackets == streamed.rxPackets
+          && stats.lostPackets == streamed.lostPackets)
+        {
+          continue;
+        }
+      m_stream << now << "," << flowI->first
+               << "," << stats.txPackets - streamed.txPackets
+               << "," << stats.txBytes - streamed.txBytes
+               << "," << stats.rxPackets - streamed.rxPackets
+               << "," << stats.rxBytes - streamed.rxBytes
+               << "," << stats.lostPackets - streamed.lostPackets
+               << "," << stats.timesForwarded - streamed.timesForwarded
+               << "," << (stats.delaySum - streamed.delaySum).GetNanoSeconds ()
+               << "," << (stats.jitterSum - streamed.jitterSum).GetNanoSeconds ()
+               << ",";
+      // the drops of every reason code, separated by semicolons
+      streamed.packetsDropped.resize (stats.packetsDropped.size (), 0);
+      streamed.bytesDropped.resize (stats.bytesDropped.size (), 0);
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          m_stream << (reasonCode > 0 ? ";" : "")
+                   << stats.packetsDropped[reasonCode] - streamed.packetsDropped[reasonCode];
+        }
+      m_stream << ",";
+      for (uint32_t reasonCode = 0; reasonCode < stats.bytesDropped.size (); reasonCode++)
+        {
+          m_stream << (reasonCode > 0 ? ";" : "")
+                   << stats.bytesDropped[reasonCode] - streamed.bytesDropped[reasonCode];
+        }
+      m_stream << "\n";
+      streamed.delaySum = stats.delaySum;
+      streamed.jitterSum = stats.jitterSum;
+      streamed.txBytes = stats.txBytes;
+      streamed.rxBytes = stats.rxBytes;
+      streamed.txPackets = stats.txPackets;
+      streamed.rxPackets = stats.rxPackets;
+      streamed.lostPackets = stats.lostPackets;
+      streamed.timesForwarded = stats.timesForwarded;
+      streamed.packetsDropped = stats.packetsDropped;
+      streamed.bytesDropped = stats.bytesDropped;
+    }
+  m_stream.flush ();
+}
+
+void
+FlowMonitor::PeriodicFlushStream ()
+{
+  FlushStream ();
+  Simulator::Schedule (m_streamInterval, &FlowMonitor::PeriodicFlushStream, this);
 }
 
 void
 FlowMonitor::NotifyConstructionCompleted ()
 {
   Object::NotifyConstructionCompleted ();
-  Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
+  Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this, 0);
+  if (!m_streamFileName.empty ())
+    {
+      m_stream.open (m_streamFileName.c_str (), std::ios::out);
+      if (!m_stream.is_open ())
+        {
+          NS_FATAL_ERROR ("Cannot open the flow monitor stream file " << m_streamFileName);
+        }
+      m_stream << "time,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,timesForwarded,delaySum,jitterSum,"
+                  "packetsDropped,bytesDropped\n";
+      Simulator::Schedule (m_streamInterval, &FlowMonitor::PeriodicFlushStream, this);
+    }
+}
+
+void
+FlowMonitor::DoDispose ()
+{
+  if (m_stream.is_open ())
+    {
+      m_stream.close ();
+    }
+  Object::DoDispose ();
 }
 
 void
 FlowMonitor::AddProbe (Ptr<FlowProbe> probe)
 {
   m_flowProbes.push_back (probe);
+  uint32_t shard = probe->GetShard ();
+  if (shard > 0 && m_stream.is_open ())
+    {
+      // the partitions update their shards concurrently, which are only
+      // merged after the run
+      NS_FATAL_ERROR ("The flow monitor can't stream the statistics of the nodes of several system ids, "
+                      "leave StreamFileName empty in parallel simulations");
+    }
+  if (m_shards.size () <= shard)
+    {
+      m_shards.resize (shard + 1);
+    }
+  // the shard 0 is checked from the construction of the monitor, and the
+  // others in the partition of their first probe
+  if (shard > 0 && !m_shards[shard].checkScheduled)
+    {
+      m_shards[shard].checkScheduled = true;
+      Simulator::ScheduleWithContext (probe->GetContext (), PERIODIC_CHECK_INTERVAL,
+                                      &FlowMonitor::PeriodicCheckForLostPackets, this, shard);
+    }
 }
 
 std::vector< Ptr<FlowProbe> >
@@ -374,7 +1097,11 @@ FlowMonitor::StopRightNow ()
       return;
     }
   m_enabled = false;
-  CheckForLostPackets ();
+  // the shards of a parallel run are only checked after it
+  if (m_shards.size () <= 1)
+    {
+      CheckForLostPackets ();
+    }
 }
 
 void
@@ -392,8 +1119,9 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, int indent, bool enableHist
   indent += 2;
   INDENT (indent); os << "<FlowStats>\n";
   indent += 2;
-  for (std::map<FlowId, FlowStats>::const_iterator flowI = m_flowStats.begin ();
-       flowI != m_flowStats.end (); flowI++)
+  std::map<FlowId, FlowStats> flowStats = GetFlowStats ();
+  for (std::map<FlowId, FlowStats>::const_iterator flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
     {
 
       INDENT (indent);
@@ -412,6 +1140,8 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, int indent, bool enableHist
       ATTRIB (rxPackets)
       ATTRIB (lostPackets)
       ATTRIB (timesForwarded)
+      ATTRIB (untrackedTxPackets)
+      ATTRIB (untrackedRxPackets)
       << ">\n";
 #undef ATTRIB
 
@@ -482,6 +1212,431 @@ FlowMonitor::SerializeToXmlFile (std::string fileName, bool enableHistograms, bo
   os.close ();
 }
 
+static void
+AppendHistogram (ColumnTable &table, FlowId flowId, uint32_t histogram, const Histogram &h)
+{
+  for (uint32_t index = 0; index < h.GetNBins (); index++)
+    {
+      if (h.GetBinCount (index))
+        {
+          table.AppendUnsigned (0, flowId);
+          table.AppendUnsigned (1, histogram);
+          table.AppendDouble (2, h.GetBinStart (index));
+          table.AppendDouble (3, h.GetBinWidth (index));
+          table.AppendUnsigned (4, h.GetBinCount (index));
+        }
+    }
+}
+
+void
+FlowMonitor::AppendResultTables (std::vector<ColumnTable> &tables, bool enableHistograms, bool enableProbes)
+{
+  ColumnTable flows ("FlowStats");
+  uint32_t flowId = flows.AddColumn ("flowId", ColumnTable::UINT32);
+  uint32_t timeFirstTxPacket = flows.AddColumn ("timeFirstTxPacket", ColumnTable::INT64);
+  uint32_t timeFirstRxPacket = flows.AddColumn ("timeFirstRxPacket", ColumnTable::INT64);
+  uint32_t timeLastTxPacket = flows.AddColumn ("timeLastTxPacket", ColumnTable::INT64);
+  uint32_t timeLastRxPacket = flows.AddColumn ("timeLastRxPacket", ColumnTable::INT64);
+  uint32_t delaySum = flows.AddColumn ("delaySum", ColumnTable::INT64);
+  uint32_t jitterSum = flows.AddColumn ("jitterSum", ColumnTable::INT64);
+  uint32_t lastDelay = flows.AddColumn ("lastDelay", ColumnTable::INT64);
+  uint32_t txBytes = flows.AddColumn ("txBytes", ColumnTable::UINT64);
+  uint32_t rxBytes = flows.AddColumn ("rxBytes", ColumnTable::UINT64);
+  uint32_t txPackets = flows.AddColumn ("txPackets", ColumnTable::UINT32);
+  uint32_t rxPackets = flows.AddColumn ("rxPackets", ColumnTable::UINT32);
+  uint32_t lostPackets = flows.AddColumn ("lostPackets", ColumnTable::UINT32);
+  uint32_t timesForwarded = flows.AddColumn ("timesForwarded", ColumnTable::UINT32);
+  uint32_t untrackedTxPackets = flows.AddColumn ("untrackedTxPackets", ColumnTable::UINT32);
+  uint32_t untrackedRxPackets = flows.AddColumn ("untrackedRxPackets", ColumnTable::UINT32);
+  ColumnTable drops ("packetsDropped");
+  drops.AddColumn ("flowId", ColumnTable::UINT32);
+  drops.AddColumn ("reasonCode", ColumnTable::UINT32);
+  drops.AddColumn ("packets", ColumnTable::UINT32);
+  drops.AddColumn ("bytes", ColumnTable::UINT64);
+  ColumnTable histograms ("histograms");
+  histograms.AddColumn ("flowId", ColumnTable::UINT32);
+  // 0 for delay, 1 for jitter, 2 for packet size, 3 for flow interruptions
+  histograms.AddColumn ("histogram", ColumnTable::UINT8);
+  histograms.AddColumn ("start", ColumnTable::DOUBLE);
+  histograms.AddColumn ("width", ColumnTable::DOUBLE);
+  histograms.AddColumn ("count", ColumnTable::UINT32);
+
+  std::map<FlowId, FlowStats> flowStats = GetFlowStats ();
+  for (std::map<FlowId, FlowStats>::const_iterator flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
+    {
+      const FlowStats &stats = flowI->second;
+      flows.AppendUnsigned (flowId, flowI->first);
+      flows.AppendSigned (timeFirstTxPacket, stats.timeFirstTxPacket.GetNanoSeconds ());
+      flows.AppendSigned (timeFirstRxPacket, stats.timeFirstRxPacket.GetNanoSeconds ());
+      flows.AppendSigned (timeLastTxPacket, stats.timeLastTxPacket.GetNanoSeconds ());
+      flows.AppendSigned (timeLastRxPacket, stats.timeLastRxPacket.GetNanoSeconds ());
+      flows.AppendSigned (delaySum, stats.delaySum.GetNanoSeconds ());
+      flows.AppendSigned (jitterSum, stats.jitterSum.GetNanoSeconds ());
+      flows.AppendSigned (lastDelay, stats.lastDelay.GetNanoSeconds ());
+      flows.AppendUnsigned (txBytes, stats.txBytes);
+      flows.AppendUnsigned (rxBytes, stats.rxBytes);
+      flows.AppendUnsigned (txPackets, stats.txPackets);
+      flows.AppendUnsigned (rxPackets, stats.rxPackets);
+      flows.AppendUnsigned (lostPackets, stats.lostPackets);
+      flows.AppendUnsigned (timesForwarded, stats.timesForwarded);
+      flows.AppendUnsigned (untrackedTxPackets, stats.untrackedTxPackets);
+      flows.AppendUnsigned (untrackedRxPackets, stats.untrackedRxPackets);
+
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          drops.AppendUnsigned (0, flowI->first);
+          drops.AppendUnsigned (1, reasonCode);
+          drops.AppendUnsigned (2, stats.packetsDropped[reasonCode]);
+          drops.AppendUnsigned (3, reasonCode < stats.bytesDropped.size () ? stats.bytesDropped[reasonCode] : 0);
+        }
+      if (enableHistograms)
+        {
+          AppendHistogram (histograms, flowI->first, 0, stats.delayHistogram);
+          AppendHistogram (histograms, flowI->first, 1, stats.jitterHistogram);
+          AppendHistogram (histograms, flowI->first, 2, stats.packetSizeHistogram);
+          AppendHistogram (histograms, flowI->first, 3, stats.flowInterruptionsHistogram);
+        }
+    }
+  tables.push_back (flows);
+  tables.push_back (drops);
+
+  if (m_classifier)
+    {
+      ColumnTable classifier;
+      m_classifier->SerializeToTable (classifier);
+      if (classifier.GetNColumns () > 0)
+        {
+          tables.push_back (classifier);
+        }
+    }
+
+  if (enableHistograms)
+    {
+      tables.push_back (histograms);
+    }
+
+  if (enableProbes)
+    {
+      ColumnTable probes ("FlowProbes");
+      probes.AddColumn ("probe", ColumnTable::UINT32);
+      probes.AddColumn ("flowId", ColumnTable::UINT32);
+      probes.AddColumn ("packets", ColumnTable::UINT32);
+      probes.AddColumn ("bytes", ColumnTable::UINT64);
+      probes.AddColumn ("delayFromFirstProbeSum", ColumnTable::INT64);
+      ColumnTable probeDrops ("probePacketsDropped");
+      probeDrops.AddColumn ("probe", ColumnTable::UINT32);
+      probeDrops.AddColumn ("flowId", ColumnTable::UINT32);
+      probeDrops.AddColumn ("reasonCode", ColumnTable::UINT32);
+      probeDrops.AddColumn ("packets", ColumnTable::UINT32);
+      probeDrops.AddColumn ("bytes", ColumnTable::UINT64);
+      for (uint32_t i = 0; i < m_flowProbes.size (); i++)
+        {
+          FlowProbe::Stats stats = m_flowProbes[i]->GetStats ();
+          for (FlowProbe::Stats::const_iterator iter = stats.begin (); iter != stats.end (); iter++)
+            {
+              probes.AppendUnsigned (0, i);
+              probes.AppendUnsigned (1, iter->first);
+              probes.AppendUnsigned (2, iter->second.packets);
+              probes.AppendUnsigned (3, iter->second.bytes);
+              probes.AppendSigned (4, iter->second.delayFromFirstProbeSum.GetNanoSeconds ());
+              for (uint32_t reasonCode = 0; reasonCode < iter->second.packetsDropped.size (); reasonCode++)
+                {
+                  probeDrops.AppendUnsigned (0, i);
+                  probeDrops.AppendUnsigned (1, iter->first);
+                  probeDrops.AppendUnsigned (2, reasonCode);
+                  probeDrops.AppendUnsigned (3, iter->second.packetsDropped[reasonCode]);
+                  probeDrops.AppendUnsigned (4, reasonCode < iter->second.bytesDropped.size () ?
+                                             iter->second.bytesDropped[reasonCode] : 0);
+                }
+            }
+        }
+      tables.push_back (probes);
+      tables.push_back (probeDrops);
+    }
+}
+
+void
+FlowMonitor::SerializeToBinaryStream (std::ostream &os, bool enableHistograms, bool enableProbes)
+{
+  CheckForLostPackets ();
+
+  std::vector<ColumnTable> tables;
+  AppendResultTables (tables, enableHistograms, enableProbes);
+  ColumnTable::WriteFile (os, tables);
+}
+
+
+void
+FlowMonitor::SerializeToBinaryFile (std::string fileName, bool enableHistograms, bool enableProbes)
+{
+  std::ofstream os (fileName.c_str (), std::ios::out|std::ios::binary);
+  SerializeToBinaryStream (os, enableHistograms, enableProbes);
+  os.close ();
+}
+
+
+void
+FlowMonitor::SerializeState (std::ostream &os)
+{
+  // the packets still tracked by the shards are written with those kept
+  // for the reports of other shards, none being counted as lost yet
+  std::vector<SentPacket> sentPackets (m_sentPackets);
+  std::vector<ForeignReport> foreignReports (m_foreignReports);
+  for (uint32_t shard = 0; shard < m_shards.size (); shard++)
+    {
+      const Shard &state = m_shards[shard];
+      for (std::vector<TrackedSlot>::const_iterator tracked = state.trackedPackets.begin ();
+           tracked != state.trackedPackets.end (); tracked++)
+        {
+          if (tracked->used)
+            {
+              SentPacket sent;
+              sent.shard = shard;
+              sent.flowId = tracked->flowId;
+              sent.packetId = tracked->packetId;
+              sent.packet = tracked->packet;
+              sent.received = false;
+              sentPackets.push_back (sent);
+            }
+        }
+      sentPackets.insert (sentPackets.end (), state.sentPackets.begin (), state.sentPackets.end ());
+      foreignReports.insert (foreignReports.end (), state.foreignReports.begin (), state.foreignReports.end ());
+    }
+
+  std::vector<ColumnTable> tables;
+  AppendResultTables (tables, true, true);
+
+  ColumnTable sent ("sentPackets");
+  sent.AddColumn ("flowId", ColumnTable::UINT32);
+  sent.AddColumn ("packetId", ColumnTable::UINT32);
+  sent.AddColumn ("firstSeenTime", ColumnTable::INT64);
+  sent.AddColumn ("lastSeenTime", ColumnTable::INT64);
+  sent.AddColumn ("timesForwarded", ColumnTable::UINT32);
+  sent.AddColumn ("received", ColumnTable::UINT8);
+  for (std::vector<SentPacket>::const_iterator i = sentPackets.begin (); i != sentPackets.end (); i++)
+    {
+      sent.AppendUnsigned (0, i->flowId);
+      sent.AppendUnsigned (1, i->packetId);
+      sent.AppendSigned (2, i->packet.firstSeenTime.GetNanoSeconds ());
+      sent.AppendSigned (3, i->packet.lastSeenTime.GetNanoSeconds ());
+      sent.AppendUnsigned (4, i->packet.timesForwarded);
+      sent.AppendUnsigned (5, i->received);
+    }
+  tables.push_back (sent);
+
+  std::map<Ptr<FlowProbe>, uint32_t> probeIndices;
+  for (uint32_t i = 0; i < m_flowProbes.size (); i++)
+    {
+      probeIndices[m_flowProbes[i]] = i;
+    }
+  ColumnTable reports ("foreignReports");
+  reports.AddColumn ("time", ColumnTable::INT64);
+  reports.AddColumn ("probe", ColumnTable::UINT32);
+  reports.AddColumn ("flowId", ColumnTable::UINT32);
+  reports.AddColumn ("packetId", ColumnTable::UINT32);
+  reports.AddColumn ("packetSize", ColumnTable::UINT32);
+  reports.AddColumn ("kind", ColumnTable::UINT8);
+  for (std::vector<ForeignReport>::const_iterator report = foreignReports.begin ();
+       report != foreignReports.end (); report++)
+    {
+      reports.AppendSigned (0, report->time.GetNanoSeconds ());
+      reports.AppendUnsigned (1, probeIndices[report->probe]);
+      reports.AppendUnsigned (2, report->flowId);
+      reports.AppendUnsigned (3, report->packetId);
+      reports.AppendUnsigned (4, report->packetSize);
+      reports.AppendUnsigned (5, report->kind);
+    }
+  tables.push_back (reports);
+
+  ColumnTable::WriteFile (os, tables);
+}
+
+static FlowId
+MapFlowId (const std::map<FlowId, FlowId> &flowIds, FlowId flowId)
+{
+  std::map<FlowId, FlowId>::const_iterator mapped = flowIds.find (flowId);
+  return mapped == flowIds.end () ? flowId : mapped->second;
+}
+
+bool
+FlowMonitor::MergeState (std::istream &is, uint32_t shard)
+{
+  std::vector<ColumnTable> tables;
+  if (!ColumnTable::ReadFile (is, tables))
+    {
+      return false;
+    }
+  if (m_shards.size () <= shard)
+    {
+      m_shards.resize (shard + 1);
+    }
+
+  // the table of the classifier is the one whose name is not ours
+  const char *names[] = { "FlowStats", "packetsDropped", "histograms", "FlowProbes",
+                          "probePacketsDropped", "sentPackets", "foreignReports" };
+  std::map<std::string, const ColumnTable *> known;
+  std::map<FlowId, FlowId> flowIds;
+  for (std::vector<ColumnTable>::const_iterator table = tables.begin (); table != tables.end (); table++)
+    {
+      if (std::find (names, names + 7, table->GetName ()) != names + 7)
+        {
+          known[table->GetName ()] = &*table;
+        }
+      else if (m_classifier)
+        {
+          m_classifier->MergeTable (*table, flowIds);
+        }
+    }
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      if (known.find (names[i]) == known.end ())
+        {
+          return false;
+        }
+    }
+
+  std::map<FlowId, FlowStats> flowStats;
+  const ColumnTable &flows = *known["FlowStats"];
+  for (uint64_t row = 0; row < flows.GetNRows (); row++)
+    {
+      FlowStats &stats = flowStats[MapFlowId (flowIds, flows.GetUnsigned (0, row))];
+      InitFlowStats (stats);
+      stats.timeFirstTxPacket = NanoSeconds (flows.GetSigned (flows.FindColumn ("timeFirstTxPacket"), row));
+      stats.timeFirstRxPacket = NanoSeconds (flows.GetSigned (flows.FindColumn ("timeFirstRxPacket"), row));
+      stats.timeLastTxPacket = NanoSeconds (flows.GetSigned (flows.FindColumn ("timeLastTxPacket"), row));
+      stats.timeLastRxPacket = NanoSeconds (flows.GetSigned (flows.FindColumn ("timeLastRxPacket"), row));
+      stats.delaySum = NanoSeconds (flows.GetSigned (flows.FindColumn ("delaySum"), row));
+      stats.jitterSum = NanoSeconds (flows.GetSigned (flows.FindColumn ("jitterSum"), row));
+      stats.lastDelay = NanoSeconds (flows.GetSigned (flows.FindColumn ("lastDelay"), row));
+      stats.txBytes = flows.GetUnsigned (flows.FindColumn ("txBytes"), row);
+      stats.rxBytes = flows.GetUnsigned (flows.FindColumn ("rxBytes"), row);
+      stats.txPackets = flows.GetUnsigned (flows.FindColumn ("txPackets"), row);
+      stats.rxPackets = flows.GetUnsigned (flows.FindColumn ("rxPackets"), row);
+      stats.lostPackets = flows.GetUnsigned (flows.FindColumn ("lostPackets"), row);
+      stats.timesForwarded = flows.GetUnsigned (flows.FindColumn ("timesForwarded"), row);
+      stats.untrackedTxPackets = flows.GetUnsigned (flows.FindColumn ("untrackedTxPackets"), row);
+      stats.untrackedRxPackets = flows.GetUnsigned (flows.FindColumn ("untrackedRxPackets"), row);
+    }
+  const ColumnTable &drops = *known["packetsDropped"];
+  for (uint64_t row = 0; row < drops.GetNRows (); row++)
+    {
+      FlowStats &stats = flowStats[MapFlowId (flowIds, drops.GetUnsigned (0, row))];
+      uint32_t reasonCode = drops.GetUnsigned (1, row);
+      if (stats.packetsDropped.size () < reasonCode + 1)
+        {
+          stats.packetsDropped.resize (reasonCode + 1, 0);
+          stats.bytesDropped.resize (reasonCode + 1, 0);
+        }
+      stats.packetsDropped[reasonCode] = drops.GetUnsigned (2, row);
+      stats.bytesDropped[reasonCode] = drops.GetUnsigned (3, row);
+    }
+  const ColumnTable &histograms = *known["histograms"];
+  for (uint64_t row = 0; row < histograms.GetNRows (); row++)
+    {
+      FlowStats &stats = flowStats[MapFlowId (flowIds, histograms.GetUnsigned (0, row))];
+      Histogram *histogram[] = { &stats.delayHistogram, &stats.jitterHistogram,
+                                 &stats.packetSizeHistogram, &stats.flowInterruptionsHistogram };
+      Histogram *h = histogram[histograms.GetUnsigned (1, row) & 3];
+      // the middle of the bin stays in it whatever the rounding
+      h->AddBinCount (h->GetIndex (histograms.GetDouble (2, row) + histograms.GetDouble (3, row) / 2),
+                      histograms.GetUnsigned (4, row));
+    }
+  for (std::map<FlowId, FlowStats>::const_iterator flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
+    {
+      MergeFlowStats (GetStatsForFlow (m_shards[shard], flowI->first), flowI->second);
+    }
+
+  std::map<std::pair<uint32_t, FlowId>, FlowProbe::FlowStats> probeStats;
+  const ColumnTable &probes = *known["FlowProbes"];
+  for (uint64_t row = 0; row < probes.GetNRows (); row++)
+    {
+      FlowProbe::FlowStats &stats =
+        probeStats[std::make_pair (probes.GetUnsigned (0, row), MapFlowId (flowIds, probes.GetUnsigned (1, row)))];
+      stats.packets = probes.GetUnsigned (2, row);
+      stats.bytes = probes.GetUnsigned (3, row);
+      stats.delayFromFirstProbeSum = NanoSeconds (probes.GetSigned (4, row));
+    }
+  const ColumnTable &probeDrops = *known["probePacketsDropped"];
+  for (uint64_t row = 0; row < probeDrops.GetNRows (); row++)
+    {
+      FlowProbe::FlowStats &stats =
+        probeStats[std::make_pair (probeDrops.GetUnsigned (0, row), MapFlowId (flowIds, probeDrops.GetUnsigned (1, row)))];
+      uint32_t reasonCode = probeDrops.GetUnsigned (2, row);
+      if (stats.packetsDropped.size () < reasonCode + 1)
+        {
+          stats.packetsDropped.resize (reasonCode + 1, 0);
+          stats.bytesDropped.resize (reasonCode + 1, 0);
+        }
+      stats.packetsDropped[reasonCode] = probeDrops.GetUnsigned (3, row);
+      stats.bytesDropped[reasonCode] = probeDrops.GetUnsigned (4, row);
+    }
+  for (std::map<std::pair<uint32_t, FlowId>, FlowProbe::FlowStats>::const_iterator
+       probeI = probeStats.begin (); probeI != probeStats.end (); probeI++)
+    {
+      if (probeI->first.first >= m_flowProbes.size ())
+        {
+          NS_LOG_WARN ("Statistics of the unknown probe " << probeI->first.first << " ignored.");
+          continue;
+        }
+      m_flowProbes[probeI->first.first]->AddFlowStats (probeI->first.second, probeI->second);
+    }
+
+  const ColumnTable &sentPackets = *known["sentPackets"];
+  for (uint64_t row = 0; row < sentPackets.GetNRows (); row++)
+    {
+      SentPacket sent;
+      sent.shard = shard;
+      sent.flowId = MapFlowId (flowIds, sentPackets.GetUnsigned (0, row));
+      sent.packetId = sentPackets.GetUnsigned (1, row);
+      sent.packet.firstSeenTime = NanoSeconds (sentPackets.GetSigned (2, row));
+      sent.packet.lastSeenTime = NanoSeconds (sentPackets.GetSigned (3, row));
+      sent.packet.timesForwarded = sentPackets.GetUnsigned (4, row);
+      sent.received = sentPackets.GetUnsigned (5, row);
+      m_sentPackets.push_back (sent);
+    }
+  const ColumnTable &reports = *known["foreignReports"];
+  for (uint64_t row = 0; row < reports.GetNRows (); row++)
+    {
+      if (reports.GetUnsigned (1, row) >= m_flowProbes.size ())
+        {
+          NS_LOG_WARN ("Report of the unknown probe " << reports.GetUnsigned (1, row) << " ignored.");
+          continue;
+        }
+      ForeignReport report;
+      report.time = NanoSeconds (reports.GetSigned (0, row));
+      report.probe = m_flowProbes[reports.GetUnsigned (1, row)];
+      report.flowId = MapFlowId (flowIds, reports.GetUnsigned (2, row));
+      report.packetId = reports.GetUnsigned (3, row);
+      report.packetSize = reports.GetUnsigned (4, row);
+      report.kind = reports.GetUnsigned (5, row);
+      m_foreignReports.push_back (report);
+    }
+  return true;
+}
+
+void
+FlowMonitor::SetDistributed (bool distributed)
+{
+  m_distributed = distributed;
+}
+
+void
+FlowMonitor::MergeRanks (const std::vector<std::string> &states)
+{
+  for (uint32_t rank = 1; rank < states.size (); rank++)
+    {
+      std::istringstream is (states[rank], std::ios::in|std::ios::binary);
+      if (!MergeState (is, rank))
+        {
+          NS_FATAL_ERROR ("Cannot read the flow monitor state of the rank " << rank);
+        }
+    }
+  m_ranksReduced = true;
+  CheckForLostPackets ();
+}
+
 
 } // namespace ns3
 
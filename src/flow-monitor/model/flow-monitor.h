@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <map>
+#include <fstream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -31,13 +32,41 @@
 #include "ns3/histogram.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#endif
 
 namespace ns3 {
 
+class ColumnTable;
+
 /// \brief An object that monitors and reports back packet flows observed during a simulation
 ///
 /// The FlowMonitor class is responsible forcoordinating efforts
 /// regarding probes, and collects end-to-end flowstatistics.
+///
+/// For very long runs, the monitor can keep a bounded memory: the
+/// MaxTrackedPackets attribute fixes the number of packets in flight it
+/// tracks, LogLinearBins bounds the number of bins of the histograms, and
+/// StreamFileName writes the changes of the counters of every flow
+/// periodically, so that they can be followed while the simulation
+/// runs; the histograms and the probe statistics are only available
+/// from the final queries and serializations.
+///
+/// The state is sharded by the system id of the node of the reporting
+/// probe, so that the partitions of a parallel simulation update their
+/// own statistics and tracked packets only, and the statistics are
+/// merged when they are queried or serialized.  With several shards, the
+/// reports on a packet sent from another shard are matched every second
+/// once they are older than MaxPerHopDelay and two seconds, when every
+/// shard has published its packets, and the packets no report may still
+/// match are released; CheckForLostPackets matches the rest after
+/// Simulator::Run, and must be called before the queries and
+/// serializations.  The monitors of the ranks of a distributed
+/// simulation keep these packets and reports until MergeRanks collects
+/// the state of every rank at the rank 0, which FlowMonitorMpiHelper
+/// does.
 class FlowMonitor : public Object
 {
 public:
@@ -66,7 +95,7 @@ public:
 
     /// Contains the sum of all end-to-end delays for all received
     /// packets of the flow.
-    Time     delaySum; // delayCount == rxPackets
+    Time     delaySum; // delayCount == rxPackets - untrackedRxPackets
 
     /// Contains the sum of all end-to-end delay jitter (delay
     /// variation) values for all received packets of the flow.  Here
@@ -75,7 +104,7 @@ public:
     /// i.e. \f$Jitter\left\{P_N\right\} = \left|Delay\left\{P_N\right\} - Delay\left\{P_{N-1}\right\}\right|\f$.
     /// This definition is in accordance with the Type-P-One-way-ipdv
     /// as defined in IETF RFC 3393.
-    Time     jitterSum; // jitterCount == rxPackets - 1
+    Time     jitterSum; // jitterCount == rxPackets - untrackedRxPackets - 1
 
     Time     lastDelay;
 
@@ -99,6 +128,16 @@ public:
     /// forwarded, summed for all received packets in the flow
     uint32_t timesForwarded;
 
+    /// Number of transmitted packets which were not tracked because
+    /// MaxTrackedPackets packets were already in flight.  They count
+    /// in txPackets and txBytes, but CheckForLostPackets never counts
+    /// them as lost
+    uint32_t untrackedTxPackets;
+    /// Number of untracked packets received.  They count in rxPackets
+    /// and rxBytes, but not in the delays, the jitters, nor
+    /// timesForwarded
+    uint32_t untrackedRxPackets;
+
     /// Histogram of the packet delays
     Histogram delayHistogram;
     /// Histogram of the packet jitters
@@ -168,6 +207,40 @@ public:
   /// Check right now for packets that appear to be lost
   void CheckForLostPackets ();
 
+  /// Write to the stream file a line for each flow whose statistics
+  /// changed since the last write, with the changes.  This is done every
+  /// StreamInterval, and should be done once more at the end of the
+  /// simulation.
+  void FlushStream ();
+
+  /// \returns the number of packets which were not tracked because
+  /// MaxTrackedPackets packets were already in flight in their shard
+  uint64_t GetNUntrackedPackets () const;
+
+  /// Declare the monitor as the one of a rank of a distributed
+  /// simulation among others, before Simulator::Run: the packets and
+  /// reports which another rank may match are then kept until MergeRanks
+  void SetDistributed (bool distributed);
+  /// Merge the states which the other ranks wrote with SerializeState,
+  /// then check for the packets lost in the whole simulation.  The
+  /// probes must have been installed in the same order on every rank.
+  /// \param states the state of every rank, indexed by rank, the one of
+  ///        this monitor, at the index 0, being ignored
+  void MergeRanks (const std::vector<std::string> &states);
+  /// Serializes the statistics, the packets in flight and the reports
+  /// not matched yet to an std::ostream as a ColumnTable file, which
+  /// MergeState reads into another monitor; the packets in flight are
+  /// not counted as lost
+  /// \param os the output stream, which should be opened in binary mode
+  void SerializeState (std::ostream &os);
+  /// Merge into a shard the state written by SerializeState, mapping the
+  /// flow identifiers through the classifier
+  /// \param is the input stream, which should be opened in binary mode
+  /// \param shard the shard which receives the state, usually the rank
+  ///        of the monitor which wrote it
+  /// \returns false if the state cannot be read
+  bool MergeState (std::istream &is, uint32_t shard);
+
   /// Check right now for packets that appear to be lost, considering
   /// packets as lost if not seen in the network for a time larger
   /// than maxDelay
@@ -200,11 +273,26 @@ public:
   /// \param enableHistograms if true, include also the histograms in the output
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
+  /// Serializes the results to an std::ostream as the tables of a
+  /// ColumnTable file: "FlowStats", "packetsDropped" and the table of
+  /// the classifier, then "histograms", "FlowProbes" and
+  /// "probePacketsDropped" if enabled.  The times are written in
+  /// nanoseconds, and the results are the same as in XML format.
+  /// \param os the output stream, which should be opened in binary mode
+  /// \param enableHistograms if true, include also the histograms in the output
+  /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
+  void SerializeToBinaryStream (std::ostream &os, bool enableHistograms, bool enableProbes);
+  /// Same as SerializeToBinaryStream, but writes to a file instead
+  /// \param fileName name or path of the output file that will be created
+  /// \param enableHistograms if true, include also the histograms in the output
+  /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
+  void SerializeToBinaryFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
 
 protected:
 
   virtual void NotifyConstructionCompleted ();
+  virtual void DoDispose ();
 
 private:
 
@@ -215,12 +303,103 @@ private:
     uint32_t timesForwarded; // number of times the packet was reportedly forwarded
   };
 
-  // FlowId --> FlowStats
-  std::map<FlowId, FlowStats> m_flowStats;
+  // a slot of the open-addressing table of the tracked packets
+  struct TrackedSlot
+  {
+    bool used;
+    FlowId flowId;
+    FlowPacketId packetId;
+    TrackedPacket packet;
+  };
+
+  // the counters of a flow at the last write to the stream file
+  struct StreamedStats
+  {
+    StreamedStats () : txBytes (0), rxBytes (0), txPackets (0), rxPackets (0),
+                       lostPackets (0), timesForwarded (0) {}
 
-  // (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets;
+    Time delaySum;
+    Time jitterSum;
+    uint64_t txBytes;
+    uint64_t rxBytes;
+    uint32_t txPackets;
+    uint32_t rxPackets;
+    uint32_t lostPackets;
+    uint32_t timesForwarded;
+    std::vector<uint32_t> packetsDropped;
+    std::vector<uint64_t> bytesDropped;
+  };
+
+  // a packet out of the tracked packets of its shard, kept to match the
+  // reports of the other shards
+  struct SentPacket
+  {
+    uint32_t shard;
+    FlowId flowId;
+    FlowPacketId packetId;
+    // once received, timesForwarded counts the forwards not yet added
+    // to the statistics and lastSeenTime is the time of the reception
+    TrackedPacket packet;
+    bool received; // received or dropped, kept for the forward reports
+  };
+
+  enum ReportKind
+  {
+    REPORT_FORWARD,
+    REPORT_LAST_RX,
+    REPORT_DROP
+  };
+
+  // a report on a packet which the shard of the probe does not track
+  struct ForeignReport
+  {
+    Time time;
+    Ptr<FlowProbe> probe;
+    FlowId flowId;
+    FlowPacketId packetId;
+    uint32_t packetSize;
+    uint8_t kind;
+  };
+
+  // the state updated by the probes of the nodes of a system id
+  struct Shard
+  {
+    Shard ();
+
+    // FlowId --> FlowStats
+    std::map<FlowId, FlowStats> flowStats;
+    // (FlowId,PacketId) --> TrackedPacket, with linear probing and a
+    // power of two number of slots
+    std::vector<TrackedSlot> trackedPackets;
+    uint32_t nTrackedPackets;
+    uint64_t nUntrackedPackets;
+    // the packets, reports and untracked packets of each flow since the
+    // last publication of the shard
+    std::vector<SentPacket> sentPackets;
+    std::vector<ForeignReport> foreignReports;
+    std::map<FlowId, uint32_t> untrackedPackets;
+    bool checkScheduled;
+    // the time of the last publication, and the time up to which the
+    // reports of the shard were matched
+    Time published;
+    Time matched;
+  };
+
+  std::vector<Shard> m_shards;
+  // the packets and reports published by the shards which remain to be
+  // matched, the packets being sorted by SentBefore, and the untracked
+  // packets of each flow not received yet
+  std::vector<SentPacket> m_sentPackets;
+  std::vector<ForeignReport> m_foreignReports;
+  std::map<FlowId, uint32_t> m_untrackedPackets;
+#ifdef HAVE_PTHREAD_H
+  // taken by the partitions to publish and match their shards
+  SystemMutex m_mutex;
+#endif
+  bool m_distributed;
+  // true once the state of every rank was merged here
+  bool m_ranksReduced;
+  uint32_t m_maxTrackedPackets;
   Time m_maxPerHopDelay;
   std::vector< Ptr<FlowProbe> > m_flowProbes;
 
@@ -235,9 +414,53 @@ private:
   double m_packetSizeBinWidth;
   double m_flowInterruptionsBinWidth;
   Time m_flowInterruptionsMinTime;
-
-  FlowStats& GetStatsForFlow (FlowId flowId);
-  void PeriodicCheckForLostPackets ();
+  uint32_t m_logLinearBins;
+
+  std::string m_streamFileName;
+  Time m_streamInterval;
+  std::ofstream m_stream;
+  std::map<FlowId, StreamedStats> m_streamedStats;
+
+  void InitFlowStats (FlowStats &stats) const;
+  FlowStats& GetStatsForFlow (Shard &shard, FlowId flowId);
+  static void MergeFlowStats (FlowStats &stats, const FlowStats &other);
+  void RecordRx (FlowStats &stats, Time now, Time delay, uint32_t packetSize, uint32_t timesForwarded);
+  void RecordUntrackedRx (FlowStats &stats, Time now, uint32_t packetSize);
+  void PeriodicCheckForLostPackets (uint32_t shard);
+  void PeriodicFlushStream ();
+  void AppendResultTables (std::vector<ColumnTable> &tables, bool enableHistograms, bool enableProbes);
+
+  // move the packets not seen for maxDelay out of the tracked packets of
+  // a shard, counting them as lost or keeping them as sent packets
+  void ExpireTrackedPackets (Shard &shard, Time maxDelay, bool lost);
+  void AddForeignReport (Shard &shard, Ptr<FlowProbe> probe, FlowId flowId, FlowPacketId packetId,
+                         uint32_t packetSize, uint8_t kind);
+  // order the sent packets by flow, packet and time of transmission
+  static bool SentBefore (const SentPacket &a, const SentPacket &b);
+  static bool ReportBefore (const ForeignReport &a, const ForeignReport &b);
+  // match the reports of the shards against their sent packets
+  void MatchForeignReports (Time maxDelay);
+  // publish the packets and reports of a shard to the other shards, and
+  // match those the shard may, from the partition of the shard
+  void MatchShard (uint32_t shard);
+  void PublishShard (uint32_t shard);
+  // match the reports of a shard, or of every shard if shard is the
+  // number of shards, up to a time; unless resolve is set, the reports
+  // without a sent packet are kept for later
+  void MatchReports (uint32_t shard, Time until, bool resolve);
+  // release the sent packets of a shard, or of every shard, whose
+  // reports are all matched up to a time, counting their forwards or
+  // counting them as lost
+  void ReleaseSentPackets (uint32_t shard, Time until, Time maxDelay);
+  // true if the packets of every rank are known here
+  bool IsComplete () const;
+
+  uint32_t GetTrackedSlot (const Shard &shard, FlowId flowId, FlowPacketId packetId) const;
+  // returns the number of slots if the packet is not tracked
+  uint32_t FindTrackedPacket (const Shard &shard, FlowId flowId, FlowPacketId packetId) const;
+  TrackedPacket* AddTrackedPacket (Shard &shard, FlowId flowId, FlowPacketId packetId);
+  void RemoveTrackedPacket (Shard &shard, uint32_t slot);
+  void ResizeTrackedPackets (Shard &shard, uint32_t nSlots);
 };
 
 
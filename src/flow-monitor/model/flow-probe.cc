@@ -20,6 +20,7 @@
 
 #include "ns3/flow-probe.h"
 #include "ns3/flow-monitor.h"
+#include "ns3/node.h"
 
 namespace ns3 {
 
@@ -30,7 +31,17 @@ FlowProbe::~FlowProbe ()
 
 
 FlowProbe::FlowProbe (Ptr<FlowMonitor> flowMonitor)
-  : m_flowMonitor (flowMonitor)
+  : m_flowMonitor (flowMonitor),
+    m_shard (0),
+    m_context (0xffffffff)
+{
+  m_flowMonitor->AddProbe (this);
+}
+
+FlowProbe::FlowProbe (Ptr<FlowMonitor> flowMonitor, Ptr<Node> node)
+  : m_flowMonitor (flowMonitor),
+    m_shard (node->GetSystemId ()),
+    m_context (node->GetId ())
 {
   m_flowMonitor->AddProbe (this);
 }
@@ -58,12 +69,46 @@ FlowProbe::AddPacketDropStats (FlowId flowId, uint32_t packetSize, uint32_t reas
   flow.bytesDropped[reasonCode] += packetSize;
 }
  
+void
+FlowProbe::AddFlowStats (FlowId flowId, const FlowStats &stats)
+{
+  FlowStats &flow = m_stats[flowId];
+  flow.delayFromFirstProbeSum += stats.delayFromFirstProbeSum;
+  flow.bytes += stats.bytes;
+  flow.packets += stats.packets;
+  if (flow.packetsDropped.size () < stats.packetsDropped.size ())
+    {
+      flow.packetsDropped.resize (stats.packetsDropped.size (), 0);
+      flow.bytesDropped.resize (stats.packetsDropped.size (), 0);
+    }
+  for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+    {
+      flow.packetsDropped[reasonCode] += stats.packetsDropped[reasonCode];
+      if (reasonCode < stats.bytesDropped.size ())
+        {
+          flow.bytesDropped[reasonCode] += stats.bytesDropped[reasonCode];
+        }
+    }
+}
+
 FlowProbe::Stats
 FlowProbe::GetStats () const 
 {
   return m_stats;
 }
 
+uint32_t
+FlowProbe::GetShard () const
+{
+  return m_shard;
+}
+
+uint32_t
+FlowProbe::GetContext () const
+{
+  return m_context;
+}
+
 void
 FlowProbe::SerializeToXmlStream (std::ostream &os, int indent, uint32_t index) const
 {
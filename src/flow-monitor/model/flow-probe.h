@@ -31,11 +31,16 @@
 namespace ns3 {
 
 class FlowMonitor;
+class Node;
 
 /// The FlowProbe class is responsible for listening for packet events
 /// in a specific point of the simulated space, report those events to
 /// the global FlowMonitor, and collect its own flow statistics
 /// regarding only the packets that pass through that probe.
+///
+/// The probe of a node reports to the shard of the monitor of the system
+/// id of the node, so that the nodes of different partitions of a
+/// parallel simulation do not share state.
 class FlowProbe : public SimpleRefCount<FlowProbe>
 {
 private:
@@ -45,6 +50,10 @@ private:
 protected:
 
   FlowProbe (Ptr<FlowMonitor> flowMonitor);
+  /// \param flowMonitor the monitor to report to
+  /// \param node the node of the probe, whose system id selects the
+  ///        shard of the monitor
+  FlowProbe (Ptr<FlowMonitor> flowMonitor, Ptr<Node> node);
 
 public:
   virtual ~FlowProbe ();
@@ -70,6 +79,17 @@ public:
 
   void AddPacketStats (FlowId flowId, uint32_t packetSize, Time delayFromFirstProbe);
   void AddPacketDropStats (FlowId flowId, uint32_t packetSize, uint32_t reasonCode);
+  /// Add the partial statistics of a flow seen by another copy of this
+  /// probe, such as the copy of another MPI rank
+  void AddFlowStats (FlowId flowId, const FlowStats &stats);
+
+  /// \returns the shard of the monitor the probe reports to, 0 for the
+  /// probes without a node
+  uint32_t GetShard () const;
+  /// \returns the identifier of the node of the probe, or
+  /// 0xffffffff, the context outside of the nodes, for the probes
+  /// without a node
+  uint32_t GetContext () const;
 
   /// Get the partial flow statistics stored in this probe.  With this
   /// information you can, for example, find out what is the delay
@@ -82,6 +102,10 @@ protected:
   Ptr<FlowMonitor> m_flowMonitor;
   Stats m_stats;
 
+private:
+  uint32_t m_shard;
+  uint32_t m_context;
+
 };
 
 
@@ -44,21 +44,35 @@ Histogram::GetNBins () const
 }
 
 double 
-Histogram::GetBinStart (uint32_t index)
+Histogram::GetBinStart (uint32_t index) const
 {
-  return index*m_binWidth;
+  if (index < m_nSubBins || m_nSubBins == 0)
+    {
+      return index*m_binWidth;
+    }
+  // the bins of each doubling of the range start at nSubBins / 2 times
+  // their width
+  uint32_t halfSubBins = m_nSubBins / 2;
+  uint32_t shift = (index - m_nSubBins) / halfSubBins + 1;
+  uint64_t start = (index - m_nSubBins) % halfSubBins + halfSubBins;
+  return ldexp (start * m_binWidth, shift);
 }
 
 double 
-Histogram::GetBinEnd (uint32_t index)
+Histogram::GetBinEnd (uint32_t index) const
 {
-  return (index + 1) * m_binWidth;
+  return GetBinStart (index) + GetBinWidth (index);
 }
 
 double 
 Histogram::GetBinWidth (uint32_t index) const
 {
-  return m_binWidth;
+  if (index < m_nSubBins || m_nSubBins == 0)
+    {
+      return m_binWidth;
+    }
+  uint32_t shift = (index - m_nSubBins) / (m_nSubBins / 2) + 1;
+  return ldexp (m_binWidth, shift);
 }
 
 void 
@@ -68,17 +82,53 @@ Histogram::SetDefaultBinWidth (double binWidth)
   m_binWidth = binWidth;
 }
 
+void 
+Histogram::SetLogLinear (uint32_t nSubBins)
+{
+  NS_ASSERT (m_histogram.size () == 0); //we can only change the bins if no values were added
+  NS_ASSERT_MSG (nSubBins != 1 && (nSubBins & (nSubBins - 1)) == 0, "The number of sub-bins must be a power of two");
+  m_nSubBins = nSubBins;
+  m_subBinsShift = 0;
+  while ((1U << m_subBinsShift) < nSubBins)
+    {
+      m_subBinsShift++;
+    }
+}
+
 uint32_t 
-Histogram::GetBinCount (uint32_t index) 
+Histogram::GetBinCount (uint32_t index) const
 {
   NS_ASSERT (index < m_histogram.size ());
   return m_histogram[index];
 }
 
+uint32_t
+Histogram::GetIndex (double value) const
+{
+  if (m_nSubBins == 0)
+    {
+      return (uint32_t)floor (value/m_binWidth);
+    }
+  double bins = floor (value/m_binWidth);
+  if (bins < m_nSubBins)
+    {
+      return bins > 0 ? (uint32_t)bins : 0;
+    }
+  // the values beyond 2^32 bins of the default width share the last bins
+  uint64_t i = bins < 4294967296.0 ? (uint64_t)bins : 0xffffffffULL;
+  uint32_t log2 = 0;
+  while ((i >> log2) > 1)
+    {
+      log2++;
+    }
+  uint32_t shift = log2 - m_subBinsShift + 1;
+  return m_nSubBins + (shift - 1) * (m_nSubBins / 2) + ((i >> shift) - m_nSubBins / 2);
+}
+
 void 
 Histogram::AddValue (double value)
 {
-  uint32_t index = (uint32_t)floor (value/m_binWidth);
+  uint32_t index = GetIndex (value);
 
   //check if we need to resize the vector
   NS_LOG_DEBUG ("AddValue: index=" << index << ", m_histogram.size()=" << m_histogram.size ());
@@ -90,14 +140,28 @@ Histogram::AddValue (double value)
   m_histogram[index]++;
 }
 
+void
+Histogram::AddBinCount (uint32_t index, uint32_t count)
+{
+  if (index >= m_histogram.size ())
+    {
+      m_histogram.resize (index + 1, 0);
+    }
+  m_histogram[index] += count;
+}
+
 Histogram::Histogram (double binWidth)
 {
   m_binWidth = binWidth;
+  m_nSubBins = 0;
+  m_subBinsShift = 0;
 }
 
 Histogram::Histogram ()
 {
-  Histogram (DEFAULT_BIN_WIDTH);
+  m_binWidth = DEFAULT_BIN_WIDTH;
+  m_nSubBins = 0;
+  m_subBinsShift = 0;
 }
 
 
@@ -119,8 +183,8 @@ Histogram::SerializeToXmlStream (std::ostream &os, int indent, std::string eleme
           INDENT (indent);
           os << "<bin"
              << " index=\"" << (index) << "\""
-             << " start=\"" << (index*m_binWidth) << "\""
-             << " width=\"" << m_binWidth << "\""
+             << " start=\"" << GetBinStart (index) << "\""
+             << " width=\"" << GetBinWidth (index) << "\""
              << " count=\"" << m_histogram[index] << "\""
              << " />\n";
         }
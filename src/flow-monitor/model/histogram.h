@@ -37,14 +37,30 @@ public:
 
   // Methods for Getting the Histogram Results
   uint32_t GetNBins () const;
-  double GetBinStart (uint32_t index);
-  double GetBinEnd (uint32_t index);
+  double GetBinStart (uint32_t index) const;
+  double GetBinEnd (uint32_t index) const;
   double GetBinWidth (uint32_t index) const;
   void SetDefaultBinWidth (double binWidth);
-  uint32_t GetBinCount (uint32_t index);
+  uint32_t GetBinCount (uint32_t index) const;
+  /// \returns the index of the bin of a value
+  uint32_t GetIndex (double value) const;
+
+  /// \brief Use log-linear bins, whose number stays bounded whatever the
+  /// values added
+  ///
+  /// The first nSubBins bins have the default width, then each doubling
+  /// of the range is split in nSubBins / 2 bins, so that the width of a
+  /// bin stays within 2 / nSubBins of its start.  At most nSubBins * 17
+  /// bins are used.
+  /// \param nSubBins the number of bins of the default width, a power of
+  ///        two, or zero for linear bins
+  void SetLogLinear (uint32_t nSubBins);
 
   // Method for adding values
   void AddValue (double value);
+  /// \brief Add count values to the bin of an index, to merge the
+  /// counts of a histogram with the same bins
+  void AddBinCount (uint32_t index, uint32_t count);
 
 
   void SerializeToXmlStream (std::ostream &os, int indent, std::string elementName) const;
@@ -55,6 +71,8 @@ public:
 private:
   std::vector<uint32_t> m_histogram;
   double m_binWidth;
+  uint32_t m_nSubBins;
+  uint32_t m_subBinsShift;
 };
 
 
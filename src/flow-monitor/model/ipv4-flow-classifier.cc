@@ -21,8 +21,12 @@
 #include "ns3/packet.h"
 
 #include "ipv4-flow-classifier.h"
+#include "column-table.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include "ns3/abort.h"
+
+#include <algorithm>
 
 namespace ns3 {
 
@@ -30,6 +34,9 @@ namespace ns3 {
 const uint8_t TCP_PROT_NUMBER = 6;
 const uint8_t UDP_PROT_NUMBER = 17;
 
+/* the size of the hash table when the first flow is added */
+const uint32_t MIN_SLOTS = 64;
+
 
 
 bool operator < (const Ipv4FlowClassifier::FiveTuple &t1,
@@ -96,9 +103,22 @@ bool operator == (const Ipv4FlowClassifier::FiveTuple &t1,
 
 
 Ipv4FlowClassifier::Ipv4FlowClassifier ()
+#ifdef HAVE_PTHREAD_H
+  : m_locked (false)
+#endif
 {
 }
 
+void
+Ipv4FlowClassifier::SetLocked (bool locked)
+{
+#ifdef HAVE_PTHREAD_H
+  m_locked = locked;
+#else
+  NS_ABORT_MSG_IF (locked, "Ipv4FlowClassifier::SetLocked: no threads in this build");
+#endif
+}
+
 bool
 Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
                               uint32_t *out_flowId, uint32_t *out_packetId)
@@ -138,37 +158,104 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
       return false;
     }
 
-  // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
-    = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
+  *out_flowId = GetFlowId (tuple);
+  *out_packetId = ipHeader.GetIdentification ();
 
-  // if the insertion succeeded, we need to assign this tuple a new flow identifier
-  if (insert.second)
+  return true;
+}
+
+FlowId
+Ipv4FlowClassifier::GetFlowId (const FiveTuple &tuple)
+{
+#ifdef HAVE_PTHREAD_H
+  if (m_locked)
     {
-      insert.first->second = GetNewFlowId ();
+      CriticalSection cs (m_mutex);
+      return FindOrAddFlow (tuple);
     }
+#endif
+  return FindOrAddFlow (tuple);
+}
 
-  *out_flowId = insert.first->second;
-  *out_packetId = ipHeader.GetIdentification ();
+FlowId
+Ipv4FlowClassifier::FindOrAddFlow (const FiveTuple &tuple)
+{
+  if ((m_flows.size () + 1) * 2 > m_slots.size ())
+    {
+      Grow ();
+    }
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = Hash (tuple) & mask;
+  while (m_slots[i].flowId != 0 && !(m_slots[i].tuple == tuple))
+    {
+      i = (i + 1) & mask;
+    }
 
-  return true;
+  // if the tuple is not in the table, we need to assign it a new flow identifier
+  if (m_slots[i].flowId == 0)
+    {
+      m_slots[i].tuple = tuple;
+      m_slots[i].flowId = GetNewFlowId ();
+      m_flows.push_back (tuple);
+      NS_ASSERT (m_slots[i].flowId == m_flows.size ());
+    }
+  return m_slots[i].flowId;
 }
 
+uint32_t
+Ipv4FlowClassifier::Hash (const FiveTuple &tuple)
+{
+  uint64_t addresses = (uint64_t (tuple.sourceAddress.Get ()) << 32) | tuple.destinationAddress.Get ();
+  uint64_t ports = (uint64_t (tuple.protocol) << 32) | (uint32_t (tuple.sourcePort) << 16) | tuple.destinationPort;
+  uint64_t h = addresses * 0x9e3779b97f4a7c15ULL ^ ports * 0xc2b2ae3d27d4eb4fULL;
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 32;
+  return h;
+}
 
-Ipv4FlowClassifier::FiveTuple
-Ipv4FlowClassifier::FindFlow (FlowId flowId) const
+void
+Ipv4FlowClassifier::Grow (void)
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  uint32_t size = std::max<uint32_t> (MIN_SLOTS, m_slots.size () * 2);
+  Slot empty;
+  empty.flowId = 0;
+  m_slots.assign (size, empty);
+  uint32_t mask = size - 1;
+  for (uint32_t flow = 0; flow < m_flows.size (); flow++)
     {
-      if (iter->second == flowId)
+      uint32_t i = Hash (m_flows[flow]) & mask;
+      while (m_slots[i].flowId != 0)
         {
-          return iter->first;
+          i = (i + 1) & mask;
         }
+      m_slots[i].tuple = m_flows[flow];
+      m_slots[i].flowId = flow + 1;
     }
-  NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
-  FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
-  return retval;
+}
+
+std::vector<std::pair<Ipv4FlowClassifier::FiveTuple, FlowId> >
+Ipv4FlowClassifier::GetSortedFlows (void) const
+{
+  std::vector<std::pair<FiveTuple, FlowId> > flows;
+  flows.reserve (m_flows.size ());
+  for (uint32_t flow = 0; flow < m_flows.size (); flow++)
+    {
+      flows.push_back (std::make_pair (m_flows[flow], flow + 1));
+    }
+  std::sort (flows.begin (), flows.end ());
+  return flows;
+}
+
+
+Ipv4FlowClassifier::FiveTuple
+Ipv4FlowClassifier::FindFlow (FlowId flowId) const
+{
+  if (flowId == 0 || flowId > m_flows.size ())
+    {
+      NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
+    }
+  return m_flows[flowId - 1];
 }
 
 void
@@ -179,8 +266,9 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
   INDENT (indent); os << "<Ipv4FlowClassifier>\n";
 
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  std::vector<std::pair<FiveTuple, FlowId> > flows = GetSortedFlows ();
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
     {
       INDENT (indent);
       os << "<Flow flowId=\"" << iter->second << "\""
@@ -198,6 +286,50 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 #undef INDENT
 }
 
+void
+Ipv4FlowClassifier::SerializeToTable (ColumnTable &table) const
+{
+  table = ColumnTable ("Ipv4FlowClassifier");
+  uint32_t flowId = table.AddColumn ("flowId", ColumnTable::UINT32);
+  uint32_t sourceAddress = table.AddColumn ("sourceAddress", ColumnTable::UINT32);
+  uint32_t destinationAddress = table.AddColumn ("destinationAddress", ColumnTable::UINT32);
+  uint32_t protocol = table.AddColumn ("protocol", ColumnTable::UINT8);
+  uint32_t sourcePort = table.AddColumn ("sourcePort", ColumnTable::UINT16);
+  uint32_t destinationPort = table.AddColumn ("destinationPort", ColumnTable::UINT16);
+  std::vector<std::pair<FiveTuple, FlowId> > flows = GetSortedFlows ();
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
+    {
+      table.AppendUnsigned (flowId, iter->second);
+      table.AppendUnsigned (sourceAddress, iter->first.sourceAddress.Get ());
+      table.AppendUnsigned (destinationAddress, iter->first.destinationAddress.Get ());
+      table.AppendUnsigned (protocol, iter->first.protocol);
+      table.AppendUnsigned (sourcePort, iter->first.sourcePort);
+      table.AppendUnsigned (destinationPort, iter->first.destinationPort);
+    }
+}
+
+void
+Ipv4FlowClassifier::MergeTable (const ColumnTable &table, std::map<FlowId, FlowId> &flowIds)
+{
+  uint32_t flowId = table.FindColumn ("flowId");
+  uint32_t sourceAddress = table.FindColumn ("sourceAddress");
+  uint32_t destinationAddress = table.FindColumn ("destinationAddress");
+  uint32_t protocol = table.FindColumn ("protocol");
+  uint32_t sourcePort = table.FindColumn ("sourcePort");
+  uint32_t destinationPort = table.FindColumn ("destinationPort");
+  for (uint64_t row = 0; row < table.GetNRows (); row++)
+    {
+      FiveTuple tuple;
+      tuple.sourceAddress = Ipv4Address (table.GetUnsigned (sourceAddress, row));
+      tuple.destinationAddress = Ipv4Address (table.GetUnsigned (destinationAddress, row));
+      tuple.protocol = table.GetUnsigned (protocol, row);
+      tuple.sourcePort = table.GetUnsigned (sourcePort, row);
+      tuple.destinationPort = table.GetUnsigned (destinationPort, row);
+      flowIds[table.GetUnsigned (flowId, row)] = GetFlowId (tuple);
+    }
+}
+
 
 } // namespace ns3
 
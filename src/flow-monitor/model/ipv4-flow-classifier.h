@@ -22,10 +22,14 @@
 #define IPV4_FLOW_CLASSIFIER_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#endif
 
 namespace ns3 {
 
@@ -35,6 +39,13 @@ class Packet;
 /// From these packet headers, a tuple (source-ip, destination-ip,
 /// protocol, source-port, destination-port) is created, and a unique
 /// flow identifier is assigned for each different tuple combination
+///
+/// The tuples are kept in an open-addressing hash table with linear
+/// probing, whose entries hold the tuple and the identifier of the flow,
+/// and in a vector indexed by the identifier of the flow.  The flows are
+/// serialized in the order of their tuples.  The tables are locked only
+/// if SetLocked was called, which FlowMonitorHelper does once it
+/// installs probes on nodes of several system ids.
 class Ipv4FlowClassifier : public FlowClassifier
 {
 public:
@@ -50,6 +61,10 @@ public:
 
   Ipv4FlowClassifier ();
 
+  /// \brief lock the tables on every classification, so that the
+  /// partitions of a multithreaded simulation may share the classifier
+  void SetLocked (bool locked);
+
   /// \brief try to classify the packet into flow-id and packet-id
   /// \return true if the packet was classified, false if not (i.e. it
   /// does not appear to be part of a flow).
@@ -60,10 +75,38 @@ public:
   FiveTuple FindFlow (FlowId flowId) const;
 
   virtual void SerializeToXmlStream (std::ostream &os, int indent) const;
+  virtual void SerializeToTable (ColumnTable &table) const;
+  virtual void MergeTable (const ColumnTable &table, std::map<FlowId, FlowId> &flowIds);
 
 private:
 
-  std::map<FiveTuple, FlowId> m_flowMap;
+  /// an entry of the hash table, which is empty if flowId is 0
+  struct Slot
+  {
+    FiveTuple tuple;
+    FlowId flowId;
+  };
+
+  static uint32_t Hash (const FiveTuple &tuple);
+  /// \returns the identifier of the flow of a tuple, which is new if the
+  /// tuple was not classified yet
+  FlowId GetFlowId (const FiveTuple &tuple);
+  FlowId FindOrAddFlow (const FiveTuple &tuple);
+  /// double the size of the hash table and insert the flows again
+  void Grow (void);
+  /// \returns the tuples and the flows, sorted by tuple
+  std::vector<std::pair<FiveTuple, FlowId> > GetSortedFlows (void) const;
+
+  /// the hash table, whose size is a power of two at least twice the
+  /// number of flows
+  std::vector<Slot> m_slots;
+  /// the tuple of each flow, at the index of the flow identifier minus 1
+  std::vector<FiveTuple> m_flows;
+#ifdef HAVE_PTHREAD_H
+  /// true if probes in several threads share the classifier
+  bool m_locked;
+  SystemMutex m_mutex;
+#endif
 
 };
 
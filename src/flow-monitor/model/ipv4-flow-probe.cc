@@ -150,7 +150,7 @@ Ipv4FlowProbeTag::GetPacketSize (void) const
 Ipv4FlowProbe::Ipv4FlowProbe (Ptr<FlowMonitor> monitor,
                               Ptr<Ipv4FlowClassifier> classifier,
                               Ptr<Node> node)
-  : FlowProbe (monitor),
+  : FlowProbe (monitor, node),
     m_classifier (classifier)
 {
   NS_LOG_FUNCTION (this << node->GetId ());
@@ -209,13 +209,44 @@ Ipv4FlowProbe::SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet>
     }
 }
 
+bool
+Ipv4FlowProbe::ClassifyAndRemoveTag (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
+                                     uint32_t *out_flowId, uint32_t *out_packetId)
+{
+  // remove the tags that are added by Ipv4FlowProbe::SendOutgoingLogger ()
+  Ipv4FlowProbeTag fTag;
+
+  // ConstCast: see http://www.nsnam.org/bugzilla/show_bug.cgi?id=904
+  if (ConstCast<Packet> (ipPayload)->RemovePacketTag (fTag))
+    {
+      *out_flowId = fTag.GetFlowId ();
+      *out_packetId = fTag.GetPacketId ();
+      return true;
+    }
+  return m_classifier->Classify (ipHeader, ipPayload, out_flowId, out_packetId);
+}
+
 void
 Ipv4FlowProbe::ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface)
 {
   FlowId flowId;
   FlowPacketId packetId;
 
-  if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
+  // the packets sent by a node with a probe carry their identifiers in
+  // a tag, which spares classifying them again at each hop
+  Ipv4FlowProbeTag fTag;
+  bool found = ipPayload->PeekPacketTag (fTag);
+  if (found)
+    {
+      flowId = fTag.GetFlowId ();
+      packetId = fTag.GetPacketId ();
+    }
+  else
+    {
+      found = m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId);
+    }
+
+  if (found)
     {
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportForwarding ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<");");
@@ -230,13 +261,8 @@ Ipv4FlowProbe::ForwardUpLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ip
   FlowId flowId;
   FlowPacketId packetId;
 
-  if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
+  if (ClassifyAndRemoveTag (ipHeader, ipPayload, &flowId, &packetId))
     {
-      // remove the tags that are added by Ipv4FlowProbe::SendOutgoingLogger ()
-      Ipv4FlowProbeTag fTag;
-
-      // ConstCast: see http://www.nsnam.org/bugzilla/show_bug.cgi?id=904
-      ConstCast<Packet> (ipPayload)->RemovePacketTag (fTag);
 
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("ReportLastRx ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<");");
@@ -269,13 +295,8 @@ Ipv4FlowProbe::DropLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPaylo
   FlowId flowId;
   FlowPacketId packetId;
 
-  if (m_classifier->Classify (ipHeader, ipPayload, &flowId, &packetId))
+  if (ClassifyAndRemoveTag (ipHeader, ipPayload, &flowId, &packetId))
     {
-      // remove the tags that are added by Ipv4FlowProbe::SendOutgoingLogger ()
-      Ipv4FlowProbeTag fTag;
-
-      // ConstCast: see http://www.nsnam.org/bugzilla/show_bug.cgi?id=904
-      ConstCast<Packet> (ipPayload)->RemovePacketTag (fTag);
 
       uint32_t size = (ipPayload->GetSize () + ipHeader.GetSerializedSize ());
       NS_LOG_DEBUG ("Drop ("<<this<<", "<<flowId<<", "<<packetId<<", "<<size<<", " << reason 
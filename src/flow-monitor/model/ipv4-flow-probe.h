@@ -70,6 +70,12 @@ public:
 
 private:
 
+  /// Take the identifiers of the flow and of the packet from the tag
+  /// added by the probe of the sender, which is removed, or else from
+  /// the classifier
+  /// \return true if the packet was classified
+  bool ClassifyAndRemoveTag (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload,
+                             uint32_t *out_flowId, uint32_t *out_packetId);
   void SendOutgoingLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface);
   void ForwardLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface);
   void ForwardUpLogger (const Ipv4Header &ipHeader, Ptr<const Packet> ipPayload, uint32_t interface);
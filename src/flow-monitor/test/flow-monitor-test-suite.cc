@@ -0,0 +1,549 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/column-table.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/udp-header.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace ns3 {
+
+// a probe which only forwards the reports of the test to the monitor
+class TestFlowProbe : public FlowProbe
+{
+public:
+  TestFlowProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+  TestFlowProbe (Ptr<FlowMonitor> monitor, Ptr<Node> node)
+    : FlowProbe (monitor, node)
+  {
+  }
+};
+
+/*
+ * Many packets of a few flows are sent, then received in another order
+ * than they were sent, while the monitor keeps a bounded number of them
+ * in flight and streams the statistics of the flows.
+ */
+class FlowMonitorStreamTestCase : public TestCase
+{
+public:
+  FlowMonitorStreamTestCase ();
+
+  virtual void DoRun (void);
+
+private:
+  void Send (uint32_t first, uint32_t last);
+  void Receive (uint32_t first, uint32_t last);
+  void Drop (void);
+
+  Ptr<FlowMonitor> m_monitor;
+  Ptr<FlowProbe> m_probe;
+};
+
+FlowMonitorStreamTestCase::FlowMonitorStreamTestCase ()
+  : TestCase ("Track a bounded number of packets and stream the flow statistics")
+{
+}
+
+void
+FlowMonitorStreamTestCase::Send (uint32_t first, uint32_t last)
+{
+  for (uint32_t i = first; i < last; i++)
+    {
+      m_monitor->ReportFirstTx (m_probe, 1 + i % 3, i, 100);
+    }
+}
+
+void
+FlowMonitorStreamTestCase::Receive (uint32_t first, uint32_t last)
+{
+  // every other packet first, so that the table keeps holes
+  for (uint32_t i = first; i < last; i += 2)
+    {
+      m_monitor->ReportLastRx (m_probe, 1 + i % 3, i, 100);
+    }
+  for (uint32_t i = first + 1; i < last; i += 2)
+    {
+      m_monitor->ReportLastRx (m_probe, 1 + i % 3, i, 100);
+    }
+}
+
+void
+FlowMonitorStreamTestCase::Drop (void)
+{
+  m_monitor->ReportDrop (m_probe, 1, 3000, 100, 2);
+}
+
+void
+FlowMonitorStreamTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flow-monitor-stream.csv");
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::FlowMonitor");
+  factory.Set ("MaxTrackedPackets", UintegerValue (1000));
+  factory.Set ("LogLinearBins", UintegerValue (8));
+  factory.Set ("StreamFileName", StringValue (fileName));
+  factory.Set ("StreamInterval", TimeValue (Seconds (1)));
+  m_monitor = factory.Create<FlowMonitor> ();
+  m_probe = Create<TestFlowProbe> (m_monitor);
+
+  // 900 packets in flight, then 1200 of which 200 cannot be tracked
+  Simulator::Schedule (Seconds (0.5), &FlowMonitorStreamTestCase::Send, this, 0, 900);
+  Simulator::Schedule (Seconds (0.7), &FlowMonitorStreamTestCase::Receive, this, 0, 900);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitorStreamTestCase::Send, this, 900, 2100);
+  Simulator::Schedule (Seconds (1.7), &FlowMonitorStreamTestCase::Receive, this, 900, 2100);
+  Simulator::Schedule (Seconds (1.8), &FlowMonitorStreamTestCase::Drop, this);
+  Simulator::Stop (Seconds (2.5));
+  m_monitor->StartRightNow ();
+  Simulator::Run ();
+  m_monitor->FlushStream ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_monitor->GetNUntrackedPackets (), 200, "Packets beyond the limit");
+  std::map<FlowId, FlowMonitor::FlowStats> stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 3, "Three flows");
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (i->second.txPackets, 700, "Flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (i->second.lostPackets, (i->first == 1 ? 1 : 0), "Flow " << i->first);
+      NS_TEST_EXPECT_MSG_LT (i->second.delayHistogram.GetNBins (), 8 * 17 + 1, "Flow " << i->first);
+    }
+  uint32_t nReceived = 0;
+  uint32_t nUntrackedTx = 0;
+  uint32_t nUntrackedRx = 0;
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); i++)
+    {
+      nReceived += i->second.rxPackets;
+      nUntrackedTx += i->second.untrackedTxPackets;
+      nUntrackedRx += i->second.untrackedRxPackets;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nReceived, 2100, "Every packet is received, tracked or not");
+  NS_TEST_EXPECT_MSG_EQ (nUntrackedTx, 200, "Untracked packets sent");
+  NS_TEST_EXPECT_MSG_EQ (nUntrackedRx, 200, "Untracked packets received");
+
+  // one line per flow for each of the two seconds, the last flush has
+  // nothing new
+  std::ifstream stream (fileName.c_str ());
+  std::string line;
+  std::getline (stream, line);
+  NS_TEST_EXPECT_MSG_EQ (line.substr (0, 12), "time,flowId,", "Header of the stream");
+  uint32_t nLines = 0;
+  uint32_t nStreamed = 0;
+  uint32_t nDropLines = 0;
+  while (std::getline (stream, line))
+    {
+      // ...,packetsDropped,bytesDropped, with one count per reason code
+      if (line.size () > 14 && line.substr (line.size () - 14) == ",0;0;1,0;0;100")
+        {
+          nDropLines++;
+        }
+      // time,flowId,txPackets,txBytes,rxPackets,...
+      std::string::size_type pos = 0;
+      for (uint32_t field = 0; field < 4; field++)
+        {
+          pos = line.find (',', pos) + 1;
+        }
+      nStreamed += atoi (line.c_str () + pos);
+      nLines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nLines, 6, "Lines of the stream");
+  NS_TEST_EXPECT_MSG_EQ (nStreamed, 2100, "Packets received in the stream");
+  NS_TEST_EXPECT_MSG_EQ (nDropLines, 1, "Drops in the stream");
+
+  m_monitor = 0;
+  m_probe = 0;
+  Simulator::Destroy ();
+}
+
+/*
+ * The statistics of a few flows, a drop and the probe are written as
+ * binary tables, which are read back and compared with the statistics of
+ * the monitor.
+ */
+class FlowMonitorBinaryTestCase : public TestCase
+{
+public:
+  FlowMonitorBinaryTestCase ();
+
+  virtual void DoRun (void);
+};
+
+FlowMonitorBinaryTestCase::FlowMonitorBinaryTestCase ()
+  : TestCase ("Write the flow statistics as binary tables and read them back")
+{
+}
+
+void
+FlowMonitorBinaryTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = Create<TestFlowProbe> (monitor);
+  monitor->StartRightNow ();
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      monitor->ReportFirstTx (probe, 1 + i % 3, i, 100 + i);
+    }
+  for (uint32_t i = 0; i < 29; i++)
+    {
+      monitor->ReportLastRx (probe, 1 + i % 3, i, 100 + i);
+    }
+  monitor->ReportDrop (probe, 3, 29, 129, 2);
+
+  std::stringstream stream;
+  monitor->SerializeToBinaryStream (stream, true, true);
+  std::vector<ColumnTable> tables;
+  NS_TEST_ASSERT_MSG_EQ (ColumnTable::ReadFile (stream, tables), true, "Tables read back");
+  // no classifier, so no table for it
+  NS_TEST_ASSERT_MSG_EQ (tables.size (), 5, "Number of tables");
+  NS_TEST_EXPECT_MSG_EQ (tables[0].GetName (), "FlowStats", "First table");
+  NS_TEST_EXPECT_MSG_EQ (tables[1].GetName (), "packetsDropped", "Second table");
+  NS_TEST_EXPECT_MSG_EQ (tables[2].GetName (), "histograms", "Third table");
+  NS_TEST_EXPECT_MSG_EQ (tables[3].GetName (), "FlowProbes", "Fourth table");
+
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  const ColumnTable &flows = tables[0];
+  NS_TEST_ASSERT_MSG_EQ (flows.GetNRows (), stats.size (), "One row per flow");
+  uint32_t flowId = flows.FindColumn ("flowId");
+  uint32_t txBytes = flows.FindColumn ("txBytes");
+  uint32_t rxPackets = flows.FindColumn ("rxPackets");
+  uint32_t delaySum = flows.FindColumn ("delaySum");
+  NS_TEST_ASSERT_MSG_LT (delaySum, flows.GetNColumns (), "Column of the delays");
+  NS_TEST_EXPECT_MSG_EQ (flows.FindColumn ("unknown"), flows.GetNColumns (), "No such column");
+  uint64_t row = 0;
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); i++, row++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (flows.GetUnsigned (flowId, row), i->first, "Flow of row " << row);
+      NS_TEST_EXPECT_MSG_EQ (flows.GetUnsigned (txBytes, row), i->second.txBytes, "Flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flows.GetUnsigned (rxPackets, row), i->second.rxPackets, "Flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flows.GetSigned (delaySum, row), i->second.delaySum.GetNanoSeconds (), "Flow " << i->first);
+    }
+
+  const ColumnTable &drops = tables[1];
+  NS_TEST_ASSERT_MSG_EQ (drops.GetNRows (), 3, "Reason codes up to the drop");
+  NS_TEST_EXPECT_MSG_EQ (drops.GetUnsigned (0, 2), 3, "Flow of the drop");
+  NS_TEST_EXPECT_MSG_EQ (drops.GetUnsigned (2, 2), 1, "Packets of the drop");
+  NS_TEST_EXPECT_MSG_EQ (drops.GetUnsigned (3, 2), 129, "Bytes of the drop");
+
+  const ColumnTable &probes = tables[3];
+  NS_TEST_ASSERT_MSG_EQ (probes.GetNRows (), 3, "One row per flow of the probe");
+  uint32_t nPackets = 0;
+  for (row = 0; row < probes.GetNRows (); row++)
+    {
+      nPackets += probes.GetUnsigned (probes.FindColumn ("packets"), row);
+    }
+  NS_TEST_EXPECT_MSG_EQ (nPackets, 59, "Packets seen by the probe");
+
+  // a stream which is not made of tables
+  std::stringstream garbage ("<?xml version=\"1.0\" ?>");
+  NS_TEST_EXPECT_MSG_EQ (ColumnTable::ReadFile (garbage, tables), false, "Not a file of tables");
+
+  Simulator::Destroy ();
+}
+
+/*
+ * The packets of many flows are classified twice, in two orders, which
+ * grows the hash table of the classifier several times.
+ */
+class Ipv4FlowClassifierTestCase : public TestCase
+{
+public:
+  Ipv4FlowClassifierTestCase ();
+
+  virtual void DoRun (void);
+
+private:
+  FlowId Classify (Ptr<Ipv4FlowClassifier> classifier, uint32_t flow);
+};
+
+Ipv4FlowClassifierTestCase::Ipv4FlowClassifierTestCase ()
+  : TestCase ("Classify the packets of many flows")
+{
+}
+
+FlowId
+Ipv4FlowClassifierTestCase::Classify (Ptr<Ipv4FlowClassifier> classifier, uint32_t flow)
+{
+  // flows which differ by a single field of their tuple
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address (0x0a000001 + flow % 7));
+  ipHeader.SetDestination (Ipv4Address (0x0a010001 + flow % 11));
+  ipHeader.SetProtocol (17);
+  ipHeader.SetIdentification (flow);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (1000 + flow / 77);
+  udpHeader.SetDestinationPort (9);
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (udpHeader);
+  FlowId flowId = 0;
+  FlowPacketId packetId = 0;
+  bool classified = classifier->Classify (ipHeader, packet, &flowId, &packetId);
+  NS_TEST_EXPECT_MSG_EQ (classified, true, "Flow " << flow);
+  NS_TEST_EXPECT_MSG_EQ (packetId, flow, "Packet of flow " << flow);
+  return flowId;
+}
+
+void
+Ipv4FlowClassifierTestCase::DoRun (void)
+{
+  const uint32_t nFlows = 1000;
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  std::vector<FlowId> flowIds;
+  for (uint32_t flow = 0; flow < nFlows; flow++)
+    {
+      flowIds.push_back (Classify (classifier, flow));
+      NS_TEST_EXPECT_MSG_EQ (flowIds.back (), flow + 1, "New flow");
+    }
+  for (uint32_t flow = nFlows; flow > 0; flow--)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Classify (classifier, flow - 1), flowIds[flow - 1], "Known flow");
+    }
+
+  Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow (flowIds[100]);
+  NS_TEST_EXPECT_MSG_EQ (tuple.sourceAddress, Ipv4Address (0x0a000001 + 100 % 7), "Source of a flow");
+  NS_TEST_EXPECT_MSG_EQ (tuple.sourcePort, 1000 + 100 / 77, "Source port of a flow");
+
+  // broadcast packets are not classified
+  Ipv4Header ipHeader;
+  ipHeader.SetDestination (Ipv4Address::GetBroadcast ());
+  FlowId flowId;
+  FlowPacketId packetId;
+  NS_TEST_EXPECT_MSG_EQ (classifier->Classify (ipHeader, Create<Packet> (10), &flowId, &packetId), false,
+                         "Broadcast packet");
+
+  // the flows are serialized in the order of their tuples
+  ColumnTable table;
+  classifier->SerializeToTable (table);
+  NS_TEST_ASSERT_MSG_EQ (table.GetNRows (), nFlows, "One row per flow");
+  uint32_t sourceAddress = table.FindColumn ("sourceAddress");
+  uint32_t destinationAddress = table.FindColumn ("destinationAddress");
+  for (uint64_t row = 1; row < table.GetNRows (); row++)
+    {
+      uint64_t previous = (table.GetUnsigned (sourceAddress, row - 1) << 32) + table.GetUnsigned (destinationAddress, row - 1);
+      uint64_t current = (table.GetUnsigned (sourceAddress, row) << 32) + table.GetUnsigned (destinationAddress, row);
+      NS_TEST_EXPECT_MSG_LT (previous, current + 1, "Order of row " << row);
+    }
+}
+
+/*
+ * Two flows go from a sender to a receiver through a router, and are
+ * monitored three ways: with all the probes in a single shard, with the
+ * sender alone in the shard 0, and with the sender and the others
+ * reporting to two monitors, as two MPI ranks would, whose states are
+ * merged.  The results must be the same.
+ */
+class FlowMonitorShardTestCase : public TestCase
+{
+public:
+  FlowMonitorShardTestCase ();
+
+  virtual void DoRun (void);
+
+private:
+  enum Hop
+  {
+    SENDER,
+    ROUTER,
+    RECEIVER
+  };
+
+  // the monitor and the probe of each hop, for one way of monitoring
+  struct Setup
+  {
+    Ptr<FlowMonitor> monitors[3];
+    Ptr<FlowProbe> probes[3];
+  };
+
+  void Report (enum Hop hop, FlowId flowId, FlowPacketId packetId, uint32_t size);
+  Ptr<FlowMonitor> CreateMonitor ();
+  void CheckStats (Ptr<FlowMonitor> monitor, Ptr<FlowProbe> router, std::string name);
+
+  std::vector<Setup> m_setups;
+};
+
+FlowMonitorShardTestCase::FlowMonitorShardTestCase ()
+  : TestCase ("Merge the statistics of the shards and of the ranks")
+{
+}
+
+void
+FlowMonitorShardTestCase::Report (enum Hop hop, FlowId flowId, FlowPacketId packetId, uint32_t size)
+{
+  for (std::vector<Setup>::const_iterator setup = m_setups.begin (); setup != m_setups.end (); setup++)
+    {
+      Ptr<FlowMonitor> monitor = setup->monitors[hop];
+      switch (hop)
+        {
+        case SENDER:
+          monitor->ReportFirstTx (setup->probes[hop], flowId, packetId, size);
+          break;
+        case ROUTER:
+          monitor->ReportForwarding (setup->probes[hop], flowId, packetId, size);
+          break;
+        case RECEIVER:
+          monitor->ReportLastRx (setup->probes[hop], flowId, packetId, size);
+          break;
+        }
+    }
+}
+
+Ptr<FlowMonitor>
+FlowMonitorShardTestCase::CreateMonitor ()
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (1)));
+  monitor->StartRightNow ();
+  return monitor;
+}
+
+void
+FlowMonitorShardTestCase::CheckStats (Ptr<FlowMonitor> monitor, Ptr<FlowProbe> router, std::string name)
+{
+  std::map<FlowId, FlowMonitor::FlowStats> expected = m_setups[0].monitors[SENDER]->GetFlowStats ();
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), expected.size (), name << ": number of flows");
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = expected.begin (); i != expected.end (); i++)
+    {
+      const FlowMonitor::FlowStats &flow = stats[i->first];
+      NS_TEST_EXPECT_MSG_EQ (flow.txPackets, i->second.txPackets, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.rxPackets, i->second.rxPackets, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.lostPackets, i->second.lostPackets, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.timesForwarded, i->second.timesForwarded, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.delaySum, i->second.delaySum, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.jitterSum, i->second.jitterSum, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.timeFirstRxPacket, i->second.timeFirstRxPacket, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.timeLastTxPacket, i->second.timeLastTxPacket, name << ": flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow.delayHistogram.GetNBins (), i->second.delayHistogram.GetNBins (),
+                             name << ": flow " << i->first);
+    }
+  FlowProbe::Stats expectedRouter = m_setups[0].probes[ROUTER]->GetStats ();
+  FlowProbe::Stats routerStats = router->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (routerStats[1].packets, expectedRouter[1].packets, name << ": router");
+  NS_TEST_EXPECT_MSG_EQ (routerStats[1].delayFromFirstProbeSum, expectedRouter[1].delayFromFirstProbeSum,
+                         name << ": router");
+}
+
+void
+FlowMonitorShardTestCase::DoRun (void)
+{
+  Ptr<Node> nodes[3] = { CreateObject<Node> (0), CreateObject<Node> (1), CreateObject<Node> (1) };
+
+  Setup single;
+  Ptr<FlowMonitor> monitor = CreateMonitor ();
+  for (uint32_t hop = 0; hop < 3; hop++)
+    {
+      single.monitors[hop] = monitor;
+      single.probes[hop] = Create<TestFlowProbe> (monitor);
+    }
+  m_setups.push_back (single);
+
+  Setup sharded;
+  monitor = CreateMonitor ();
+  for (uint32_t hop = 0; hop < 3; hop++)
+    {
+      sharded.monitors[hop] = monitor;
+      sharded.probes[hop] = Create<TestFlowProbe> (monitor, nodes[hop]);
+    }
+  m_setups.push_back (sharded);
+
+  // every rank has the probes of all the nodes, but only reports for its
+  // own nodes
+  Setup ranks;
+  Ptr<FlowMonitor> rank0 = CreateMonitor ();
+  Ptr<FlowMonitor> rank1 = CreateMonitor ();
+  rank0->SetDistributed (true);
+  rank1->SetDistributed (true);
+  Ptr<FlowProbe> rank0Probes[3];
+  for (uint32_t hop = 0; hop < 3; hop++)
+    {
+      rank0Probes[hop] = Create<TestFlowProbe> (rank0, nodes[hop]);
+      Ptr<FlowProbe> rank1Probe = Create<TestFlowProbe> (rank1, nodes[hop]);
+      bool local = nodes[hop]->GetSystemId () == 0;
+      ranks.monitors[hop] = local ? rank0 : rank1;
+      ranks.probes[hop] = local ? rank0Probes[hop] : rank1Probe;
+    }
+  m_setups.push_back (ranks);
+
+  // the first flow is received with two delays, the second is lost
+  Simulator::Schedule (Seconds (0.1), &FlowMonitorShardTestCase::Report, this, SENDER, 1, 1, 100);
+  Simulator::Schedule (Seconds (0.1), &FlowMonitorShardTestCase::Report, this, SENDER, 2, 1, 200);
+  Simulator::Schedule (Seconds (0.2), &FlowMonitorShardTestCase::Report, this, ROUTER, 1, 1, 100);
+  Simulator::Schedule (Seconds (0.3), &FlowMonitorShardTestCase::Report, this, RECEIVER, 1, 1, 100);
+  Simulator::Schedule (Seconds (0.4), &FlowMonitorShardTestCase::Report, this, SENDER, 1, 2, 100);
+  Simulator::Schedule (Seconds (0.45), &FlowMonitorShardTestCase::Report, this, ROUTER, 1, 2, 100);
+  Simulator::Schedule (Seconds (0.6), &FlowMonitorShardTestCase::Report, this, RECEIVER, 1, 2, 100);
+  Simulator::Stop (Seconds (25));
+  Simulator::Run ();
+
+  single.monitors[SENDER]->CheckForLostPackets ();
+  std::map<FlowId, FlowMonitor::FlowStats> stats = single.monitors[SENDER]->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].rxPackets, 2, "Received packets");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].timesForwarded, 2, "Forwarded packets");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].jitterSum, Seconds (0), "Same delays");
+  NS_TEST_EXPECT_MSG_EQ (stats[2].lostPackets, 1, "Lost packets");
+
+  // the reports of the other shard are matched while running, once every
+  // shard published its packets
+  NS_TEST_EXPECT_MSG_EQ (sharded.monitors[SENDER]->GetFlowStats ()[1].rxPackets, 2, "Received while running");
+  NS_TEST_EXPECT_MSG_EQ (sharded.monitors[SENDER]->GetFlowStats ()[2].lostPackets, 1, "Lost while running");
+  sharded.monitors[SENDER]->CheckForLostPackets ();
+  CheckStats (sharded.monitors[SENDER], sharded.probes[ROUTER], "Two shards");
+
+  // the ranks keep every packet until they are merged
+  NS_TEST_EXPECT_MSG_EQ (rank0->GetFlowStats ()[2].lostPackets, 0, "Lost before the merge");
+  rank0->CheckForLostPackets ();
+  std::ostringstream state;
+  rank1->SerializeState (state);
+  std::vector<std::string> states (2);
+  states[1] = state.str ();
+  rank0->MergeRanks (states);
+  // the reports of the rank 1 are merged into the probes of the rank 0
+  CheckStats (rank0, rank0Probes[ROUTER], "Two ranks");
+
+  m_setups.clear ();
+  Simulator::Destroy ();
+}
+
+static class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ()
+    : TestSuite ("flow-monitor", UNIT)
+  {
+    AddTestCase (new FlowMonitorStreamTestCase ());
+    AddTestCase (new FlowMonitorBinaryTestCase ());
+    AddTestCase (new Ipv4FlowClassifierTestCase ());
+    AddTestCase (new FlowMonitorShardTestCase ());
+  }
+} g_flowMonitorTestSuite;
+
+} // namespace ns3
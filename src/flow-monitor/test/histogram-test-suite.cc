@@ -69,6 +69,51 @@ HistogramTestCase::DoRun (void)
   }
 }
 
+class LogLinearHistogramTestCase : public ns3::TestCase {
+public:
+  LogLinearHistogramTestCase ();
+  virtual void DoRun (void);
+};
+
+LogLinearHistogramTestCase::LogLinearHistogramTestCase ()
+  : ns3::TestCase ("LogLinearHistogram")
+{
+}
+
+void
+LogLinearHistogramTestCase::DoRun (void)
+{
+  Histogram h (0.5);
+  h.SetLogLinear (4);
+
+  // the first 4 bins are linear
+  h.AddValue (1.2);
+  NS_TEST_EXPECT_MSG_EQ (h.GetNBins (), 3, "");
+  NS_TEST_EXPECT_MSG_EQ (h.GetBinCount (2), 1, "");
+  NS_TEST_EXPECT_MSG_EQ_TOL (h.GetBinStart (3), 1.5, 1e-9, "");
+
+  // then 2 bins per doubling: [2, 3) [3, 4) [4, 6) [6, 8) ...
+  h.AddValue (3.5);
+  h.AddValue (5.9);
+  NS_TEST_EXPECT_MSG_EQ (h.GetNBins (), 7, "");
+  NS_TEST_EXPECT_MSG_EQ (h.GetBinCount (4), 0, "");
+  NS_TEST_EXPECT_MSG_EQ (h.GetBinCount (5), 1, "");
+  NS_TEST_EXPECT_MSG_EQ (h.GetBinCount (6), 1, "");
+  NS_TEST_EXPECT_MSG_EQ_TOL (h.GetBinStart (6), 4.0, 1e-9, "");
+  NS_TEST_EXPECT_MSG_EQ_TOL (h.GetBinWidth (6), 2.0, 1e-9, "");
+  NS_TEST_EXPECT_MSG_EQ_TOL (h.GetBinEnd (7), 8.0, 1e-9, "");
+
+  // the number of bins stays bounded
+  h.AddValue (1e30);
+  NS_TEST_EXPECT_MSG_LT (h.GetNBins (), 4 * 17 + 1, "");
+  uint32_t last = h.GetNBins () - 1;
+  NS_TEST_EXPECT_MSG_EQ (h.GetBinCount (last), 1, "");
+  for (uint32_t i = 1; i < h.GetNBins (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (h.GetBinStart (i), h.GetBinEnd (i - 1), 1e-9, "Bin " << i);
+    }
+}
+
 static class HistogramTestSuite : public TestSuite
 {
 public:
@@ -76,6 +121,7 @@ public:
     : TestSuite ("histogram", UNIT) 
   {
     AddTestCase (new HistogramTestCase ());
+    AddTestCase (new LogLinearHistogramTestCase ());
   }
 } g_HistogramTestSuite;
 
@@ -80,6 +80,9 @@ public:
    * its representation of the global topology before recomputing routes.
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
+   * If the GlobalRoutingIncrementalSpf global value is true, only the
+   * routes of the routers that the topology change may affect are
+   * recomputed.
    *
    */
   static void RecomputeRoutingTables (void);
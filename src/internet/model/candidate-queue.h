@@ -22,8 +22,9 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -43,8 +44,11 @@ class SPFVertex;
  *
  * Although a STL priority_queue almost does what we want, the requirement
  * for a Find () operation, the dynamic nature of the data and the derived
- * requirement for a Reorder () operation led us to implement this simple 
- * enhanced priority queue.
+ * requirement for a DecreaseKey () operation led us to implement this
+ * enhanced priority queue: a binary heap whose vertices know their
+ * position in it, indexed by vertex ID.  Push, Pop and DecreaseKey cost
+ * O(log n) and Find O(1).  Vertices of equal rank are popped in the order
+ * they were pushed, or had their distance decreased.
  */
 class CandidateQueue
 {
@@ -146,6 +150,16 @@ public:
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Move a Shortest Path First Vertex pointer up the queue after its
+ * m_distanceFromRoot has been decreased.
+ * @internal
+ *
+ * @see SPFVertex
+ * @param v A vertex of the queue.
+ */
+  void DecreaseKey (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * @internal
@@ -156,7 +170,8 @@ public:
  * increasing distance.
  *
  * This method is provided in case the values of m_distanceFromRoot change
- * during the routing calculations.
+ * during the routing calculations.  It rebuilds the whole heap; prefer
+ * DecreaseKey () when a single distance has decreased.
  *
  * @see SPFVertex
  */
@@ -189,8 +204,23 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t;
-  CandidateList_t m_candidates;
+  /// A vertex of the heap, with the rank of its last push or decrease
+  struct Candidate
+  {
+    SPFVertex *vertex;
+    uint64_t order;
+  };
+
+  static bool IsBefore (const Candidate &c1, const Candidate &c2);
+  void Place (uint32_t index, const Candidate &c);
+  void SiftUp (uint32_t index, Candidate c);
+  void SiftDown (uint32_t index, Candidate c);
+
+  typedef std::vector<Candidate> CandidateHeap_t;
+  CandidateHeap_t m_candidates;
+  /// the vertex returned by Find for each vertex ID
+  sgi::hash_map<Ipv4Address, SPFVertex*, Ipv4AddressHash> m_index;
+  uint64_t m_order;
 
   friend std::ostream& operator<< (std::ostream& os, const CandidateQueue& q);
 };
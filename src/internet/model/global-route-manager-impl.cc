@@ -34,7 +34,17 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -72,6 +82,212 @@ operator<< (std::ostream& os, const SPFVertex::ListOfSPFVertex_t& vs)
   return os;
 }
 
+namespace {
+
+static GlobalValue g_spfThreads ("GlobalRoutingSpfThreads",
+                                 "The number of threads running the SPF calculations of global routing",
+                                 UintegerValue (1),
+                                 MakeUintegerChecker<uint32_t> (1));
+
+static GlobalValue g_incrementalSpf ("GlobalRoutingIncrementalSpf",
+                                     "Whether a topology change only recomputes the global routes of the routers it may affect",
+                                     BooleanValue (false),
+                                     MakeBooleanChecker ());
+
+bool
+IsSameLSA (const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < a->GetNLinkRecords (); j++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (j);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (j);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t j = 0; j < a->GetNAttachedRouters (); j++)
+    {
+      if (a->GetAttachedRouter (j) != b->GetAttachedRouter (j))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+//
+// Union-find of the vertices of the link state graph, to tell which
+// routers a changed LSA may affect.
+//
+class LSAComponents
+{
+public:
+  void Union (Ipv4Address a, Ipv4Address b)
+  {
+    uint32_t ra = Find (a);
+    uint32_t rb = Find (b);
+    if (ra != rb)
+      {
+        m_parent[ra] = rb;
+      }
+  }
+  uint32_t Find (Ipv4Address a)
+  {
+    uint32_t i = GetIndex (a);
+    while (m_parent[i] != i)
+      {
+        m_parent[i] = m_parent[m_parent[i]];
+        i = m_parent[i];
+      }
+    return i;
+  }
+private:
+  uint32_t GetIndex (Ipv4Address a)
+  {
+    std::pair<sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash>::iterator, bool> result =
+      m_index.insert (std::make_pair (a, m_parent.size ()));
+    if (result.second)
+      {
+        m_parent.push_back (m_parent.size ());
+      }
+    return result.first->second;
+  }
+  sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_index;
+  std::vector<uint32_t> m_parent;
+};
+
+//
+// The global routes are removed one by one; route 0 is removed as many
+// times as there are routes.
+//
+void
+DeleteRoutes (Ptr<Node> node, Ptr<Ipv4GlobalRouting> gr)
+{
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << nRoutes << " routes from node " << node->GetId ());
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+}
+
+// the rank of a vertex that the SPF run did not reach
+const uint32_t SPF_UNREACHED = 0xffffffff;
+
+//
+// The edges of the link state graph out of a vertex, in the order SPFNext
+// follows them, as (vertex, metric) pairs.
+//
+typedef std::vector<std::pair<Ipv4Address, uint32_t> > LSAEdges;
+
+void
+GetLSAEdges (const GlobalRouteManagerLSDB& db, const GlobalRoutingLSA* lsa, LSAEdges& edges)
+{
+  edges.clear ();
+  if (lsa == 0)
+    {
+      return;
+    }
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              edges.push_back (std::make_pair (lr->GetLinkId (), lr->GetMetric ()));
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+        {
+          GlobalRoutingLSA* w = db.GetLSAByLinkData (lsa->GetAttachedRouter (j));
+          if (w != 0)
+            {
+              edges.push_back (std::make_pair (w->GetLinkStateId (), 0));
+            }
+        }
+    }
+}
+
+//
+// The destinations that SPFIntraAddRouter, SPFIntraAddStub and
+// SPFIntraAddTransit add routes to for a vertex, in the order they do.
+//
+typedef std::vector<std::pair<uint32_t, uint32_t> > LSANetworks;
+
+void
+GetLSADestinations (const GlobalRoutingLSA* lsa, std::vector<Ipv4Address>& hosts, LSANetworks& networks)
+{
+  hosts.clear ();
+  networks.clear ();
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              hosts.push_back (lr->GetLinkData ());
+            }
+          else if (lr->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+            {
+              Ipv4Mask mask (lr->GetLinkData ().Get ());
+              networks.push_back (std::make_pair (lr->GetLinkId ().CombineMask (mask).Get (), mask.Get ()));
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      Ipv4Mask mask = lsa->GetNetworkLSANetworkMask ();
+      networks.push_back (std::make_pair (lsa->GetLinkStateId ().CombineMask (mask).Get (), mask.Get ()));
+    }
+}
+
+//
+// If b is a subsequence of a, the elements of a that are not in b.
+//
+template <typename T>
+bool
+GetRemoved (const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& removed)
+{
+  removed.clear ();
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < a.size (); i++)
+    {
+      if (j < b.size () && a[i] == b[j])
+        {
+          j++;
+        }
+      else
+        {
+          removed.push_back (a[i]);
+        }
+    }
+  return j == b.size ();
+}
+
+} // anonymous namespace
+
 // ---------------------------------------------------------------------------
 //
 // SPFVertex Implementation
@@ -87,7 +303,8 @@ SPFVertex::SPFVertex () :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidateIndex (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -100,7 +317,8 @@ SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) :
   m_nextHop ("0.0.0.0"),
   m_parents (),
   m_children (),
-  m_vertexProcessed (false)
+  m_vertexProcessed (false),
+  m_candidateIndex (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -458,9 +676,27 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      m_lsas.push_back (lsa);
+//
+// Index the transit link records for GetLSAByLinkData, which finds the LSA
+// with the lowest address first.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::pair<LinkDataIndex_t::iterator, bool> result =
+            m_linkDataIndex.insert (std::make_pair (lr->GetLinkData (), LSDBPair_t (addr, lsa)));
+          if (!result.second && addr < result.first->second.first)
+            {
+              result.first->second = LSDBPair_t (addr, lsa);
+            }
+        }
     }
 }
 
@@ -483,13 +719,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -499,24 +732,59 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of one of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataIndex_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      return i->second.second;
+    }
+  return 0;
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetNumLSAs () const
+{
+  return m_lsas.size ();
+}
+
+GlobalRoutingLSA*
+GlobalRouteManagerLSDB::GetLSAByIndex (uint32_t index) const
+{
+  return m_lsas.at (index);
+}
+
+bool
+GlobalRouteManagerLSDB::Compare (const GlobalRouteManagerLSDB& other, std::set<Ipv4Address>& changed) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      GlobalRoutingLSA* otherLsa = other.GetLSA (i->first);
+      if (otherLsa == 0 || !IsSameLSA (i->second, otherLsa))
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
+          changed.insert (i->first);
         }
     }
-  return 0;
+  for (LSDBMap_t::const_iterator i = other.m_database.begin (); i != other.m_database.end (); i++)
+    {
+      if (GetLSA (i->first) == 0)
+        {
+          changed.insert (i->first);
+        }
+    }
+  if (m_extdatabase.size () != other.m_extdatabase.size ())
+    {
+      return true;
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      if (!IsSameLSA (m_extdatabase[j], other.m_extdatabase[j]))
+        {
+          return true;
+        }
+    }
+  return false;
 }
 
 // ---------------------------------------------------------------------------
@@ -525,18 +793,160 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // ---------------------------------------------------------------------------
 
+GlobalRouteManagerImpl::SPFJob::SPFJob ()
+  : keepOrder (false)
+{
+}
+
+//
+// The SPF jobs of a batch, taken in turn by the threads running them.  The
+// workers stay up for all the batches of an SPFCalculate call: each waits
+// on its own condition for the next batch, and the last one done with a
+// batch wakes the main thread.
+//
+class GlobalRouteManagerImpl::SPFJobQueue
+{
+public:
+  SPFJobQueue (uint32_t nWorkers)
+    : m_jobs (0),
+      m_next (0),
+      m_stop (false),
+      m_nWorkers (nWorkers),
+      m_nRunning (0)
+  {
+#ifdef HAVE_PTHREAD_H
+    for (uint32_t t = 0; t < nWorkers; t++)
+      {
+        m_start.push_back (new SystemCondition ());
+      }
+#else
+    NS_ASSERT (nWorkers == 0);
+#endif
+  }
+  ~SPFJobQueue ()
+  {
+#ifdef HAVE_PTHREAD_H
+    for (uint32_t t = 0; t < m_start.size (); t++)
+      {
+        delete m_start[t];
+      }
+#endif
+  }
+  // main thread: hand a batch to the workers
+  void Start (std::vector<SPFJob>& jobs)
+  {
+    m_jobs = &jobs;
+    m_next = 0;
+    m_nRunning = m_nWorkers;
+#ifdef HAVE_PTHREAD_H
+    m_done.SetCondition (m_nWorkers == 0);
+    for (uint32_t t = 0; t < m_start.size (); t++)
+      {
+        m_start[t]->SetCondition (true);
+        m_start[t]->Signal ();
+      }
+#endif
+  }
+  // main thread: wait until the workers are done with the batch
+  void Wait (void)
+  {
+#ifdef HAVE_PTHREAD_H
+    while (m_done.TimedWait (WAIT_NS))
+      {
+      }
+#endif
+  }
+  // main thread: let the workers return, once they are done with the batch
+  void Stop (void)
+  {
+    m_stop = true;
+#ifdef HAVE_PTHREAD_H
+    for (uint32_t t = 0; t < m_start.size (); t++)
+      {
+        m_start[t]->SetCondition (true);
+        m_start[t]->Signal ();
+      }
+#endif
+  }
+  // worker: wait for the next batch; false once stopped
+  bool WaitForBatch (uint32_t worker)
+  {
+#ifdef HAVE_PTHREAD_H
+    while (m_start[worker]->TimedWait (WAIT_NS))
+      {
+      }
+    m_start[worker]->SetCondition (false);
+#endif
+    return !m_stop;
+  }
+  // worker: done with the batch
+  void Finish (void)
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (m_mutex);
+    if (--m_nRunning == 0)
+      {
+        m_done.SetCondition (true);
+        m_done.Signal ();
+      }
+#endif
+  }
+  SPFJob* Pop (void)
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (m_mutex);
+#endif
+    if (m_next == m_jobs->size ())
+      {
+        return 0;
+      }
+    return &(*m_jobs)[m_next++];
+  }
+private:
+  // the waits only time out to check their condition again
+  static const uint64_t WAIT_NS = 1000000000;
+  std::vector<SPFJob>* m_jobs;
+  uint32_t m_next;
+  bool m_stop;
+  uint32_t m_nWorkers;
+  uint32_t m_nRunning;
+#ifdef HAVE_PTHREAD_H
+  SystemMutex m_mutex;
+  std::vector<SystemCondition*> m_start;
+  SystemCondition m_done;
+#endif
+};
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_ownsLsdb (true),
+    m_job (0),
+    m_haveNodes (false),
+    m_queue (0),
+    m_workerIndex (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_lsdb = new GlobalRouteManagerLSDB ();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb)
+  :
+    m_spfroot (0),
+    m_lsdb (lsdb),
+    m_ownsLsdb (false),
+    m_job (0),
+    m_haveNodes (false),
+    m_queue (0),
+    m_workerIndex (0)
+{
+  NS_LOG_FUNCTION (lsdb);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
@@ -566,20 +976,10 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (node, router->GetRoutingProtocol ());
     }
+  m_vertexIndex.clear ();
+  m_spfRanks.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -668,53 +1068,703 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // The area's link state database is represented as a directed graph.
 // The graph's vertices are routers, transit networks and stub networks.
 //
-// The first stage of the procedure (i.e., the Dijkstra algorithm)
-// can now be summarized as follows. At each iteration of the
-// algorithm, there is a list of candidate vertices.  Paths from
-// the root to these vertices have been found, but not necessarily
-// the shortest ones.  However, the paths to the candidate vertex
-// that is closest to the root are guaranteed to be shortest; this
-// vertex is added to the shortest-path tree, removed from the
-// candidate list, and its adjacent vertices are examined for
-// possible addition to/modification of the candidate list.  The
-// algorithm then iterates again.  It terminates when the candidate
-// list becomes empty. 
+// The first stage of the procedure (i.e., the Dijkstra algorithm)
+// can now be summarized as follows. At each iteration of the
+// algorithm, there is a list of candidate vertices.  Paths from
+// the root to these vertices have been found, but not necessarily
+// the shortest ones.  However, the paths to the candidate vertex
+// that is closest to the root are guaranteed to be shortest; this
+// vertex is added to the shortest-path tree, removed from the
+// candidate list, and its adjacent vertices are examined for
+// possible addition to/modification of the candidate list.  The
+// algorithm then iterates again.  It terminates when the candidate
+// list becomes empty. 
+//
+void
+GlobalRouteManagerImpl::InitializeRoutes ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+//
+// Walk the list of nodes in the system.
+//
+  NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<Ptr<Node> > nodes;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+//
+// Look for the GlobalRouter interface that indicates that the node is
+// participating in routing.
+//
+      Ptr<GlobalRouter> rtr = 
+        node->GetObject<GlobalRouter> ();
+
+      // Ignore nodes that are not assigned to our systemId (distributed sim);
+      // the threads of a multithreaded simulation share the routes
+      if (MpiInterface::IsEnabled () && node->GetSystemId () != MpiInterface::GetSystemId ())
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          nodes.push_back (node);
+        }
+    }
+  SPFCalculate (nodes);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  BooleanValue incremental;
+  g_incrementalSpf.GetValue (incremental);
+  if (!incremental.Get ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+//
+// Build the new database next to the one the routes come from, and find the
+// routers whose routes may change.
+//
+  GlobalRouteManagerLSDB* old = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  std::set<Ipv4Address> affected;
+  std::vector<LSAShrink> shrinks;
+  std::map<Ipv4Address, std::vector<uint32_t> > patches;
+  FindAffectedRouters (*old, affected, shrinks, patches);
+  delete old;
+
+  std::vector<Ptr<Node> > nodes;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      if (affected.find (rtr->GetRouterId ()) == affected.end ())
+        {
+          std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator patch = patches.find (rtr->GetRouterId ());
+          if (patch != patches.end ())
+            {
+              ApplyLSAShrinks (rtr->GetRoutingProtocol (), shrinks, patch->second);
+            }
+          continue;
+        }
+      m_spfRanks.erase (rtr->GetRouterId ());
+      DeleteRoutes (node, rtr->GetRoutingProtocol ());
+      if ((!MpiInterface::IsEnabled () || node->GetSystemId () == MpiInterface::GetSystemId ())
+          && rtr->GetNumLSAs ())
+        {
+          nodes.push_back (node);
+        }
+    }
+  NS_LOG_INFO ("Recomputing the routes of " << nodes.size () << " routers, patching those of " << patches.size ());
+  SPFCalculate (nodes);
+}
+
+//
+// The SPF run of a router only depends on the LSAs it reaches, in the order
+// it adds them to its tree: it follows the links of each vertex to the
+// vertices not yet in the tree, and adds routes to the destinations of the
+// vertex with the exits that the tree gives it.  So a router whose own LSA
+// did not change gets the same tree, in the same order, unless a vertex it
+// reached changed the links it follows, that is the links to the vertices
+// it added to its tree later or not at all; the rank of each vertex in the
+// tree of each router is kept for this.  The exits of the router, though,
+// are taken from the links of its neighbors back to it, so a change next
+// to it affects it too.  With the same tree, a vertex that gained
+// destinations needs a recomputation, while one that lost some only needs
+// the routes to them removed.
+//
+// The routers that do not reach a changed LSA, in the old or the new
+// topology, are found with the connected components of the union of both
+// link state graphs; all the routers are affected if the AS external LSAs
+// changed, and so are those whose tree is not known.  A stub router only
+// gets a default route through its neighbor, so it is only affected by a
+// change of its own LSA or of the LSA of its neighbor.
+//
+void
+GlobalRouteManagerImpl::FindAffectedRouters (const GlobalRouteManagerLSDB& old, std::set<Ipv4Address>& affected,
+                                             std::vector<LSAShrink>& shrinks,
+                                             std::map<Ipv4Address, std::vector<uint32_t> >& patches) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::set<Ipv4Address> changed;
+  bool externalsChanged = m_lsdb->Compare (old, changed);
+  NS_LOG_LOGIC (changed.size () << " LSAs changed");
+
+  const GlobalRouteManagerLSDB* databases[2] = { m_lsdb, &old };
+  LSAComponents components;
+  for (uint32_t d = 0; d < 2; d++)
+    {
+      for (uint32_t i = 0; i < databases[d]->GetNumLSAs (); i++)
+        {
+          GlobalRoutingLSA* lsa = databases[d]->GetLSAByIndex (i);
+          components.Union (lsa->GetLinkStateId (), lsa->GetLinkStateId ());
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+                  || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  components.Union (lsa->GetLinkStateId (), lr->GetLinkId ());
+                }
+            }
+        }
+    }
+  std::set<uint32_t> tainted;
+  for (std::set<Ipv4Address>::const_iterator i = changed.begin (); i != changed.end (); i++)
+    {
+      tainted.insert (components.Find (*i));
+    }
+//
+// Sort out what the changed LSAs do.  The networks a changed router is
+// attached to may resolve their attached routers differently, so their links
+// are compared too, and a router next to them takes its exits from the
+// changed router.
+//
+  std::set<Ipv4Address> nextTo;
+  std::set<Ipv4Address> relinked;
+  std::vector<Ipv4Address> grown;
+  std::vector<Ipv4Address> shrunk;
+  for (std::set<Ipv4Address>::const_iterator i = changed.begin (); i != changed.end (); i++)
+    {
+      GlobalRoutingLSA* lsas[2] = { old.GetLSA (*i), m_lsdb->GetLSA (*i) };
+      nextTo.insert (*i);
+      relinked.insert (*i);
+      for (uint32_t d = 0; d < 2; d++)
+        {
+          for (uint32_t j = 0; lsas[d] != 0 && j < lsas[d]->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *lr = lsas[d]->GetLinkRecord (j);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  nextTo.insert (lr->GetLinkId ());
+                  relinked.insert (lr->GetLinkId ());
+                }
+            }
+        }
+      if (lsas[0] == 0 || lsas[1] == 0)
+        {
+          grown.push_back (*i);
+          continue;
+        }
+      std::vector<Ipv4Address> hosts[2];
+      LSANetworks networks[2];
+      GetLSADestinations (lsas[0], hosts[0], networks[0]);
+      GetLSADestinations (lsas[1], hosts[1], networks[1]);
+      std::vector<Ipv4Address> removedHosts;
+      LSANetworks removedNetworks;
+      if (!GetRemoved (hosts[0], hosts[1], removedHosts)
+          || !GetRemoved (networks[0], networks[1], removedNetworks))
+        {
+          grown.push_back (*i);
+        }
+      else if (!removedHosts.empty () || !removedNetworks.empty ())
+        {
+          shrunk.push_back (*i);
+        }
+    }
+  std::vector<Ipv4Address> edgeVertices;
+  std::vector<LSAEdges> edges[2];
+  for (std::set<Ipv4Address>::const_iterator i = relinked.begin (); i != relinked.end (); i++)
+    {
+      LSAEdges oldEdges;
+      LSAEdges newEdges;
+      GetLSAEdges (old, old.GetLSA (*i), oldEdges);
+      GetLSAEdges (*m_lsdb, m_lsdb->GetLSA (*i), newEdges);
+      if (oldEdges != newEdges)
+        {
+          edgeVertices.push_back (*i);
+          edges[0].push_back (oldEdges);
+          edges[1].push_back (newEdges);
+        }
+    }
+//
+// The routes to a destination that only the shrunk LSA advertised all go;
+// for the others, the exits toward the LSA are those of the routes to one
+// such destination.  Without one, the routers reaching the LSA recompute.
+//
+  if (!shrunk.empty ())
+    {
+      sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> hostCount;
+      std::map<std::pair<uint32_t, uint32_t>, uint32_t> networkCount;
+      std::vector<Ipv4Address> hosts;
+      LSANetworks networks;
+      for (uint32_t i = 0; i < old.GetNumLSAs (); i++)
+        {
+          GetLSADestinations (old.GetLSAByIndex (i), hosts, networks);
+          for (uint32_t j = 0; j < hosts.size (); j++)
+            {
+              hostCount[hosts[j]]++;
+            }
+          for (uint32_t j = 0; j < networks.size (); j++)
+            {
+              networkCount[networks[j]]++;
+            }
+        }
+      for (uint32_t i = 0; i < shrunk.size (); i++)
+        {
+          std::vector<Ipv4Address> oldHosts;
+          std::vector<Ipv4Address> removedHosts;
+          LSANetworks oldNetworks;
+          LSANetworks removedNetworks;
+          GetLSADestinations (old.GetLSA (shrunk[i]), oldHosts, oldNetworks);
+          GetLSADestinations (m_lsdb->GetLSA (shrunk[i]), hosts, networks);
+          GetRemoved (oldHosts, hosts, removedHosts);
+          GetRemoved (oldNetworks, networks, removedNetworks);
+
+          LSAShrink shrink;
+          shrink.vertex = shrunk[i];
+          shrink.haveExit = false;
+          for (uint32_t j = 0; j < oldHosts.size () && !shrink.haveExit; j++)
+            {
+              if (hostCount[oldHosts[j]] == 1)
+                {
+                  shrink.haveExit = true;
+                  shrink.exit.type = SPFRoute::HOST;
+                  shrink.exit.dest = oldHosts[j];
+                  shrink.exit.mask = Ipv4Mask::GetOnes ();
+                }
+            }
+          for (uint32_t j = 0; j < oldNetworks.size () && !shrink.haveExit; j++)
+            {
+              if (networkCount[oldNetworks[j]] == 1)
+                {
+                  shrink.haveExit = true;
+                  shrink.exit.type = SPFRoute::NETWORK;
+                  shrink.exit.dest = Ipv4Address (oldNetworks[j].first);
+                  shrink.exit.mask = Ipv4Mask (oldNetworks[j].second);
+                }
+            }
+          SPFRoute route;
+          route.outIf = 0;
+          for (uint32_t j = 0; j < removedHosts.size (); j++)
+            {
+              route.type = SPFRoute::HOST;
+              route.dest = removedHosts[j];
+              route.mask = Ipv4Mask::GetOnes ();
+              (hostCount[removedHosts[j]] == 1 ? shrink.unique : shrink.shared).push_back (route);
+            }
+          for (uint32_t j = 0; j < removedNetworks.size (); j++)
+            {
+              route.type = SPFRoute::NETWORK;
+              route.dest = Ipv4Address (removedNetworks[j].first);
+              route.mask = Ipv4Mask (removedNetworks[j].second);
+              (networkCount[removedNetworks[j]] == 1 ? shrink.unique : shrink.shared).push_back (route);
+            }
+          if (!shrink.shared.empty () && !shrink.haveExit)
+            {
+              grown.push_back (shrunk[i]);
+            }
+          else
+            {
+              shrinks.push_back (shrink);
+            }
+        }
+    }
+
+  std::set<Ipv4Address> seen;
+  for (uint32_t d = 0; d < 2; d++)
+    {
+      for (uint32_t i = 0; i < databases[d]->GetNumLSAs (); i++)
+        {
+          GlobalRoutingLSA* lsa = databases[d]->GetLSAByIndex (i);
+          Ipv4Address id = lsa->GetLinkStateId ();
+          if (lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+            {
+              continue;
+            }
+          if (changed.find (id) != changed.end ())
+            {
+              affected.insert (id);
+              continue;
+            }
+//
+// The LSA did not change, so it is the same in both databases.  Tell stub
+// routers, as CheckForStubNode does: a single point-to-point link whose
+// peer links back.
+//
+          uint32_t nTransits = 0;
+          GlobalRoutingLinkRecord *p2p = 0;
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                {
+                  nTransits++;
+                  p2p = lr;
+                }
+              else if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  nTransits++;
+                }
+            }
+          bool stub = nTransits == 0;
+          if (nTransits == 1 && p2p != 0)
+            {
+              GlobalRoutingLSA* peer = databases[d]->GetLSA (p2p->GetLinkId ());
+              for (uint32_t j = 0; peer != 0 && j < peer->GetNLinkRecords (); j++)
+                {
+                  GlobalRoutingLinkRecord *lr = peer->GetLinkRecord (j);
+                  if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint && lr->GetLinkId () == id)
+                    {
+                      stub = true;
+                      if (changed.find (peer->GetLinkStateId ()) != changed.end ())
+                        {
+                          affected.insert (id);
+                        }
+                      break;
+                    }
+                }
+            }
+          if (stub || !seen.insert (id).second
+              || (tainted.find (components.Find (id)) == tainted.end () && !externalsChanged))
+            {
+              continue;
+            }
+          sgi::hash_map<Ipv4Address, std::vector<uint32_t>, Ipv4AddressHash>::const_iterator ranks =
+            m_spfRanks.find (id);
+          if (externalsChanged || ranks == m_spfRanks.end ())
+            {
+              affected.insert (id);
+              continue;
+            }
+          bool recompute = false;
+          for (uint32_t j = 0; j < lsa->GetNLinkRecords () && !recompute; j++)
+            {
+              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+              recompute = lr->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork
+                && nextTo.find (lr->GetLinkId ()) != nextTo.end ();
+            }
+          for (uint32_t j = 0; j < grown.size () && !recompute; j++)
+            {
+              recompute = GetSPFRank (ranks->second, grown[j]) != SPF_UNREACHED;
+            }
+          for (uint32_t j = 0; j < edgeVertices.size () && !recompute; j++)
+            {
+              uint32_t rank = GetSPFRank (ranks->second, edgeVertices[j]);
+              if (rank == SPF_UNREACHED)
+                {
+                  continue;
+                }
+              // the links the SPF run follows, to the vertices it adds later
+              LSAEdges followed[2];
+              for (uint32_t e = 0; e < 2; e++)
+                {
+                  for (LSAEdges::const_iterator k = edges[e][j].begin (); k != edges[e][j].end (); k++)
+                    {
+                      if (GetSPFRank (ranks->second, k->first) > rank)
+                        {
+                          followed[e].push_back (*k);
+                        }
+                    }
+                }
+              recompute = followed[0] != followed[1];
+            }
+          if (recompute)
+            {
+              affected.insert (id);
+              continue;
+            }
+          for (uint32_t j = 0; j < shrinks.size (); j++)
+            {
+              if (GetSPFRank (ranks->second, shrinks[j].vertex) != SPF_UNREACHED)
+                {
+                  patches[id].push_back (j);
+                }
+            }
+        }
+    }
+  NS_LOG_LOGIC (affected.size () << " routers affected, " << patches.size () << " patched");
+}
+
+//
+// Remove the routes to the destinations the shrunk LSAs lost, with the
+// exits read before any route is removed.
+//
+void
+GlobalRouteManagerImpl::ApplyLSAShrinks (Ptr<Ipv4GlobalRouting> routing, const std::vector<LSAShrink>& shrinks,
+                                         const std::vector<uint32_t>& indices) const
+{
+  NS_LOG_FUNCTION (routing << indices.size ());
+  std::vector<Ipv4RoutingTableEntry> hostRoutes;
+  std::vector<Ipv4RoutingTableEntry> networkRoutes;
+  std::vector<Ipv4RoutingTableEntry> routes;
+  std::vector<Ipv4RoutingTableEntry> exits;
+  for (uint32_t i = 0; i < indices.size (); i++)
+    {
+      const LSAShrink& shrink = shrinks[indices[i]];
+      exits.clear ();
+      if (shrink.haveExit)
+        {
+          if (shrink.exit.type == SPFRoute::HOST)
+            {
+              routing->GetHostRoutesTo (shrink.exit.dest, exits);
+            }
+          else
+            {
+              routing->GetNetworkRoutesTo (shrink.exit.dest, shrink.exit.mask, exits);
+            }
+        }
+      for (std::vector<SPFRoute>::const_iterator j = shrink.unique.begin (); j != shrink.unique.end (); j++)
+        {
+          if (j->type == SPFRoute::HOST)
+            {
+              routing->GetHostRoutesTo (j->dest, routes);
+              hostRoutes.insert (hostRoutes.end (), routes.begin (), routes.end ());
+            }
+          else
+            {
+              routing->GetNetworkRoutesTo (j->dest, j->mask, routes);
+              networkRoutes.insert (networkRoutes.end (), routes.begin (), routes.end ());
+            }
+        }
+      for (std::vector<SPFRoute>::const_iterator j = shrink.shared.begin (); j != shrink.shared.end (); j++)
+        {
+          for (std::vector<Ipv4RoutingTableEntry>::const_iterator k = exits.begin (); k != exits.end (); k++)
+            {
+              if (j->type == SPFRoute::HOST)
+                {
+                  hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (j->dest, k->GetGateway (), k->GetInterface ()));
+                }
+              else
+                {
+                  networkRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (j->dest, j->mask, k->GetGateway (), k->GetInterface ()));
+                }
+            }
+        }
+    }
+  routing->RemoveRoutes (hostRoutes, networkRoutes);
+}
+
+//
+// The SPF calculations run in batches: the jobs of a batch are prepared
+// from the nodes, run on the threads, then their routes are installed, so
+// that the threads never touch the nodes or their routing protocols.  The
+// threads are started once and wait for the batches in between.
+//
+void
+GlobalRouteManagerImpl::SPFCalculate (const std::vector<Ptr<Node> >& nodes)
+{
+  NS_LOG_FUNCTION (nodes.size ());
+  UintegerValue value;
+  g_spfThreads.GetValue (value);
+  uint32_t nThreads = std::max<uint32_t> (value.Get (), 1);
+#ifndef HAVE_PTHREAD_H
+  nThreads = 1;
+#endif
+  nThreads = std::min<uint32_t> (nThreads, nodes.size ());
+  if (nodes.empty ())
+    {
+      return;
+    }
+  m_haveNodes = NodeList::GetNNodes () > 0;
+  BooleanValue incremental;
+  g_incrementalSpf.GetValue (incremental);
+
+  // this thread works too, along with nThreads - 1 workers
+  SPFJobQueue queue (nThreads - 1);
+  m_queue = &queue;
+  std::vector<GlobalRouteManagerImpl*> workers;
+#ifdef HAVE_PTHREAD_H
+  std::vector<Ptr<SystemThread> > threads;
+#endif
+  for (uint32_t t = 1; t < nThreads; t++)
+    {
+      GlobalRouteManagerImpl* worker = new GlobalRouteManagerImpl (m_lsdb);
+      worker->m_haveNodes = m_haveNodes;
+      worker->m_queue = &queue;
+      worker->m_workerIndex = t - 1;
+      workers.push_back (worker);
+#ifdef HAVE_PTHREAD_H
+      threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::RunSPFWorker, worker)));
+      threads.back ()->Start ();
+#endif
+    }
+
+  const uint32_t batchSize = 64 * nThreads;
+  std::vector<SPFJob> jobs;
+  for (uint32_t first = 0; first < nodes.size (); first += batchSize)
+    {
+      jobs.clear ();
+      jobs.resize (std::min<uint32_t> (batchSize, nodes.size () - first));
+      for (uint32_t i = 0; i < jobs.size (); i++)
+        {
+          Ptr<Node> node = nodes[first + i];
+          PrepareSPFJob (node, node->GetObject<GlobalRouter> ()->GetRouterId (), jobs[i]);
+          jobs[i].keepOrder = incremental.Get ();
+        }
+      queue.Start (jobs);
+      RunSPFJobs ();
+      queue.Wait ();
+      for (uint32_t i = 0; i < jobs.size (); i++)
+        {
+          RecordSPFOrder (jobs[i]);
+          InstallSPFRoutes (jobs[i]);
+        }
+    }
+  queue.Stop ();
+#ifdef HAVE_PTHREAD_H
+  for (uint32_t t = 0; t < threads.size (); t++)
+    {
+      threads[t]->Join ();
+    }
+#endif
+  m_queue = 0;
+  for (uint32_t t = 0; t < workers.size (); t++)
+    {
+      delete workers[t];
+    }
+}
+
+void
+GlobalRouteManagerImpl::RunSPFJobs (void)
+{
+  for (SPFJob* job = m_queue->Pop (); job != 0; job = m_queue->Pop ())
+    {
+      SPFCalculate (*job);
+    }
+}
+
+void
+GlobalRouteManagerImpl::RunSPFWorker (void)
+{
+  while (m_queue->WaitForBatch (m_workerIndex))
+    {
+      RunSPFJobs ();
+      m_queue->Finish ();
+    }
+}
+
+void
+GlobalRouteManagerImpl::RecordSPFOrder (const SPFJob& job)
+{
+  if (!job.keepOrder)
+    {
+      return;
+    }
+  if (job.order.empty ())
+    {
+      m_spfRanks.erase (job.root);
+      return;
+    }
+  std::vector<uint32_t> indices;
+  for (std::vector<Ipv4Address>::const_iterator i = job.order.begin (); i != job.order.end (); i++)
+    {
+      indices.push_back (m_vertexIndex.insert (std::make_pair (*i, m_vertexIndex.size ())).first->second);
+    }
+  std::vector<uint32_t>& ranks = m_spfRanks[job.root];
+  ranks.assign (m_vertexIndex.size (), 0);
+  for (uint32_t i = 0; i < indices.size (); i++)
+    {
+      ranks[indices[i]] = i + 1;
+    }
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetSPFRank (const std::vector<uint32_t>& ranks, Ipv4Address vertex) const
+{
+  sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_vertexIndex.find (vertex);
+  if (i == m_vertexIndex.end () || i->second >= ranks.size () || ranks[i->second] == 0)
+    {
+      return SPF_UNREACHED;
+    }
+  return ranks[i->second] - 1;
+}
+
+//
+// Copy what the SPF calculation needs from the node: its interface
+// addresses, for FindOutgoingInterfaceId, and its routing protocol, for
+// InstallSPFRoutes.
 //
 void
-GlobalRouteManagerImpl::InitializeRoutes ()
+GlobalRouteManagerImpl::PrepareSPFJob (Ptr<Node> node, Ipv4Address root, SPFJob& job) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
-//
-// Walk the list of nodes in the system.
-//
-  NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  NS_LOG_FUNCTION (node << root);
+  job.root = root;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
-//
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != MpiInterface::GetSystemId ()) 
+      return;
+    }
+  Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+  NS_ASSERT_MSG (rtr, "GlobalRouteManagerImpl::PrepareSPFJob (): GetObject for <GlobalRouter> interface failed");
+  job.routing = rtr->GetRoutingProtocol ();
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, "GlobalRouteManagerImpl::PrepareSPFJob (): GetObject for <Ipv4> interface failed");
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
         {
-          continue;
+          job.addresses.push_back (std::make_pair (i, ipv4->GetAddress (i, j).GetLocal ()));
         }
+    }
+}
 
-//
-// if the node has a global router interface, then run the global routing
-// algorithms.
-//
-      if (rtr && rtr->GetNumLSAs () )
+void
+GlobalRouteManagerImpl::InstallSPFRoutes (const SPFJob& job) const
+{
+  NS_LOG_FUNCTION (job.root << job.routes.size ());
+  if (job.routing == 0)
+    {
+      return;
+    }
+  for (std::vector<SPFRoute>::const_iterator i = job.routes.begin (); i != job.routes.end (); i++)
+    {
+      switch (i->type)
         {
-          SPFCalculate (rtr->GetRouterId ());
+        case SPFRoute::HOST:
+          job.routing->AddHostRouteTo (i->dest, i->nextHop, i->outIf);
+          break;
+        case SPFRoute::NETWORK:
+          job.routing->AddNetworkRouteTo (i->dest, i->mask, i->nextHop, i->outIf);
+          break;
+        case SPFRoute::EXTERNAL:
+          job.routing->AddASExternalRouteTo (i->dest, i->mask, i->nextHop, i->outIf);
+          break;
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask, Ipv4Address nextHop, uint32_t outIf)
+{
+  SPFRoute route;
+  route.type = type;
+  route.dest = dest;
+  route.mask = mask;
+  route.nextHop = nextHop;
+  route.outIf = outIf;
+  m_job->routes.push_back (route);
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetStatus (GlobalRoutingLSA* lsa) const
+{
+  sgi::hash_map<Ipv4Address, GlobalRoutingLSA::SPFStatus, Ipv4AddressHash>::const_iterator i =
+    m_status.find (lsa->GetLinkStateId ());
+  return i == m_status.end () ? GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED : i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_status[lsa->GetLinkStateId ()] = status;
 }
 
 //
@@ -822,7 +1872,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -846,7 +1896,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -858,7 +1908,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -873,7 +1923,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -945,7 +1995,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.DecreaseKey (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1305,12 +2355,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  AddRoute (SPFRoute::NETWORK, Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
+                            FindOutgoingInterfaceId (transitLink->GetLinkData ()));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
                                 FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1322,17 +2368,42 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
   return false;
 }
 
-// quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  Ptr<Node> node = 0;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr && rtr->GetRouterId () == root)
+        {
+          node = *i;
+          break;
+        }
+    }
+  m_haveNodes = NodeList::GetNNodes () > 0;
+  SPFJob job;
+  PrepareSPFJob (node, root, job);
+  SPFCalculate (job);
+  InstallSPFRoutes (job);
+}
+
+// quagga ospf_spf_calculate
+void
+GlobalRouteManagerImpl::SPFCalculate (SPFJob& job)
+{
+  Ipv4Address root = job.root;
+  NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Start from unexplored LSAs; the status of the LSAs is kept by this SPF
+// run rather than in the shared database.
 //
-  m_lsdb->Initialize ();
+  m_job = &job;
+  m_status.clear ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1352,8 +2423,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+  job.order.clear ();
+  if (job.keepOrder)
+    {
+      job.order.push_back (root);
+    }
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1362,10 +2438,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_haveNodes && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      job.order.clear ();
       delete m_spfroot;
+      m_spfroot = 0;
+      m_job = 0;
       return;
     }
 
@@ -1413,7 +2492,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      if (job.keepOrder)
+        {
+          job.order.push_back (v->GetVertexId ());
+        }
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1487,6 +2570,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_job = 0;
 }
 
 void
@@ -1545,108 +2629,44 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.
+//
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
+// The vertex <v> has the next hops and outbound interfaces that the root
+// node uses to reach the advertising router; the routes to the external
+// network go the same ways.  They are recorded in the SPF job of the root
+// and installed once the calculation is over.
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          AddRoute (SPFRoute::EXTERNAL, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
-
 // Processing logic from RFC 2328, page 166 and quagga ospf_spf_process_stubs ()
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
@@ -1705,122 +2725,50 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  The routes are recorded
+// in the SPF job of the root, and installed once the calculation is over.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// The vertex <v> (corresponding to the node that has the stub network) has
+// the next hops and outbound interfaces precalculated for us, that the root
+// node uses to forward packets to it.
+//
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
-// Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// Return the interface number corresponding to a given IP address and mask,
+// as GetInterfaceForPrefix() does on the root node, but from the addresses
+// copied into the SPF job.
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
@@ -1828,70 +2776,19 @@ int32_t
 GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (a << amask);
-//
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_ASSERT_MSG (m_job, "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): No SPF job");
+  for (std::vector<std::pair<uint32_t, Ipv4Address> >::const_iterator i = m_job->addresses.begin ();
+       i != m_job->addresses.end (); i++)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
+      if (i->second.CombineMask (amask) == a.CombineMask (amask))
         {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
+          return i->first;
         }
     }
 //
 // Couldn't find it.
 //
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find interface of " << a << " on root node " << m_job->root);
   return -1;
 }
 
@@ -1920,69 +2817,24 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  The routes are recorded
+// in the SPF job of the root, and installed once the calculation is over.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
-//
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -1991,71 +2843,56 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Router " << routerId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
+// We're going to add a host route to the host address found in the
+// m_linkData field of the point-to-point link record.  In the case of a
+// point-to-point link, this is the local IP address of the node connected
+// to the link.  The vertex <v> (corresponding to the node that has these
+// links and interfaces) has an m_nextHop address precalculated for us that
+// is the address to which the root node should send packets to be forwarded
+// to these IP addresses.  Similarly, the vertex <v> has an m_rootOif
+// (outbound interface index) to which the packets should be send for
+// forwarding.
 //
-// Done adding the routes for the selected node.
+// Walk through all available exit directions due to ECMP, and add a host
+// route for each of the exit directions toward the vertex 'v'.
 //
-          return;
-        }
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              AddRoute (SPFRoute::HOST, lr->GetLinkData (), Ipv4Mask::GetOnes (), nextHop, outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2065,104 +2902,48 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  The routes are recorded
+// in the SPF job of the root, and installed once the calculation is over.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+// Get the Global Router Link State Advertisement of the transit network
+// vertex, whose network and mask the routes go to.
+//
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add a network route for each of the exit directions toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-      if (rtr == 0)
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
         }
-    } 
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
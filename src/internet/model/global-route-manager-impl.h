@@ -26,10 +26,12 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -550,6 +552,8 @@ private:
   ListOfSPFVertex_t m_parents;
   ListOfSPFVertex_t m_children;
   bool m_vertexProcessed; 
+  /// position of the vertex in the heap of the CandidateQueue holding it
+  uint32_t m_candidateIndex;
 
 /**
  * @brief The SPFVertex copy construction is disallowed.  There's no need for
@@ -566,6 +570,7 @@ private:
   //friend std::ostream& operator<< (std::ostream& os, const ListOfIf_t& ifs);
   //friend std::ostream& operator<< (std::ostream& os, const ListOfAddr_t& addrs);
   friend std::ostream& operator<< (std::ostream& os, const SPFVertex::ListOfSPFVertex_t& vs);
+  friend class CandidateQueue;
 };
 
 /**
@@ -667,13 +672,45 @@ public:
   GlobalRoutingLSA* GetExtLSA (uint32_t index) const;
   uint32_t GetNumExtLSAs () const;
 
+/**
+ * @brief Get the number of router and network LSAs in the database.
+ * @internal
+ */
+  uint32_t GetNumLSAs () const;
+
+/**
+ * @brief Get a router or network LSA, in insertion order.
+ * @internal
+ *
+ * @param index an index in [0, GetNumLSAs ())
+ */
+  GlobalRoutingLSA* GetLSAByIndex (uint32_t index) const;
+
+/**
+ * @brief Find the LSAs that differ between this database and another one,
+ * such as the one built before a topology change.
+ * @internal
+ *
+ * @param other the database to compare with
+ * @param changed (returned) the link state IDs of the router and network
+ * LSAs found in a single database, or different in the two
+ * @returns true if the AS external LSAs differ
+ */
+  bool Compare (const GlobalRouteManagerLSDB& other, std::set<Ipv4Address>& changed) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t;
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t;
+  typedef sgi::hash_map<Ipv4Address, LSDBPair_t, Ipv4AddressHash> LinkDataIndex_t;
 
   LSDBMap_t m_database;
   std::vector<GlobalRoutingLSA*> m_extdatabase;
+  // the LSAs of m_database, in insertion order
+  std::vector<GlobalRoutingLSA*> m_lsas;
+  // the LSA of GetLSAByLinkData for the link data of each transit link
+  // record, the one with the lowest link state ID as in a walk of
+  // m_database
+  LinkDataIndex_t m_linkDataIndex;
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -698,6 +735,13 @@ private:
  * and finally configure each of the node's forwarding tables.
  *
  * The design is guided by OSPFv2 RFC 2328 section 16.1.1 and quagga ospfd.
+ *
+ * The SPF calculations of the routers only read the link state database.
+ * They can run on several threads, as set by the GlobalRoutingSpfThreads
+ * global value, while the routes they find are installed by the main
+ * thread, in node order.  After a topology change, UpdateRoutes can
+ * recompute only the routers that the changed LSAs may affect, if the
+ * GlobalRoutingIncrementalSpf global value is true.
  */
 class GlobalRouteManagerImpl
 {
@@ -729,6 +773,22 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Bring the routes up to date after a topology change
+ * @internal
+ *
+ * This is DeleteGlobalRoutes, BuildGlobalRoutingDatabase and
+ * InitializeRoutes, unless incremental SPF is enabled.  Then the new
+ * database is compared with the one the routes were computed from, and
+ * only the routers whose SPF run would go differently are recomputed:
+ * the routers whose own LSA changed, the routers next to a changed LSA,
+ * the routers whose SPF run follows a changed link or reaches a vertex
+ * with new destinations, and the stub routers whose single neighbor
+ * changed.  The routers that only reach destinations which went away
+ * have the routes to them removed.
+ */
+  virtual void UpdateRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  * @internal
@@ -756,10 +816,102 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+/**
+ * @brief A route found by an SPF calculation
+ */
+  struct SPFRoute
+  {
+    enum Type
+    {
+      HOST,
+      NETWORK,
+      EXTERNAL
+    } type;
+    Ipv4Address dest;
+    Ipv4Mask mask;
+    Ipv4Address nextHop;
+    uint32_t outIf;
+  };
+
+/**
+ * @brief The SPF calculation of a router.  Everything an SPF run needs
+ * from the node is copied beforehand, so that the run only reads the
+ * LSDB and can go on any thread.
+ */
+  struct SPFJob
+  {
+    SPFJob ();
+    Ipv4Address root;
+    Ptr<Ipv4GlobalRouting> routing;
+    // the (interface, local address) pairs of the node, in interface order
+    std::vector<std::pair<uint32_t, Ipv4Address> > addresses;
+    std::vector<SPFRoute> routes;
+    // whether to record the vertices in the order they join the SPF tree,
+    // root first; none are recorded for a stub router
+    bool keepOrder;
+    std::vector<Ipv4Address> order;
+  };
+
+/**
+ * @brief The destinations that a changed router LSA no longer advertises,
+ * while the rest of its LSA stays the same
+ * @internal
+ *
+ * The destinations that only this LSA advertised lose all their routes;
+ * the others lose the routes through the exits of the LSA, which are
+ * those of the routes to exit, a destination only this LSA advertised.
+ */
+  struct LSAShrink
+  {
+    Ipv4Address vertex;
+    bool haveExit;
+    SPFRoute exit;
+    std::vector<SPFRoute> unique;
+    std::vector<SPFRoute> shared;
+  };
+
+  class SPFJobQueue;
+
+/**
+ * @brief Create a worker running SPF calculations on the LSDB of another
+ * GlobalRouteManagerImpl, which it does not own.
+ */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb);
+
   SPFVertex* m_spfroot;
   GlobalRouteManagerLSDB* m_lsdb;
+  bool m_ownsLsdb;
+  // the state of the SPF run in progress
+  sgi::hash_map<Ipv4Address, GlobalRoutingLSA::SPFStatus, Ipv4AddressHash> m_status;
+  SPFJob* m_job;
+  bool m_haveNodes;
+  // the jobs a worker takes its SPF calculations from
+  SPFJobQueue* m_queue;
+  uint32_t m_workerIndex;
+  // for incremental SPF, the rank at which each vertex joined the SPF tree
+  // of each router, plus one, or zero if it was not reached; the vertices
+  // are indexed in the order they are first seen
+  sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_vertexIndex;
+  sgi::hash_map<Ipv4Address, std::vector<uint32_t>, Ipv4AddressHash> m_spfRanks;
+
+  GlobalRoutingLSA::SPFStatus GetStatus (GlobalRoutingLSA* lsa) const;
+  void SetStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
+  void PrepareSPFJob (Ptr<Node> node, Ipv4Address root, SPFJob& job) const;
+  void InstallSPFRoutes (const SPFJob& job) const;
+  void SPFCalculate (const std::vector<Ptr<Node> >& nodes);
+  void RunSPFJobs (void);
+  void RunSPFWorker (void);
+  void RecordSPFOrder (const SPFJob& job);
+  uint32_t GetSPFRank (const std::vector<uint32_t>& ranks, Ipv4Address vertex) const;
+  void AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask, Ipv4Address nextHop, uint32_t outIf);
+  void FindAffectedRouters (const GlobalRouteManagerLSDB& old, std::set<Ipv4Address>& affected,
+                            std::vector<LSAShrink>& shrinks,
+                            std::map<Ipv4Address, std::vector<uint32_t> >& patches) const;
+  void ApplyLSAShrinks (Ptr<Ipv4GlobalRouting> routing, const std::vector<LSAShrink>& shrinks,
+                        const std::vector<uint32_t>& indices) const;
   bool CheckForStubNode (Ipv4Address root);
   void SPFCalculate (Ipv4Address root);
+  void SPFCalculate (SPFJob& job);
   void SPFProcessStubs (SPFVertex* v);
   void ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa);
   void SPFNext (SPFVertex*, CandidateQueue&);
@@ -67,6 +67,14 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Bring the routes up to date after a topology change, recomputing
+ * only the affected routers if the GlobalRoutingIncrementalSpf global value
+ * is true
+ * @internal
+ */
+  static void UpdateRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
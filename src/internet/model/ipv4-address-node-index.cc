@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/simulation-singleton.h"
+#include "ipv4-address-node-index.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4AddressNodeIndex");
+
+namespace ns3 {
+
+class Ipv4AddressNodeIndexImpl
+{
+public:
+  void Add (Ipv4Address address, uint32_t nodeId);
+  void Remove (Ipv4Address address, uint32_t nodeId);
+  Ptr<Node> GetNode (Ipv4Address address) const;
+  uint32_t GetNAddresses (void) const;
+
+private:
+  // the ids of the nodes owning each address, in increasing order,
+  // once per interface address
+  typedef sgi::hash_map<Ipv4Address, std::vector<uint32_t>, Ipv4AddressHash> Index;
+
+  Index m_index;
+};
+
+void
+Ipv4AddressNodeIndexImpl::Add (Ipv4Address address, uint32_t nodeId)
+{
+  std::vector<uint32_t> &ids = m_index[address];
+  ids.insert (std::upper_bound (ids.begin (), ids.end (), nodeId), nodeId);
+}
+
+void
+Ipv4AddressNodeIndexImpl::Remove (Ipv4Address address, uint32_t nodeId)
+{
+  Index::iterator i = m_index.find (address);
+  if (i == m_index.end ())
+    {
+      return;
+    }
+  std::vector<uint32_t>::iterator j = std::lower_bound (i->second.begin (), i->second.end (), nodeId);
+  if (j != i->second.end () && *j == nodeId)
+    {
+      i->second.erase (j);
+    }
+  if (i->second.empty ())
+    {
+      m_index.erase (i);
+    }
+}
+
+Ptr<Node>
+Ipv4AddressNodeIndexImpl::GetNode (Ipv4Address address) const
+{
+  Index::const_iterator i = m_index.find (address);
+  if (i == m_index.end ())
+    {
+      return 0;
+    }
+  return NodeList::GetNode (i->second.front ());
+}
+
+uint32_t
+Ipv4AddressNodeIndexImpl::GetNAddresses (void) const
+{
+  return m_index.size ();
+}
+
+void
+Ipv4AddressNodeIndex::Add (Ipv4Address address, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (address << node->GetId ());
+  SimulationSingleton<Ipv4AddressNodeIndexImpl>::Get ()->Add (address, node->GetId ());
+}
+
+void
+Ipv4AddressNodeIndex::Remove (Ipv4Address address, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (address << node->GetId ());
+  SimulationSingleton<Ipv4AddressNodeIndexImpl>::Get ()->Remove (address, node->GetId ());
+}
+
+Ptr<Node>
+Ipv4AddressNodeIndex::GetNode (Ipv4Address address)
+{
+  return SimulationSingleton<Ipv4AddressNodeIndexImpl>::Get ()->GetNode (address);
+}
+
+uint32_t
+Ipv4AddressNodeIndex::GetNAddresses (void)
+{
+  return SimulationSingleton<Ipv4AddressNodeIndexImpl>::Get ()->GetNAddresses ();
+}
+
+} // namespace ns3
@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ADDRESS_NODE_INDEX_H
+#define IPV4_ADDRESS_NODE_INDEX_H
+
+#include "ns3/ptr.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Simulation-wide index from Ipv4 interface addresses to the
+ * nodes owning them
+ *
+ * Ipv4L3Protocol adds an entry whenever an address is added to one of
+ * its interfaces, and removes it with the address, right where the
+ * routing protocol gets NotifyAddAddress and NotifyRemoveAddress.  The
+ * loopback address, which is not added through Ipv4::AddAddress, is not
+ * indexed.
+ *
+ * If several nodes own the same address, the one with the lowest node
+ * id is returned, as a walk of the NodeList would find it.
+ *
+ * The index is cleared by Simulator::Destroy.
+ */
+class Ipv4AddressNodeIndex
+{
+public:
+  /**
+   * \param address an address of the node
+   * \param node the node owning the address
+   *
+   * Called by Ipv4L3Protocol::AddAddress.
+   */
+  static void Add (Ipv4Address address, Ptr<Node> node);
+
+  /**
+   * \param address an address of the node
+   * \param node the node which no longer owns the address
+   *
+   * Called by Ipv4L3Protocol::RemoveAddress.
+   */
+  static void Remove (Ipv4Address address, Ptr<Node> node);
+
+  /**
+   * \param address an Ipv4 interface address
+   * \returns the node owning the address, or 0 if no node does
+   */
+  static Ptr<Node> GetNode (Ipv4Address address);
+
+  /**
+   * \returns the number of distinct addresses in the index
+   */
+  static uint32_t GetNAddresses (void);
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ADDRESS_NODE_INDEX_H */
@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ipv4-flow-hash.h"
+#include "tcp-l4-protocol.h"
+#include "udp-l4-protocol.h"
+
+namespace ns3 {
+
+// one round of MurmurHash3
+static uint32_t
+Murmur3Mix (uint32_t h, uint32_t k)
+{
+  k *= 0xcc9e2d51;
+  k = (k << 15) | (k >> 17);
+  k *= 0x1b873593;
+  h ^= k;
+  h = (h << 13) | (h >> 19);
+  return h * 5 + 0xe6546b64;
+}
+
+static uint32_t
+Murmur3Final (uint32_t h, uint32_t length)
+{
+  h ^= length;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static uint32_t
+Fnv1a (uint32_t seed, const uint8_t *key, uint32_t length)
+{
+  uint32_t h = 2166136261U ^ seed;
+  for (uint32_t i = 0; i < length; i++)
+    {
+      h ^= key[i];
+      h *= 16777619;
+    }
+  return h;
+}
+
+static uint32_t
+Crc32 (uint32_t seed, const uint8_t *key, uint32_t length)
+{
+  uint32_t crc = ~seed;
+  for (uint32_t i = 0; i < length; i++)
+    {
+      crc ^= key[i];
+      for (uint32_t bit = 0; bit < 8; bit++)
+        {
+          crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+  return ~crc;
+}
+
+uint32_t
+Ipv4FlowHash::Hash (Ptr<const Packet> packet, const Ipv4Header &header, uint32_t seed, enum Function function)
+{
+  uint8_t protocol = header.GetProtocol ();
+  uint32_t ports = 0;
+  if (packet != 0
+      && (protocol == TcpL4Protocol::PROT_NUMBER || protocol == UdpL4Protocol::PROT_NUMBER))
+    {
+      Ipv4FlowPortsTag tag;
+      if (packet->PeekPacketTag (tag))
+        {
+          ports = tag.GetPorts ();
+        }
+      else if (packet->GetSize () >= 4)
+        {
+          uint8_t buffer[4];
+          packet->CopyData (buffer, 4);
+          ports = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+        }
+    }
+  uint32_t source = header.GetSource ().Get ();
+  uint32_t destination = header.GetDestination ().Get ();
+
+  if (function == MURMUR3)
+    {
+      uint32_t h = seed;
+      h = Murmur3Mix (h, source);
+      h = Murmur3Mix (h, destination);
+      h = Murmur3Mix (h, protocol);
+      h = Murmur3Mix (h, ports);
+      return Murmur3Final (h, 16);
+    }
+
+  // the 5-tuple in network byte order
+  uint8_t key[13];
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      key[i] = source >> (24 - 8 * i);
+      key[4 + i] = destination >> (24 - 8 * i);
+      key[9 + i] = ports >> (24 - 8 * i);
+    }
+  key[8] = protocol;
+  if (function == FNV1A)
+    {
+      return Fnv1a (seed, key, sizeof (key));
+    }
+  return Crc32 (seed, key, sizeof (key));
+}
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4FlowPortsTag);
+
+Ipv4FlowPortsTag::Ipv4FlowPortsTag ()
+  : m_ports (0)
+{
+}
+
+Ipv4FlowPortsTag::Ipv4FlowPortsTag (uint16_t sourcePort, uint16_t destinationPort)
+  : m_ports ((uint32_t (sourcePort) << 16) | destinationPort)
+{
+}
+
+uint32_t
+Ipv4FlowPortsTag::GetPorts (void) const
+{
+  return m_ports;
+}
+
+TypeId
+Ipv4FlowPortsTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4FlowPortsTag")
+    .SetParent<Tag> ()
+    .AddConstructor<Ipv4FlowPortsTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+Ipv4FlowPortsTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+Ipv4FlowPortsTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+
+void
+Ipv4FlowPortsTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_ports);
+}
+
+void
+Ipv4FlowPortsTag::Deserialize (TagBuffer i)
+{
+  m_ports = i.ReadU32 ();
+}
+
+void
+Ipv4FlowPortsTag::Print (std::ostream &os) const
+{
+  os << "SourcePort=" << (m_ports >> 16) << " DestinationPort=" << (m_ports & 0xffff);
+}
+
+} // namespace ns3
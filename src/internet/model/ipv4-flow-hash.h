@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_FLOW_HASH_H
+#define IPV4_FLOW_HASH_H
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief Hash of the 5-tuple of a packet, for multipath routing
+ *
+ * The hash covers the source and destination addresses, the protocol
+ * and, for TCP and UDP, the source and destination ports, read from
+ * the Ipv4FlowPortsTag of the packet if it has one, or else from the
+ * first four bytes of the packet.  Routing protocols get the packet
+ * with its transport header in RouteInput, and either the header or
+ * the tag in RouteOutput, so all the packets of a flow hash to the
+ * same value on a given node.
+ *
+ * Several hash functions are available, as in hardware routers.  They
+ * all give the same hash to the packets of a flow, but spread a given
+ * set of flows differently.
+ */
+class Ipv4FlowHash
+{
+public:
+  /**
+   * Hash functions
+   */
+  enum Function
+  {
+    MURMUR3, /**< 32-bit MurmurHash3 of the 5-tuple words */
+    FNV1A,   /**< 32-bit FNV-1a of the 13 bytes of the 5-tuple */
+    CRC32    /**< CRC-32 (IEEE 802.3) of the 13 bytes of the 5-tuple */
+  };
+
+  /**
+   * \param packet the packet, starting with its transport header, or 0
+   * \param header the Ipv4 header of the packet
+   * \param seed a value mixed into the hash, so that different nodes
+   *        or runs can spread the same flows differently
+   * \param function the hash function
+   * \returns the hash of the 5-tuple of the packet
+   */
+  static uint32_t Hash (Ptr<const Packet> packet, const Ipv4Header &header, uint32_t seed,
+                        enum Function function = MURMUR3);
+};
+
+/**
+ * \ingroup ipv4
+ *
+ * \brief The ports of a packet which has no transport header yet
+ *
+ * Sockets add this tag around the RouteOutput call they make before
+ * the transport header is built, so that Ipv4FlowHash sees the ports
+ * without the header being added and removed on every packet.
+ */
+class Ipv4FlowPortsTag : public Tag
+{
+public:
+  Ipv4FlowPortsTag ();
+  Ipv4FlowPortsTag (uint16_t sourcePort, uint16_t destinationPort);
+
+  /**
+   * \returns the source port in the high 16 bits and the destination
+   *          port in the low 16 bits, as they appear on the wire
+   */
+  uint32_t GetPorts (void) const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint32_t m_ports;
+};
+
+} // namespace ns3
+
+#endif /* IPV4_FLOW_HASH_H */
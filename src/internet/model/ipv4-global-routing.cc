@@ -17,6 +17,8 @@
 //
 
 #include <vector>
+#include <set>
+#include <algorithm>
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
@@ -27,6 +29,9 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
 
@@ -46,6 +51,23 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_randomEcmpRouting),
                    MakeBooleanChecker ())
+    .AddAttribute ("FlowEcmpRouting",
+                   "Set to true if packets are routed among ECMP by a hash of their 5-tuple, so that the packets of a flow take the same route; RandomEcmpRouting takes precedence",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_flowEcmpRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EcmpHash",
+                   "The hash function of FlowEcmpRouting",
+                   EnumValue (Ipv4FlowHash::MURMUR3),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpHash),
+                   MakeEnumChecker (Ipv4FlowHash::MURMUR3, "Murmur3",
+                                    Ipv4FlowHash::FNV1A, "Fnv1a",
+                                    Ipv4FlowHash::CRC32, "Crc32"))
+    .AddAttribute ("EcmpSeed",
+                   "The seed of the hash of FlowEcmpRouting, mixed with the node id",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpSeed),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -57,6 +79,9 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
+    m_flowEcmpRouting (false),
+    m_ecmpHash (Ipv4FlowHash::MURMUR3),
+    m_ecmpSeed (0),
     m_respondToInterfaceEvents (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -67,6 +92,13 @@ Ipv4GlobalRouting::~Ipv4GlobalRouting ()
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+void
+Ipv4GlobalRouting::AddHostRoute (Ipv4RoutingTableEntry *route)
+{
+  m_hostRoutes.push_back (route);
+  m_hostRouteGroups[route->GetDest ()].push_back (route);
+}
+
 void 
 Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest, 
                                    Ipv4Address nextHop, 
@@ -75,7 +107,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   NS_LOG_FUNCTION (dest << nextHop << interface);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
-  m_hostRoutes.push_back (route);
+  AddHostRoute (route);
 }
 
 void 
@@ -85,7 +117,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   NS_LOG_FUNCTION (dest << interface);
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
-  m_hostRoutes.push_back (route);
+  AddHostRoute (route);
 }
 
 void 
@@ -101,6 +133,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (route);
 }
 
 void 
@@ -114,6 +147,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (route);
 }
 
 void 
@@ -129,116 +163,123 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_ASexternalRouteTrie.Insert (route);
 }
 
 
 Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  Ipv4Address dest = header.GetDestination ();
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  // the routes that bring packets to their destination, kept from one
+  // lookup to the next so that lookups do not allocate
+  m_lookupRoutes.clear ();
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  NextHopGroups::const_iterator group = m_hostRouteGroups.find (dest);
+  if (group != m_hostRouteGroups.end ())
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      if (oif == 0 && group->second.size () > 0)
         {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
+          // the precomputed group of host routes
+          NS_LOG_LOGIC (group->second.size () << " global host routes found");
+          return SelectRoute (group->second, header, p);
         }
-    }
-  if (allRoutes.size () == 0) // if no host route is found
-    {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      for (NextHopGroup::const_iterator i = group->second.begin (); i != group->second.end (); i++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
             {
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
+          m_lookupRoutes.push_back (*i);
+        }
+      if (m_lookupRoutes.size () > 0)
+        {
+          NS_LOG_LOGIC (m_lookupRoutes.size () << " global host routes found");
+          return SelectRoute (m_lookupRoutes, header, p);
         }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+
+  NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
+  // every matching network route, in table order
+  m_networkRouteTrie.Lookup (dest, m_lookupMatches);
+  for (std::vector<Ipv4RouteTrie::Entry>::const_iterator j = m_lookupMatches.begin (); j != m_lookupMatches.end (); j++)
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      if (oif != 0)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          if (oif != m_ipv4->GetNetDevice (j->route->GetInterface ()))
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*k);
-              break;
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
         }
+      m_lookupRoutes.push_back (j->route);
+      NS_LOG_LOGIC (m_lookupRoutes.size () << "Found global network route" << j->route);
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  if (m_lookupRoutes.size () > 0)
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
+      return SelectRoute (m_lookupRoutes, header, p);
+    }
+
+  // consider external if no host/network found, and only the first
+  // matching one
+  if (oif == 0)
+    {
+      const Ipv4RouteTrie::Entry *external = m_ASexternalRouteTrie.LookupFirst (dest);
+      if (external != 0)
         {
-          selectIndex = m_rand.GetInteger (0, allRoutes.size ()-1);
+          NS_LOG_LOGIC ("Found external route" << external->route);
+          m_lookupRoutes.push_back (external->route);
+          return SelectRoute (m_lookupRoutes, header, p);
         }
-      else 
+      return 0;
+    }
+  m_ASexternalRouteTrie.Lookup (dest, m_lookupMatches);
+  for (std::vector<Ipv4RouteTrie::Entry>::const_iterator k = m_lookupMatches.begin (); k != m_lookupMatches.end (); k++)
+    {
+      NS_LOG_LOGIC ("Found external route" << k->route);
+      if (oif != m_ipv4->GetNetDevice (k->route->GetInterface ()))
         {
-          selectIndex = 0;
+          NS_LOG_LOGIC ("Not on requested interface, skipping");
+          continue;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
-      // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
-      // XXX handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
-      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-      return rtentry;
-    }
-  else 
+      m_lookupRoutes.push_back (k->route);
+      return SelectRoute (m_lookupRoutes, header, p);
+    }
+  return 0;
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::SelectRoute (const NextHopGroup &routes, const Ipv4Header &header, Ptr<const Packet> p)
+{
+  // pick up one of the routes uniformly at random if random
+  // ECMP routing is enabled, by the hash of the flow if flow
+  // ECMP routing is enabled, or always select the first route
+  // consistently otherwise
+  uint32_t selectIndex = 0;
+  if (m_randomEcmpRouting)
     {
-      return 0;
+      selectIndex = m_rand.GetInteger (0, routes.size ()-1);
+    }
+  else if (m_flowEcmpRouting && routes.size () > 1)
+    {
+      uint32_t nodeId = m_ipv4->GetObject<Node> ()->GetId ();
+      uint32_t hash = Ipv4FlowHash::Hash (p, header, m_ecmpSeed ^ (nodeId * 0x9e3779b9), m_ecmpHash);
+      selectIndex = hash % routes.size ();
     }
+  Ipv4RoutingTableEntry* route = routes[selectIndex]; 
+  // create a Ipv4Route object from the selected routing table entry
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route->GetDest ());
+  // XXX handle multi-address case
+  rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+  rtentry->SetGateway (route->GetGateway ());
+  uint32_t interfaceIdx = route->GetInterface ();
+  rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+  return rtentry;
 }
 
 uint32_t 
@@ -315,6 +356,13 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              NextHopGroups::iterator group = m_hostRouteGroups.find ((*i)->GetDest ());
+              NS_ASSERT (group != m_hostRouteGroups.end ());
+              group->second.erase (std::find (group->second.begin (), group->second.end (), *i));
+              if (group->second.empty ())
+                {
+                  m_hostRouteGroups.erase (group);
+                }
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -332,6 +380,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkRouteTrie.Remove (*j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -348,6 +397,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          m_ASexternalRouteTrie.Remove (*k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -358,6 +408,117 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+void
+Ipv4GlobalRouting::GetHostRoutesTo (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry> &routes) const
+{
+  NS_LOG_FUNCTION (dest);
+  routes.clear ();
+  NextHopGroups::const_iterator group = m_hostRouteGroups.find (dest);
+  if (group != m_hostRouteGroups.end ())
+    {
+      for (NextHopGroup::const_iterator i = group->second.begin (); i != group->second.end (); i++)
+        {
+          routes.push_back (**i);
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::GetNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask,
+                                       std::vector<Ipv4RoutingTableEntry> &routes) const
+{
+  NS_LOG_FUNCTION (network << networkMask);
+  routes.clear ();
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  m_networkRouteTrie.Lookup (network, matches);
+  for (std::vector<Ipv4RouteTrie::Entry>::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      if (i->route->GetDestNetwork () == network
+          && i->route->GetDestNetworkMask () == networkMask)
+        {
+          routes.push_back (*i->route);
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::RemoveRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                                 const std::vector<Ipv4RoutingTableEntry> &networkRoutes)
+{
+  NS_LOG_FUNCTION (hostRoutes.size () << networkRoutes.size ());
+  // pick the routes to remove out of their groups and the trie, then
+  // drop them from the lists in one pass
+  std::set<Ipv4RoutingTableEntry *> removed;
+  for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = hostRoutes.begin (); i != hostRoutes.end (); i++)
+    {
+      NextHopGroups::iterator group = m_hostRouteGroups.find (i->GetDest ());
+      if (group == m_hostRouteGroups.end ())
+        {
+          continue;
+        }
+      for (NextHopGroup::iterator j = group->second.begin (); j != group->second.end (); j++)
+        {
+          if ((*j)->GetGateway () == i->GetGateway () && (*j)->GetInterface () == i->GetInterface ())
+            {
+              removed.insert (*j);
+              group->second.erase (j);
+              break;
+            }
+        }
+      if (group->second.empty ())
+        {
+          m_hostRouteGroups.erase (group);
+        }
+    }
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = networkRoutes.begin (); i != networkRoutes.end (); i++)
+    {
+      m_networkRouteTrie.Lookup (i->GetDestNetwork (), matches);
+      for (std::vector<Ipv4RouteTrie::Entry>::const_iterator j = matches.begin (); j != matches.end (); j++)
+        {
+          Ipv4RoutingTableEntry *route = j->route;
+          if (route->GetDestNetwork () == i->GetDestNetwork ()
+              && route->GetDestNetworkMask () == i->GetDestNetworkMask ()
+              && route->GetGateway () == i->GetGateway ()
+              && route->GetInterface () == i->GetInterface ())
+            {
+              removed.insert (route);
+              m_networkRouteTrie.Remove (route);
+              break;
+            }
+        }
+    }
+  if (removed.empty ())
+    {
+      return;
+    }
+  for (HostRoutesI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); )
+    {
+      if (removed.count (*i))
+        {
+          delete *i;
+          i = m_hostRoutes.erase (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  for (NetworkRoutesI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); )
+    {
+      if (removed.count (*j))
+        {
+          delete *j;
+          j = m_networkRoutes.erase (j);
+        }
+      else
+        {
+          j++;
+        }
+    }
+  NS_LOG_LOGIC ("Removed " << removed.size () << " routes");
+}
+
 void
 Ipv4GlobalRouting::DoDispose (void)
 {
@@ -368,18 +529,21 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*i);
     }
+  m_hostRouteGroups.clear ();
   for (NetworkRoutesI j = m_networkRoutes.begin (); 
        j != m_networkRoutes.end (); 
        j = m_networkRoutes.erase (j)) 
     {
       delete (*j);
     }
+  m_networkRouteTrie.Clear ();
   for (ASExternalRoutesI l = m_ASexternalRoutes.begin (); 
        l != m_ASexternalRoutes.end ();
        l = m_ASexternalRoutes.erase (l))
     {
       delete (*l);
     }
+  m_ASexternalRouteTrie.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -448,7 +612,7 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, p, oif);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -526,7 +690,7 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, p);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -546,9 +710,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -558,9 +720,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -570,9 +730,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -582,9 +740,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -21,13 +21,17 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
+#include "ns3/sgi-hashmap.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable.h"
+#include "ns3/ipv4-flow-hash.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -63,6 +67,16 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * When several routes of the same kind lead to a destination, the first
+ * one is used, unless RandomEcmpRouting picks one at random for every
+ * packet, or FlowEcmpRouting picks one by a hash of the 5-tuple of the
+ * packet, so that all the packets of a flow take the same route.  The
+ * hash is seeded with EcmpSeed and the node id, so that successive
+ * routers make independent choices.  Host routes are grouped by
+ * destination as they are added, so finding the routes to a host is a
+ * single hash table lookup, and network and AS external routes are
+ * indexed by an Ipv4RouteTrie.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -211,12 +225,53 @@ public:
  */
   void RemoveRoute (uint32_t i);
 
+/**
+ * \brief Get the host routes to a destination.
+ *
+ * \param dest The destination of the routes.
+ * \param routes (returned) The host routes to dest, in table order.
+ */
+  void GetHostRoutesTo (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry> &routes) const;
+
+/**
+ * \brief Get the network routes to a network.
+ *
+ * \param network The Ipv4Address network of the routes.
+ * \param networkMask The Ipv4Mask of the network.
+ * \param routes (returned) The network routes to exactly this network and
+ * mask, in table order.
+ */
+  void GetNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask,
+                           std::vector<Ipv4RoutingTableEntry> &routes) const;
+
+/**
+ * \brief Remove host and network routes from the global routing table.
+ *
+ * Each of the given routes removes the first route of the table that has
+ * the same destination, mask, gateway and interface and that was not
+ * already removed; routes without a match are ignored.  Unlike calls to
+ * RemoveRoute, this walks the table only once.
+ *
+ * \param hostRoutes The host routes to remove.
+ * \param networkRoutes The network routes to remove.
+ *
+ * \see Ipv4GlobalRouting::RemoveRoute
+ */
+  void RemoveRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                     const std::vector<Ipv4RoutingTableEntry> &networkRoutes);
+
 protected:
   void DoDispose (void);
 
 private:
   /// Set to true if packets are randomly routed among ECMP; set to false for using only one route consistently
   bool m_randomEcmpRouting;
+  /// Set to true if packets are routed among ECMP by a hash of their 5-tuple
+  bool m_flowEcmpRouting;
+  /// The hash function of flow ECMP routing
+  enum Ipv4FlowHash::Function m_ecmpHash;
+  /// The seed of the hash of flow ECMP routing
+  uint32_t m_ecmpSeed;
   /// Set to true if this interface should respond to interface events by globallly recomputing routes 
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
@@ -231,12 +286,35 @@ private:
   typedef std::list<Ipv4RoutingTableEntry *> ASExternalRoutes;
   typedef std::list<Ipv4RoutingTableEntry *>::const_iterator ASExternalRoutesCI;
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
+  /// the host routes to each destination, in the order of m_hostRoutes
+  typedef std::vector<Ipv4RoutingTableEntry *> NextHopGroup;
+  typedef sgi::hash_map<Ipv4Address, NextHopGroup, Ipv4AddressHash> NextHopGroups;
 
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /**
+   * \param header the header of the packet to route
+   * \param p the packet, starting with its transport header, or 0
+   * \param oif the output device to use, if not 0
+   * \returns the route, or 0 if there is none
+   */
+  Ptr<Ipv4Route> LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p, Ptr<NetDevice> oif = 0);
+  /**
+   * \param routes the candidate routes, at least one
+   * \param header the header of the packet to route
+   * \param p the packet, starting with its transport header, or 0
+   * \returns the route to the candidate picked by the ECMP mode
+   */
+  Ptr<Ipv4Route> SelectRoute (const NextHopGroup &routes, const Ipv4Header &header, Ptr<const Packet> p);
+  void AddHostRoute (Ipv4RoutingTableEntry *route);
 
   HostRoutes m_hostRoutes;
+  NextHopGroups m_hostRouteGroups;
+  Ipv4RouteTrie m_networkRouteTrie;
+  Ipv4RouteTrie m_ASexternalRouteTrie;
   NetworkRoutes m_networkRoutes;
   ASExternalRoutes m_ASexternalRoutes; // External routes imported
+  // scratch space of LookupGlobal
+  NextHopGroup m_lookupRoutes;
+  std::vector<Ipv4RouteTrie::Entry> m_lookupMatches;
 
   Ptr<Ipv4> m_ipv4;
 };
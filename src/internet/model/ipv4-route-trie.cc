@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "ns3/assert.h"
+#include "ipv4-route-trie.h"
+#include "ipv4-routing-table-entry.h"
+
+namespace ns3 {
+
+namespace {
+
+// mask of the first length bits
+inline uint32_t
+PrefixMask (uint32_t length)
+{
+  return length == 0 ? 0 : 0xffffffffU << (32 - length);
+}
+
+// bit i of address, counting from the most significant one
+inline uint32_t
+GetBit (uint32_t address, uint32_t i)
+{
+  return (address >> (31 - i)) & 1;
+}
+
+bool
+CompareOrder (const Ipv4RouteTrie::Entry &a, const Ipv4RouteTrie::Entry &b)
+{
+  return a.order < b.order;
+}
+
+} // anonymous namespace
+
+Ipv4RouteTrie::Ipv4RouteTrie ()
+  : m_root (0),
+    m_nRoutes (0),
+    m_order (0)
+{
+}
+
+Ipv4RouteTrie::~Ipv4RouteTrie ()
+{
+  Clear ();
+}
+
+Ipv4RouteTrie::Node *
+Ipv4RouteTrie::NewNode (uint32_t prefix, uint32_t length)
+{
+  Node *node = new Node;
+  node->prefix = prefix;
+  node->length = length;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+void
+Ipv4RouteTrie::Delete (Node *node)
+{
+  if (node != 0)
+    {
+      Delete (node->child[0]);
+      Delete (node->child[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RouteTrie::Insert (Ipv4RoutingTableEntry *route, uint32_t metric)
+{
+  Entry entry;
+  entry.route = route;
+  entry.metric = metric;
+  entry.order = m_order++;
+  m_nRoutes++;
+
+  Ipv4Mask mask = route->GetDestNetworkMask ();
+  uint32_t inverse = ~mask.Get ();
+  if ((inverse & (inverse + 1)) != 0)
+    {
+      m_irregular.push_back (entry);
+      return;
+    }
+  uint32_t length = mask.GetPrefixLength ();
+  uint32_t prefix = route->GetDestNetwork ().Get () & mask.Get ();
+
+  Node **slot = &m_root;
+  while (true)
+    {
+      Node *node = *slot;
+      if (node == 0)
+        {
+          node = NewNode (prefix, length);
+          node->entries.push_back (entry);
+          *slot = node;
+          return;
+        }
+      // length of the common prefix of the route and the node
+      uint32_t common = std::min (length, node->length);
+      uint32_t diff = (prefix ^ node->prefix) & PrefixMask (common);
+      if (diff != 0)
+        {
+          common = 0;
+          while (GetBit (diff, common) == 0)
+            {
+              common++;
+            }
+        }
+      if (common == node->length)
+        {
+          if (common == length)
+            {
+              node->entries.push_back (entry);
+              return;
+            }
+          slot = &node->child[GetBit (prefix, common)];
+          continue;
+        }
+      // the node moves below a new one, which holds the route or
+      // forks between the route and the node
+      Node *parent;
+      if (common == length)
+        {
+          parent = NewNode (prefix, length);
+          parent->entries.push_back (entry);
+        }
+      else
+        {
+          parent = NewNode (prefix & PrefixMask (common), common);
+          Node *leaf = NewNode (prefix, length);
+          leaf->entries.push_back (entry);
+          parent->child[GetBit (prefix, common)] = leaf;
+        }
+      parent->child[GetBit (node->prefix, common)] = node;
+      *slot = parent;
+      return;
+    }
+}
+
+bool
+Ipv4RouteTrie::Remove (Node **slot, uint32_t prefix, uint32_t length, Ipv4RoutingTableEntry *route)
+{
+  Node *node = *slot;
+  if (node == 0 || node->length > length || ((prefix ^ node->prefix) & PrefixMask (node->length)) != 0)
+    {
+      return false;
+    }
+  if (node->length < length)
+    {
+      if (!Remove (&node->child[GetBit (prefix, node->length)], prefix, length, route))
+        {
+          return false;
+        }
+    }
+  else
+    {
+      std::vector<Entry>::iterator i = node->entries.begin ();
+      while (i != node->entries.end () && i->route != route)
+        {
+          i++;
+        }
+      if (i == node->entries.end ())
+        {
+          return false;
+        }
+      node->entries.erase (i);
+    }
+  // merge away a node left without routes and with less than two children
+  if (node->entries.empty () && (node->child[0] == 0 || node->child[1] == 0))
+    {
+      *slot = node->child[0] != 0 ? node->child[0] : node->child[1];
+      delete node;
+    }
+  return true;
+}
+
+bool
+Ipv4RouteTrie::Remove (Ipv4RoutingTableEntry *route)
+{
+  for (std::vector<Entry>::iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if (i->route == route)
+        {
+          m_irregular.erase (i);
+          m_nRoutes--;
+          return true;
+        }
+    }
+  Ipv4Mask mask = route->GetDestNetworkMask ();
+  if (Remove (&m_root, route->GetDestNetwork ().Get () & mask.Get (), mask.GetPrefixLength (), route))
+    {
+      m_nRoutes--;
+      return true;
+    }
+  return false;
+}
+
+void
+Ipv4RouteTrie::Clear (void)
+{
+  Delete (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+  m_nRoutes = 0;
+}
+
+void
+Ipv4RouteTrie::Lookup (Ipv4Address dest, std::vector<Entry> &matches) const
+{
+  matches.clear ();
+  uint32_t address = dest.Get ();
+  const Node *node = m_root;
+  while (node != 0 && ((address ^ node->prefix) & PrefixMask (node->length)) == 0)
+    {
+      matches.insert (matches.end (), node->entries.begin (), node->entries.end ());
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (address, node->length)];
+    }
+  for (std::vector<Entry>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if (i->route->GetDestNetworkMask ().IsMatch (dest, i->route->GetDestNetwork ()))
+        {
+          matches.push_back (*i);
+        }
+    }
+  if (matches.size () > 1)
+    {
+      std::sort (matches.begin (), matches.end (), CompareOrder);
+    }
+}
+
+const Ipv4RouteTrie::Entry *
+Ipv4RouteTrie::LookupFirst (Ipv4Address dest) const
+{
+  uint32_t address = dest.Get ();
+  const Entry *first = 0;
+  const Node *node = m_root;
+  while (node != 0 && ((address ^ node->prefix) & PrefixMask (node->length)) == 0)
+    {
+      // the entries of a node are in insertion order
+      if (!node->entries.empty () && (first == 0 || node->entries.front ().order < first->order))
+        {
+          first = &node->entries.front ();
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (address, node->length)];
+    }
+  // the irregular routes are in insertion order too
+  for (std::vector<Entry>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if (first != 0 && i->order > first->order)
+        {
+          break;
+        }
+      if (i->route->GetDestNetworkMask ().IsMatch (dest, i->route->GetDestNetwork ()))
+        {
+          first = &*i;
+          break;
+        }
+    }
+  return first;
+}
+
+uint32_t
+Ipv4RouteTrie::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
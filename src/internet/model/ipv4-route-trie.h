@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup internet
+ *
+ * \brief Path-compressed binary trie of network routes
+ *
+ * The trie indexes the network routes of Ipv4StaticRouting and
+ * Ipv4GlobalRouting by destination prefix, so that finding the routes
+ * matching a destination costs at most one visit per prefix length
+ * instead of a scan of the whole routing table.  Nodes that neither
+ * hold a route nor fork are merged away, and the trie is updated in
+ * place as routes are inserted and removed.
+ *
+ * Lookup returns every matching route in insertion order, so that the
+ * routing protocols can keep their own selection rules (longest prefix
+ * and metric, or first match) and give the same results as with the
+ * scan of their route lists.  Routes whose mask is not contiguous
+ * cannot be placed in the trie and are checked one by one.
+ *
+ * The trie does not own the routes.
+ */
+class Ipv4RouteTrie
+{
+public:
+  /**
+   * A route of the trie
+   */
+  struct Entry
+  {
+    Ipv4RoutingTableEntry *route;
+    uint32_t metric;
+    uint32_t order; /**< rank of insertion */
+  };
+
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * \param route the route, whose destination network and mask are
+   *        indexed; it must stay valid until removed
+   * \param metric the metric of the route
+   */
+  void Insert (Ipv4RoutingTableEntry *route, uint32_t metric = 0);
+
+  /**
+   * \param route a route previously inserted
+   * \returns true if the route was found and removed
+   */
+  bool Remove (Ipv4RoutingTableEntry *route);
+
+  /**
+   * Remove every route.
+   */
+  void Clear (void);
+
+  /**
+   * \param dest the destination address
+   * \param matches (returned) the routes whose network contains dest,
+   *        in insertion order
+   */
+  void Lookup (Ipv4Address dest, std::vector<Entry> &matches) const;
+
+  /**
+   * \param dest the destination address
+   * \returns the first inserted route whose network contains dest, or 0
+   *          if there is none; unlike Lookup, this does not allocate
+   */
+  const Entry * LookupFirst (Ipv4Address dest) const;
+
+  /**
+   * \returns the number of routes of the trie
+   */
+  uint32_t GetNRoutes (void) const;
+
+private:
+  struct Node
+  {
+    uint32_t prefix;
+    uint32_t length;
+    Node *child[2];
+    std::vector<Entry> entries;
+  };
+
+  Ipv4RouteTrie (const Ipv4RouteTrie &o);
+  Ipv4RouteTrie & operator = (const Ipv4RouteTrie &o);
+
+  static Node * NewNode (uint32_t prefix, uint32_t length);
+  static void Delete (Node *node);
+  static bool Remove (Node **slot, uint32_t prefix, uint32_t length, Ipv4RoutingTableEntry *route);
+
+  Node *m_root;
+  // the routes whose mask is not contiguous
+  std::vector<Entry> m_irregular;
+  uint32_t m_nRoutes;
+  uint32_t m_order;
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
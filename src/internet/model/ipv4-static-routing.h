@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -390,6 +391,10 @@ private:
   Ipv4Address SourceAddressSelection (uint32_t interface, Ipv4Address dest);
 
   NetworkRoutes m_networkRoutes;
+  /// m_networkRoutes indexed by destination prefix
+  Ipv4RouteTrie m_networkRouteTrie;
+  /// scratch space of LookupStatic
+  std::vector<Ipv4RouteTrie::Entry> m_lookupMatches;
   MulticastRoutes m_multicastRoutes;
 
   Ptr<Ipv4> m_ipv4;
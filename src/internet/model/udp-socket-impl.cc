@@ -30,6 +30,7 @@
 #include "ns3/ipv4-packet-info-tag.h"
 #include "udp-socket-impl.h"
 #include "udp-l4-protocol.h"
+#include "ipv4-flow-hash.h"
 #include "ipv4-end-point.h"
 #include <limits>
 
@@ -440,7 +441,12 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port)
       Ptr<Ipv4Route> route;
       Ptr<NetDevice> oif = m_boundnetdevice; //specify non-zero if bound to a specific device
       // TBD-- we could cache the route and just check its validity
+      // the routing protocol sees the ports, as it does for packets
+      // sent by Ipv4L3Protocol, so that it can hash the flow
+      Ipv4FlowPortsTag portsTag (m_endPoint->GetLocalPort (), port);
+      p->AddPacketTag (portsTag);
       route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_); 
+      p->RemovePacketTag (portsTag);
       if (route != 0)
         {
           NS_LOG_LOGIC ("Route exists");
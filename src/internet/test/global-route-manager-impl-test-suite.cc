@@ -26,6 +26,20 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
+#include <sstream>
+#include <algorithm>
 #include <stdlib.h> // for rand()
 
 namespace ns3 {
@@ -213,6 +227,235 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   // does not crash
 }
 
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  static bool Compare (const SPFVertex* v1, const SPFVertex* v2);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue pops in the order of a sorted list")
+{
+}
+
+bool
+CandidateQueueTestCase::Compare (const SPFVertex* v1, const SPFVertex* v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  // the reference is a list kept sorted as the queue used to be: pushed
+  // after the vertices of the same rank, and moved after them when its
+  // distance decreases
+  CandidateQueue candidate;
+  std::vector<SPFVertex*> reference;
+  std::vector<SPFVertex*> popped;
+  uint32_t id = 0;
+  for (uint32_t n = 0; n < 2000; ++n)
+    {
+      uint32_t action = rand () % 4;
+      if (action < 2 || reference.empty ())
+        {
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (++id));
+          v->SetVertexType (rand () % 2 ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (rand () % 20);
+          candidate.Push (v);
+          reference.insert (std::upper_bound (reference.begin (), reference.end (), v, &Compare), v);
+        }
+      else if (action == 2)
+        {
+          SPFVertex *v = reference[rand () % reference.size ()];
+          NS_TEST_ASSERT_MSG_EQ (candidate.Find (v->GetVertexId ()), v, "Find failed");
+          if (v->GetDistanceFromRoot () > 0)
+            {
+              reference.erase (std::find (reference.begin (), reference.end (), v));
+              v->SetDistanceFromRoot (rand () % v->GetDistanceFromRoot ());
+              candidate.DecreaseKey (v);
+              reference.insert (std::upper_bound (reference.begin (), reference.end (), v, &Compare), v);
+            }
+        }
+      else
+        {
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, reference.front (), "Wrong vertex popped");
+          reference.erase (reference.begin ());
+          NS_TEST_ASSERT_MSG_EQ (candidate.Find (v->GetVertexId ()), 0, "A popped vertex must not be found");
+          popped.push_back (v);
+        }
+      NS_TEST_ASSERT_MSG_EQ (candidate.Size (), reference.size (), "Wrong size");
+    }
+  for (uint32_t i = 0; i < popped.size (); ++i)
+    {
+      delete popped[i];
+    }
+}
+
+class GlobalRouteManagerUpdateTestCase : public TestCase
+{
+public:
+  GlobalRouteManagerUpdateTestCase ();
+  virtual void DoRun (void);
+private:
+  void Link (Ptr<Node> a, Ptr<Node> b);
+  void Stub (Ptr<Node> a);
+  std::string GetRoutingTables (void) const;
+  uint32_t GetNRoutes (Ptr<Node> node) const;
+
+  NodeContainer m_nodes;
+  Ipv4AddressHelper m_address;
+};
+
+GlobalRouteManagerUpdateTestCase::GlobalRouteManagerUpdateTestCase ()
+  : TestCase ("Threaded and incremental SPF give the routes of a full recompute")
+{
+}
+
+void
+GlobalRouteManagerUpdateTestCase::Link (Ptr<Node> a, Ptr<Node> b)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  Ptr<Node> ends[2] = { a, b };
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      ends[i]->AddDevice (device);
+      devices.Add (device);
+    }
+  m_address.Assign (devices);
+  m_address.NewNetwork ();
+}
+
+void
+GlobalRouteManagerUpdateTestCase::Stub (Ptr<Node> a)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetChannel (channel);
+  a->AddDevice (device);
+  m_address.Assign (NetDeviceContainer (device));
+  m_address.NewNetwork ();
+}
+
+std::string
+GlobalRouteManagerUpdateTestCase::GetRoutingTables (void) const
+{
+  std::ostringstream os;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&os);
+  for (uint32_t i = 0; i < m_nodes.GetN (); ++i)
+    {
+      m_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->PrintRoutingTable (stream);
+    }
+  return os.str ();
+}
+
+uint32_t
+GlobalRouteManagerUpdateTestCase::GetNRoutes (Ptr<Node> node) const
+{
+  return node->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->GetNRoutes ();
+}
+
+void
+GlobalRouteManagerUpdateTestCase::DoRun (void)
+{
+  // two triangles of routers sharing router 2, router 5 hanging off router
+  // 4 with a stub network, router 6 off router 0, and a separate pair of
+  // routers; there are no equal-cost paths through networks, which the SPF
+  // does not handle
+  m_nodes.Create (9);
+  InternetStackHelper stack;
+  stack.Install (m_nodes);
+  m_address.SetBase ("10.1.1.0", "255.255.255.0");
+  const uint32_t links[][2] = { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 3 }, { 3, 4 }, { 4, 2 }, { 4, 5 }, { 6, 0 }, { 7, 8 } };
+  for (uint32_t i = 0; i < sizeof (links) / sizeof (links[0]); ++i)
+    {
+      Link (m_nodes.Get (links[i][0]), m_nodes.Get (links[i][1]));
+    }
+  Stub (m_nodes.Get (5));
+  Ptr<Node> island = m_nodes.Get (7);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string serial = GetRoutingTables ();
+
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ (GetRoutingTables (), serial, "Threads must not change the routes");
+
+  // take the link between routers 1 and 2 down
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (true));
+  Ptr<Ipv4> ipv4 = m_nodes.Get (1)->GetObject<Ipv4> ();
+  ipv4->SetDown (2);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string incremental = GetRoutingTables ();
+  NS_TEST_EXPECT_MSG_NE (incremental, serial, "The routes should change");
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ (incremental, GetRoutingTables (), "Incremental SPF must give the routes of a full recompute");
+
+  // routers away from the change keep their routes: a route added by hand
+  // to the pair of routers survives
+  Ptr<Ipv4GlobalRouting> islandRouting = island->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  islandRouting->AddHostRouteTo (Ipv4Address ("10.9.9.9"), 1);
+  uint32_t nIslandRoutes = GetNRoutes (island);
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (true));
+  ipv4->SetUp (2);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ (GetNRoutes (island), nIslandRoutes, "The pair of routers should not be recomputed");
+  islandRouting->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (GetRoutingTables (), serial, "The routes should be back to the first ones");
+
+  // a higher metric from router 3 to the network it shares with router 2 is
+  // a link that the SPF runs of routers 1 and 6 never follow, so they keep
+  // their routes, while router 5 loses a path; then, when the stub network
+  // of router 5 goes away, the other routers only lose their routes to it
+  Ptr<Ipv4GlobalRouting> routings[2] = {
+    m_nodes.Get (1)->GetObject<GlobalRouter> ()->GetRoutingProtocol (),
+    m_nodes.Get (6)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()
+  };
+  uint32_t nRoutes[2];
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      routings[i]->AddHostRouteTo (Ipv4Address ("10.9.9.9"), 1);
+      nRoutes[i] = routings[i]->GetNRoutes ();
+    }
+  m_nodes.Get (3)->GetObject<Ipv4> ()->SetMetric (1, 5);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (routings[i]->GetNRoutes (), nRoutes[i], "Routers away from the link should not be recomputed");
+    }
+  m_nodes.Get (5)->GetObject<Ipv4> ()->SetDown (2);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (routings[i]->GetNRoutes (), nRoutes[i] - 1, "Routers should only lose the route to the stub network");
+      routings[i]->RemoveRoute (0);
+    }
+  incremental = GetRoutingTables ();
+  NS_TEST_EXPECT_MSG_NE (incremental, serial, "The routes should change");
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ (incremental, GetRoutingTables (), "Incremental SPF must give the routes of a full recompute");
+
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (1));
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  m_nodes = NodeContainer ();
+  Simulator::Destroy ();
+}
 
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
@@ -221,6 +464,8 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase ());
+    AddTestCase (new CandidateQueueTestCase ());
+    AddTestCase (new GlobalRouteManagerUpdateTestCase ());
   }
 } g_globalRoutingManagerImplTestSuite;
 
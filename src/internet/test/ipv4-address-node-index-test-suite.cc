@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-node-index.h"
+
+namespace ns3 {
+
+class Ipv4AddressNodeIndexTestCase : public TestCase
+{
+public:
+  Ipv4AddressNodeIndexTestCase ();
+  virtual void DoRun (void);
+private:
+  uint32_t AddDevice (Ptr<Node> node);
+};
+
+Ipv4AddressNodeIndexTestCase::Ipv4AddressNodeIndexTestCase ()
+  : TestCase ("Ipv4 address to node index follows AddAddress and RemoveAddress")
+{
+}
+
+uint32_t
+Ipv4AddressNodeIndexTestCase::AddDevice (Ptr<Node> node)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  return node->GetObject<Ipv4> ()->AddInterface (device);
+}
+
+void
+Ipv4AddressNodeIndexTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  Ptr<Ipv4> ipv4[3];
+  uint32_t interface[3];
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      ipv4[i] = nodes.Get (i)->GetObject<Ipv4> ();
+      interface[i] = AddDevice (nodes.Get (i));
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNAddresses (), 0, "Loopback addresses are not indexed");
+
+  ipv4[0]->AddAddress (interface[0], Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.0")));
+  ipv4[1]->AddAddress (interface[1], Ipv4InterfaceAddress (Ipv4Address ("10.0.0.2"), Ipv4Mask ("255.0.0.0")));
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.1")), nodes.Get (0), "Wrong node");
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.2")), nodes.Get (1), "Wrong node");
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.3")), 0, "Unknown address");
+
+  // a duplicated address belongs to the lowest node id
+  ipv4[2]->AddAddress (interface[2], Ipv4InterfaceAddress (Ipv4Address ("10.0.0.9"), Ipv4Mask ("255.0.0.0")));
+  ipv4[1]->AddAddress (interface[1], Ipv4InterfaceAddress (Ipv4Address ("10.0.0.9"), Ipv4Mask ("255.0.0.0")));
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.9")), nodes.Get (1), "Lowest node id expected");
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNAddresses (), 3, "Wrong number of addresses");
+
+  // 10.0.0.9 is the second address of interface[1] on node 1
+  ipv4[1]->RemoveAddress (interface[1], 1);
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.9")), nodes.Get (2), "Remaining owner expected");
+  ipv4[2]->RemoveAddress (interface[2], 0);
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNode (Ipv4Address ("10.0.0.9")), 0, "Removed address");
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNAddresses (), 2, "Wrong number of addresses");
+
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (Ipv4AddressNodeIndex::GetNAddresses (), 0, "Index must be cleared by Simulator::Destroy");
+}
+
+static class Ipv4AddressNodeIndexTestSuite : public TestSuite
+{
+public:
+  Ipv4AddressNodeIndexTestSuite ()
+    : TestSuite ("ipv4-address-node-index", UNIT)
+  {
+    AddTestCase (new Ipv4AddressNodeIndexTestCase);
+  }
+} g_ipv4AddressNodeIndexTestSuite;
+
+} // namespace ns3
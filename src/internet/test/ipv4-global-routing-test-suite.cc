@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <set>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-flow-hash.h"
+
+namespace ns3 {
+
+class Ipv4GlobalRoutingFlowEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFlowEcmpTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<NetDevice> Route (uint16_t sourcePort);
+
+  Ptr<Ipv4GlobalRouting> m_routing;
+  Ipv4Address m_dest;
+};
+
+Ipv4GlobalRoutingFlowEcmpTestCase::Ipv4GlobalRoutingFlowEcmpTestCase ()
+  : TestCase ("Flow ECMP spreads flows over the next-hop group of a host route")
+{
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingFlowEcmpTestCase::Route (uint16_t sourcePort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (sourcePort);
+  udp.SetDestinationPort (9);
+  p->AddHeader (udp);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.0.0.1"));
+  header.SetDestination (m_dest);
+  header.SetProtocol (17);
+  Socket::SocketErrno err;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (p, header, 0, err);
+  return route ? route->GetOutputDevice () : 0;
+}
+
+void
+Ipv4GlobalRoutingFlowEcmpTestCase::DoRun (void)
+{
+  const uint32_t nHops = 4;
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper stack;
+  stack.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interfaces[nHops];
+  for (uint32_t i = 0; i < nHops; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      interfaces[i] = ipv4->AddInterface (device);
+      ipv4->AddAddress (interfaces[i], Ipv4InterfaceAddress (Ipv4Address (0x0a000001 + (i << 8)), Ipv4Mask ("255.255.255.0")));
+      ipv4->SetUp (interfaces[i]);
+    }
+
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  m_routing->SetIpv4 (ipv4);
+  m_dest = Ipv4Address ("10.9.0.1");
+  for (uint32_t i = 0; i < nHops; ++i)
+    {
+      m_routing->AddHostRouteTo (m_dest, Ipv4Address (0x0a000002 + (i << 8)), interfaces[i]);
+    }
+  // another destination does not join the group
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.0.2"), Ipv4Address ("10.0.0.2"), interfaces[0]);
+
+  // without ECMP, the first route always wins
+  NS_TEST_EXPECT_MSG_EQ (Route (1000), ipv4->GetNetDevice (interfaces[0]), "First route expected");
+  NS_TEST_EXPECT_MSG_EQ (Route (1001), ipv4->GetNetDevice (interfaces[0]), "First route expected");
+
+  m_routing->SetAttribute ("FlowEcmpRouting", BooleanValue (true));
+  std::set<Ptr<NetDevice> > used;
+  for (uint16_t port = 1000; port < 1064; ++port)
+    {
+      Ptr<NetDevice> device = Route (port);
+      NS_TEST_EXPECT_MSG_EQ (Route (port), device, "The packets of a flow must take the same route");
+      used.insert (device);
+    }
+  NS_TEST_EXPECT_MSG_EQ (used.size (), nHops, "64 flows should use every next hop");
+
+  // removing routes shrinks the group; the first host route is index 0
+  m_routing->RemoveRoute (0);
+  m_routing->RemoveRoute (0);
+  m_routing->RemoveRoute (0);
+  used.clear ();
+  for (uint16_t port = 1000; port < 1064; ++port)
+    {
+      used.insert (Route (port));
+    }
+  NS_TEST_EXPECT_MSG_EQ (used.size (), 1, "A single next hop is left");
+  NS_TEST_EXPECT_MSG_EQ (*used.begin (), ipv4->GetNetDevice (interfaces[nHops - 1]), "Wrong remaining next hop");
+  m_routing->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (Route (1000), 0, "No route is left");
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
+class Ipv4FlowHashTestCase : public TestCase
+{
+public:
+  Ipv4FlowHashTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4FlowHashTestCase::Ipv4FlowHashTestCase ()
+  : TestCase ("Flow hash functions cover the 5-tuple")
+{
+}
+
+void
+Ipv4FlowHashTestCase::DoRun (void)
+{
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.0.0.1"));
+  header.SetDestination (Ipv4Address ("10.0.1.1"));
+  UdpHeader udp;
+  udp.SetSourcePort (1000);
+  udp.SetDestinationPort (9);
+  Ptr<Packet> p1 = Create<Packet> (10);
+  p1->AddHeader (udp);
+  udp.SetSourcePort (1001);
+  Ptr<Packet> p2 = Create<Packet> (10);
+  p2->AddHeader (udp);
+
+  const Ipv4FlowHash::Function functions[] = { Ipv4FlowHash::MURMUR3, Ipv4FlowHash::FNV1A, Ipv4FlowHash::CRC32 };
+  std::set<uint32_t> hashes;
+  for (uint32_t f = 0; f < 3; ++f)
+    {
+      header.SetProtocol (17);
+      uint32_t h1 = Ipv4FlowHash::Hash (p1, header, 0, functions[f]);
+      NS_TEST_EXPECT_MSG_EQ (Ipv4FlowHash::Hash (p1->Copy (), header, 0, functions[f]), h1, "The hash must be deterministic");
+      NS_TEST_EXPECT_MSG_NE (Ipv4FlowHash::Hash (p2, header, 0, functions[f]), h1, "UDP ports must be hashed");
+      NS_TEST_EXPECT_MSG_NE (Ipv4FlowHash::Hash (p1, header, 1, functions[f]), h1, "The seed must be hashed");
+      hashes.insert (h1);
+
+      // ports mean nothing to other protocols
+      header.SetProtocol (1);
+      NS_TEST_EXPECT_MSG_EQ (Ipv4FlowHash::Hash (p2, header, 0, functions[f]),
+                             Ipv4FlowHash::Hash (p1, header, 0, functions[f]), "Only TCP and UDP ports are hashed");
+    }
+  NS_TEST_EXPECT_MSG_EQ (hashes.size (), 3, "The hash functions should differ");
+}
+
+static class Ipv4GlobalRoutingTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingTestSuite ()
+    : TestSuite ("ipv4-global-routing", UNIT)
+  {
+    AddTestCase (new Ipv4GlobalRoutingFlowEcmpTestCase);
+    AddTestCase (new Ipv4FlowHashTestCase);
+  }
+} g_ipv4GlobalRoutingTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <list>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/random-variable.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-route-trie.h"
+
+namespace ns3 {
+
+class Ipv4RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv4RouteTrieTestCase ();
+  virtual void DoRun (void);
+private:
+  // compare the trie against a scan of the routes, for a sample of
+  // destinations around the routes
+  void Check (const Ipv4RouteTrie &trie, const std::list<Ipv4RoutingTableEntry *> &routes);
+  UniformVariable m_rand;
+};
+
+Ipv4RouteTrieTestCase::Ipv4RouteTrieTestCase ()
+  : TestCase ("Route trie matches a scan of the routing table")
+{
+}
+
+void
+Ipv4RouteTrieTestCase::Check (const Ipv4RouteTrie &trie, const std::list<Ipv4RoutingTableEntry *> &routes)
+{
+  NS_TEST_ASSERT_MSG_EQ (trie.GetNRoutes (), routes.size (), "Wrong number of routes");
+  std::vector<Ipv4RouteTrie::Entry> matches;
+  for (uint32_t n = 0; n < 500; ++n)
+    {
+      // mostly addresses of 10.0.0.0/16, where the routes are
+      uint32_t address = m_rand.GetInteger (0, 3) ? 0x0a000000 | m_rand.GetInteger (0, 0xffff) : m_rand.GetInteger (0, 0xffffffff);
+      Ipv4Address dest (address);
+      std::vector<Ipv4RoutingTableEntry *> expected;
+      for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin (); i != routes.end (); i++)
+        {
+          if ((*i)->GetDestNetworkMask ().IsMatch (dest, (*i)->GetDestNetwork ()))
+            {
+              expected.push_back (*i);
+            }
+        }
+      trie.Lookup (dest, matches);
+      NS_TEST_ASSERT_MSG_EQ (matches.size (), expected.size (), "Wrong number of matches for " << dest);
+      for (uint32_t i = 0; i < expected.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (matches[i].route, expected[i], "Wrong match or order for " << dest);
+        }
+      const Ipv4RouteTrie::Entry *first = trie.LookupFirst (dest);
+      NS_TEST_ASSERT_MSG_EQ ((first == 0 ? 0 : first->route), (expected.empty () ? 0 : expected.front ()),
+                             "Wrong first match for " << dest);
+    }
+}
+
+void
+Ipv4RouteTrieTestCase::DoRun (void)
+{
+  SeedManager::SetSeed (1);
+  SeedManager::SetRun (1);
+  Ipv4RouteTrie trie;
+  std::list<Ipv4RoutingTableEntry *> routes;
+
+  // a default route, an irregular mask, then random prefixes of
+  // 10.0.0.0/16 with duplicates
+  routes.push_back (new Ipv4RoutingTableEntry (Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask::GetZero (), 0)));
+  routes.push_back (new Ipv4RoutingTableEntry (Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.255.255"), 1)));
+  for (uint32_t n = 0; n < 300; ++n)
+    {
+      uint32_t length = m_rand.GetInteger (8, 32);
+      uint32_t mask = 0xffffffffU << (32 - length);
+      Ipv4Address network ((0x0a000000 | m_rand.GetInteger (0, 0xffff)) & mask);
+      routes.push_back (new Ipv4RoutingTableEntry (Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, Ipv4Mask (mask), n)));
+    }
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      trie.Insert (*i);
+    }
+  Check (trie, routes);
+
+  // remove about half of the routes, in random order
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); )
+    {
+      if (m_rand.GetInteger (0, 1))
+        {
+          NS_TEST_ASSERT_MSG_EQ (trie.Remove (*i), true, "Route must be found");
+          delete *i;
+          i = routes.erase (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  Check (trie, routes);
+
+  // routes added afterwards come last
+  for (uint32_t n = 0; n < 50; ++n)
+    {
+      Ipv4Address network ((0x0a000000 | m_rand.GetInteger (0, 0xffff)) & 0xffffff00);
+      routes.push_back (new Ipv4RoutingTableEntry (Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, Ipv4Mask ("255.255.255.0"), n)));
+      trie.Insert (routes.back ());
+    }
+  Check (trie, routes);
+
+  Ipv4RoutingTableEntry unknown = Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.255.0.0"), 0);
+  NS_TEST_ASSERT_MSG_EQ (trie.Remove (&unknown), false, "Route is not in the trie");
+
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i = routes.erase (i))
+    {
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (*i), true, "Route must be found");
+      delete *i;
+    }
+  Check (trie, routes);
+}
+
+static class Ipv4RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteTrieTestSuite ()
+    : TestSuite ("ipv4-route-trie", UNIT)
+  {
+    AddTestCase (new Ipv4RouteTrieTestCase);
+  }
+} g_ipv4RouteTrieTestSuite;
+
+} // namespace ns3
@@ -45,6 +45,7 @@
 #include "ns3/packet-sink-helper.h"
 #include "ns3/point-to-point-helper.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/distributed-simulator-impl.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/ipv4-nix-vector-helper.h"
@@ -600,6 +601,7 @@ main (int argc, char *argv[])
   Simulator::Run ();
   TIMER_NOW (t2);
   cout << "Simulator finished." << endl;
+  DynamicCast<DistributedSimulatorImpl> (Simulator::GetImplementation ())->PrintStatistics (cout);
   Simulator::Destroy ();
   // Exit the MPI execution environment
   MpiInterface::Disable ();
@@ -608,6 +610,7 @@ main (int argc, char *argv[])
   cout << "Simulator init time: " << d1 << endl;
   cout << "Simulator run time: " << d2 << endl;
   cout << "Total elapsed time: " << d1 + d2 << endl;
+  MpiInterface::PrintStatistics (cout);
   return 0;
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
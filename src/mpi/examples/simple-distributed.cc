@@ -53,6 +53,8 @@
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/on-off-helper.h"
 #include "ns3/packet-sink-helper.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/flow-monitor-mpi-helper.h"
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -89,10 +91,13 @@ main (int argc, char *argv[])
   Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue ("1Mbps"));
   Config::SetDefault ("ns3::OnOffApplication::MaxBytes", UintegerValue (512));
   bool nix = true;
+  std::string flowMonitorFile = "";
 
   // Parse command line
   CommandLine cmd;
   cmd.AddValue ("nix", "Enable the use of nix-vector or global routing", nix);
+  cmd.AddValue ("flowMonitor", "XML file to write the flow statistics of all the ranks to, or empty for none",
+                flowMonitorFile);
   cmd.Parse (argc, argv);
 
   // Create leaf nodes on left with system id 0
@@ -242,8 +247,26 @@ main (int argc, char *argv[])
       clientApps.Stop (Seconds (5));
     }
 
+  // The packets leave the rank 0 and are received by the rank 1, whose
+  // monitors merge their state at the rank 0 after the run
+  FlowMonitorHelper flowMonitorHelper;
+  Ptr<FlowMonitor> flowMonitor;
+  if (!flowMonitorFile.empty ())
+    {
+      flowMonitor = flowMonitorHelper.InstallAll ();
+      FlowMonitorMpiHelper::SetDistributed (flowMonitor);
+    }
+
   Simulator::Stop (Seconds (5));
   Simulator::Run ();
+  if (flowMonitor)
+    {
+      FlowMonitorMpiHelper::ReduceAcrossRanks (flowMonitor);
+      if (systemId == 0)
+        {
+          flowMonitor->SerializeToXmlFile (flowMonitorFile, true, true);
+        }
+    }
   Simulator::Destroy ();
   // Exit the MPI execution environment
   MpiInterface::Disable ();
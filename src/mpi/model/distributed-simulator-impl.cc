@@ -26,6 +26,7 @@
 #include "ns3/node-container.h"
 #include "ns3/ptr.h"
 #include "ns3/pointer.h"
+#include "ns3/enum.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
@@ -76,6 +77,12 @@ DistributedSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DistributedSimulatorImpl")
     .SetParent<Object> ()
     .AddConstructor<DistributedSimulatorImpl> ()
+    .AddAttribute ("SynchronizationMode",
+                   "How the systems agree on the times up to which they may run.",
+                   EnumValue (SYNC_BARRIER),
+                   MakeEnumAccessor (&DistributedSimulatorImpl::m_synchronizationMode),
+                   MakeEnumChecker (SYNC_BARRIER, "Barrier",
+                                    SYNC_NULL_MESSAGE, "NullMessage"))
   ;
   return tid;
 }
@@ -105,6 +112,10 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
   m_events = 0;
+  m_synchronizationMode = SYNC_BARRIER;
+  m_nWindows = 0;
+  m_runSeconds = 0;
+  m_blockedSeconds = 0;
 }
 
 DistributedSimulatorImpl::~DistributedSimulatorImpl ()
@@ -153,6 +164,9 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
     }
   else
     {
+      m_neighbors.clear ();
+      m_neighborLookAhead.assign (m_systemCount, Seconds (0));
+      m_nullMessageTimes.assign (m_systemCount, Seconds (0));
       NodeContainer c = NodeContainer::GetGlobal ();
       for (NodeContainer::Iterator iter = c.Begin (); iter != c.End (); ++iter)
         {
@@ -197,6 +211,16 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
               // it the new lookAhead.
               TimeValue delay;
               channel->GetAttribute ("Delay", delay);
+              Time &neighborLookAhead = m_neighborLookAhead[remoteNode->GetSystemId ()];
+              if (neighborLookAhead.IsZero ())
+                {
+                  m_neighbors.push_back (remoteNode->GetSystemId ());
+                  neighborLookAhead = delay.Get ();
+                }
+              else if (delay.Get () < neighborLookAhead)
+                {
+                  neighborLookAhead = delay.Get ();
+                }
               if (DistributedSimulatorImpl::m_lookAhead.IsZero ())
                 {
                   DistributedSimulatorImpl::m_lookAhead = delay.Get ();
@@ -267,55 +291,120 @@ DistributedSimulatorImpl::Next (void) const
   return TimeStep (NextTs ());
 }
 
+void
+DistributedSimulatorImpl::SynchronizeBarrier (void)
+{
+#ifdef NS3_MPI
+  // First send the packets aggregated during the window
+  MpiInterface::Flush ();
+  // Then receive any pending messages
+  MpiInterface::ReceiveMessages ();
+  // And check for send completes
+  MpiInterface::TestSendComplete ();
+  // Finally calculate the lbts
+  LbtsMessage lMsg (MpiInterface::GetRxCount (), MpiInterface::GetTxCount (), m_myId, Next ());
+  m_pLBTS[m_myId] = lMsg;
+  MPI_Allgather (&lMsg, sizeof (LbtsMessage), MPI_BYTE, m_pLBTS,
+                 sizeof (LbtsMessage), MPI_BYTE, MPI_COMM_WORLD);
+  Time smallestTime = m_pLBTS[0].GetSmallestTime ();
+  // The totRx and totTx counts insure there are no transient
+  // messages;  If totRx != totTx, there are transients,
+  // so we don't update the granted time.
+  uint32_t totRx = m_pLBTS[0].GetRxCount ();
+  uint32_t totTx = m_pLBTS[0].GetTxCount ();
+
+  for (uint32_t i = 1; i < m_systemCount; ++i)
+    {
+      if (m_pLBTS[i].GetSmallestTime () < smallestTime)
+        {
+          smallestTime = m_pLBTS[i].GetSmallestTime ();
+        }
+      totRx += m_pLBTS[i].GetRxCount ();
+      totTx += m_pLBTS[i].GetTxCount ();
+
+    }
+  if (totRx == totTx)
+    {
+      m_grantedTime = smallestTime + DistributedSimulatorImpl::m_lookAhead;
+      m_nWindows++;
+    }
+#endif
+}
+
+void
+DistributedSimulatorImpl::SynchronizeNullMessage (void)
+{
+#ifdef NS3_MPI
+  MpiInterface::Flush ();
+  MpiInterface::ReceiveMessages ();
+  MpiInterface::TestSendComplete ();
+  // No packet from the neighbors arrives before their lower bounds
+  Time grantedTime = GetMaximumSimulationTime ();
+  for (std::vector<uint32_t>::const_iterator i = m_neighbors.begin (); i != m_neighbors.end (); ++i)
+    {
+      grantedTime = Min (grantedTime, MpiInterface::GetLowerBound (*i));
+    }
+  if (grantedTime > m_grantedTime)
+    {
+      m_grantedTime = grantedTime;
+      m_nWindows++;
+    }
+  // Nothing happens on this system before its next event or the next
+  // packets from its neighbors, and a packet sent then reaches a
+  // neighbor at least one lookahead later
+  Time earliest = Min (Next (), m_grantedTime);
+  for (std::vector<uint32_t>::const_iterator i = m_neighbors.begin (); i != m_neighbors.end (); ++i)
+    {
+      Time lowerBound = earliest + m_neighborLookAhead[*i];
+      if (lowerBound > m_nullMessageTimes[*i])
+        {
+          MpiInterface::SendNullMessage (*i, lowerBound);
+          m_nullMessageTimes[*i] = lowerBound;
+        }
+    }
+#endif
+}
+
 void
 DistributedSimulatorImpl::Run (void)
 {
 #ifdef NS3_MPI
   CalculateLookAhead ();
   m_stop = false;
+  double start = MPI_Wtime ();
   while (!m_events->IsEmpty () && !m_stop)
     {
       Time nextTime = Next ();
       if (nextTime > m_grantedTime)
         { // Can't process, calculate a new LBTS
-          // First receive any pending messages
-          MpiInterface::ReceiveMessages ();
-          // reset next time
-          nextTime = Next ();
-          // And check for send completes
-          MpiInterface::TestSendComplete ();
-          // Finally calculate the lbts
-          LbtsMessage lMsg (MpiInterface::GetRxCount (), MpiInterface::GetTxCount (), m_myId, nextTime);
-          m_pLBTS[m_myId] = lMsg;
-          MPI_Allgather (&lMsg, sizeof (LbtsMessage), MPI_BYTE, m_pLBTS,
-                         sizeof (LbtsMessage), MPI_BYTE, MPI_COMM_WORLD);
-          Time smallestTime = m_pLBTS[0].GetSmallestTime ();
-          // The totRx and totTx counts insure there are no transient
-          // messages;  If totRx != totTx, there are transients,
-          // so we don't update the granted time.
-          uint32_t totRx = m_pLBTS[0].GetRxCount ();
-          uint32_t totTx = m_pLBTS[0].GetTxCount ();
-
-          for (uint32_t i = 1; i < m_systemCount; ++i)
+          double blocked = MPI_Wtime ();
+          if (m_synchronizationMode == SYNC_NULL_MESSAGE)
             {
-              if (m_pLBTS[i].GetSmallestTime () < smallestTime)
-                {
-                  smallestTime = m_pLBTS[i].GetSmallestTime ();
-                }
-              totRx += m_pLBTS[i].GetRxCount ();
-              totTx += m_pLBTS[i].GetTxCount ();
-
+              SynchronizeNullMessage ();
             }
-          if (totRx == totTx)
+          else
             {
-              m_grantedTime = smallestTime + DistributedSimulatorImpl::m_lookAhead;
+              SynchronizeBarrier ();
             }
+          // reset next time
+          nextTime = Next ();
+          m_blockedSeconds += MPI_Wtime () - blocked;
         }
       if (nextTime <= m_grantedTime)
         { // Save to process
           ProcessOneEvent ();
         }
     }
+  MpiInterface::Flush ();
+  if (m_synchronizationMode == SYNC_NULL_MESSAGE)
+    {
+      // This system sends nothing more
+      for (std::vector<uint32_t>::const_iterator i = m_neighbors.begin (); i != m_neighbors.end (); ++i)
+        {
+          MpiInterface::SendNullMessage (*i, GetMaximumSimulationTime ());
+        }
+    }
+  m_runSeconds += MPI_Wtime () - start;
 
   // If the simulator stopped naturally by lack of events, make a
   // consistency test to check that we didn't lose any events along the way.
@@ -325,6 +414,32 @@ DistributedSimulatorImpl::Run (void)
 #endif
 }
 
+uint64_t
+DistributedSimulatorImpl::GetNWindows (void) const
+{
+  return m_nWindows;
+}
+
+double
+DistributedSimulatorImpl::GetRunSeconds (void) const
+{
+  return m_runSeconds;
+}
+
+double
+DistributedSimulatorImpl::GetBlockedSeconds (void) const
+{
+  return m_blockedSeconds;
+}
+
+void
+DistributedSimulatorImpl::PrintStatistics (std::ostream &os) const
+{
+  os << "Distributed simulator: system " << m_myId << ", "
+     << m_nWindows << " windows, " << m_blockedSeconds << " s blocked and "
+     << m_runSeconds - m_blockedSeconds << " s executing" << std::endl;
+}
+
 uint32_t DistributedSimulatorImpl::GetSystemId () const
 {
   return m_myId;
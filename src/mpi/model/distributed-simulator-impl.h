@@ -25,6 +25,8 @@
 #include "ns3/ptr.h"
 
 #include <list>
+#include <ostream>
+#include <vector>
 
 namespace ns3 {
 
@@ -87,10 +89,29 @@ private:
  * \ingroup mpi
  *
  * \brief distributed simulator implementation using lookahead
+ *
+ * With the Barrier synchronization mode, all the systems agree on the
+ * next window in a global MPI_Allgather, and the window is as long as the
+ * smallest delay of all the links between systems.  With the NullMessage
+ * mode, each system only waits for its neighbors, the systems it shares
+ * links with: it sends them null messages with the time before which it
+ * will send them nothing more, its next event plus the smallest delay of
+ * the links to each neighbor, and processes its events up to the
+ * smallest time its neighbors gave it.  Distant systems do not delay
+ * each other, and the links with long delays allow long windows.
  */
 class DistributedSimulatorImpl : public SimulatorImpl
 {
 public:
+  /**
+   * How the systems agree on the times up to which they may run
+   */
+  enum SynchronizationMode
+  {
+    SYNC_BARRIER,      /**< A global barrier for every window */
+    SYNC_NULL_MESSAGE  /**< Null messages between neighbors */
+  };
+
   static TypeId GetTypeId (void);
 
   DistributedSimulatorImpl ();
@@ -118,9 +139,32 @@ public:
   virtual uint32_t GetSystemId (void) const;
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns the number of times the granted time moved forward
+   */
+  uint64_t GetNWindows (void) const;
+  /**
+   * \returns the wall-clock time spent in Run, in seconds
+   */
+  double GetRunSeconds (void) const;
+  /**
+   * \returns the wall-clock time spent in Run waiting for the other
+   *          systems, in seconds
+   */
+  double GetBlockedSeconds (void) const;
+  /**
+   * \param os the output stream
+   *
+   * Print the windows and the time this system spent blocked and
+   * executing.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
 private:
   virtual void DoDispose (void);
   void CalculateLookAhead (void);
+  void SynchronizeBarrier (void);
+  void SynchronizeNullMessage (void);
 
   void ProcessOneEvent (void);
   uint64_t NextTs (void) const;
@@ -143,6 +187,14 @@ private:
   Time         m_grantedTime; // Last LBTS
   static Time  m_lookAhead;   // Lookahead value
 
+  enum SynchronizationMode m_synchronizationMode;
+  std::vector<uint32_t> m_neighbors;
+  std::vector<Time> m_neighborLookAhead; // Lookahead to each system
+  std::vector<Time> m_nullMessageTimes;  // Last null message to each system
+  uint64_t m_nWindows;
+  double m_runSeconds;
+  double m_blockedSeconds;
+
 };
 
 } // namespace ns3
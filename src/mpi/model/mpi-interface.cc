@@ -22,6 +22,7 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <cstring>
 
 #include "mpi-interface.h"
 #include "mpi-receiver.h"
@@ -39,27 +40,75 @@
 
 namespace ns3 {
 
+// Each packet is sent as a record made of a header of eight 32-bit
+// words: the receive time on two words, the node, the device, whether
+// the packet is compact, the size of the data which follows, and for a
+// compact packet the offset and the size of the run of zeros removed
+// from the data.  The data is padded so that the next record stays
+// aligned.  A null message is a record for no node, whose time is the
+// lower bound in time steps.
+static const uint32_t RECORD_HEADER_SIZE = 32;
+static const uint32_t NULL_MESSAGE_NODE = 0xffffffff;
+
+static uint32_t
+GetRecordSize (uint32_t dataSize)
+{
+  return RECORD_HEADER_SIZE + ((dataSize + 7) & (~7));
+}
+
+static void
+FindLongestZeroRun (const uint8_t *data, uint32_t size, uint32_t &start, uint32_t &length)
+{
+  start = 0;
+  length = 0;
+  uint32_t i = 0;
+  while (i < size)
+    {
+      if (data[i] != 0)
+        {
+          i++;
+          continue;
+        }
+      uint32_t j = i + 1;
+      while (j < size && data[j] == 0)
+        {
+          j++;
+        }
+      if (j - i > length)
+        {
+          start = i;
+          length = j - i;
+        }
+      i = j;
+    }
+}
+
 SentBuffer::SentBuffer ()
 {
-  m_buffer = 0;
   m_request = 0;
 }
 
 SentBuffer::~SentBuffer ()
 {
-  delete [] m_buffer;
 }
 
 uint8_t*
 SentBuffer::GetBuffer ()
 {
-  return m_buffer;
+  return &m_buffer[0];
+}
+
+uint32_t
+SentBuffer::GetSize ()
+{
+  return m_buffer.size ();
 }
 
 void
-SentBuffer::SetBuffer (uint8_t* buffer)
+SentBuffer::SetBuffer (std::vector<uint8_t> &buffer)
 {
-  m_buffer = buffer;
+  m_buffer.swap (buffer);
+  buffer.clear ();
 }
 
 #ifdef NS3_MPI
@@ -76,24 +125,22 @@ bool                  MpiInterface::m_initialized = false;
 bool                  MpiInterface::m_enabled = false;
 uint32_t              MpiInterface::m_rxCount = 0;
 uint32_t              MpiInterface::m_txCount = 0;
+uint64_t              MpiInterface::m_nTxMessages = 0;
+uint64_t              MpiInterface::m_nTxBytes = 0;
+uint64_t              MpiInterface::m_nCompactPackets = 0;
+uint64_t              MpiInterface::m_nNullMessages = 0;
+std::vector<Time>     MpiInterface::m_lowerBounds;
 std::list<SentBuffer> MpiInterface::m_pendingTx;
-
-#ifdef NS3_MPI
-MPI_Request* MpiInterface::m_requests;
-char**       MpiInterface::m_pRxBuffers;
-#endif
+std::vector<std::vector<uint8_t> > MpiInterface::m_txBatches;
+std::vector<uint8_t>  MpiInterface::m_rxBuffer;
 
 void
 MpiInterface::Destroy ()
 {
 #ifdef NS3_MPI
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      delete [] m_pRxBuffers[i];
-    }
-  delete [] m_pRxBuffers;
-  delete [] m_requests;
-
+  m_txBatches.clear ();
+  m_rxBuffer.clear ();
+  m_lowerBounds.clear ();
   m_pendingTx.clear ();
 #endif
 }
@@ -110,6 +157,39 @@ MpiInterface::GetTxCount ()
   return m_txCount;
 }
 
+uint64_t
+MpiInterface::GetNTxMessages ()
+{
+  return m_nTxMessages;
+}
+
+uint64_t
+MpiInterface::GetNTxBytes ()
+{
+  return m_nTxBytes;
+}
+
+uint64_t
+MpiInterface::GetNCompactPackets ()
+{
+  return m_nCompactPackets;
+}
+
+uint64_t
+MpiInterface::GetNNullMessages ()
+{
+  return m_nNullMessages;
+}
+
+void
+MpiInterface::PrintStatistics (std::ostream &os)
+{
+  os << "MPI interface: " << m_txCount << " packets sent in "
+     << m_nTxMessages << " messages of " << m_nTxBytes << " bytes, "
+     << m_nCompactPackets << " compact packets, "
+     << m_nNullMessages << " null messages" << std::endl;
+}
+
 uint32_t
 MpiInterface::GetSystemId ()
 {
@@ -154,15 +234,8 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
-  m_pRxBuffers = new char*[m_size];
-  m_requests = new MPI_Request[m_size];
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
-    }
+  m_txBatches.resize (m_size);
+  m_lowerBounds.resize (m_size, Seconds (0));
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -172,90 +245,241 @@ void
 MpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
 {
 #ifdef NS3_MPI
-  SentBuffer sendBuf;
-  m_pendingTx.push_back (sendBuf);
-  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
+  std::vector<uint8_t> &batch = m_txBatches[nodeSysId];
+
+  // Without nix-vector and metadata, only the bytes of the packet are
+  // needed to create it again, and its virtual payload is sent as its
+  // length only
+  bool compact = p->GetNixVector () == 0 && !p->BeginItem ().HasNext ();
+  uint32_t zeroStart = compact ? p->GetVirtualPayloadStart () : 0;
+  uint32_t zeroSize = compact ? p->GetVirtualPayloadSize () : 0;
+  uint32_t size = compact ? p->GetSize () - zeroSize : p->GetSerializedSize ();
+  uint32_t offset = batch.size ();
+  batch.resize (offset + GetRecordSize (size));
+  uint8_t* data = &batch[offset] + RECORD_HEADER_SIZE;
+  if (compact && zeroSize > 0)
+    {
+      p->CopyDataWithoutVirtualPayload (data, size);
+      m_nCompactPackets++;
+    }
+  else if (compact)
+    {
+      // the payload was written out, so look for its zeros
+      p->CopyData (data, size);
+      FindLongestZeroRun (data, size, zeroStart, zeroSize);
+      std::memmove (data + zeroStart, data + zeroStart + zeroSize, size - zeroStart - zeroSize);
+      size -= zeroSize;
+      batch.resize (offset + GetRecordSize (size));
+      m_nCompactPackets++;
+    }
+  else
+    {
+      p->Serialize (data, size);
+    }
 
-  uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
   // Add the time, dest node and dest device
   uint64_t t = rxTime.GetNanoSeconds ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
+  uint64_t* pTime = reinterpret_cast <uint64_t *> (&batch[offset]);
   *pTime++ = t;
   uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
   *pData++ = node;
   *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
+  *pData++ = compact;
+  *pData++ = size;
+  *pData++ = zeroStart;
+  *pData++ = zeroSize;
+  m_txCount++;
 
-  // Find the system id for the destination node
-  Ptr<Node> destNode = NodeList::GetNode (node);
-  uint32_t nodeSysId = destNode->GetSystemId ();
+  if (batch.size () >= MAX_MPI_MSG_SIZE)
+    {
+      SendBatch (nodeSysId);
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
 
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
-  m_txCount++;
+void
+MpiInterface::Flush ()
+{
+#ifdef NS3_MPI
+  for (uint32_t i = 0; i < m_txBatches.size (); ++i)
+    {
+      if (!m_txBatches[i].empty ())
+        {
+          SendBatch (i);
+        }
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+MpiInterface::SendNullMessage (uint32_t sid, const Time &lowerBound)
+{
+#ifdef NS3_MPI
+  // The null message follows the packets in the same MPI message, so
+  // that it is never received before them
+  std::vector<uint8_t> &batch = m_txBatches[sid];
+  uint32_t offset = batch.size ();
+  batch.resize (offset + GetRecordSize (0));
+  int64_t* pTime = reinterpret_cast <int64_t *> (&batch[offset]);
+  *pTime++ = lowerBound.GetTimeStep ();
+  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
+  *pData++ = NULL_MESSAGE_NODE;
+  m_nNullMessages++;
+  SendBatch (sid);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+Time
+MpiInterface::GetLowerBound (uint32_t sid)
+{
+  return m_lowerBounds[sid];
+}
+
+std::vector<std::string>
+MpiInterface::Gather (const std::string &data)
+{
+  std::vector<std::string> all;
+  if (!IsEnabled ())
+    {
+      all.push_back (data);
+      return all;
+    }
+#ifdef NS3_MPI
+  int size = data.size ();
+  std::vector<int> sizes (m_sid == 0 ? m_size : 0);
+  MPI_Gather (&size, 1, MPI_INT, sizes.empty () ? 0 : &sizes[0], 1, MPI_INT, 0, MPI_COMM_WORLD);
+  std::vector<int> offsets (sizes.size (), 0);
+  int total = 0;
+  for (uint32_t i = 0; i < sizes.size (); ++i)
+    {
+      offsets[i] = total;
+      total += sizes[i];
+    }
+  std::vector<char> buffer (total + 1);
+  MPI_Gatherv (const_cast<char *> (data.data ()), size, MPI_BYTE, &buffer[0],
+               sizes.empty () ? 0 : &sizes[0], offsets.empty () ? 0 : &offsets[0],
+               MPI_BYTE, 0, MPI_COMM_WORLD);
+  for (uint32_t i = 0; i < sizes.size (); ++i)
+    {
+      all.push_back (std::string (&buffer[offsets[i]], sizes[i]));
+    }
+#endif
+  return all;
+}
+
+void
+MpiInterface::SendBatch (uint32_t sid)
+{
+#ifdef NS3_MPI
+  SentBuffer sendBuf;
+  m_pendingTx.push_back (sendBuf);
+  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
+  i->SetBuffer (m_txBatches[sid]);
+
+  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), i->GetSize (), MPI_CHAR, sid,
+             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  m_nTxMessages++;
+  m_nTxBytes += i->GetSize ();
+#endif
+}
+
 void
 MpiInterface::ReceiveMessages ()
-{ // Poll the non-block reads to see if data arrived
+{ // Poll for the messages which arrived
 #ifdef NS3_MPI
   while (true)
     {
       int flag = 0;
-      int index = 0;
       MPI_Status status;
 
-      MPI_Testany (GetSize (), m_requests, &index, &flag, &status);
+      MPI_Iprobe (MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &flag, &status);
       if (!flag)
         {
           break;        // No more messages
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
-
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t nanoSeconds = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
+      if (m_rxBuffer.size () < static_cast<uint32_t> (count))
+        {
+          m_rxBuffer.resize (count);
+        }
+      MPI_Recv (&m_rxBuffer[0], count, MPI_CHAR, status.MPI_SOURCE, 0,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-      Time rxTime = NanoSeconds (nanoSeconds);
+      uint32_t offset = 0;
+      while (offset < static_cast<uint32_t> (count))
+        {
+          // Get the meta data first
+          uint64_t* pTime = reinterpret_cast<uint64_t *> (&m_rxBuffer[offset]);
+          uint64_t nanoSeconds = *pTime++;
+          uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
+          uint32_t node = *pData++;
+          uint32_t dev  = *pData++;
+          uint32_t compact = *pData++;
+          uint32_t size = *pData++;
+          uint32_t zeroStart = *pData++;
+          uint32_t zeroSize = *pData++;
+          uint8_t* data = &m_rxBuffer[offset] + RECORD_HEADER_SIZE;
+          offset += GetRecordSize (size);
+
+          if (node == NULL_MESSAGE_NODE)
+            {
+              m_lowerBounds[status.MPI_SOURCE] = TimeStep (static_cast<int64_t> (nanoSeconds));
+              continue;
+            }
 
-      count -= sizeof (nanoSeconds) + sizeof (node) + sizeof (dev);
+          Time rxTime = NanoSeconds (nanoSeconds);
 
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+          m_rxCount++; // Count this receive
 
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
-        {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
+          Ptr<Packet> p;
+          if (compact)
             {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
+              // The zeros are added as a zero area, which takes no memory
+              p = Create<Packet> (data, zeroStart);
+              if (zeroSize > 0)
+                {
+                  p->AddAtEnd (Create<Packet> (zeroSize));
+                }
+              if (size > zeroStart)
+                {
+                  p->AddAtEnd (Create<Packet> (data + zeroStart, size - zeroStart));
+                }
+            }
+          else
+            {
+              p = Create<Packet> (data, size, true);
             }
-        }
 
-      NS_ASSERT (pNode && pMpiRec);
+          // Find the correct node/device to schedule receive event
+          Ptr<Node> pNode = NodeList::GetNode (node);
+          Ptr<MpiReceiver> pMpiRec = 0;
+          uint32_t nDevices = pNode->GetNDevices ();
+          for (uint32_t i = 0; i < nDevices; ++i)
+            {
+              Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+              if (pThisDev->GetIfIndex () == dev)
+                {
+                  pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+                  break;
+                }
+            }
 
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+          NS_ASSERT (pNode && pMpiRec);
 
-      // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[index]);
+          // Schedule the rx event
+          Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                          &MpiReceiver::Receive, pMpiRec, p);
+        }
     }
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
@@ -24,6 +24,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <ostream>
+#include <string>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
@@ -45,10 +48,10 @@ namespace ns3 {
  */
 
 /**
- * maximum MPI message size for easy
- * buffer creation
+ * size at which the packets aggregated for a system are sent without
+ * waiting for the end of the window
  */
-const uint32_t MAX_MPI_MSG_SIZE = 2000;
+const uint32_t MAX_MPI_MSG_SIZE = 65536;
 
 /**
  * \ingroup mpi
@@ -66,16 +69,21 @@ public:
    */
   uint8_t* GetBuffer ();
   /**
-   * \param buffer pointer to sent buffer
+   * \return size of sent buffer
    */
-  void SetBuffer (uint8_t* buffer);
+  uint32_t GetSize ();
+  /**
+   * \param buffer data to send, which is moved to the sent buffer
+   *        without copy and leaves \p buffer empty
+   */
+  void SetBuffer (std::vector<uint8_t> &buffer);
   /**
    * \return MPI request
    */
   MPI_Request* GetRequest ();
 
 private:
-  uint8_t* m_buffer;
+  std::vector<uint8_t> m_buffer;
   MPI_Request m_request;
 };
 
@@ -85,6 +93,13 @@ class Packet;
  * \ingroup mpi
  *
  * Interface between ns-3 and MPI
+ *
+ * The packets sent to a system are aggregated in a single message,
+ * which is sent when the simulator computes the next window, or earlier
+ * when it reaches MAX_MPI_MSG_SIZE.  A packet without nix-vector and
+ * metadata travels as its bytes only, and its longest run of zeros,
+ * usually the dummy payload of an application, as a length; it gets a
+ * new uid on the receiving system.  Other packets are fully serialized.
  */
 class MpiInterface
 {
@@ -124,9 +139,38 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device
+   * Serialize a packet for the specified node and net device, it is
+   * sent with the next Flush
    */
   static void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the packets aggregated for every system
+   */
+  static void Flush ();
+  /**
+   * \param sid the system to inform
+   * \param lowerBound the time before which no packet sent from now on
+   *        will arrive at the system
+   *
+   * Send a null message to a system, after the packets aggregated for it
+   */
+  static void SendNullMessage (uint32_t sid, const Time &lowerBound);
+  /**
+   * \param sid a system
+   * \return the time before which no packet from the system will arrive
+   *         anymore, as given by its last null message
+   */
+  static Time GetLowerBound (uint32_t sid);
+  /**
+   * \param data the data of the calling system
+   * \return on the system 0, the data of every system, indexed by
+   *         system id, and nothing on the others
+   *
+   * Collect some data of every system at the system 0, for instance the
+   * results to merge after the simulation.  All the systems must call it,
+   * and it returns the data alone when MPI is not enabled.
+   */
+  static std::vector<std::string> Gather (const std::string &data);
   /**
    * Check for received messages complete
    */
@@ -143,8 +187,32 @@ public:
    * \return transmitted count in packets
    */
   static uint32_t GetTxCount ();
+  /**
+   * \return number of messages sent
+   */
+  static uint64_t GetNTxMessages ();
+  /**
+   * \return number of bytes sent
+   */
+  static uint64_t GetNTxBytes ();
+  /**
+   * \return number of packets sent without their metadata
+   */
+  static uint64_t GetNCompactPackets ();
+  /**
+   * \return number of null messages sent
+   */
+  static uint64_t GetNNullMessages ();
+  /**
+   * \param os the output stream
+   *
+   * Print the packets and messages sent.
+   */
+  static void PrintStatistics (std::ostream &os);
 
 private:
+  static void SendBatch (uint32_t sid);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -156,11 +224,19 @@ private:
   static bool     m_initialized;
   static bool     m_enabled;
 
-  // Pending non-blocking receives
-  static MPI_Request* m_requests;
+  static uint64_t m_nTxMessages;
+  static uint64_t m_nTxBytes;
+  static uint64_t m_nCompactPackets;
+  static uint64_t m_nNullMessages;
+
+  // Lower bounds given by the null messages of each system
+  static std::vector<Time> m_lowerBounds;
+
+  // Packets waiting to be sent to each system
+  static std::vector<std::vector<uint8_t> > m_txBatches;
 
-  // Data buffers for non-blocking reads
-  static char**   m_pRxBuffers;
+  // Data buffer for the reads
+  static std::vector<uint8_t> m_rxBuffer;
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
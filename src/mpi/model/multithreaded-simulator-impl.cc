@@ -0,0 +1,858 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/core-config.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/rng-stream.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif
+
+#include <algorithm>
+#include <sched.h>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+namespace {
+
+// timestamp of the next event of a partition without event, and
+// lookahead between partitions which are not linked
+const uint64_t NO_EVENT = ~static_cast<uint64_t> (0);
+// number of checks of a barrier between two yields of the processor
+const uint32_t SPINS = 1000;
+
+// the partition run by the thread, during Run only
+#ifdef HAVE_PTHREAD_H
+__thread void *t_partition __attribute__ ((tls_model ("initial-exec"))) = 0;
+
+SystemMutex &
+GetDestroyMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+#else
+void *t_partition = 0;
+#endif
+
+} // anonymous namespace
+
+/**
+ * A barrier for a fixed number of threads, which spin while they wait so
+ * that the short windows of a simulation do not pay for a system call.
+ */
+class SpinBarrier
+{
+public:
+  SpinBarrier (uint32_t n);
+  void Wait (void);
+private:
+  uint32_t m_n;
+  volatile uint32_t m_count;
+  volatile uint32_t m_generation;
+};
+
+SpinBarrier::SpinBarrier (uint32_t n)
+  : m_n (n),
+    m_count (0),
+    m_generation (0)
+{
+}
+
+void
+SpinBarrier::Wait (void)
+{
+  uint32_t generation = m_generation;
+  if (__sync_add_and_fetch (&m_count, 1) == m_n)
+    {
+      m_count = 0;
+      // the builtin is a full memory barrier, which publishes the writes
+      // of every thread before the barrier to the threads released
+      __sync_add_and_fetch (&m_generation, 1);
+      return;
+    }
+  uint32_t spins = 0;
+  while (m_generation == generation)
+    {
+      // let the other threads run if there are more threads than processors
+      if (++spins == SPINS)
+        {
+          sched_yield ();
+          spins = 0;
+        }
+    }
+  __sync_synchronize ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::Partition::Partition ()
+  : id (0),
+    events (0),
+    currentTs (0),
+    // before ::Run is entered, the currentUid will be zero
+    currentUid (0),
+    currentContext (0xffffffff),
+    // uids are allocated from 4.
+    // uid 0 is "invalid" events
+    // uid 1 is "now" events
+    // uid 2 is "destroy" events
+    uid (4),
+    unscheduledEvents (0),
+    next (NO_EVENT),
+    stopTs (NO_EVENT),
+    requestedStopTs (NO_EVENT),
+    stopped (false),
+    nEvents (0),
+    nSent (0)
+{
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_running (false),
+    m_stopTs (NO_EVENT),
+    m_barrier (0),
+    m_nextWorker (0),
+    m_nWindows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *partition = *i;
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_partitionOf.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::CreatePartition (uint32_t id)
+{
+  Partition *partition = new Partition ();
+  partition->id = id;
+  partition->events = m_schedulerFactory.Create<Scheduler> ();
+  RngStream::GetPartitionSeed (id, partition->rngSeed);
+  return partition;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  if (t_partition != 0)
+    {
+      return static_cast<Partition *> (t_partition);
+    }
+  return const_cast<Partition *> (&m_main);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  // the events outside of the nodes, and those of the nodes created since
+  // the last run, stay in the partition 0
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitions[m_partitionOf[context]];
+    }
+  return m_partitions[0];
+}
+
+void
+MultithreadedSimulatorImpl::Distribute (void)
+{
+  uint32_t nNodes = NodeList::GetNNodes ();
+  if (nNodes != m_partitionOf.size ())
+    {
+      NS_LOG_LOGIC ("partition " << nNodes << " nodes");
+      m_partitionOf.resize (nNodes);
+      for (uint32_t i = 0; i < nNodes; i++)
+        {
+          uint32_t id = NodeList::GetNode (i)->GetSystemId ();
+          m_partitionOf[i] = id;
+          while (m_partitions.size () <= id)
+            {
+              m_partitions.push_back (CreatePartition (m_partitions.size ()));
+            }
+        }
+      // move the events to the partitions of their nodes
+      std::vector<Scheduler::Event> events;
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+        {
+          Partition *partition = *i;
+          while (!partition->events->IsEmpty ())
+            {
+              events.push_back (partition->events->RemoveNext ());
+            }
+          partition->unscheduledEvents = 0;
+        }
+      for (std::vector<Scheduler::Event>::iterator i = events.begin (); i != events.end (); i++)
+        {
+          Partition *partition = GetPartition (i->key.m_context);
+          partition->unscheduledEvents++;
+          partition->events->Insert (*i);
+        }
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      (*i)->outbox.resize (m_partitions.size ());
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  uint32_t n = m_partitions.size ();
+  m_lookAhead.assign (n * n, NO_EVENT);
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); i++)
+    {
+      Ptr<Channel> channel = *i;
+      if (channel->GetNDevices () < 2)
+        {
+          continue;
+        }
+      Ptr<Node> node = channel->GetDevice (0)->GetNode ();
+      if (node == 0)
+        {
+          continue;
+        }
+      uint32_t from = m_partitionOf[node->GetId ()];
+      for (uint32_t j = 1; j < channel->GetNDevices (); j++)
+        {
+          node = channel->GetDevice (j)->GetNode ();
+          if (node == 0 || m_partitionOf[node->GetId ()] == from)
+            {
+              continue;
+            }
+          uint32_t to = m_partitionOf[node->GetId ()];
+          // only the point-to-point channel hands its packets over to
+          // another thread
+          if (channel->GetInstanceTypeId ().GetName () != "ns3::PointToPointChannel")
+            {
+              NS_FATAL_ERROR ("Channel " << channel->GetId () << " of type " << channel->GetInstanceTypeId ().GetName ()
+                                         << " links nodes of the partitions " << from << " and " << to
+                                         << ", only point-to-point channels can");
+            }
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          uint64_t lookAhead = delay.Get ().GetTimeStep ();
+          if (lookAhead == 0)
+            {
+              NS_FATAL_ERROR ("Channel " << channel->GetId () << " links nodes of the partitions " << from
+                                         << " and " << to << " without delay");
+            }
+          m_lookAhead[from * n + to] = std::min (m_lookAhead[from * n + to], lookAhead);
+          m_lookAhead[to * n + from] = std::min (m_lookAhead[to * n + from], lookAhead);
+        }
+    }
+  // an event may reach a partition through partitions which have no event
+  // yet, or come back to its sender: the windows are bounded by the
+  // shortest paths between the partitions, including the cycles
+  m_distance = m_lookAhead;
+  for (uint32_t k = 0; k < n; k++)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (m_distance[i * n + k] == NO_EVENT)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < n; j++)
+            {
+              if (m_distance[k * n + j] != NO_EVENT)
+                {
+                  m_distance[i * n + j] = std::min (m_distance[i * n + j],
+                                                    m_distance[i * n + k] + m_distance[k * n + j]);
+                }
+            }
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  m_schedulerFactory = schedulerFactory;
+  if (m_partitions.empty ())
+    {
+      m_partitions.push_back (CreatePartition (0));
+      return;
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *partition = *i;
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!partition->events->IsEmpty ())
+        {
+          scheduler->Insert (partition->events->RemoveNext ());
+        }
+      partition->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+  partition->nEvents++;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+Time
+MultithreadedSimulatorImpl::Next (void) const
+{
+  NS_ASSERT (!IsFinished ());
+  uint64_t next = NO_EVENT;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          next = std::min (next, (*i)->events->PeekNext ().key.m_ts);
+        }
+    }
+  return TimeStep (next);
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *partition)
+{
+  NS_LOG_FUNCTION (this << partition->id);
+  t_partition = partition;
+  uint32_t n = m_partitions.size ();
+  if (n > 1)
+    {
+      RngStream::SetThreadSeed (partition->rngSeed);
+    }
+  while (true)
+    {
+      // receive the events sent during the last window
+      for (uint32_t i = 0; i < n; i++)
+        {
+          std::vector<Scheduler::Event> &inbox = m_partitions[i]->outbox[partition->id];
+          for (std::vector<Scheduler::Event>::iterator j = inbox.begin (); j != inbox.end (); j++)
+            {
+              j->key.m_uid = partition->uid;
+              partition->uid++;
+              partition->unscheduledEvents++;
+              partition->events->Insert (*j);
+            }
+          inbox.clear ();
+        }
+      if (partition->events->IsEmpty () || partition->stopped)
+        {
+          partition->next = NO_EVENT;
+        }
+      else
+        {
+          partition->next = partition->events->PeekNext ().key.m_ts;
+        }
+      partition->stopTs = partition->requestedStopTs;
+      m_barrier->Wait ();
+
+      // every partition sees the same published values, so that they all
+      // agree on the end of the run
+      uint64_t stopTs = NO_EVENT;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          stopTs = std::min (stopTs, m_partitions[i]->stopTs);
+        }
+      bool done = true;
+      uint64_t bound = NO_EVENT;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          uint64_t next = m_partitions[i]->next;
+          if (next == NO_EVENT)
+            {
+              continue;
+            }
+          if (next <= stopTs)
+            {
+              done = false;
+            }
+          uint64_t distance = m_distance[i * n + partition->id];
+          if (distance != NO_EVENT)
+            {
+              bound = std::min (bound, next + distance);
+            }
+        }
+      if (done)
+        {
+          break;
+        }
+      if (partition->id == 0)
+        {
+          m_nWindows++;
+        }
+
+      // the events earlier than the bound cannot be preceded by an event
+      // which another partition has yet to send
+      while (!partition->stopped && !partition->events->IsEmpty ())
+        {
+          uint64_t ts = partition->events->PeekNext ().key.m_ts;
+          if (ts >= bound || ts > stopTs)
+            {
+              break;
+            }
+          ProcessOneEvent (partition);
+        }
+      m_barrier->Wait ();
+    }
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!partition->events->IsEmpty () || partition->unscheduledEvents == 0);
+  RngStream::SetThreadSeed (0);
+  t_partition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::RunWorker (void)
+{
+  uint32_t id = __sync_fetch_and_add (&m_nextWorker, 1);
+  RunPartition (m_partitions[id]);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  Distribute ();
+  CalculateLookAhead ();
+  uint32_t n = m_partitions.size ();
+  if (n > 1)
+    {
+#ifndef HAVE_PTHREAD_H
+      NS_FATAL_ERROR ("Can't run the partitions of the multithreaded simulator without threads");
+#endif
+      StringValue pool;
+      if (GlobalValue::GetValueByNameFailSafe ("EventImplPool", pool) && pool.Get () == "Shared")
+        {
+          NS_FATAL_ERROR ("The threads of the multithreaded simulator can't share the free list of the events, "
+                          "set EventImplPool to PerThread");
+        }
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *partition = *i;
+      partition->uid = std::max (partition->uid, m_main.uid);
+      partition->stopTs = m_stopTs;
+      partition->requestedStopTs = m_stopTs;
+      partition->stopped = false;
+    }
+
+  SpinBarrier barrier (n);
+  m_barrier = &barrier;
+  m_running = true;
+#ifdef HAVE_PTHREAD_H
+  std::vector<Ptr<SystemThread> > threads;
+  m_nextWorker = 1;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::RunWorker, this));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+#endif
+  RunPartition (m_partitions[0]);
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+#endif
+  m_running = false;
+  m_barrier = 0;
+  m_stopTs = NO_EVENT;
+
+  // outside of Run, the time is the one of the latest partition
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      m_main.currentTs = std::max (m_main.currentTs, (*i)->currentTs);
+      m_main.uid = std::max (m_main.uid, (*i)->uid);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunOneEvent (void)
+{
+  Distribute ();
+  Partition *partition = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if (!(*i)->events->IsEmpty ()
+          && (partition == 0 || (*i)->events->PeekNext ().key.m_ts < partition->events->PeekNext ().key.m_ts))
+        {
+          partition = *i;
+        }
+    }
+  NS_ASSERT (partition != 0);
+  partition->uid = std::max (partition->uid, m_main.uid);
+  t_partition = partition;
+  if (m_partitions.size () > 1)
+    {
+      RngStream::SetThreadSeed (partition->rngSeed);
+    }
+  ProcessOneEvent (partition);
+  RngStream::SetThreadSeed (0);
+  t_partition = 0;
+  m_main.currentTs = std::max (m_main.currentTs, partition->currentTs);
+  m_main.uid = std::max (m_main.uid, partition->uid);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetCurrent ()->id;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_running)
+    {
+      Partition *current = GetCurrent ();
+      current->stopped = true;
+      current->requestedStopTs = std::min (current->requestedStopTs, current->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  Partition *current = GetCurrent ();
+  uint64_t ts = current->currentTs + time.GetTimeStep ();
+  if (m_running)
+    {
+      current->requestedStopTs = std::min (current->requestedStopTs, ts);
+    }
+  else
+    {
+      m_stopTs = std::min (m_stopTs, ts);
+    }
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  Partition *current = GetCurrent ();
+  Time tAbsolute = time + TimeStep (current->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (current->currentTs));
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  ev.key.m_context = current->currentContext;
+  ev.key.m_uid = current->uid;
+  current->uid++;
+  Partition *partition = m_running ? current : GetPartition (ev.key.m_context);
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  Partition *current = GetCurrent ();
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = current->currentTs + time.GetTimeStep ();
+  ev.key.m_context = context;
+  Partition *partition = GetPartition (context);
+  if (m_running && partition != current)
+    {
+      // the receiving partition gives the event its uid when it takes
+      // the event from the mailbox
+      uint64_t lookAhead = m_lookAhead[current->id * m_partitions.size () + partition->id];
+      if (time.IsNegative () || static_cast<uint64_t> (time.GetTimeStep ()) < lookAhead)
+        {
+          NS_FATAL_ERROR ("Event scheduled by the partition " << current->id << " for the partition "
+                                                              << partition->id << " within the lookahead");
+        }
+      current->outbox[partition->id].push_back (ev);
+      current->nSent++;
+      return;
+    }
+  ev.key.m_uid = current->uid;
+  current->uid++;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  Partition *current = GetCurrent ();
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = current->currentTs;
+  ev.key.m_context = current->currentContext;
+  ev.key.m_uid = current->uid;
+  current->uid++;
+  Partition *partition = m_running ? current : GetPartition (ev.key.m_context);
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->currentTs, 0xffffffff, 2);
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetDestroyMutex ());
+#endif
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrent ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetDestroyMutex ());
+#endif
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (id.GetContext ());
+  NS_ASSERT_MSG (!m_running || partition == GetCurrent (), "An event can only be removed by its own partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetDestroyMutex ());
+#endif
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  // the events are compared with the progress of the partition which
+  // runs them
+  Partition *partition = GetPartition (ev.GetContext ());
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < partition->currentTs
+      || (ev.GetTs () == partition->currentTs
+          && ev.GetUid () <= partition->currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  // XXX: I am fairly certain other compilers use other non-standard
+  // post-fixes to indicate 64 bit constants.
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNPartitions (void) const
+{
+  return m_partitions.size ();
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetNWindows (void) const
+{
+  return m_nWindows;
+}
+
+void
+MultithreadedSimulatorImpl::PrintStatistics (std::ostream &os) const
+{
+  uint64_t nEvents = 0;
+  uint64_t nSent = 0;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      nEvents += (*i)->nEvents;
+      nSent += (*i)->nSent;
+    }
+  os << "Multithreaded simulator: " << m_partitions.size () << " partitions, "
+     << m_nWindows << " windows, " << nEvents << " events, "
+     << nSent << " sent to another partition" << std::endl;
+}
+
+} // namespace ns3
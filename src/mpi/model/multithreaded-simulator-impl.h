@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+class SpinBarrier;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief parallel simulator implementation using the threads of a
+ * single process
+ *
+ * The nodes are partitioned by their system id, as for the distributed
+ * simulator, and each partition runs its events in its own thread, the
+ * main thread running the partition 0.  The partitions advance through
+ * conservative windows separated by barriers: at the start of a window,
+ * every partition publishes the timestamp of its next event, and then
+ * processes its events earlier than the lower bound on the timestamp of
+ * the events it can still receive, that is the minimum over the
+ * partitions of their next timestamp plus the lookahead of the shortest
+ * path from them, possibly through other partitions or back to itself.
+ * The lookahead of each pair of partitions is the minimum delay of the
+ * point-to-point channels which link them, so that the partitions
+ * joined by slow links drift apart further than with the single global
+ * lookahead of the distributed simulator.
+ *
+ * The events scheduled for the nodes of another partition are appended
+ * to a mailbox per pair of partitions, which the receiving partition
+ * empties into its scheduler after the next barrier.  Each mailbox has a
+ * single writer and a single reader, which never access it at the same
+ * time, so that the exchange needs neither a lock nor an atomic
+ * operation, and the packets are not serialized: the point-to-point
+ * channel hands over a copy of the packet which shares no data with the
+ * sender (see Packet::DeepCopy).
+ *
+ * Only point-to-point channels with a positive delay may link nodes of
+ * different partitions, and the models must not share state between
+ * the nodes of different partitions: nix-vector routing, whose state is
+ * global, and packet printing are not supported.  The flow monitor keeps
+ * its state per partition, and merges it after the run.
+ * The events scheduled outside of the nodes, with Simulator::Schedule
+ * before the simulation starts, run in the partition 0.
+ *
+ * With several partitions, the random number streams created during
+ * the run come from a sequence per partition (see
+ * RngStream::SetThreadSeed), so that a run with the same partitions is
+ * reproducible whatever the order in which the threads create them.
+ *
+ * Simulator::Stop with a delay stops every partition after its events at
+ * the stop time, while Simulator::Stop without argument stops the calling
+ * partition at once and the others at the end of their window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual Time Next (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual void RunOneEvent (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the number of partitions of the last run
+   */
+  uint32_t GetNPartitions (void) const;
+  /**
+   * \returns the number of windows of the last runs
+   */
+  uint64_t GetNWindows (void) const;
+  /**
+   * \param os the output stream
+   *
+   * Print the number of partitions and of windows, and the number of
+   * events processed and sent to another partition.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
+private:
+  struct Partition
+  {
+    Partition ();
+    uint32_t id;
+    Ptr<Scheduler> events;
+    uint64_t currentTs;
+    uint32_t currentUid;
+    uint32_t currentContext;
+    uint32_t uid;
+    // number of events inserted but not processed yet, not counting the
+    // "destroy" events; this is used for validation
+    int unscheduledEvents;
+    // the events sent to each partition during the current window
+    std::vector<std::vector<Scheduler::Event> > outbox;
+    // timestamp of the next event and stop time, published at the start
+    // of a window for the other partitions
+    uint64_t next;
+    uint64_t stopTs;
+    // stop time requested during the current window
+    uint64_t requestedStopTs;
+    // Simulator::Stop was called by an event of the partition
+    bool stopped;
+    uint64_t nEvents;
+    uint64_t nSent;
+    // the sequence of the random number streams created by the events
+    // of the partition, when there are several partitions
+    double rngSeed[6];
+  };
+
+  virtual void DoDispose (void);
+  Partition *CreatePartition (uint32_t id);
+  /* Return the partition of the calling thread, or the main partition
+   * outside of Run. */
+  inline Partition *GetCurrent (void) const;
+  /* Return the partition which runs the events of the context. */
+  inline Partition *GetPartition (uint32_t context) const;
+  /* Split the events among the partitions of the nodes, if the nodes
+   * changed since the last run. */
+  void Distribute (void);
+  void CalculateLookAhead (void);
+  void ProcessOneEvent (Partition *partition);
+  void RunPartition (Partition *partition);
+  void RunWorker (void);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  ObjectFactory m_schedulerFactory;
+  // the state of the main thread outside of Run, in which the events are
+  // not inserted
+  Partition m_main;
+  // the partitions, indexed by system id
+  std::vector<Partition *> m_partitions;
+  // the partition of each node, indexed by node id
+  std::vector<uint32_t> m_partitionOf;
+  // lookahead from the partition i to j at i * partitions + j
+  std::vector<uint64_t> m_lookAhead;
+  // lookahead of the shortest path from the partition i to j, likewise
+  std::vector<uint64_t> m_distance;
+  bool m_running;
+  uint64_t m_stopTs;
+  SpinBarrier *m_barrier;
+  uint32_t m_nextWorker;
+  uint64_t m_nWindows;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -20,6 +20,14 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include <pthread.h>
+#endif
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
@@ -46,96 +54,276 @@ static struct Zeroes
 namespace ns3 {
 
 
-uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+namespace {
+
+GlobalValue g_bufferDataPool ("BufferDataPool",
+                              "Whether the data of the buffers is recycled through pools of "
+                              "blocks of a few sizes, with a cache per thread",
+                              BooleanValue (true),
+                              MakeBooleanChecker ());
+
+// the data of the buffers is allocated in blocks of 2^(MIN_SHIFT+c) bytes
+// for the class c, and larger data is not pooled
+const uint32_t MIN_SHIFT = 7;
+const uint32_t N_CLASSES = 10;
+// a thread keeps up to CACHE_BLOCKS blocks of each class, and moves
+// BATCH_BLOCKS of them at once to or from the global pool, which keeps
+// up to GLOBAL_BLOCKS blocks of each class
+const uint32_t CACHE_BLOCKS = 64;
+const uint32_t BATCH_BLOCKS = 32;
+const uint32_t GLOBAL_BLOCKS = 1024;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+struct FreeList
+{
+  FreeBlock *head;
+  uint32_t n;
+};
+
+struct BufferCache
+{
+  FreeList m_free[N_CLASSES];
+  uint64_t m_nHits;
+  uint64_t m_nMisses;
+  // false once its thread has exited, so that a new thread takes it
+  bool m_inUse;
+  // the next cache in the list of all caches
+  BufferCache *m_next;
+};
+
+// the blocks given back by the caches
+FreeList g_global[N_CLASSES];
+// every cache created, whose counters are summed by the statistics
+BufferCache *g_caches = 0;
+// the bytes currently allocated for the data of the buffers, pooled or
+// not, and their maximum
+uint64_t g_bytes = 0;
+uint64_t g_peakBytes = 0;
+#ifdef HAVE_PTHREAD_H
+__thread BufferCache *t_cache __attribute__ ((tls_model ("initial-exec"))) = 0;
+pthread_key_t g_cacheKey;
+
+SystemMutex &
+GetPoolMutex (void)
+{
+  // never destroyed, as buffers may be freed by static destructors
+  static SystemMutex *mutex = new SystemMutex ();
+  return *mutex;
+}
+#else
+BufferCache *t_cache = 0;
+#endif
+
+bool
+IsPoolEnabled (void)
+{
+  // read once, so that a block is always given back to a pool
+  static BooleanValue enabled (true);
+  static bool read = GlobalValue::GetValueByNameFailSafe ("BufferDataPool", enabled);
+  (void)read;
+  return enabled.Get ();
+}
+
+void
+AddBytes (int64_t n)
+{
+  uint64_t bytes = __sync_add_and_fetch (&g_bytes, n);
+  uint64_t peak = g_peakBytes;
+  while (bytes > peak && !__sync_bool_compare_and_swap (&g_peakBytes, peak, bytes))
+    {
+      peak = g_peakBytes;
+    }
+}
+
+// move up to n blocks from the head of one list to another
+void
+MoveBlocks (FreeList &from, FreeList &to, uint32_t n)
+{
+  while (n > 0 && from.head != 0)
+    {
+      FreeBlock *block = from.head;
+      from.head = block->next;
+      from.n--;
+      block->next = to.head;
+      to.head = block;
+      to.n++;
+      n--;
+    }
+}
+
+void
+ReleaseCache (void *p)
+{
+  BufferCache *cache = static_cast<BufferCache *> (p);
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetPoolMutex ());
+#endif
+  for (uint32_t c = 0; c < N_CLASSES; c++)
+    {
+      MoveBlocks (cache->m_free[c], g_global[c], GLOBAL_BLOCKS - std::min (GLOBAL_BLOCKS, g_global[c].n));
+      while (cache->m_free[c].head != 0)
         {
-          Buffer::Deallocate (*i);
+          FreeBlock *block = cache->m_free[c].head;
+          cache->m_free[c].head = block->next;
+          AddBytes (-(int64_t (1) << (MIN_SHIFT + c)));
+          delete [] reinterpret_cast<uint8_t *> (block);
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      cache->m_free[c].n = 0;
     }
+  cache->m_inUse = false;
 }
 
+#ifdef HAVE_PTHREAD_H
 void
-Buffer::Recycle (struct Buffer::Data *data)
+CreateCacheKey (void)
 {
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
+  pthread_key_create (&g_cacheKey, &ReleaseCache);
+}
+#endif
+
+BufferCache *
+CreateCache (void)
+{
+  BufferCache *cache = 0;
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (GetPoolMutex ());
+#endif
+    for (cache = g_caches; cache != 0; cache = cache->m_next)
+      {
+        if (!cache->m_inUse)
+          {
+            break;
+          }
+      }
+    if (cache == 0)
+      {
+        cache = new BufferCache ();
+        for (uint32_t c = 0; c < N_CLASSES; c++)
+          {
+            cache->m_free[c].head = 0;
+            cache->m_free[c].n = 0;
+          }
+        cache->m_nHits = 0;
+        cache->m_nMisses = 0;
+        cache->m_next = g_caches;
+        g_caches = cache;
+      }
+    cache->m_inUse = true;
+  }
+#ifdef HAVE_PTHREAD_H
+  // the cache is released when its thread exits
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once (&once, &CreateCacheKey);
+  pthread_setspecific (g_cacheKey, cache);
+#endif
+  t_cache = cache;
+  return cache;
+}
+
+inline BufferCache *
+GetCache (void)
+{
+  if (t_cache != 0)
+    {
+      return t_cache;
     }
-  else
+  return CreateCache ();
+}
+
+// returns a block of at least size bytes, and sets size to its size
+uint8_t *
+AllocateBlock (uint32_t &size)
+{
+  BufferCache *cache = GetCache ();
+  uint32_t c = 0;
+  while (c < N_CLASSES && (1U << (MIN_SHIFT + c)) < size)
+    {
+      c++;
+    }
+  if (c == N_CLASSES || !IsPoolEnabled ())
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      cache->m_nMisses++;
+      AddBytes (size);
+      return new uint8_t [size];
     }
+  size = 1U << (MIN_SHIFT + c);
+  FreeList &list = cache->m_free[c];
+  if (list.head == 0)
+    {
+      // the other threads give blocks back to the global list, which is
+      // only read under the lock
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetPoolMutex ());
+#endif
+      MoveBlocks (g_global[c], list, BATCH_BLOCKS);
+    }
+  if (list.head != 0)
+    {
+      FreeBlock *block = list.head;
+      list.head = block->next;
+      list.n--;
+      cache->m_nHits++;
+      return reinterpret_cast<uint8_t *> (block);
+    }
+  cache->m_nMisses++;
+  AddBytes (size);
+  return new uint8_t [size];
 }
 
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
+void
+DeallocateBlock (uint8_t *b, uint32_t size)
 {
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  uint32_t c = 0;
+  while (c < N_CLASSES && (1U << (MIN_SHIFT + c)) != size)
+    {
+      c++;
+    }
+  if (c == N_CLASSES || !IsPoolEnabled ())
     {
-      g_freeList = new Buffer::FreeList ();
+      AddBytes (-int64_t (size));
+      delete [] b;
+      return;
     }
-  else if (IS_INITIALIZED (g_freeList))
+  // with a cache per thread, a block freed by another thread joins the
+  // cache of that thread
+  FreeList &list = GetCache ()->m_free[c];
+  FreeBlock *block = reinterpret_cast<FreeBlock *> (b);
+  block->next = list.head;
+  list.head = block;
+  list.n++;
+  if (list.n > CACHE_BLOCKS)
     {
-      while (!g_freeList->empty ()) 
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetPoolMutex ());
+#endif
+      MoveBlocks (list, g_global[c], std::min (BATCH_BLOCKS, GLOBAL_BLOCKS - std::min (GLOBAL_BLOCKS, g_global[c].n)));
+      while (list.n > CACHE_BLOCKS)
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
+          block = list.head;
+          list.head = block->next;
+          list.n--;
+          AddBytes (-int64_t (size));
+          delete [] reinterpret_cast<uint8_t *> (block);
         }
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
 }
-#else /* BUFFER_FREE_LIST */
+
+// location in a newly-allocated buffer where you should start writing
+// data, i.e., m_start should be initialized to this value.  Each thread
+// of a multithreaded simulation has its own.
+#ifdef HAVE_PTHREAD_H
+__thread uint32_t t_recommendedStart __attribute__ ((tls_model ("initial-exec"))) = 0;
+#else
+uint32_t t_recommendedStart = 0;
+#endif
+
+} // anonymous namespace
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -148,7 +336,6 @@ Buffer::Create (uint32_t size)
 {
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -159,9 +346,9 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
+  uint8_t *b = AllocateBlock (size);
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
@@ -171,7 +358,43 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_ASSERT (data->m_count == 0);
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  DeallocateBlock (buf, data->m_size - 1 + sizeof (struct Buffer::Data));
+}
+
+uint64_t
+Buffer::GetNPoolHits (void)
+{
+  uint64_t n = 0;
+  for (BufferCache *cache = g_caches; cache != 0; cache = cache->m_next)
+    {
+      n += cache->m_nHits;
+    }
+  return n;
+}
+
+uint64_t
+Buffer::GetNPoolMisses (void)
+{
+  uint64_t n = 0;
+  for (BufferCache *cache = g_caches; cache != 0; cache = cache->m_next)
+    {
+      n += cache->m_nMisses;
+    }
+  return n;
+}
+
+uint64_t
+Buffer::GetPeakBytes (void)
+{
+  return g_peakBytes;
+}
+
+void
+Buffer::PrintStatistics (std::ostream &os)
+{
+  os << "Buffers: " << GetNPoolHits () << " pool hits, "
+     << GetNPoolMisses () << " misses, "
+     << GetPeakBytes () << " peak bytes" << std::endl;
 }
 
 Buffer::Buffer ()
@@ -233,7 +456,7 @@ Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
   m_data = Buffer::Create (0);
-  m_start = std::min (m_data->m_size, g_recommendedStart);
+  m_start = std::min (m_data->m_size, t_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
   m_zeroAreaEnd = m_zeroAreaStart + zeroSize;
@@ -259,7 +482,10 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (m_maxZeroAreaStart > t_recommendedStart)
+    {
+      t_recommendedStart = m_maxZeroAreaStart;
+    }
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -273,7 +499,10 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (m_maxZeroAreaStart > t_recommendedStart)
+    {
+      t_recommendedStart = m_maxZeroAreaStart;
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
@@ -428,17 +657,73 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
-
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
+  /**
+   * Otherwise, the zero area of the result is the largest of the two
+   * zero areas, or both of them if they are adjacent, and only the
+   * zero bytes of the other one are written out.  leadSize is the
+   * number of bytes of the result before its zero area.
+   */
+  uint32_t size = GetSize ();
+  uint32_t oSize = o.GetSize ();
+  uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+  uint32_t oZeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+  uint32_t leadSize;
+  uint32_t newZeroSize;
+  if (m_end == m_zeroAreaEnd && o.m_start == o.m_zeroAreaStart)
+    {
+      leadSize = m_zeroAreaStart - m_start;
+      newZeroSize = zeroSize + oZeroSize;
+    }
+  else if (zeroSize >= oZeroSize)
+    {
+      leadSize = m_zeroAreaStart - m_start;
+      newZeroSize = zeroSize;
+    }
+  else
+    {
+      leadSize = size + o.m_zeroAreaStart - o.m_start;
+      newZeroSize = oZeroSize;
+    }
+  uint32_t trailStart = leadSize + newZeroSize;
+
+  /* the data before then after the zero area is written first, while
+   * dst has no zero area yet */
+  Buffer dst;
+  dst.AddAtEnd (size + oSize - newZeroSize);
+  Buffer::Iterator i = dst.Begin ();
+  WriteRange (i, *this, 0, std::min (leadSize, size));
+  if (leadSize > size)
+    {
+      WriteRange (i, o, 0, leadSize - size);
+    }
+  if (trailStart < size)
+    {
+      WriteRange (i, *this, trailStart, size);
+    }
+  WriteRange (i, o, std::max (trailStart, size) - size, oSize);
+  dst.m_zeroAreaStart = dst.m_start + leadSize;
+  dst.m_zeroAreaEnd = dst.m_zeroAreaStart + newZeroSize;
+  dst.m_end += newZeroSize;
+  dst.m_data->m_dirtyEnd = dst.m_end;
+  dst.m_maxZeroAreaStart = std::max (dst.m_maxZeroAreaStart, dst.m_zeroAreaStart);
   *this = dst;
   NS_ASSERT (CheckInternalState ());
 }
 
+void
+Buffer::WriteRange (Buffer::Iterator &i, const Buffer &src, uint32_t start, uint32_t end)
+{
+  if (start == end)
+    {
+      return;
+    }
+  Buffer::Iterator from = src.Begin ();
+  from.Next (start);
+  Buffer::Iterator to = src.Begin ();
+  to.Next (end);
+  i.Write (from, to);
+}
+
 void 
 Buffer::RemoveAtStart (uint32_t start)
 {
@@ -782,6 +1067,29 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
   return originalSize - size;
 }
 
+uint32_t
+Buffer::GetZeroAreaStart (void) const
+{
+  return m_zeroAreaStart - m_start;
+}
+
+uint32_t
+Buffer::GetZeroAreaSize (void) const
+{
+  return m_zeroAreaEnd - m_zeroAreaStart;
+}
+
+uint32_t
+Buffer::CopyDataWithoutZeroArea (uint8_t *buffer, uint32_t size) const
+{
+  uint32_t tmpsize = std::min (m_zeroAreaStart - m_start, size);
+  memcpy (buffer, m_data->m_data + m_start, tmpsize);
+  uint32_t copied = tmpsize;
+  tmpsize = std::min (m_end - m_zeroAreaEnd, size - copied);
+  memcpy (buffer + copied, m_data->m_data + m_zeroAreaStart, tmpsize);
+  return copied + tmpsize;
+}
+
 /******************************************************
  *            The buffer iterator below.
  ******************************************************/
@@ -846,25 +1154,32 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  /* the written bytes are all before or all after our zero area */
+  uint8_t *to = &m_data[m_current];
+  if (m_current > m_zeroStart)
+    {
+      to -= m_zeroEnd - m_zeroStart;
+    }
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (to, &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      memset (to, 0, toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
   memcpy (to, from, toCopy);
   m_current += toCopy;
 }
@@ -1126,11 +1441,26 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   /* see RFC 1071 to understand this code. */
   uint32_t sum = initialChecksum;
+  uint32_t left = size;
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
+  while (left >= 2)
+    {
+      if (m_current >= m_zeroStart && m_current < m_zeroEnd)
+        {
+          /* the words of the zero area add nothing to the sum */
+          uint32_t zeros = std::min (m_zeroEnd - m_current, left) & (~1);
+          if (zeros > 0)
+            {
+              m_current += zeros;
+              left -= zeros;
+              continue;
+            }
+        }
+      sum += ReadU16 ();
+      left -= 2;
+    }
 
-  if (size & 1)
+  if (left)
     sum += ReadU8 ();
 
   while (sum >> 16)
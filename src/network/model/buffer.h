@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define noBUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -521,6 +519,53 @@ private:
 
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \returns the offset of the virtual zero area from the start of the
+   *          buffer
+   */
+  uint32_t GetZeroAreaStart (void) const;
+  /**
+   * \returns the number of bytes of the virtual zero area, which are
+   *          never allocated
+   */
+  uint32_t GetZeroAreaSize (void) const;
+  /**
+   * Copy the bytes before then after the virtual zero area, so that
+   * the buffer can be created again from them and the size of its
+   * zero area.
+   *
+   * \param buffer the byte buffer to copy to
+   * \param size the size of the byte buffer
+   * \returns the number of bytes copied
+   */
+  uint32_t CopyDataWithoutZeroArea (uint8_t *buffer, uint32_t size) const;
+
+  /**
+   * \returns the number of allocations of the data of a buffer which
+   *          took a block from a pool
+   *
+   * The data is allocated in blocks of a few sizes, kept by a cache per
+   * thread and a global pool, unless the "BufferDataPool" global value
+   * is false.
+   */
+  static uint64_t GetNPoolHits (void);
+  /**
+   * \returns the number of allocations of the data of a buffer which
+   *          had to allocate memory
+   */
+  static uint64_t GetNPoolMisses (void);
+  /**
+   * \returns the largest number of bytes allocated at once for the data
+   *          of the buffers, in use or pooled
+   */
+  static uint64_t GetPeakBytes (void);
+  /**
+   * \param os the output stream
+   *
+   * Print the counters of all threads on a single line.
+   */
+  static void PrintStatistics (std::ostream &os);
+
   inline Buffer (Buffer const &o);
   Buffer &operator = (Buffer const &o);
   Buffer ();
@@ -570,6 +615,8 @@ private:
   void Initialize (uint32_t zeroSize);
   uint32_t GetInternalSize (void) const;
   uint32_t GetInternalEnd (void) const;
+  /* write the bytes [start, end) of src at i, and move i after them */
+  static void WriteRange (Buffer::Iterator &i, const Buffer &src, uint32_t start, uint32_t end);
   static void Recycle (struct Buffer::Data *data);
   static struct Buffer::Data *Create (uint32_t size);
   static struct Buffer::Data *Allocate (uint32_t reqSize);
@@ -587,13 +634,6 @@ private:
    * m_zeroAreaStart.
    */
   uint32_t m_maxZeroAreaStart;
-  /**
-   * location in a newly-allocated buffer where you should start
-   * writing data. i.e., m_start should be initialized to this 
-   * value.
-   */
-  static uint32_t g_recommendedStart;
-
   /* offset to the start of the virtual zero area from the start 
    * of m_data->m_data
    */
@@ -610,17 +650,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
-  static struct LocalStaticDestructor g_localStaticDestructor;
-#endif
 };
 
 } // namespace ns3
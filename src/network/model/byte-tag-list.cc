@@ -19,6 +19,10 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 #include <vector>
 #include <string.h>
 
@@ -38,12 +42,19 @@ struct ByteTagListData {
 };
 
 #ifdef USE_FREE_LIST
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+// each thread of a multithreaded simulation has its own free list
+class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
+  ByteTagListDataFreeList ();
   ~ByteTagListDataFreeList ();
-} g_freeList;
-static uint32_t g_maxSize = 0;
+  uint32_t m_maxSize;
+};
+
+ByteTagListDataFreeList::ByteTagListDataFreeList ()
+  : m_maxSize (0)
+{
+}
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -54,6 +65,45 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       delete [] buffer;
     }
 }
+
+#ifdef HAVE_PTHREAD_H
+static __thread ByteTagListDataFreeList *t_freeList __attribute__ ((tls_model ("initial-exec"))) = 0;
+static pthread_key_t g_freeListKey;
+
+static void
+DeleteFreeList (void *freeList)
+{
+  delete static_cast<ByteTagListDataFreeList *> (freeList);
+}
+
+static void
+CreateFreeListKey (void)
+{
+  pthread_key_create (&g_freeListKey, &DeleteFreeList);
+}
+
+static ByteTagListDataFreeList &
+GetFreeList (void)
+{
+  if (t_freeList == 0)
+    {
+      // deleted with its blocks when its thread exits
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      pthread_once (&once, &CreateFreeListKey);
+      t_freeList = new ByteTagListDataFreeList ();
+      pthread_setspecific (g_freeListKey, t_freeList);
+    }
+  return *t_freeList;
+}
+#else
+static ByteTagListDataFreeList g_freeList;
+
+static ByteTagListDataFreeList &
+GetFreeList (void)
+{
+  return g_freeList;
+}
+#endif
 #endif /* USE_FREE_LIST */
 
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
@@ -131,6 +181,10 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      memcpy (m_inline, o.m_inline, m_used);
+    }
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -148,6 +202,10 @@ ByteTagList::operator = (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      memcpy (m_inline, o.m_inline, m_used);
+    }
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -166,8 +224,18 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   NS_ASSERT (m_used <= spaceNeeded);
   if (m_data == 0)
     {
+      if (spaceNeeded <= BYTE_TAG_INLINE_SIZE)
+        {
+          TagBuffer tag = TagBuffer (&m_inline[m_used], &m_inline[spaceNeeded]);
+          tag.WriteU32 (tid.GetUid ());
+          tag.WriteU32 (bufferSize);
+          tag.WriteU32 (start);
+          tag.WriteU32 (end);
+          m_used = spaceNeeded;
+          return tag;
+        }
       m_data = Allocate (spaceNeeded);
-      m_used = 0;
+      memcpy (&m_data->data, m_inline, m_used);
     } 
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
@@ -225,7 +293,8 @@ ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
   if (m_data == 0)
     {
-      return Iterator (0, 0, offsetStart, offsetEnd);
+      uint8_t *data = const_cast<uint8_t *> (m_inline);
+      return Iterator (data, &data[m_used], offsetStart, offsetEnd);
     }
   else
     {
@@ -339,10 +408,11 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  ByteTagListDataFreeList &freeList = GetFreeList ();
+  while (!freeList.empty ())
     {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
+      struct ByteTagListData *data = freeList.back ();
+      freeList.pop_back ();
       NS_ASSERT (data != 0);
       if (data->size >= size)
         {
@@ -353,7 +423,7 @@ ByteTagList::Allocate (uint32_t size)
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint8_t *buffer = new uint8_t [std::max (size, freeList.m_maxSize) + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
   data->size = size;
@@ -369,19 +439,20 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
+  ByteTagListDataFreeList &freeList = GetFreeList ();
+  freeList.m_maxSize = std::max (freeList.m_maxSize, data->size);
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
+      if (freeList.size () > FREE_LIST_SIZE ||
+          data->size < freeList.m_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
           delete [] buffer;
         }
       else
         {
-          g_freeList.push_back (data);
+          freeList.push_back (data);
         }
     }
 }
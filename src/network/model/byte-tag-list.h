@@ -28,6 +28,14 @@ namespace ns3 {
 
 struct ByteTagListData;
 
+/**
+ * \ingroup constants
+ * \brief Size of the inline tag buffer
+ * The tags of a ByteTagList are stored in the list itself, without any
+ * allocation, as long as they fit in this number of bytes.
+ */
+#define BYTE_TAG_INLINE_SIZE 64
+
 /**
  * \ingroup packet
  *
@@ -44,9 +52,11 @@ struct ByteTagListData;
  *     as 4 32bit integers (TypeId, tag data size, start, end) followed 
  *     by the tag data as generated by Tag::Serialize.
  *
- *   - the struct ByteTagListData structure which contains the tag byte buffer
- *     is shared and, thus, reference-counted. This data structure is unshared
- *     as-needed to emulate COW semantics.
+ *   - as long as the tags fit in BYTE_TAG_INLINE_SIZE bytes, the buffer is
+ *     kept in the list itself and copied with it.  Beyond, they are moved
+ *     to a struct ByteTagListData structure, which contains the tag byte
+ *     buffer and is shared and, thus, reference-counted. This data
+ *     structure is unshared as-needed to emulate COW semantics.
  *
  *   - each tag tags a unique set of bytes identified by the pair of offsets 
  *     (start,end). These offsets are provided by Buffer::GetCurrentStartOffset
@@ -163,6 +173,7 @@ private:
 
   uint16_t m_used;
   struct ByteTagListData *m_data;
+  uint8_t m_inline[BYTE_TAG_INLINE_SIZE];
 };
 
 } // namespace ns3
@@ -83,6 +83,15 @@ public:
    *          to this node.
    */
   uint32_t GetSystemId (void) const;
+  /**
+   * \param systemId the system id for parallel simulations
+   *
+   * Move this node to another system, before the simulation starts.
+   * With MPI, the point-to-point channels of the node which link it to
+   * another system must then be created again, as
+   * TopologyPartitionHelper does.
+   */
+  void SetSystemId (uint32_t systemId);
 
   /**
    * \param device NetDevice to associate to this node.
@@ -26,6 +26,10 @@
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
@@ -34,9 +38,23 @@ namespace ns3 {
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+
+namespace {
+
+#ifdef HAVE_PTHREAD_H
+__thread void *t_freeList __attribute__ ((tls_model ("initial-exec"))) = 0;
+pthread_key_t g_freeListKey;
+__thread uint16_t t_chunkUid __attribute__ ((tls_model ("initial-exec"))) = 0;
+#else
+uint16_t t_chunkUid = 0;
+#endif
+
+} // anonymous namespace
+
+PacketMetadata::DataFreeList::DataFreeList ()
+  : m_maxSize (0)
+{
+}
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -44,7 +62,43 @@ PacketMetadata::DataFreeList::~DataFreeList ()
     {
       PacketMetadata::Deallocate (*i);
     }
+#ifndef HAVE_PTHREAD_H
+  // the packets destroyed after the static list must not recycle into it
   PacketMetadata::m_enable = false;
+#endif
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+PacketMetadata::DeleteFreeList (void *freeList)
+{
+  delete static_cast<DataFreeList *> (freeList);
+}
+
+void
+PacketMetadata::CreateFreeListKey (void)
+{
+  pthread_key_create (&g_freeListKey, &DeleteFreeList);
+}
+#endif
+
+PacketMetadata::DataFreeList &
+PacketMetadata::GetFreeList (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (t_freeList == 0)
+    {
+      // deleted with its blocks when its thread exits
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      pthread_once (&once, &CreateFreeListKey);
+      t_freeList = new DataFreeList ();
+      pthread_setspecific (g_freeListKey, t_freeList);
+    }
+  return *static_cast<DataFreeList *> (t_freeList);
+#else
+  static DataFreeList freeList;
+  return freeList;
+#endif
 }
 
 void 
@@ -565,15 +619,16 @@ PacketMetadata::ReadItems (uint16_t current,
 struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
+  DataFreeList &freeList = GetFreeList ();
+  NS_LOG_LOGIC ("create size="<<size<<", max="<<freeList.m_maxSize);
+  if (size > freeList.m_maxSize)
     {
-      m_maxSize = size;
+      freeList.m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (!freeList.empty ()) 
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
+      struct PacketMetadata::Data *data = freeList.back ();
+      freeList.pop_back ();
       if (data->m_size >= size) 
         {
           NS_LOG_LOGIC ("create found size="<<data->m_size);
@@ -583,8 +638,8 @@ PacketMetadata::Create (uint32_t size)
       PacketMetadata::Deallocate (data);
       NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
     }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  NS_LOG_LOGIC ("create alloc size="<<freeList.m_maxSize);
+  return PacketMetadata::Allocate (freeList.m_maxSize);
 }
 
 void
@@ -595,16 +650,17 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
       PacketMetadata::Deallocate (data);
       return;
     } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  DataFreeList &freeList = GetFreeList ();
+  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+  if (freeList.size () > 1000 ||
+      data->m_size < freeList.m_maxSize) 
     {
       PacketMetadata::Deallocate (data);
     } 
   else 
     {
-      m_freeList.push_back (data);
+      freeList.push_back (data);
     }
 }
 
@@ -631,6 +687,23 @@ PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
   delete [] buf;
 }
 
+PacketMetadata
+PacketMetadata::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy (m_packetUid, 0);
+  if (copy.m_data->m_size < m_used)
+    {
+      PacketMetadata::Deallocate (copy.m_data);
+      copy.m_data = PacketMetadata::Allocate (m_used);
+    }
+  memcpy (copy.m_data->m_data, m_data->m_data, m_used);
+  copy.m_data->m_dirtyEnd = m_used;
+  copy.m_head = m_head;
+  copy.m_tail = m_tail;
+  copy.m_used = m_used;
+  return copy;
+}
 
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
@@ -664,8 +737,8 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = t_chunkUid;
+  t_chunkUid++;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
@@ -733,8 +806,8 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = t_chunkUid;
+  t_chunkUid++;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
@@ -132,6 +132,11 @@ private:
   inline PacketMetadata &operator = (PacketMetadata const& o);
   inline ~PacketMetadata ();
 
+  /**
+   * \returns a copy of this metadata which shares no data with it
+   */
+  PacketMetadata DeepCopy (void) const;
+
   void AddHeader (Header const &header, uint32_t size);
   void RemoveHeader (Header const &header, uint32_t size);
 
@@ -284,10 +289,13 @@ private:
     uint64_t packetUid;
   };
 
+  // each thread of a multithreaded simulation has its own free list
   class DataFreeList : public std::vector<struct Data *>
   {
 public:
+    DataFreeList ();
     ~DataFreeList ();
+    uint32_t m_maxSize;
   };
 
   friend DataFreeList::~DataFreeList ();
@@ -322,12 +330,14 @@ public:
   bool IsSharedPointerOk (uint16_t pointer) const;
 
 
+  static DataFreeList &GetFreeList (void);
+  static void DeleteFreeList (void *freeList);
+  static void CreateFreeListKey (void);
   static struct PacketMetadata::Data *Create (uint32_t size);
   static void Recycle (struct PacketMetadata::Data *data);
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
 
@@ -336,8 +346,6 @@ public:
   // middle of a simulation, which isn't allowed.
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize;
-  static uint16_t m_chunkUid;
 
   struct Data *m_data;
   /**
@@ -88,33 +88,40 @@ PacketTagList::Remove (Tag &tag)
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  bool found = false;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          tag.Deserialize (TagBuffer (m_inline[i].data, m_inline[i].data+PACKET_TAG_MAX_SIZE));
+          m_nInline--;
+          for (uint32_t j = i; j < m_nInline; j++)
+            {
+              m_inline[j] = m_inline[j + 1];
+            }
+          Link ();
+          return true;
+        }
+    }
+  struct TagData *found = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
         {
-          found = true;
+          found = cur;
           tag.Deserialize (TagBuffer (cur->data, cur->data+PACKET_TAG_MAX_SIZE));
+          break;
         }
     }
-  if (!found) 
+  if (found == 0) 
     {
       return false;
     }
+  // copy the nodes in front of the removed one, which may be shared,
+  // and share the nodes behind it
   struct TagData *start = 0;
   struct TagData **prevNext = &start;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (struct TagData *cur = m_next; cur != found; cur = cur->next) 
     {
-      if (cur->tid == tid) 
-        {
-          /**
-           * XXX
-           * Note: I believe that we could optimize this to
-           * avoid copying each TagData located after the target id
-           * and just link the already-copied list to the next tag.
-           */
-          continue;
-        }
       struct TagData *copy = AllocData ();
       copy->tid = cur->tid;
       copy->count = 1;
@@ -123,9 +130,14 @@ PacketTagList::Remove (Tag &tag)
       *prevNext = copy;
       prevNext = &copy->next;
     }
-  *prevNext = 0;
-  RemoveAll ();
+  *prevNext = found->next;
+  if (found->next != 0)
+    {
+      found->next->count++;
+    }
+  FreeShared ();
   m_next = start;
+  Link ();
   return true;
 }
 
@@ -134,19 +146,29 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (const struct TagData *cur = Head (); cur != 0; cur = cur->next) 
     {
       NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
     }
-  struct TagData *head = AllocData ();
+  PacketTagList *list = const_cast<PacketTagList *> (this);
+  struct TagData *head;
+  if (m_nInline < PACKET_TAG_INLINE_SIZE)
+    {
+      head = &list->m_inline[m_nInline];
+      head->next = m_nInline == 0 ? m_next : &list->m_inline[m_nInline - 1];
+      list->m_nInline++;
+    }
+  else
+    {
+      head = AllocData ();
+      head->next = m_next;
+      list->m_next = head;
+      list->Link ();
+    }
   head->count = 1;
-  head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
   NS_ASSERT (tag.GetSerializedSize () <= PACKET_TAG_MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data+tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
 }
 
 bool
@@ -154,12 +176,13 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (const struct TagData *cur = Head (); cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
         {
           /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data+PACKET_TAG_MAX_SIZE));
+          tag.Deserialize (TagBuffer (const_cast<uint8_t *> (cur->data), 
+                                      const_cast<uint8_t *> (cur->data)+PACKET_TAG_MAX_SIZE));
           return true;
         }
     }
@@ -170,7 +193,31 @@ PacketTagList::Peek (Tag &tag) const
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
-  return m_next;
+  if (m_nInline == 0)
+    {
+      return m_next;
+    }
+  return &m_inline[m_nInline - 1];
+}
+
+PacketTagList
+PacketTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  struct TagData **last = &copy.m_next;
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *data = AllocData ();
+      memcpy (data->data, cur->data, PACKET_TAG_MAX_SIZE);
+      data->tid = cur->tid;
+      data->count = 1;
+      data->next = 0;
+      *last = data;
+      last = &data->next;
+    }
+  copy.CopyInline (*this);
+  return copy;
 }
 
 } // namespace ns3
@@ -36,6 +36,28 @@ class Tag;
  */
 #define PACKET_TAG_MAX_SIZE 20
 
+/**
+ * \ingroup constants
+ * \brief Number of tags stored inline
+ * The first tags added to a packet are stored in the PacketTagList
+ * itself, without any allocation; the next ones are allocated and
+ * shared by the copies of the list.
+ */
+#define PACKET_TAG_INLINE_SIZE 2
+
+/**
+ * \ingroup packet
+ *
+ * \brief keep track of the packet tags stored in a packet.
+ *
+ * The first PACKET_TAG_INLINE_SIZE tags are kept in the list itself and
+ * copied with it, which costs a copy of a few bytes but no allocation.
+ * The tags added beyond are kept in a linked list of reference-counted
+ * nodes shared by the copies of the list, as copy-on-write data: a
+ * list never modifies a node, it only adds nodes in front of the shared
+ * ones or copies the nodes it keeps on removal.  Head () links the
+ * inline tags, most recent first, to the shared nodes.
+ */
 class PacketTagList 
 {
 public:
@@ -58,16 +80,27 @@ public:
 
   const struct PacketTagList::TagData *Head (void) const;
 
+  /**
+   * \returns a list with the same tags, in the same order, which shares
+   *          no data with this list
+   */
+  PacketTagList DeepCopy (void) const;
+
 private:
 
   bool Remove (TypeId tid);
   struct PacketTagList::TagData *AllocData (void) const;
   void FreeData (struct TagData *data) const;
+  inline void CopyInline (PacketTagList const &o);
+  inline void Link (void);
+  inline void FreeShared (void);
 
   static struct PacketTagList::TagData *g_free;
   static uint32_t g_nfree;
 
   struct TagData *m_next;
+  uint32_t m_nInline;
+  struct TagData m_inline[PACKET_TAG_INLINE_SIZE];
 };
 
 } // namespace ns3
@@ -79,7 +112,8 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_nInline (0)
 {
 }
 
@@ -90,32 +124,69 @@ PacketTagList::PacketTagList (PacketTagList const &o)
     {
       m_next->count++;
     }
+  CopyInline (o);
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      FreeShared ();
+      m_next = o.m_next;
+      if (m_next != 0) 
+        {
+          m_next->count++;
+        }
     }
+  CopyInline (o);
   return *this;
 }
 
 PacketTagList::~PacketTagList ()
 {
-  RemoveAll ();
+  FreeShared ();
+}
+
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  m_nInline = o.m_nInline;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
+  Link ();
+}
+
+void
+PacketTagList::Link (void)
+{
+  if (m_nInline == 0)
+    {
+      return;
+    }
+  m_inline[0].next = m_next;
+  for (uint32_t i = 1; i < m_nInline; i++)
+    {
+      m_inline[i].next = &m_inline[i - 1];
+    }
 }
 
 void
 PacketTagList::RemoveAll (void)
+{
+  FreeShared ();
+  m_nInline = 0;
+}
+
+void
+PacketTagList::FreeShared (void)
 {
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
@@ -21,6 +21,7 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/core-config.h"
 #include <string>
 #include <stdarg.h>
 
@@ -28,7 +29,34 @@ NS_LOG_COMPONENT_DEFINE ("Packet");
 
 namespace ns3 {
 
-uint32_t Packet::m_globalUid = 0;
+namespace {
+
+// the lower 32 bits of the uids of the packets.  Each thread takes
+// blocks of UID_BLOCK uids from a global counter, so that the threads of
+// a multithreaded simulation, and those of its successive runs, never
+// give the same uid, without an atomic operation per packet.
+const uint32_t UID_BLOCK = 1024;
+uint32_t g_nextUidBlock = 0;
+#ifdef HAVE_PTHREAD_H
+__thread uint32_t t_nextUid __attribute__ ((tls_model ("initial-exec"))) = 0;
+__thread uint32_t t_lastUid __attribute__ ((tls_model ("initial-exec"))) = 0;
+#else
+uint32_t t_nextUid = 0;
+uint32_t t_lastUid = 0;
+#endif
+
+inline uint32_t
+AllocateUid (void)
+{
+  if (t_nextUid == t_lastUid)
+    {
+      t_nextUid = __sync_fetch_and_add (&g_nextUidBlock, UID_BLOCK);
+      t_lastUid = t_nextUid + UID_BLOCK;
+    }
+  return t_nextUid++;
+}
+
+} // anonymous namespace
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -125,6 +153,33 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer buffer;
+  buffer.AddAtStart (m_buffer.GetSize ());
+  buffer.Begin ().Write (m_buffer.Begin (), m_buffer.End ());
+  // the byte tags keep their place relative to the start of the data
+  int32_t adjustment = buffer.GetCurrentStartOffset () - m_buffer.GetCurrentStartOffset ();
+  ByteTagList byteTagList;
+  ByteTagList::Iterator i = m_byteTagList.Begin (m_buffer.GetCurrentStartOffset (),
+                                                 m_buffer.GetCurrentEndOffset ());
+  while (i.HasNext ())
+    {
+      ByteTagList::Iterator::Item item = i.Next ();
+      TagBuffer tag = byteTagList.Add (item.tid, item.size, item.start + adjustment, item.end + adjustment);
+      tag.CopyFrom (item.buf);
+    }
+  Ptr<Packet> p = Ptr<Packet> (new Packet (buffer, byteTagList, m_packetTagList.DeepCopy (),
+                                           m_metadata.DeepCopy ()), false);
+  if (m_nixVector)
+    {
+      p->m_nixVector = m_nixVector->Copy ();
+    }
+  return p;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -135,10 +190,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -177,10 +231,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -203,10 +256,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -387,6 +439,24 @@ Packet::CopyData (std::ostream *os, uint32_t size) const
   return m_buffer.CopyData (os, size);
 }
 
+uint32_t
+Packet::GetVirtualPayloadStart (void) const
+{
+  return m_buffer.GetZeroAreaStart ();
+}
+
+uint32_t
+Packet::GetVirtualPayloadSize (void) const
+{
+  return m_buffer.GetZeroAreaSize ();
+}
+
+uint32_t
+Packet::CopyDataWithoutVirtualPayload (uint8_t *buffer, uint32_t size) const
+{
+  return m_buffer.CopyDataWithoutZeroArea (buffer, size);
+}
+
 uint64_t 
 Packet::GetUid (void) const
 {
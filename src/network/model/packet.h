@@ -214,9 +214,10 @@ public:
   /**
    * Create a packet with a zero-filled payload.
    * The memory necessary for the payload is not allocated:
-   * it will be allocated at any later point if you attempt
-   * to fragment this packet or to access the zero-filled
-   * bytes. The packet is allocated with a new uid (as 
+   * the payload is virtual, and stays so when the packet is
+   * fragmented, reassembled, serialized or checksummed. It is
+   * only allocated if you call the deprecated PeekData method.
+   * The packet is allocated with a new uid (as 
    * returned by getUid).
    * 
    * \param size the size of the zero-filled payload
@@ -365,6 +366,28 @@ public:
    */
   void CopyData (std::ostream *os, uint32_t size) const;
 
+  /**
+   * \returns the offset from the start of the packet of its virtual
+   *          payload, the zero-filled bytes which are not allocated
+   */
+  uint32_t GetVirtualPayloadStart (void) const;
+  /**
+   * \returns the size of the virtual payload, zero if all the bytes
+   *          of the packet are allocated
+   */
+  uint32_t GetVirtualPayloadSize (void) const;
+  /**
+   * \param buffer a pointer to a byte buffer where the bytes of the
+   *        packet before then after its virtual payload should be
+   *        copied.
+   * \param size the size of the byte buffer.
+   * \returns the number of bytes copied
+   *
+   * The packet is equal to these bytes with GetVirtualPayloadSize
+   * zeros inserted at GetVirtualPayloadStart.
+   */
+  uint32_t CopyDataWithoutVirtualPayload (uint8_t *buffer, uint32_t size) const;
+
   /**
    * \returns a COW copy of the packet.
    *
@@ -374,6 +397,17 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \returns a copy of the packet which shares no data with it.
+   *
+   * The reference counts of the datasets shared by the copies of a
+   * packet are not atomic, so that a packet handed over to another
+   * thread, as across the partitions of a multithreaded simulation, must
+   * be a deep copy.  The copy keeps the uid, the tags and the nix-vector
+   * of the packet.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * A packet is allocated a new uid when it is created
    * empty or with zero-filled payload.
@@ -566,8 +600,6 @@ private:
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector;
-
-  static uint32_t m_globalUid;
 };
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet);
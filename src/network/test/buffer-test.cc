@@ -1,6 +1,8 @@
 #include "ns3/buffer.h"
 #include "ns3/random-variable.h"
 #include "ns3/test.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
 
 namespace ns3 {
 
@@ -318,6 +320,71 @@ BufferTest::DoRun (void)
       NS_TEST_ASSERT_MSG_EQ ( evilBuffer [i], cBuf [i] , "Bad buffer peeked");
     }
   free (cBuf);
+
+  // the concatenation of buffers keeps a zero area
+  Buffer a (5);
+  a.AddAtStart (2);
+  i = a.Begin ();
+  i.WriteU8 (0x1);
+  i.WriteU8 (0x2);
+  Buffer b (4);
+  b.AddAtStart (1);
+  b.Begin ().WriteU8 (0x3);
+  b.AddAtEnd (1);
+  i = b.End ();
+  i.Prev (1);
+  i.WriteU8 (0x4);
+  buffer = a;
+  buffer.AddAtEnd (b);
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaStart (), 2, "The larger zero area is kept");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaSize (), 5, "The larger zero area is kept");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().CalculateIpChecksum (buffer.GetSize ()),
+                         buffer.CreateFullCopy ().Begin ().CalculateIpChecksum (buffer.GetSize ()),
+                         "Checksum over the zero area");
+  ENSURE_WRITTEN_BYTES (buffer, 13, 0x1, 0x2, 0, 0, 0, 0, 0, 0x3, 0, 0, 0, 0, 0x4);
+  uint8_t real[8];
+  NS_TEST_EXPECT_MSG_EQ (buffer.CopyDataWithoutZeroArea (real, 8), 8, "Bytes outside of the zero area");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)real[1], 0x2, "Last byte before the zero area");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)real[2], 0x3, "First byte after the zero area");
+  buffer = b;
+  buffer.AddAtEnd (a);
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaStart (), 8, "The larger zero area is kept");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaSize (), 5, "The larger zero area is kept");
+  ENSURE_WRITTEN_BYTES (buffer, 13, 0x3, 0, 0, 0, 0, 0x4, 0x1, 0x2, 0, 0, 0, 0, 0);
+  // adjacent zero areas of a buffer whose data is shared
+  buffer = Buffer (4);
+  Buffer shared = buffer;
+  b.RemoveAtStart (1);
+  buffer.AddAtEnd (b);
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaSize (), 8, "Adjacent zero areas are merged");
+  ENSURE_WRITTEN_BYTES (buffer, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0x4);
+  // a buffer without zero area before one with a zero area
+  buffer = Buffer ();
+  buffer.AddAtStart (2);
+  i = buffer.Begin ();
+  i.WriteU8 (0x5);
+  i.WriteU8 (0x6);
+  buffer.AddAtEnd (b);
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaStart (), 2, "The zero area is kept");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetZeroAreaSize (), 4, "The zero area is kept");
+  ENSURE_WRITTEN_BYTES (buffer, 7, 0x5, 0x6, 0, 0, 0, 0, 0x4);
+
+  // the data of a deleted buffer is taken again from the pool
+  BooleanValue pool;
+  GlobalValue::GetValueByName ("BufferDataPool", pool);
+  uint64_t hits = Buffer::GetNPoolHits ();
+  uint64_t misses = Buffer::GetNPoolMisses ();
+  for (uint32_t j = 0; j < 10; j++)
+    {
+      buffer = Buffer ();
+      buffer.AddAtStart (200);
+    }
+  if (pool.Get ())
+    {
+      NS_TEST_EXPECT_MSG_GT (Buffer::GetNPoolHits (), hits + 8, "The data is recycled");
+    }
+  NS_TEST_EXPECT_MSG_GT (Buffer::GetNPoolMisses () + Buffer::GetNPoolHits (), misses + hits + 9, "Every allocation is counted");
+  NS_TEST_EXPECT_MSG_GT (Buffer::GetPeakBytes (), 200, "Peak bytes");
 }
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+
+#include "ns3/test.h"
+#include "ns3/random-variable.h"
+#include "ns3/mac-learning-table.h"
+
+namespace ns3 {
+
+class MacLearningTableTestCase : public TestCase
+{
+public:
+  MacLearningTableTestCase ();
+  virtual void DoRun (void);
+private:
+  struct Entry
+  {
+    uint32_t port;
+    Time expiration;
+  };
+};
+
+MacLearningTableTestCase::MacLearningTableTestCase ()
+  : TestCase ("MAC learning table matches a map of expiration times")
+{
+}
+
+void
+MacLearningTableTestCase::DoRun (void)
+{
+  std::map<uint32_t, Entry> reference;
+  MacLearningTable table;
+  table.SetExpirationTime (Seconds (10));
+  table.SetSweepInterval (Seconds (3));
+  UniformVariable rand;
+  SeedManager::SetSeed (1);
+  SeedManager::SetRun (1);
+
+  // learn random addresses among 2000, with the time moving forward so that
+  // entries expire, and check the lookups against the reference
+  Time now = Seconds (0);
+  uint64_t learned = 0;
+  for (uint32_t n = 0; n < 20000; ++n)
+    {
+      now += MilliSeconds (rand.GetInteger (0, 2));
+      uint32_t id = rand.GetInteger (0, 1999);
+      uint8_t buffer[6] = { 0, 0, 0, 0, uint8_t (id >> 8), uint8_t (id) };
+      Mac48Address address;
+      address.CopyFrom (buffer);
+      if (rand.GetInteger (0, 1))
+        {
+          uint32_t port = rand.GetInteger (0, 7);
+          std::map<uint32_t, Entry>::iterator i = reference.find (id);
+          if (i == reference.end () || i->second.expiration <= now)
+            {
+              learned++;
+            }
+          Entry &entry = reference[id];
+          entry.port = port;
+          entry.expiration = now + Seconds (10);
+          table.Learn (address, port, now);
+        }
+      else
+        {
+          std::map<uint32_t, Entry>::iterator i = reference.find (id);
+          bool expected = i != reference.end () && i->second.expiration > now;
+          uint32_t port = 0;
+          bool found = table.Lookup (address, port, now);
+          NS_TEST_ASSERT_MSG_EQ (found, expected, "Wrong lookup of " << address << " at " << now);
+          if (expected)
+            {
+              NS_TEST_ASSERT_MSG_EQ (port, i->second.port, "Wrong port of " << address);
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.GetNLearned (), learned, "Wrong number of learned addresses");
+
+  // a sweep long after the last frame ages every entry out
+  uint32_t port;
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup (Mac48Address ("00:00:00:00:00:01"), port, now + Seconds (11)), false,
+                         "Every entry has expired");
+  NS_TEST_ASSERT_MSG_EQ (table.GetNEntries (), 0, "Expired entries must be swept");
+  NS_TEST_ASSERT_MSG_EQ (table.GetNAgedOut (), learned, "Every learned entry must age out");
+}
+
+static class MacLearningTableTestSuite : public TestSuite
+{
+public:
+  MacLearningTableTestSuite ()
+    : TestSuite ("mac-learning-table", UNIT)
+  {
+    AddTestCase (new MacLearningTableTestCase);
+  }
+} g_macLearningTableTestSuite;
+
+} // namespace ns3
@@ -420,6 +420,53 @@ PacketTest::DoRun (void)
     NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), false, "trivial");
   }
 
+  {
+    // more packet tags than are stored inline, shared by a copy
+    Packet p;
+    p.AddPacketTag (ATestTag<1> ());
+    p.AddPacketTag (ATestTag<2> ());
+    p.AddPacketTag (ATestTag<3> ());
+    p.AddPacketTag (ATestTag<4> ());
+    p.AddPacketTag (ATestTag<5> ());
+    Packet copy = p;
+    ATestTag<2> b;
+    ATestTag<4> d;
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (d), true, "shared tag");
+    NS_TEST_EXPECT_MSG_EQ (d.m_error, false, "shared tag data");
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (b), true, "inline tag");
+    NS_TEST_EXPECT_MSG_EQ (b.m_error, false, "inline tag data");
+    copy.AddPacketTag (ATestTag<6> ());
+    uint32_t nTags = 0;
+    for (PacketTagIterator i = copy.GetPacketTagIterator (); i.HasNext (); i.Next ())
+      {
+        nTags++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (nTags, 4, "tags of the copy");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (d), false, "removed from the copy");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (d), true, "kept by the original");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), true, "kept by the original");
+    ATestTag<6> f;
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (f), false, "added to the copy");
+    ATestTag<1> a;
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (a), true, "oldest tag");
+    NS_TEST_EXPECT_MSG_EQ (a.m_error, false, "oldest tag data");
+  }
+
+  {
+    // more byte tags than fit inline
+    Ptr<Packet> tmp = Create<Packet> (100);
+    tmp->AddByteTag (ATestTag<20> ());
+    Ptr<Packet> copy = tmp->Copy ();
+    tmp->AddByteTag (ATestTag<19> ());
+    tmp->AddByteTag (ATestTag<18> ());
+    CHECK (copy, 1, E (20, 0, 100));
+    CHECK (tmp, 3, E (20, 0, 100), E (19, 0, 100), E (18, 0, 100));
+    copy = tmp->Copy ();
+    tmp->AddByteTag (ATestTag<17> ());
+    CHECK (copy, 3, E (20, 0, 100), E (19, 0, 100), E (18, 0, 100));
+    CHECK (tmp, 4, E (20, 0, 100), E (19, 0, 100), E (18, 0, 100), E (17, 0, 100));
+  }
+
   {
     // bug 572
     Ptr<Packet> tmp = Create<Packet> (1000);
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "mac-learning-table.h"
+
+NS_LOG_COMPONENT_DEFINE ("MacLearningTable");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t INITIAL_SIZE = 16;
+
+} // anonymous namespace
+
+MacLearningTable::MacLearningTable ()
+  : m_slots (INITIAL_SIZE),
+    m_mask (INITIAL_SIZE - 1),
+    m_nEntries (0),
+    m_expirationTime (Seconds (300)),
+    m_sweepInterval (Seconds (60)),
+    m_nextSweep (Seconds (0)),
+    m_nLearned (0),
+    m_nAgedOut (0)
+{
+}
+
+void
+MacLearningTable::SetExpirationTime (Time expirationTime)
+{
+  m_expirationTime = expirationTime;
+}
+
+void
+MacLearningTable::SetSweepInterval (Time sweepInterval)
+{
+  m_sweepInterval = sweepInterval;
+}
+
+uint64_t
+MacLearningTable::GetKey (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = 1;
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+
+uint32_t
+MacLearningTable::FindSlot (uint64_t key) const
+{
+  // the low bits of the addresses allocated by a simulation are the ones
+  // that differ, so mix them into the high bits used as the index
+  uint32_t i = ((key * 0x9e3779b97f4a7c15ULL) >> 32) & m_mask;
+  while (m_slots[i].key != 0 && m_slots[i].key != key)
+    {
+      i = (i + 1) & m_mask;
+    }
+  return i;
+}
+
+void
+MacLearningTable::Resize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  std::vector<Slot> slots (size);
+  slots.swap (m_slots);
+  m_mask = size - 1;
+  for (std::vector<Slot>::const_iterator i = slots.begin (); i != slots.end (); i++)
+    {
+      if (i->key != 0)
+        {
+          m_slots[FindSlot (i->key)] = *i;
+        }
+    }
+}
+
+void
+MacLearningTable::Sweep (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+  m_nextSweep = now + m_sweepInterval;
+  uint32_t nEntries = 0;
+  int64_t step = now.GetTimeStep ();
+  for (std::vector<Slot>::iterator i = m_slots.begin (); i != m_slots.end (); i++)
+    {
+      if (i->key == 0)
+        {
+          continue;
+        }
+      if (i->expiration <= step)
+        {
+          i->key = 0;
+          m_nAgedOut++;
+        }
+      else
+        {
+          nEntries++;
+        }
+    }
+  if (nEntries != m_nEntries)
+    {
+      // removing entries breaks the probe sequences of the others
+      m_nEntries = nEntries;
+      Resize (m_slots.size ());
+    }
+}
+
+void
+MacLearningTable::Learn (Mac48Address address, uint32_t port, Time now)
+{
+  if (now >= m_nextSweep)
+    {
+      Sweep (now);
+    }
+  uint64_t key = GetKey (address);
+  uint32_t i = FindSlot (key);
+  Slot &slot = m_slots[i];
+  int64_t step = now.GetTimeStep ();
+  if (slot.key == 0)
+    {
+      slot.key = key;
+      m_nLearned++;
+      m_nEntries++;
+    }
+  else if (slot.expiration <= step)
+    {
+      m_nAgedOut++;
+      m_nLearned++;
+    }
+  slot.port = port;
+  slot.expiration = step + m_expirationTime.GetTimeStep ();
+  // keep the load under one half
+  if (2 * m_nEntries > m_slots.size ())
+    {
+      Resize (2 * m_slots.size ());
+    }
+}
+
+bool
+MacLearningTable::Lookup (Mac48Address address, uint32_t &port, Time now)
+{
+  if (now >= m_nextSweep)
+    {
+      Sweep (now);
+    }
+  const Slot &slot = m_slots[FindSlot (GetKey (address))];
+  if (slot.key == 0 || slot.expiration <= now.GetTimeStep ())
+    {
+      return false;
+    }
+  port = slot.port;
+  return true;
+}
+
+void
+MacLearningTable::Clear (void)
+{
+  m_slots.assign (INITIAL_SIZE, Slot ());
+  m_mask = INITIAL_SIZE - 1;
+  m_nEntries = 0;
+}
+
+uint32_t
+MacLearningTable::GetNEntries (void) const
+{
+  return m_nEntries;
+}
+
+uint64_t
+MacLearningTable::GetNLearned (void) const
+{
+  return m_nLearned;
+}
+
+uint64_t
+MacLearningTable::GetNAgedOut (void) const
+{
+  return m_nAgedOut;
+}
+
+} // namespace ns3
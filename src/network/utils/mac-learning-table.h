@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MAC_LEARNING_TABLE_H
+#define MAC_LEARNING_TABLE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+#include "mac48-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup address
+ *
+ * \brief The learned ports of the MAC addresses seen by a bridge or switch
+ *
+ * An open-addressing hash table with linear probing, keyed on the 48 bits
+ * of the address, so that learning a source and looking up a destination
+ * cost a hash and a few slots on the per-frame path.  An entry is valid
+ * until its expiration time, which Lookup checks, but expired entries are
+ * only removed by a sweep of the whole table, at most once per sweep
+ * interval, when the table is next used.
+ */
+class MacLearningTable
+{
+public:
+  MacLearningTable ();
+
+  /**
+   * \param expirationTime how long an entry stays valid after the last
+   *        frame from its address
+   */
+  void SetExpirationTime (Time expirationTime);
+
+  /**
+   * \param sweepInterval the minimum time between two sweeps of the
+   *        expired entries
+   */
+  void SetSweepInterval (Time sweepInterval);
+
+  /**
+   * \param address the source address of a frame
+   * \param port the port the frame came from
+   * \param now the current time
+   */
+  void Learn (Mac48Address address, uint32_t port, Time now);
+
+  /**
+   * \param address a destination address
+   * \param port (returned) the learned port of the address
+   * \param now the current time
+   * \returns true if the address has a valid entry
+   */
+  bool Lookup (Mac48Address address, uint32_t &port, Time now);
+
+  /**
+   * Forget every entry.  The counters are kept.
+   */
+  void Clear (void);
+
+  /**
+   * \returns the number of entries, including the expired ones not swept
+   *          yet
+   */
+  uint32_t GetNEntries (void) const;
+
+  /**
+   * \returns the number of addresses learned while unknown or expired
+   */
+  uint64_t GetNLearned (void) const;
+
+  /**
+   * \returns the number of entries which expired
+   */
+  uint64_t GetNAgedOut (void) const;
+
+private:
+  struct Slot
+  {
+    uint64_t key;       // the address, with bit 48 set; 0 for an empty slot
+    uint32_t port;
+    int64_t expiration; // time step of the expiration
+  };
+
+  static uint64_t GetKey (Mac48Address address);
+  uint32_t FindSlot (uint64_t key) const;
+  void Resize (uint32_t size);
+  void Sweep (Time now);
+
+  std::vector<Slot> m_slots;
+  uint32_t m_mask;
+  uint32_t m_nEntries;
+  Time m_expirationTime;
+  Time m_sweepInterval;
+  Time m_nextSweep;
+  uint64_t m_nLearned;
+  uint64_t m_nAgedOut;
+};
+
+} // namespace ns3
+
+#endif /* MAC_LEARNING_TABLE_H */
@@ -65,4 +65,16 @@
  * current node extracts the appropriate neighbor-index from the 
  * nix-vector and transmits the packet through the corresponding 
  * net-device.  This continues until the packet reaches the destination.
+ *
+ * When the topology is regular, the BFS can be skipped by giving the 
+ * helper an Ipv4NixPathOracle (Ipv4NixVectorHelper::SetPathOracle).  The 
+ * oracle returns the node path to a destination in closed form, which is 
+ * then encoded into a nix-vector using the per-node neighbor tables.  
+ * Paths the oracle does not answer are still found by the BFS.
+ *
+ * The BFS records every equal-cost parent of each node.  With the 
+ * EcmpMode attribute set to PerFlow or PerPacket, the source picks one 
+ * of the equal-cost paths by a hash of the 5-tuple, seeded by EcmpSeed, 
+ * or anew for every packet.  The choice is encoded in the nix-vector, 
+ * so intermediate nodes forward the packet as usual.
  * */
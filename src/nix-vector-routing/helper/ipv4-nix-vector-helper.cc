@@ -29,7 +29,8 @@ Ipv4NixVectorHelper::Ipv4NixVectorHelper ()
 }
 
 Ipv4NixVectorHelper::Ipv4NixVectorHelper (const Ipv4NixVectorHelper &o)
-  : m_agentFactory (o.m_agentFactory)
+  : m_agentFactory (o.m_agentFactory),
+    m_oracle (o.m_oracle)
 {
 }
 
@@ -44,7 +45,14 @@ Ipv4NixVectorHelper::Create (Ptr<Node> node) const
 {
   Ptr<Ipv4NixVectorRouting> agent = m_agentFactory.Create<Ipv4NixVectorRouting> ();
   agent->SetNode (node);
+  agent->SetPathOracle (m_oracle);
   node->AggregateObject (agent);
   return agent;
 }
+
+void
+Ipv4NixVectorHelper::SetPathOracle (Ptr<Ipv4NixPathOracle> oracle)
+{
+  m_oracle = oracle;
+}
 } // namespace ns3
@@ -23,6 +23,7 @@
 
 #include "ns3/object-factory.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/ipv4-nix-path-oracle.h"
 
 namespace ns3 {
 
@@ -65,6 +66,14 @@ public:
   */
   virtual Ptr<Ipv4RoutingProtocol> Create (Ptr<Node> node) const;
 
+  /**
+   * \param oracle a path oracle, shared by every routing protocol
+   *        created afterwards by this helper or its copies
+   *
+   * \see Ipv4NixPathOracle
+   */
+  void SetPathOracle (Ptr<Ipv4NixPathOracle> oracle);
+
 private:
   /**
    * \internal
@@ -74,6 +83,7 @@ private:
   Ipv4NixVectorHelper &operator = (const Ipv4NixVectorHelper &o);
 
   ObjectFactory m_agentFactory;
+  Ptr<Ipv4NixPathOracle> m_oracle;
 };
 } // namespace ns3
 
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_NIX_PATH_ORACLE_H
+#define IPV4_NIX_PATH_ORACLE_H
+
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/node.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup nixvectorrouting
+ *
+ * \brief Source of precomputed paths for Ipv4NixVectorRouting
+ *
+ * Structured topologies know the path between two of their hosts from
+ * the addresses alone.  A path oracle hands that knowledge to nix-vector
+ * routing, which then encodes the path into a nix-vector directly instead
+ * of searching the whole graph with a BFS.
+ *
+ * Paths must be made of adjacent nodes, as seen by nix-vector routing
+ * (bridges are transparent), and must only use links that are up: the
+ * oracle is trusted, so it should not be used for link failure studies.
+ * Whenever the oracle cannot answer, routing falls back to the BFS.
+ */
+class Ipv4NixPathOracle : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual ~Ipv4NixPathOracle ();
+
+  /**
+   * \param source the node the packet is sent from
+   * \param dest the destination address of the packet
+   * \param path (returned) every node of the path, source and
+   *        destination included
+   * \returns true if the oracle knows the path, false to let nix-vector
+   *          routing compute it itself
+   */
+  virtual bool GetPath (Ptr<Node> source, Ipv4Address dest, std::vector< Ptr<Node> > &path) = 0;
+
+  /**
+   * Used by the multipath modes of nix-vector routing.  The default
+   * implementation knows no equal-cost paths, which makes multipath
+   * routing fall back to the BFS.
+   *
+   * \param source the node the packet is sent from
+   * \param dest the destination address of the packet
+   * \returns the number of equal-cost paths from source to dest, or 0
+   *          if the oracle does not know them
+   */
+  virtual uint32_t GetNEqualCostPaths (Ptr<Node> source, Ipv4Address dest);
+
+  /**
+   * \param source the node the packet is sent from
+   * \param dest the destination address of the packet
+   * \param index the index of the path, in [0, GetNEqualCostPaths ())
+   * \param path (returned) every node of the path, source and
+   *        destination included
+   * \returns true if the oracle knows the path
+   */
+  virtual bool GetEqualCostPath (Ptr<Node> source, Ipv4Address dest, uint32_t index, std::vector< Ptr<Node> > &path);
+};
+
+} // namespace ns3
+
+#endif /* IPV4_NIX_PATH_ORACLE_H */
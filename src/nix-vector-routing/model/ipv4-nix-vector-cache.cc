@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+#include "ipv4-nix-vector-cache.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorCache");
+
+namespace ns3 {
+
+// rough size of the bookkeeping of an entry (map and list nodes), and
+// of a cached nix-vector besides its bits
+static const uint64_t ENTRY_OVERHEAD = 128;
+static const uint64_t NIX_VECTOR_OVERHEAD = 96;
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorCache);
+
+TypeId
+Ipv4NixVectorCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4NixVectorCache")
+    .SetParent<Object> ()
+    .AddConstructor<Ipv4NixVectorCache> ()
+    .AddAttribute ("MaxBytes",
+                   "The memory the cache may use before evicting the least recently used sources, 0 for no limit.",
+                   UintegerValue (256 << 20),
+                   MakeUintegerAccessor (&Ipv4NixVectorCache::m_maxBytes),
+                   MakeUintegerChecker<uint64_t> ())
+  ;
+  return tid;
+}
+
+Ptr<Ipv4NixVectorCache>
+Ipv4NixVectorCache::Get (void)
+{
+  return *DoGet ();
+}
+
+Ptr<Ipv4NixVectorCache> *
+Ipv4NixVectorCache::DoGet (void)
+{
+  static Ptr<Ipv4NixVectorCache> ptr = 0;
+  if (ptr == 0)
+    {
+      ptr = CreateObject<Ipv4NixVectorCache> ();
+      Simulator::ScheduleDestroy (&Ipv4NixVectorCache::Delete);
+    }
+  return &ptr;
+}
+
+void
+Ipv4NixVectorCache::Delete (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  (*DoGet ())->Dispose ();
+  (*DoGet ()) = 0;
+}
+
+Ipv4NixVectorCache::Ipv4NixVectorCache ()
+  : m_maxBytes (0),
+    m_generation (0),
+    m_bytes (0),
+    m_hits (0),
+    m_misses (0),
+    m_treeHits (0),
+    m_treeMisses (0),
+    m_evictions (0),
+    m_bfsMicroSeconds (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ipv4NixVectorCache::~Ipv4NixVectorCache ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+Ipv4NixVectorCache::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_entries.clear ();
+  m_lru.clear ();
+  m_bytes = 0;
+  Object::DoDispose ();
+}
+
+Ipv4NixVectorCache::Entry &
+Ipv4NixVectorCache::Touch (uint32_t source)
+{
+  Entries::iterator i = m_entries.find (source);
+  if (i == m_entries.end ())
+    {
+      i = m_entries.insert (Entries::value_type (source, Entry ())).first;
+      m_lru.push_front (source);
+      i->second.lru = m_lru.begin ();
+      i->second.bytes = ENTRY_OVERHEAD;
+      m_bytes += ENTRY_OVERHEAD;
+    }
+  else if (i->second.lru != m_lru.begin ())
+    {
+      m_lru.splice (m_lru.begin (), m_lru, i->second.lru);
+    }
+  return i->second;
+}
+
+void
+Ipv4NixVectorCache::Evict (void)
+{
+  // the most recently used source is never evicted, so the entry the
+  // caller is working on stays valid
+  while (m_maxBytes != 0 && m_bytes > m_maxBytes && m_lru.size () > 1)
+    {
+      Entries::iterator i = m_entries.find (m_lru.back ());
+      NS_LOG_LOGIC ("Evicting source " << i->first << ", " << i->second.bytes << " bytes");
+      m_bytes -= i->second.bytes;
+      m_entries.erase (i);
+      m_lru.pop_back ();
+      m_evictions++;
+    }
+}
+
+uint64_t
+Ipv4NixVectorCache::GetBytes (const ParentGraph &graph)
+{
+  return (graph.first.capacity () + graph.parents.capacity () + graph.nPaths.capacity ()) * sizeof (uint32_t);
+}
+
+bool
+Ipv4NixVectorCache::LookupNixVector (uint32_t source, uint32_t dest, uint32_t path, Ptr<NixVector> &nixVector)
+{
+  Entries::iterator i = m_entries.find (source);
+  if (i == m_entries.end ())
+    {
+      m_misses++;
+      return false;
+    }
+  NixVectorMap_t::const_iterator j = i->second.nixVectors.find (std::make_pair (dest, path));
+  if (j == i->second.nixVectors.end ())
+    {
+      m_misses++;
+      return false;
+    }
+  Touch (source);
+  m_hits++;
+  nixVector = j->second;
+  return true;
+}
+
+const Ipv4NixVectorCache::ParentGraph *
+Ipv4NixVectorCache::LookupTree (uint32_t source)
+{
+  Entries::iterator i = m_entries.find (source);
+  if (i == m_entries.end () || i->second.graph.first.empty ())
+    {
+      m_treeMisses++;
+      return 0;
+    }
+  Touch (source);
+  m_treeHits++;
+  return &i->second.graph;
+}
+
+const Ipv4NixVectorCache::ParentGraph &
+Ipv4NixVectorCache::AddTree (uint32_t source, ParentGraph &graph, uint64_t bfsMicroSeconds)
+{
+  NS_LOG_FUNCTION (source << graph.parents.size () << bfsMicroSeconds);
+  m_bfsMicroSeconds += bfsMicroSeconds;
+
+  Entry &entry = Touch (source);
+  m_bytes -= entry.bytes;
+  entry.bytes -= GetBytes (entry.graph);
+  entry.graph.first.swap (graph.first);
+  entry.graph.parents.swap (graph.parents);
+  entry.graph.nPaths.swap (graph.nPaths);
+  graph = ParentGraph ();
+  entry.bytes += GetBytes (entry.graph);
+  m_bytes += entry.bytes;
+  Evict ();
+  return entry.graph;
+}
+
+void
+Ipv4NixVectorCache::AddNixVector (uint32_t source, uint32_t dest, uint32_t path, Ptr<NixVector> nixVector)
+{
+  Entry &entry = Touch (source);
+  if (entry.nixVectors.insert (NixVectorMap_t::value_type (std::make_pair (dest, path), nixVector)).second)
+    {
+      uint64_t bytes = NIX_VECTOR_OVERHEAD + (nixVector ? nixVector->GetSerializedSize () : 0);
+      entry.bytes += bytes;
+      m_bytes += bytes;
+      Evict ();
+    }
+}
+
+const Ipv4NixVectorCache::NixVectorMap_t *
+Ipv4NixVectorCache::GetNixVectors (uint32_t source) const
+{
+  Entries::const_iterator i = m_entries.find (source);
+  if (i == m_entries.end ())
+    {
+      return 0;
+    }
+  return &i->second.nixVectors;
+}
+
+void
+Ipv4NixVectorCache::Flush (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_entries.clear ();
+  m_lru.clear ();
+  m_bytes = 0;
+  m_generation++;
+}
+
+uint32_t
+Ipv4NixVectorCache::GetGeneration (void) const
+{
+  return m_generation;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetMisses (void) const
+{
+  return m_misses;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetTreeHits (void) const
+{
+  return m_treeHits;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetTreeMisses (void) const
+{
+  return m_treeMisses;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetEvictions (void) const
+{
+  return m_evictions;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetBfsMicroSeconds (void) const
+{
+  return m_bfsMicroSeconds;
+}
+
+uint64_t
+Ipv4NixVectorCache::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+uint32_t
+Ipv4NixVectorCache::GetNSources (void) const
+{
+  return m_entries.size ();
+}
+
+void
+Ipv4NixVectorCache::PrintStatistics (std::ostream &os) const
+{
+  os << "Nix-vector cache: " << m_hits << " hits, " << m_misses << " misses, "
+     << m_treeHits << " tree hits, " << m_treeMisses << " tree misses, "
+     << m_bfsMicroSeconds / 1000.0 << " ms in BFS, "
+     << m_entries.size () << " sources, " << m_bytes << " bytes, "
+     << m_evictions << " evictions, " << m_generation << " flushes" << std::endl;
+}
+
+} // namespace ns3
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_NIX_VECTOR_CACHE_H
+#define IPV4_NIX_VECTOR_CACHE_H
+
+#include <map>
+#include <list>
+#include <vector>
+#include <utility>
+#include <ostream>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nix-vector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup nixvectorrouting
+ *
+ * \brief Nix-vector cache shared by every Ipv4NixVectorRouting of the
+ * simulation
+ *
+ * For each source node, the cache keeps the shortest paths to every
+ * other node, found by a single BFS, along with the nix-vectors already
+ * built from them.  A single BFS per source thus answers every
+ * destination, along every equal-cost path.
+ *
+ * Entries are kept in least recently used order, and the least recently
+ * used sources are evicted whenever the estimated memory use goes over
+ * the MaxBytes attribute.
+ *
+ * Topology changes call Flush, which empties the cache and bumps its
+ * generation number.  The per-node caches of nix-vector routing compare
+ * that number to theirs and flush themselves lazily, so a topology
+ * change costs O(1) instead of a walk of the whole node list.
+ *
+ * The cache is created on first use and destroyed by
+ * Simulator::Destroy.  Its attributes can be set with Config::SetDefault
+ * before, or through Get () afterwards.
+ */
+class Ipv4NixVectorCache : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * Map of destination node id and path index to NixVector
+   */
+  typedef std::map<std::pair<uint32_t, uint32_t>, Ptr<NixVector> > NixVectorMap_t;
+
+  /**
+   * Every shortest path from a source, as found by a BFS.  The parents
+   * of node i, the neighbors one hop closer to the source, are
+   * parents[first[i]] to parents[first[i + 1] - 1] in BFS discovery
+   * order, so that the first parent of each node makes the plain BFS
+   * tree.  nPaths[i] is the number of shortest paths from the source
+   * to node i, 0 if it is unreachable, saturated at 0xffffffff.
+   */
+  struct ParentGraph
+  {
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> nPaths;
+  };
+
+  /**
+   * \returns the cache of the simulation, created on first use
+   */
+  static Ptr<Ipv4NixVectorCache> Get (void);
+
+  Ipv4NixVectorCache ();
+  virtual ~Ipv4NixVectorCache ();
+
+  /**
+   * \param source the id of the source node
+   * \param dest the id of the destination node
+   * \param path the index of the path among the equal-cost ones
+   * \param nixVector (returned) the cached nix-vector, 0 if dest was
+   *        found unreachable
+   * \returns true if the cache knows the nix-vector
+   */
+  bool LookupNixVector (uint32_t source, uint32_t dest, uint32_t path, Ptr<NixVector> &nixVector);
+
+  /**
+   * \param source the id of the source node
+   * \returns the shortest paths from source, or 0 if they are not cached
+   */
+  const ParentGraph * LookupTree (uint32_t source);
+
+  /**
+   * Store the shortest paths from a source.  The cache takes the
+   * content of graph, leaving it empty.
+   *
+   * \param source the id of the source node
+   * \param graph the shortest paths from source
+   * \param bfsMicroSeconds the wall clock time the BFS took
+   * \returns the stored paths
+   */
+  const ParentGraph & AddTree (uint32_t source, ParentGraph &graph, uint64_t bfsMicroSeconds);
+
+  /**
+   * \param source the id of the source node
+   * \param dest the id of the destination node
+   * \param path the index of the path among the equal-cost ones
+   * \param nixVector the nix-vector from source to dest, 0 if there is
+   *        no path
+   */
+  void AddNixVector (uint32_t source, uint32_t dest, uint32_t path, Ptr<NixVector> nixVector);
+
+  /**
+   * \param source the id of the source node
+   * \returns the nix-vectors cached for source, or 0 if none is; this
+   *          does not count as a use of the entry
+   */
+  const NixVectorMap_t * GetNixVectors (uint32_t source) const;
+
+  /**
+   * Forget everything, after a topology change.
+   */
+  void Flush (void);
+
+  /**
+   * \returns the number of Flush calls so far
+   */
+  uint32_t GetGeneration (void) const;
+
+  /**
+   * \returns the number of nix-vector lookups answered from the cache
+   */
+  uint64_t GetHits (void) const;
+
+  /**
+   * \returns the number of nix-vector lookups the cache could not
+   *          answer, whether the oracle or a BFS tree then built the
+   *          nix-vector
+   */
+  uint64_t GetMisses (void) const;
+
+  /**
+   * \returns the number of BFS tree lookups answered from the cache
+   */
+  uint64_t GetTreeHits (void) const;
+
+  /**
+   * \returns the number of BFS tree lookups that needed a new BFS
+   */
+  uint64_t GetTreeMisses (void) const;
+
+  /**
+   * \returns the number of sources evicted to honor MaxBytes
+   */
+  uint64_t GetEvictions (void) const;
+
+  /**
+   * \returns the total wall clock time spent in BFS, in microseconds
+   */
+  uint64_t GetBfsMicroSeconds (void) const;
+
+  /**
+   * \returns the estimated memory used by the cache, in bytes
+   */
+  uint64_t GetBytes (void) const;
+
+  /**
+   * \returns the number of sources in the cache
+   */
+  uint32_t GetNSources (void) const;
+
+  /**
+   * \param os the output stream
+   *
+   * Print the counters on a single line.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Entry
+  {
+    ParentGraph graph;
+    NixVectorMap_t nixVectors;
+    uint64_t bytes;
+    std::list<uint32_t>::iterator lru;
+  };
+  typedef std::map<uint32_t, Entry> Entries;
+
+  static Ptr<Ipv4NixVectorCache> *DoGet (void);
+  static void Delete (void);
+
+  // find the entry of source, creating it if needed, and make it the
+  // most recently used one
+  Entry & Touch (uint32_t source);
+  void Evict (void);
+  static uint64_t GetBytes (const ParentGraph &graph);
+
+  uint64_t m_maxBytes;
+
+  Entries m_entries;
+  // most recently used source first
+  std::list<uint32_t> m_lru;
+
+  uint32_t m_generation;
+  uint64_t m_bytes;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_treeHits;
+  uint64_t m_treeMisses;
+  uint64_t m_evictions;
+  uint64_t m_bfsMicroSeconds;
+};
+
+} // namespace ns3
+
+#endif /* IPV4_NIX_VECTOR_CACHE_H */
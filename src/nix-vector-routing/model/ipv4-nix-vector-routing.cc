@@ -20,13 +20,20 @@
 
 #include <queue>
 #include <iomanip>
+#include <algorithm>
+#include <sys/time.h>
 
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/names.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4-address-node-index.h"
+#include "ns3/ipv4-flow-hash.h"
 
 #include "ipv4-nix-vector-routing.h"
+#include "ipv4-nix-vector-cache.h"
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorRouting");
 
@@ -40,12 +47,35 @@ Ipv4NixVectorRouting::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::Ipv4NixVectorRouting")
     .SetParent<Ipv4RoutingProtocol> ()
     .AddConstructor<Ipv4NixVectorRouting> ()
+    .AddAttribute ("EcmpMode",
+                   "How packets sent by this node are spread over equal-cost paths.",
+                   EnumValue (ECMP_NONE),
+                   MakeEnumAccessor (&Ipv4NixVectorRouting::m_ecmpMode),
+                   MakeEnumChecker (ECMP_NONE, "None",
+                                    ECMP_PER_FLOW, "PerFlow",
+                                    ECMP_PER_PACKET, "PerPacket"))
+    .AddAttribute ("EcmpSeed",
+                   "The seed of the 5-tuple hash picking the path of a flow.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4NixVectorRouting::m_ecmpSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxRouteCacheEntries",
+                   "The number of Ipv4Routes this node caches before evicting the least recently used ones, 0 for no limit.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&Ipv4NixVectorRouting::m_maxIpv4RouteCacheEntries),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 Ipv4NixVectorRouting::Ipv4NixVectorRouting ()
-  : m_totalNeighbors (0)
+  : m_maxIpv4RouteCacheEntries (0),
+    m_cacheGeneration (0),
+    m_totalNeighbors (0),
+    m_neighborIdsValid (false),
+    m_ecmpMode (ECMP_NONE),
+    m_ecmpSeed (0),
+    m_ecmpPackets (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -72,6 +102,7 @@ Ipv4NixVectorRouting::DoDispose ()
 
   m_node = 0;
   m_ipv4 = 0;
+  m_oracle = 0;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -85,22 +116,33 @@ Ipv4NixVectorRouting::SetNode (Ptr<Node> node)
   m_node = node;
 }
 
+void
+Ipv4NixVectorRouting::SetPathOracle (Ptr<Ipv4NixPathOracle> oracle)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_oracle = oracle;
+}
+
 void
 Ipv4NixVectorRouting::FlushGlobalNixRoutingCache ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  // the caches of each node see the new generation
+  // and flush themselves on their next use
+  NS_LOG_LOGIC ("Flushing Nix caches.");
+  Ipv4NixVectorCache::Get ()->Flush ();
+}
+
+void
+Ipv4NixVectorRouting::CheckCacheGeneration ()
+{
+  uint32_t generation = Ipv4NixVectorCache::Get ()->GetGeneration ();
+  if (generation != m_cacheGeneration)
     {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4NixVectorRouting> rp = node->GetObject<Ipv4NixVectorRouting> ();
-      if (!rp)
-        {
-          continue;
-        }
-      NS_LOG_LOGIC ("Flushing Nix caches.");
-      rp->FlushNixCache ();
-      rp->FlushIpv4RouteCache ();
+      FlushNixCache ();
+      FlushIpv4RouteCache ();
+      m_cacheGeneration = generation;
     }
 }
 
@@ -108,7 +150,8 @@ void
 Ipv4NixVectorRouting::FlushNixCache ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_nixCache.clear ();
+  m_neighborIds.clear ();
+  m_neighborIdsValid = false;
 }
 
 void
@@ -116,16 +159,14 @@ Ipv4NixVectorRouting::FlushIpv4RouteCache ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_ipv4RouteCache.clear ();
+  m_ipv4RouteLru.clear ();
 }
 
 Ptr<NixVector>
-Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif, uint32_t hash)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  Ptr<NixVector> nixVector = Create<NixVector> ();
-
-  // not in cache, must build the nix vector
   // First, we have to figure out the nodes 
   // associated with these IPs
   Ptr<Node> destNode = GetNodeByIp (dest);
@@ -134,67 +175,191 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
       NS_LOG_ERROR ("No routing path exists");
       return 0;
     }
+  uint32_t sourceId = source->GetId ();
+  uint32_t destId = destNode->GetId ();
+
+  // paths forced through an output device are
+  // not shared through the cache
+  Ptr<Ipv4NixVectorCache> cache = Ipv4NixVectorCache::Get ();
+  Ipv4NixVectorCache::ParentGraph restricted;
+  const Ipv4NixVectorCache::ParentGraph *tree = 0;
+  if (oif && source != destNode)
+    {
+      BuildParentTree (source, destNode, oif, restricted);
+      tree = &restricted;
+    }
+
+  // pick the path among the equal-cost ones; path 0
+  // is the one used without multipath
+  bool useOracle = m_oracle && !oif;
+  uint32_t path = 0;
+  if (m_ecmpMode != ECMP_NONE && source != destNode)
+    {
+      uint32_t nPaths = 0;
+      if (useOracle)
+        {
+          nPaths = m_oracle->GetNEqualCostPaths (source, dest);
+          useOracle = nPaths != 0;
+        }
+      if (!useOracle)
+        {
+          if (tree == 0)
+            {
+              tree = &GetShortestPaths (source);
+            }
+          nPaths = destId < tree->nPaths.size () ? tree->nPaths[destId] : 0;
+        }
+      if (nPaths > 1)
+        {
+          path = hash % nPaths;
+        }
+    }
+
+  Ptr<NixVector> nixVector;
+  if (!oif && cache->LookupNixVector (sourceId, destId, path, nixVector))
+    {
+      NS_LOG_LOGIC ("Found Nix-vector in cache.");
+      return nixVector;
+    }
+
+  // not in cache, must build the nix vector
+  nixVector = Create<NixVector> ();
+  bool found = false;
 
   // if source == dest, then we have a special case
   // because the node is sending to itself.  have to
   // build the nix vector a little differently
   if (source == destNode)
     {
-      BuildNixVectorLocal (nixVector);
-      return nixVector;
+      found = BuildNixVectorLocal (nixVector);
     }
   else
     {
-      // otherwise proceed as normal 
-      // and build the nix vector
-      std::vector< Ptr<Node> > parentVector;
-
-      BFS (NodeList::GetNNodes (), source, destNode, parentVector, oif);
-
-      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector))
+      // the path oracle knows paths that leave through any device
+      if (useOracle)
         {
-          return nixVector;
+          std::vector< Ptr<Node> > oraclePath;
+          bool known;
+          if (m_ecmpMode != ECMP_NONE)
+            {
+              known = m_oracle->GetEqualCostPath (source, dest, path, oraclePath);
+            }
+          else
+            {
+              known = m_oracle->GetPath (source, dest, oraclePath);
+            }
+          if (known)
+            {
+              found = BuildNixVectorFromPath (oraclePath, nixVector);
+              if (found)
+                {
+                  NS_LOG_LOGIC ("Nix-vector built from the path oracle");
+                }
+              else
+                {
+                  NS_LOG_WARN ("Path oracle returned an invalid path to " << dest << ", falling back to BFS");
+                  nixVector = Create<NixVector> ();
+                }
+            }
         }
-      else
+
+      // otherwise proceed as normal: the shortest paths
+      // of the source are kept, so that they answer later
+      // destinations as well
+      if (!found)
         {
-          NS_LOG_ERROR ("No routing path exists");
-          return 0;
+          if (tree == 0)
+            {
+              tree = &GetShortestPaths (source);
+            }
+          found = BuildNixVectorFromTree (*tree, sourceId, destId, path, nixVector);
         }
     }
+
+  if (!found)
+    {
+      NS_LOG_ERROR ("No routing path exists");
+      nixVector = 0;
+    }
+  if (!oif)
+    {
+      cache->AddNixVector (sourceId, destId, path, nixVector);
+    }
+  return nixVector;
 }
 
-Ptr<NixVector>
-Ipv4NixVectorRouting::GetNixVectorInCache (Ipv4Address address)
+const Ipv4NixVectorCache::ParentGraph &
+Ipv4NixVectorRouting::GetShortestPaths (Ptr<Node> source)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  NixMap_t::iterator iter = m_nixCache.find (address);
-  if (iter != m_nixCache.end ())
+  Ptr<Ipv4NixVectorCache> cache = Ipv4NixVectorCache::Get ();
+  const Ipv4NixVectorCache::ParentGraph *tree = cache->LookupTree (source->GetId ());
+  if (tree == 0)
     {
-      NS_LOG_LOGIC ("Found Nix-vector in cache.");
-      return iter->second;
+      Ipv4NixVectorCache::ParentGraph graph;
+      uint64_t us = BuildParentTree (source, 0, 0, graph);
+      tree = &cache->AddTree (source->GetId (), graph, us);
     }
-
-  // not in cache
-  return 0;
+  return *tree;
 }
 
 Ptr<Ipv4Route>
-Ipv4NixVectorRouting::GetIpv4RouteInCache (Ipv4Address address)
+Ipv4NixVectorRouting::GetIpv4RouteInCache (Ipv4Address address, uint32_t nodeIndex)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  Ipv4RouteMap_t::iterator iter = m_ipv4RouteCache.find (address);
+  Ipv4RouteCache_t::iterator iter = m_ipv4RouteCache.find (std::make_pair (address, nodeIndex));
   if (iter != m_ipv4RouteCache.end ())
     {
       NS_LOG_LOGIC ("Found Ipv4Route in cache.");
-      return iter->second;
+      if (iter->second.lru != m_ipv4RouteLru.begin ())
+        {
+          m_ipv4RouteLru.splice (m_ipv4RouteLru.begin (), m_ipv4RouteLru, iter->second.lru);
+        }
+      return iter->second.route;
     }
 
   // not in cache
   return 0;
 }
 
+void
+Ipv4NixVectorRouting::AddIpv4RouteToCache (Ipv4Address address, uint32_t nodeIndex, Ptr<Ipv4Route> rtentry)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ipv4RouteKey_t key = std::make_pair (address, nodeIndex);
+  std::pair<Ipv4RouteCache_t::iterator, bool> inserted =
+    m_ipv4RouteCache.insert (Ipv4RouteCache_t::value_type (key, Ipv4RouteCacheEntry ()));
+  if (!inserted.second)
+    {
+      inserted.first->second.route = rtentry;
+      return;
+    }
+  m_ipv4RouteLru.push_front (key);
+  inserted.first->second.route = rtentry;
+  inserted.first->second.lru = m_ipv4RouteLru.begin ();
+
+  while (m_maxIpv4RouteCacheEntries != 0 && m_ipv4RouteCache.size () > m_maxIpv4RouteCacheEntries)
+    {
+      NS_LOG_LOGIC ("Evicting Ipv4Route to " << m_ipv4RouteLru.back ().first);
+      m_ipv4RouteCache.erase (m_ipv4RouteLru.back ());
+      m_ipv4RouteLru.pop_back ();
+    }
+}
+
+void
+Ipv4NixVectorRouting::RemoveIpv4RouteFromCache (Ipv4Address address, uint32_t nodeIndex)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ipv4RouteCache_t::iterator iter = m_ipv4RouteCache.find (std::make_pair (address, nodeIndex));
+  if (iter != m_ipv4RouteCache.end ())
+    {
+      m_ipv4RouteLru.erase (iter->second.lru);
+      m_ipv4RouteCache.erase (iter);
+    }
+}
+
 bool
 Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
 {
@@ -222,77 +387,134 @@ Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
   return false;
 }
 
+uint64_t
+Ipv4NixVectorRouting::BuildParentTree (Ptr<Node> source, Ptr<Node> dest, Ptr<NetDevice> oif, Ipv4NixVectorCache::ParentGraph & graph)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  struct timeval start;
+  gettimeofday (&start, 0);
+
+  BFS (NodeList::GetNNodes (), source, dest, graph, oif);
+
+  struct timeval end;
+  gettimeofday (&end, 0);
+  return (end.tv_sec - start.tv_sec) * 1000000ULL + end.tv_usec - start.tv_usec;
+}
+
 bool
-Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
+Ipv4NixVectorRouting::BuildNixVectorFromTree (const Ipv4NixVectorCache::ParentGraph & graph, uint32_t source, uint32_t dest,
+                                              uint32_t path, Ptr<NixVector> nixVector)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  if (source == dest)
+  if (dest >= graph.nPaths.size () || graph.nPaths[dest] == 0)
     {
-      return true;
+      return false;
     }
 
-  if (parentVector.at (dest) == 0)
+  // retrace the path from the destination.  The paths
+  // through a node are numbered parent by parent: the
+  // first nPaths[p0] go through its first parent p0,
+  // the next nPaths[p1] through p1, and so on
+  std::vector< Ptr<Node> > nodes;
+  uint32_t index = path % graph.nPaths[dest];
+  for (uint32_t id = dest; id != source; )
     {
-      return false;
+      nodes.push_back (NodeList::GetNode (id));
+      uint32_t i = graph.first[id];
+      uint32_t last = graph.first[id + 1];
+      if (i == last)
+        {
+          return false;
+        }
+      for (; i + 1 < last && index >= graph.nPaths[graph.parents[i]]; i++)
+        {
+          index -= graph.nPaths[graph.parents[i]];
+        }
+      id = graph.parents[i];
+      // only needed if the path counts saturated
+      index %= graph.nPaths[id];
     }
+  nodes.push_back (NodeList::GetNode (source));
+  std::reverse (nodes.begin (), nodes.end ());
 
-  Ptr<Node> parentNode = parentVector.at (dest);
+  return BuildNixVectorFromPath (nodes, nixVector);
+}
 
-  uint32_t numberOfDevices = parentNode->GetNDevices ();
-  uint32_t destId = 0;
-  uint32_t totalNeighbors = 0;
+bool
+Ipv4NixVectorRouting::BuildNixVectorFromPath (const std::vector< Ptr<Node> > & path, Ptr<NixVector> nixVector)
+{
+  NS_LOG_FUNCTION_NOARGS ();
 
-  // scan through the net devices on the parent node
-  // and then look at the nodes adjacent to them
-  for (uint32_t i = 0; i < numberOfDevices; i++)
+  if (path.empty () || path.front () != m_node)
     {
-      // Get a net device from the node
-      // as well as the channel, and figure
-      // out the adjacent net devices
-      Ptr<NetDevice> localNetDevice = parentNode->GetDevice (i);
-      if (localNetDevice->IsBridge ())
+      return false;
+    }
+  if (path.size () == 1)
+    {
+      return BuildNixVectorLocal (nixVector);
+    }
+
+  // the first hop must be extracted first, and the nix-vector
+  // is read back from the last added bits, so add the hops
+  // starting from the destination
+  for (uint32_t i = path.size () - 1; i > 0; i--)
+    {
+      Ptr<Ipv4NixVectorRouting> rp = path[i - 1]->GetObject<Ipv4NixVectorRouting> ();
+      if (!rp)
         {
-          continue;
+          return false;
+        }
+      const std::vector<uint32_t> &neighbors = rp->GetNeighborIds ();
+      uint32_t nextId = path[i]->GetId ();
+      uint32_t index = 0;
+      while (index < neighbors.size () && neighbors[index] != nextId)
+        {
+          index++;
+        }
+      if (index == neighbors.size ())
+        {
+          NS_LOG_LOGIC ("Node " << nextId << " is not a neighbor of node " << path[i - 1]->GetId ());
+          return false;
         }
+      NS_LOG_LOGIC ("Adding Nix: " << index << " with " << nixVector->BitCount (neighbors.size ())
+                                   << " bits, for node " << path[i - 1]->GetId ());
+      nixVector->AddNeighborIndex (index, nixVector->BitCount (neighbors.size ()));
+    }
+  return true;
+}
+
+const std::vector<uint32_t> &
+Ipv4NixVectorRouting::GetNeighborIds (void)
+{
+  CheckCacheGeneration ();
+  if (m_neighborIdsValid)
+    {
+      return m_neighborIds;
+    }
+
+  // same order as FindNetDeviceForNixIndex, which decodes
+  // the neighbor index at forwarding time
+  m_neighborIds.clear ();
+  uint32_t numberOfDevices = m_node->GetNDevices ();
+  for (uint32_t i = 0; i < numberOfDevices; i++)
+    {
+      Ptr<NetDevice> localNetDevice = m_node->GetDevice (i);
       Ptr<Channel> channel = localNetDevice->GetChannel ();
       if (channel == 0)
         {
           continue;
         }
-
-      // this function takes in the local net dev, and channnel, and
-      // writes to the netDeviceContainer the adjacent net devs
       NetDeviceContainer netDeviceContainer;
       GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
-
-      // Finally we can get the adjacent nodes
-      // and scan through them.  If we find the 
-      // node that matches "dest" then we can add 
-      // the index  to the nix vector.
-      // the index corresponds to the neighbor index
-      uint32_t offset = 0;
       for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
         {
-          Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-          if (remoteNode->GetId () == dest)
-            {
-              destId = totalNeighbors + offset;
-            }
-          offset += 1;
+          m_neighborIds.push_back ((*iter)->GetNode ()->GetId ());
         }
-
-      totalNeighbors += netDeviceContainer.GetN ();
     }
-  NS_LOG_LOGIC ("Adding Nix: " << destId << " with " 
-                               << nixVector->BitCount (totalNeighbors) << " bits, for node " << parentNode->GetId ());
-  nixVector->AddNeighborIndex (destId, nixVector->BitCount (totalNeighbors));
-
-  // recurse through parent vector, grabbing the path 
-  // and building the nix vector
-  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector);
-  return true;
+  m_neighborIdsValid = true;
+  return m_neighborIds;
 }
 
 void
@@ -340,19 +562,7 @@ Ipv4NixVectorRouting::GetNodeByIp (Ipv4Address dest)
 { 
   NS_LOG_FUNCTION_NOARGS ();
 
-  NodeContainer allNodes = NodeContainer::GetGlobal ();
-  Ptr<Node> destNode;
-
-  for (NodeContainer::Iterator i = allNodes.Begin (); i != allNodes.End (); ++i)
-    {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-      if (ipv4->GetInterfaceForAddress (dest) != -1)
-        {
-          destNode = node;
-          break;
-        }
-    }
+  Ptr<Node> destNode = Ipv4AddressNodeIndex::GetNode (dest);
 
   if (!destNode)
     {
@@ -488,22 +698,24 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
   Ptr<NixVector> nixVectorInCache;
   Ptr<NixVector> nixVectorForPacket;
 
-  NS_LOG_DEBUG ("Dest IP from header: " << header.GetDestination ());
-  // check if cache
-  nixVectorInCache = GetNixVectorInCache (header.GetDestination ());
+  CheckCacheGeneration ();
 
-  // not in cache
-  if (!nixVectorInCache)
+  NS_LOG_DEBUG ("Dest IP from header: " << header.GetDestination ());
+  // the hash picks the path among the equal-cost ones
+  uint32_t hash = 0;
+  if (m_ecmpMode == ECMP_PER_FLOW)
     {
-      NS_LOG_LOGIC ("Nix-vector not in cache, build: ");
-      // Build the nix-vector, given this node and the
-      // dest IP address
-      nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif);
-
-      // cache it
-      m_nixCache.insert (NixMap_t::value_type (header.GetDestination (), nixVectorInCache));
+      hash = Ipv4FlowHash::Hash (p, header, m_ecmpSeed);
+    }
+  else if (m_ecmpMode == ECMP_PER_PACKET)
+    {
+      hash = Ipv4FlowHash::Hash (p, header, m_ecmpSeed + m_ecmpPackets++);
     }
 
+  // Get the nix-vector, given this node and the
+  // dest IP address, from the cache or built
+  nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif, hash);
+
   // path exists
   if (nixVectorInCache)
     {
@@ -528,9 +740,9 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
       // Search here in a cache for this node index 
       // and look for a Ipv4Route
-      rtentry = GetIpv4RouteInCache (header.GetDestination ());
+      rtentry = GetIpv4RouteInCache (header.GetDestination (), nodeIndex);
 
-      if (!rtentry || !(rtentry->GetOutputDevice () == oif))
+      if (!rtentry || (oif && rtentry->GetOutputDevice () != oif))
         {
           // not in cache or a different specified output
           // device is to be used
@@ -539,7 +751,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
           // rtentry from the map
           if (rtentry)
             {
-              m_ipv4RouteCache.erase (header.GetDestination ());
+              RemoveIpv4RouteFromCache (header.GetDestination (), nodeIndex);
             }
 
           NS_LOG_LOGIC ("Ipv4Route not in cache, build: ");
@@ -579,7 +791,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
           sockerr = Socket::ERROR_NOTERROR;
 
           // add rtentry to cache
-          m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+          AddIpv4RouteToCache (header.GetDestination (), nodeIndex, rtentry);
         }
 
       NS_LOG_LOGIC ("Nix-vector contents: " << *nixVectorInCache << " : Remaining bits: " << nixVectorForPacket->GetRemainingBits ());
@@ -610,6 +822,8 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
   Ptr<Ipv4Route> rtentry;
 
+  CheckCacheGeneration ();
+
   // Get the nix-vector from the packet
   Ptr<NixVector> nixVector = p->GetNixVector ();
 
@@ -625,7 +839,7 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
   uint32_t numberOfBits = nixVector->BitCount (m_totalNeighbors);
   uint32_t nodeIndex = nixVector->ExtractNeighborIndex (numberOfBits);
 
-  rtentry = GetIpv4RouteInCache (header.GetDestination ());
+  rtentry = GetIpv4RouteInCache (header.GetDestination (), nodeIndex);
   // not in cache
   if (!rtentry)
     {
@@ -644,7 +858,7 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
       rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIndex));
 
       // add rtentry to cache
-      m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+      AddIpv4RouteToCache (header.GetDestination (), nodeIndex, rtentry);
     }
 
   NS_LOG_LOGIC ("At Node " << m_node->GetId () << ", Extracting " << numberOfBits <<
@@ -664,39 +878,46 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 {
 
   std::ostream* os = stream->GetStream ();
+  Ptr<Ipv4NixVectorCache> cache = Ipv4NixVectorCache::Get ();
+  const Ipv4NixVectorCache::NixVectorMap_t *nixVectors = cache->GetNixVectors (m_node->GetId ());
   *os << "NixCache:" << std::endl;
-  if (m_nixCache.size () > 0)
+  if (nixVectors && nixVectors->size () > 0)
     {
-      *os << "Destination     NixVector" << std::endl;
-      for (NixMap_t::const_iterator it = m_nixCache.begin (); it != m_nixCache.end (); it++)
+      *os << "DestNode        Path    NixVector" << std::endl;
+      for (Ipv4NixVectorCache::NixVectorMap_t::const_iterator it = nixVectors->begin (); it != nixVectors->end (); it++)
         {
-          std::ostringstream dest;
-          dest << it->first;
-          *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          *os << *(it->second) << std::endl;
+          *os << std::setiosflags (std::ios::left) << std::setw (16) << it->first.first;
+          *os << std::setiosflags (std::ios::left) << std::setw (8) << it->first.second;
+          if (it->second)
+            {
+              *os << *(it->second);
+            }
+          *os << std::endl;
         }
     }
+  // the route cache is stale if the shared cache
+  // has been flushed since it was filled
   *os << "Ipv4RouteCache:" << std::endl;
-  if (m_ipv4RouteCache.size () > 0)
+  if (m_cacheGeneration == cache->GetGeneration () && m_ipv4RouteCache.size () > 0)
     {
       *os << "Destination     Gateway         Source            OutputDevice" << std::endl;
-      for (Ipv4RouteMap_t::const_iterator it = m_ipv4RouteCache.begin (); it != m_ipv4RouteCache.end (); it++)
+      for (Ipv4RouteCache_t::const_iterator it = m_ipv4RouteCache.begin (); it != m_ipv4RouteCache.end (); it++)
         {
           std::ostringstream dest, gw, src;
-          dest << it->second->GetDestination ();
+          dest << it->second.route->GetDestination ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          gw << it->second->GetGateway ();
+          gw << it->second.route->GetGateway ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << gw.str ();
-          src << it->second->GetSource ();
+          src << it->second.route->GetSource ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << src.str ();
           *os << "  ";
-          if (Names::FindName (it->second->GetOutputDevice ()) != "")
+          if (Names::FindName (it->second.route->GetOutputDevice ()) != "")
             {
-              *os << Names::FindName (it->second->GetOutputDevice ());
+              *os << Names::FindName (it->second.route->GetOutputDevice ());
             }
           else
             {
-              *os << it->second->GetOutputDevice ()->GetIfIndex ();
+              *os << it->second.route->GetOutputDevice ()->GetIfIndex ();
             }
           *os << std::endl;
         }
@@ -725,35 +946,88 @@ Ipv4NixVectorRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddr
   FlushGlobalNixRoutingCache ();
 }
 
+namespace {
+
+/* state of a BFS recording every shortest path */
+struct ShortestPathSearch
+{
+  static const uint32_t UNREACHED = 0xffffffff;
+
+  ShortestPathSearch (uint32_t numberOfNodes)
+    : distance (numberOfNodes, UNREACHED),
+      lastParent (numberOfNodes, UNREACHED),
+      nPaths (numberOfNodes, 0)
+  {
+  }
+
+  /* remoteNode is adjacent to the node being explored */
+  void Visit (Ptr<Node> remoteNode, uint32_t currId, std::queue< Ptr<Node> > & greyNodeList)
+  {
+    uint32_t remoteId = remoteNode->GetId ();
+
+    // check to see if this node has been pushed before
+    // by checking its distance; if it hasn't, set its
+    // distance and push to the queue
+    if (distance.at (remoteId) == UNREACHED)
+      {
+        distance[remoteId] = distance[currId] + 1;
+        greyNodeList.push (remoteNode);
+      }
+
+    // every node one hop closer to the source is a parent,
+    // but parallel links must not count twice
+    if (distance[remoteId] == distance[currId] + 1 && lastParent[remoteId] != currId)
+      {
+        lastParent[remoteId] = currId;
+        edges.push_back (std::make_pair (remoteId, currId));
+        nPaths[remoteId] = std::min<uint64_t> (0xffffffff, uint64_t (nPaths[remoteId]) + nPaths[currId]);
+      }
+  }
+
+  std::vector<uint32_t> distance;
+  std::vector<uint32_t> lastParent;
+  std::vector<uint32_t> nPaths;
+  /* (child, parent) in discovery order */
+  std::vector< std::pair<uint32_t, uint32_t> > edges;
+};
+
+} // anonymous namespace
+
 bool
 Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source, 
-                           Ptr<Node> dest, std::vector< Ptr<Node> > & parentVector,
+                           Ptr<Node> dest, Ipv4NixVectorCache::ParentGraph & graph,
                            Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << dest->GetId ());
+  if (dest)
+    {
+      NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << dest->GetId ());
+    }
   std::queue< Ptr<Node> > greyNodeList;  // discovered nodes with unexplored children
+  ShortestPathSearch search (numberOfNodes);
+  bool found = false;
 
-  // reset the parent vector
-  parentVector.clear ();
-  parentVector.reserve (sizeof (Ptr<Node>)*numberOfNodes);
-  parentVector.insert (parentVector.begin (), sizeof (Ptr<Node>)*numberOfNodes, 0); // initialize to 0
-
-  // Add the source node to the queue, set its parent to itself 
+  // Add the source node to the queue, it is the
+  // only path to itself
   greyNodeList.push (source);
-  parentVector.at (source->GetId ()) = source;
+  search.distance.at (source->GetId ()) = 0;
+  search.nPaths[source->GetId ()] = 1;
 
   // BFS loop
   while (greyNodeList.size () != 0)
     {
       Ptr<Node> currNode = greyNodeList.front ();
+      uint32_t currId = currNode->GetId ();
       Ptr<Ipv4> ipv4 = currNode->GetObject<Ipv4> ();
  
+      // the parents of dest are all known by now, they
+      // were explored before it
       if (currNode == dest) 
         {
-          NS_LOG_LOGIC ("Made it to Node " << currNode->GetId ());
-          return true;
+          NS_LOG_LOGIC ("Made it to Node " << currId);
+          found = true;
+          break;
         }
 
       // if this is the first iteration of the loop and a 
@@ -768,18 +1042,18 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
               if (!(ipv4->IsUp (interfaceIndex)))
                 {
                   NS_LOG_LOGIC ("Ipv4Interface is down");
-                  return false;
+                  break;
                 }
             }
           if (!(oif->IsLinkUp ()))
             {
               NS_LOG_LOGIC ("Link is down.");
-              return false;
+              break;
             }
           Ptr<Channel> channel = oif->GetChannel ();
           if (channel == 0)
             { 
-              return false;
+              break;
             }
 
           // this function takes in the local net dev, and channnel, and
@@ -788,22 +1062,10 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
           GetAdjacentNetDevices (oif, channel, netDeviceContainer);
 
           // Finally we can get the adjacent nodes
-          // and scan through them.  We push them
-          // to the greyNode queue, if they aren't 
-          // already there.
+          // and scan through them.
           for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
             {
-              Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-              // check to see if this node has been pushed before
-              // by checking to see if it has a parent
-              // if it doesn't (null or 0), then set its parent and 
-              // push to the queue
-              if (parentVector.at (remoteNode->GetId ()) == 0)
-                {
-                  parentVector.at (remoteNode->GetId ()) = currNode;
-                  greyNodeList.push (remoteNode);
-                }
+              search.Visit ((*iter)->GetNode (), currId, greyNodeList);
             }
         }
       else
@@ -844,22 +1106,10 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
               GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
 
               // Finally we can get the adjacent nodes
-              // and scan through them.  We push them
-              // to the greyNode queue, if they aren't 
-              // already there.
+              // and scan through them.
               for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
                 {
-                  Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-                  // check to see if this node has been pushed before
-                  // by checking to see if it has a parent
-                  // if it doesn't (null or 0), then set its parent and 
-                  // push to the queue
-                  if (parentVector.at (remoteNode->GetId ()) == 0)
-                    {
-                      parentVector.at (remoteNode->GetId ()) = currNode;
-                      greyNodeList.push (remoteNode);
-                    }
+                  search.Visit ((*iter)->GetNode (), currId, greyNodeList);
                 }
             }
         }
@@ -869,8 +1119,25 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
       greyNodeList.pop ();
     }
 
-  // Didn't find the dest...
-  return false;
+  // sort the parents by child, keeping the discovery order
+  graph.first.assign (numberOfNodes + 1, 0);
+  for (uint32_t i = 0; i < search.edges.size (); i++)
+    {
+      graph.first[search.edges[i].first + 1]++;
+    }
+  for (uint32_t i = 0; i < numberOfNodes; i++)
+    {
+      graph.first[i + 1] += graph.first[i];
+    }
+  graph.parents.resize (search.edges.size ());
+  std::vector<uint32_t> next (graph.first.begin (), graph.first.end () - 1);
+  for (uint32_t i = 0; i < search.edges.size (); i++)
+    {
+      graph.parents[next[search.edges[i].first]++] = search.edges[i].second;
+    }
+  graph.nPaths.swap (search.nPaths);
+
+  return found;
 }
 
 } // namespace ns3
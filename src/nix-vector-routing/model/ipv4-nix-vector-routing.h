@@ -22,6 +22,7 @@
 #define IPV4_NIX_VECTOR_ROUTING_H
 
 #include <map>
+#include <list>
 
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
@@ -31,6 +32,8 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/nix-vector.h"
 #include "ns3/bridge-net-device.h"
+#include "ns3/ipv4-nix-path-oracle.h"
+#include "ns3/ipv4-nix-vector-cache.h"
 
 namespace ns3 {
 
@@ -45,10 +48,27 @@ typedef std::map<Ipv4Address, Ptr<Ipv4Route> > Ipv4RouteMap_t;
 
 /**
  * Nix-vector routing protocol
+ *
+ * By default, every packet follows the first shortest path found by the
+ * BFS.  The EcmpMode attribute spreads the traffic over all the
+ * equal-cost shortest paths instead: the source picks one per flow, by
+ * a hash of the 5-tuple, or per packet, and encodes it into the
+ * nix-vector, so that intermediate nodes forward the packet without
+ * any state or choice of their own.
  */
 class Ipv4NixVectorRouting : public Ipv4RoutingProtocol
 {
 public:
+  /**
+   * How the source picks among equal-cost paths
+   */
+  enum EcmpMode
+  {
+    ECMP_NONE,       /**< the first path found by the BFS */
+    ECMP_PER_FLOW,   /**< one path per 5-tuple hash */
+    ECMP_PER_PACKET  /**< a new path for every packet */
+  };
+
   Ipv4NixVectorRouting ();
   ~Ipv4NixVectorRouting ();
   /**
@@ -67,15 +87,22 @@ public:
 
   /**
    * @brief Called when run-time link topology change occurs
-   * which iterates through the node list and flushes any
-   * nix vector caches
+   * which flushes the shared Ipv4NixVectorCache; the caches of
+   * each node are then flushed on their next use
    *
    */
   void FlushGlobalNixRoutingCache (void);
 
+  /**
+   * @brief Let a path oracle provide the paths from this node, instead
+   * of computing them with a BFS
+   *
+   * @param oracle the path oracle, or 0 to always use the BFS
+   */
+  void SetPathOracle (Ptr<Ipv4NixPathOracle> oracle);
+
 private:
-  /* flushes the cache which stores nix-vector based on
-   * destination IP */
+  /* flushes the neighbor table of this node */
   void FlushNixCache (void);
 
   /* flushes the cache which stores the Ipv4 route
@@ -87,27 +114,52 @@ private:
    * reset to zero */
   void ResetTotalNeighbors (void);
 
+  /* flushes the caches of this node if the shared cache
+   * has been flushed since they were filled */
+  void CheckCacheGeneration (void);
+
   /*  takes in the source node and dest IP and calls GetNodeByIp,
-   *  BFS, accounting for any output interface specified, and finally
-   *  BuildNixVector to return the built nix-vector */
-  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>);
+   *  picks one of the equal-cost paths with the hash if multipath is
+   *  enabled, looks up the shared cache, and on a miss calls the BFS,
+   *  accounting for any output interface specified, and finally
+   *  BuildNixVectorFromTree to return the built nix-vector */
+  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>, uint32_t hash);
 
-  /* checks the cache based on dest IP for the nix-vector */
-  Ptr<NixVector> GetNixVectorInCache (Ipv4Address);
+  /* the shortest paths from source, from the shared cache or
+   * computed by a BFS and added to it */
+  const Ipv4NixVectorCache::ParentGraph & GetShortestPaths (Ptr<Node> source);
 
-  /* checks the cache based on dest IP for the Ipv4Route */
-  Ptr<Ipv4Route> GetIpv4RouteInCache (Ipv4Address);
+  /* checks the cache based on dest IP and neighbor index for the Ipv4Route */
+  Ptr<Ipv4Route> GetIpv4RouteInCache (Ipv4Address, uint32_t nodeIndex);
+
+  /* adds the Ipv4Route for dest IP and neighbor index to the cache,
+   * evicting the least recently used routes beyond
+   * MaxRouteCacheEntries */
+  void AddIpv4RouteToCache (Ipv4Address, uint32_t nodeIndex, Ptr<Ipv4Route> rtentry);
+
+  /* removes the Ipv4Route for dest IP and neighbor index, if cached */
+  void RemoveIpv4RouteFromCache (Ipv4Address, uint32_t nodeIndex);
 
   /* given a net-device returns all the adjacent net-devices,
    * essentially getting the neighbors on that channel */
   void GetAdjacentNetDevices (Ptr<NetDevice>, Ptr<Channel>, NetDeviceContainer &);
 
-  /* iterates through the node list and finds the one
-   * corresponding to the given Ipv4Address */
+  /* finds the node corresponding to the given Ipv4Address,
+   * through the Ipv4AddressNodeIndex */
   Ptr<Node> GetNodeByIp (Ipv4Address);
 
-  /* Recurses the parent vector, created by BFS and actually builds the nixvector */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+  /* runs the BFS from source, up to dest if not null, and returns the
+   * shortest paths and the time it took, in microseconds */
+  uint64_t BuildParentTree (Ptr<Node> source, Ptr<Node> dest, Ptr<NetDevice> oif, Ipv4NixVectorCache::ParentGraph & graph);
+
+  /* walks the parents back from dest along the given path index and
+   * actually builds the nixvector; path 0 is the plain BFS tree path */
+  bool BuildNixVectorFromTree (const Ipv4NixVectorCache::ParentGraph & graph, uint32_t source, uint32_t dest,
+                               uint32_t path, Ptr<NixVector> nixVector);
+
+  /* builds the nixvector of a path given node by node, as returned by
+   * a path oracle */
+  bool BuildNixVectorFromPath (const std::vector< Ptr<Node> > & path, Ptr<NixVector> nixVector);
 
   /* special variation of BuildNixVector for when a node is sending to itself */
   bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
@@ -116,6 +168,10 @@ private:
    * how many neighbors it has */
   uint32_t FindTotalNeighbors (void);
 
+  /* ids of the neighbor nodes, in neighbor index order; computed
+   * once and kept until the next topology change */
+  const std::vector<uint32_t> & GetNeighborIds (void);
+
   /* determine if the netdevice is bridged */
   Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd) const;
 
@@ -128,14 +184,14 @@ private:
    * Param1: total number of nodes
    * Param2: Source Node
    * Param3: Dest Node
-   * Param4: (returned) Parent vector for retracing routes
+   * Param4: (returned) every parent of every node for retracing routes
    * Param5: specific output interface to use from source node, if not null
    * Returns: false if dest not found, true o.w.
    */
   bool BFS (uint32_t numberOfNodes,
             Ptr<Node> source,
             Ptr<Node> dest,
-            std::vector< Ptr<Node> > & parentVector,
+            Ipv4NixVectorCache::ParentGraph & graph,
             Ptr<NetDevice> oif);
 
   void DoDispose (void);
@@ -153,11 +209,27 @@ private:
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
 
 
-  /* cache stores nix-vectors based on destination ip */
-  NixMap_t m_nixCache;
-
-  /* cache stores Ipv4Routes based on destination ip */
-  Ipv4RouteMap_t m_ipv4RouteCache;
+  /* cache stores Ipv4Routes based on destination ip and neighbor
+   * index, since multipath sends packets to the same destination
+   * through different neighbors; the nix-vectors are in the shared
+   * Ipv4NixVectorCache */
+  typedef std::pair<Ipv4Address, uint32_t> Ipv4RouteKey_t;
+  struct Ipv4RouteCacheEntry
+  {
+    Ptr<Ipv4Route> route;
+    std::list<Ipv4RouteKey_t>::iterator lru;
+  };
+  typedef std::map<Ipv4RouteKey_t, Ipv4RouteCacheEntry> Ipv4RouteCache_t;
+  Ipv4RouteCache_t m_ipv4RouteCache;
+  /* keys of m_ipv4RouteCache, most recently used first */
+  std::list<Ipv4RouteKey_t> m_ipv4RouteLru;
+  /* least recently used routes are evicted beyond this
+   * number of entries, 0 for no limit */
+  uint32_t m_maxIpv4RouteCacheEntries;
+
+  /* generation of the shared cache the caches of this
+   * node were filled at */
+  uint32_t m_cacheGeneration;
 
   Ptr<Ipv4> m_ipv4;
   Ptr<Node> m_node;
@@ -165,6 +237,17 @@ private:
   /* total neighbors used for nix-vector to determine
    * number of bits */
   uint32_t m_totalNeighbors;
+
+  /* neighbor node ids, in neighbor index order */
+  std::vector<uint32_t> m_neighborIds;
+  bool m_neighborIdsValid;
+
+  Ptr<Ipv4NixPathOracle> m_oracle;
+
+  enum EcmpMode m_ecmpMode;
+  uint32_t m_ecmpSeed;
+  /* packets sent in ECMP_PER_PACKET mode, mixed into the hash */
+  uint32_t m_ecmpPackets;
 };
 } // namespace ns3
 
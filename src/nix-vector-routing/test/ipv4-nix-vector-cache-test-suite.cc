@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/ipv4-nix-vector-cache.h"
+
+namespace ns3 {
+
+class Ipv4NixVectorCacheTestCase : public TestCase
+{
+public:
+  Ipv4NixVectorCacheTestCase ();
+  virtual void DoRun (void);
+private:
+  void AddTree (Ptr<Ipv4NixVectorCache> cache, uint32_t source);
+};
+
+Ipv4NixVectorCacheTestCase::Ipv4NixVectorCacheTestCase ()
+  : TestCase ("Shared nix-vector cache lookups, LRU eviction and flush")
+{
+}
+
+void
+Ipv4NixVectorCacheTestCase::AddTree (Ptr<Ipv4NixVectorCache> cache, uint32_t source)
+{
+  // 1000 nodes, every node a child of the source
+  Ipv4NixVectorCache::ParentGraph graph;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      graph.first.push_back (graph.parents.size ());
+      if (i != source)
+        {
+          graph.parents.push_back (source);
+        }
+      graph.nPaths.push_back (1);
+    }
+  graph.first.push_back (graph.parents.size ());
+  cache->AddTree (source, graph, 10);
+  NS_TEST_EXPECT_MSG_EQ (graph.parents.size (), 0, "The cache must take the tree");
+}
+
+void
+Ipv4NixVectorCacheTestCase::DoRun (void)
+{
+  Ptr<Ipv4NixVectorCache> cache = Ipv4NixVectorCache::Get ();
+  NS_TEST_ASSERT_MSG_EQ (cache, Ipv4NixVectorCache::Get (), "The cache must be shared");
+  // room for two trees of about 12000 bytes, not three
+  cache->SetAttribute ("MaxBytes", UintegerValue (30000));
+
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupTree (1), 0, "Empty cache");
+  AddTree (cache, 1);
+  const Ipv4NixVectorCache::ParentGraph *tree = cache->LookupTree (1);
+  NS_TEST_ASSERT_MSG_NE (tree, 0, "Tree expected");
+  NS_TEST_EXPECT_MSG_EQ (tree->parents.at (tree->first.at (7)), 1, "Wrong tree");
+
+  Ptr<NixVector> nixVector = Create<NixVector> ();
+  nixVector->AddNeighborIndex (3, 2);
+  cache->AddNixVector (1, 7, 0, nixVector);
+  cache->AddNixVector (1, 8, 0, 0);
+  Ptr<NixVector> found;
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupNixVector (1, 7, 0, found), true, "Nix-vector expected");
+  NS_TEST_EXPECT_MSG_EQ (found, nixVector, "Wrong nix-vector");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupNixVector (1, 8, 0, found), true, "Unreachable destination is cached too");
+  NS_TEST_EXPECT_MSG_EQ (found, 0, "Unreachable destination has no nix-vector");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupNixVector (1, 9, 0, found), false, "Unknown destination");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupNixVector (1, 7, 1, found), false, "Unknown path");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupNixVector (2, 7, 0, found), false, "Unknown source");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetHits (), 2, "Wrong number of hits");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetMisses (), 3, "Wrong number of misses");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetTreeHits (), 1, "Wrong number of tree hits");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetTreeMisses (), 1, "Wrong number of tree misses");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetBfsMicroSeconds (), 10, "Wrong BFS time");
+
+  // source 2 is the least recently used when source 3 comes in
+  AddTree (cache, 2);
+  cache->LookupTree (1);
+  AddTree (cache, 3);
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNSources (), 2, "One source must have been evicted");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetEvictions (), 1, "Wrong number of evictions");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupTree (2), 0, "Least recently used source must be evicted");
+  NS_TEST_EXPECT_MSG_NE (cache->LookupTree (1), 0, "Recently used source must stay");
+  NS_TEST_EXPECT_MSG_EQ ((cache->GetBytes () <= 30000), true, "Memory cap exceeded");
+
+  uint32_t generation = cache->GetGeneration ();
+  cache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (cache->GetGeneration (), generation + 1, "Flush must change the generation");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNSources (), 0, "Flush must empty the cache");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetBytes (), 0, "Flush must release the memory");
+
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (Ipv4NixVectorCache::Get ()->GetHits (), 0, "Simulator::Destroy must reset the cache");
+  Simulator::Destroy ();
+}
+
+static class Ipv4NixVectorCacheTestSuite : public TestSuite
+{
+public:
+  Ipv4NixVectorCacheTestSuite ()
+    : TestSuite ("ipv4-nix-vector-cache", UNIT)
+  {
+    AddTestCase (new Ipv4NixVectorCacheTestCase);
+  }
+} g_ipv4NixVectorCacheTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,572 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <deque>
+#include <set>
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-remote-channel.h"
+#include "topology-partition-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("TopologyPartitionHelper");
+
+namespace ns3 {
+
+namespace {
+
+const uint32_t NONE = ~uint32_t (0);
+// the boundary nodes are moved until a pass moves none, or at most
+const uint32_t MAX_PASSES = 8;
+
+} // anonymous namespace
+
+TopologyPartitionHelper::TopologyPartitionHelper ()
+  : m_imbalance (0.05),
+    m_nCutLinks (0),
+    m_cutWeight (0)
+{
+}
+
+void
+TopologyPartitionHelper::SetNodeWeight (Ptr<Node> node, double weight)
+{
+  m_nodeWeights[node->GetId ()] = weight;
+}
+
+void
+TopologyPartitionHelper::SetChannelWeight (Ptr<Channel> channel, double weight)
+{
+  m_channelWeights[channel->GetId ()] = weight;
+}
+
+void
+TopologyPartitionHelper::SetImbalance (double imbalance)
+{
+  m_imbalance = imbalance;
+}
+
+double
+TopologyPartitionHelper::GetNodeWeight (Ptr<Node> node) const
+{
+  std::map<uint32_t, double>::const_iterator i = m_nodeWeights.find (node->GetId ());
+  if (i != m_nodeWeights.end ())
+    {
+      return i->second;
+    }
+  return std::max (node->GetNDevices (), 1U);
+}
+
+double
+TopologyPartitionHelper::GetChannelWeight (Ptr<Channel> channel) const
+{
+  std::map<uint32_t, double>::const_iterator i = m_channelWeights.find (channel->GetId ());
+  if (i != m_channelWeights.end ())
+    {
+      return i->second;
+    }
+  return 1;
+}
+
+bool
+TopologyPartitionHelper::IsCuttable (Ptr<Channel> channel) const
+{
+  // the lookahead between two systems is the delay of the links between
+  // them
+  Ptr<PointToPointChannel> p2p = DynamicCast<PointToPointChannel> (channel);
+  if (p2p == 0 || p2p->GetNDevices () != 2)
+    {
+      return false;
+    }
+  TimeValue delay;
+  p2p->GetAttribute ("Delay", delay);
+  return delay.Get ().IsStrictlyPositive ();
+}
+
+uint32_t
+TopologyPartitionHelper::FindGroup (std::vector<uint32_t> &parent, uint32_t i) const
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+void
+TopologyPartitionHelper::BuildGroups (NodeContainer nodes, std::vector<uint32_t> &groupOf)
+{
+  NS_LOG_FUNCTION (this);
+  std::map<uint32_t, uint32_t> index;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      index[nodes.Get (i)->GetId ()] = i;
+    }
+
+  // join the nodes linked by a channel which cannot be cut
+  std::vector<uint32_t> parent (nodes.GetN ());
+  for (uint32_t i = 0; i < parent.size (); i++)
+    {
+      parent[i] = i;
+    }
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0 || IsCuttable (channel))
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); k++)
+            {
+              std::map<uint32_t, uint32_t>::const_iterator peer =
+                index.find (channel->GetDevice (k)->GetNode ()->GetId ());
+              if (peer != index.end ())
+                {
+                  parent[FindGroup (parent, peer->second)] = FindGroup (parent, i);
+                }
+            }
+        }
+    }
+
+  // number the groups in the order of their first node, so that the
+  // partition only depends on the topology
+  m_groups.clear ();
+  groupOf.assign (nodes.GetN (), NONE);
+  std::vector<uint32_t> groupOfRoot (nodes.GetN (), NONE);
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      uint32_t root = FindGroup (parent, i);
+      if (groupOfRoot[root] == NONE)
+        {
+          groupOfRoot[root] = m_groups.size ();
+          Group group;
+          group.weight = 0;
+          m_groups.push_back (group);
+        }
+      groupOf[i] = groupOfRoot[root];
+      m_groups[groupOf[i]].weight += GetNodeWeight (nodes.Get (i));
+    }
+
+  std::set<uint32_t> seen;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0 || !IsCuttable (channel) || !seen.insert (channel->GetId ()).second)
+            {
+              continue;
+            }
+          std::map<uint32_t, uint32_t>::const_iterator a =
+            index.find (channel->GetDevice (0)->GetNode ()->GetId ());
+          std::map<uint32_t, uint32_t>::const_iterator b =
+            index.find (channel->GetDevice (1)->GetNode ()->GetId ());
+          if (a == index.end () || b == index.end () || groupOf[a->second] == groupOf[b->second])
+            {
+              continue;
+            }
+          double weight = GetChannelWeight (channel);
+          m_groups[groupOf[a->second]].links[groupOf[b->second]] += weight;
+          m_groups[groupOf[b->second]].links[groupOf[a->second]] += weight;
+        }
+    }
+  NS_LOG_LOGIC (nodes.GetN () << " nodes in " << m_groups.size () << " groups");
+}
+
+uint32_t
+TopologyPartitionHelper::FindPeripheral (uint32_t start, const std::vector<uint32_t> &part) const
+{
+  // the last group reached by a breadth-first search among the groups
+  // which are not assigned yet
+  std::vector<bool> visited (m_groups.size (), false);
+  std::deque<uint32_t> queue;
+  queue.push_back (start);
+  visited[start] = true;
+  uint32_t last = start;
+  while (!queue.empty ())
+    {
+      last = queue.front ();
+      queue.pop_front ();
+      for (std::map<uint32_t, double>::const_iterator i = m_groups[last].links.begin ();
+           i != m_groups[last].links.end (); i++)
+        {
+          if (!visited[i->first] && part[i->first] == NONE)
+            {
+              visited[i->first] = true;
+              queue.push_back (i->first);
+            }
+        }
+    }
+  return last;
+}
+
+void
+TopologyPartitionHelper::Grow (uint32_t n, std::vector<uint32_t> &part) const
+{
+  NS_LOG_FUNCTION (this << n);
+  double remaining = 0;
+  std::vector<double> linkWeight (m_groups.size (), 0);
+  for (uint32_t i = 0; i < m_groups.size (); i++)
+    {
+      remaining += m_groups[i].weight;
+      for (std::map<uint32_t, double>::const_iterator j = m_groups[i].links.begin ();
+           j != m_groups[i].links.end (); j++)
+        {
+          linkWeight[i] += j->second;
+        }
+    }
+  part.assign (m_groups.size (), NONE);
+  uint32_t firstFree = 0;
+  for (uint32_t p = 0; p < n; p++)
+    {
+      while (firstFree < part.size () && part[firstFree] != NONE)
+        {
+          firstFree++;
+        }
+      if (firstFree == part.size ())
+        {
+          return;
+        }
+      if (p == n - 1)
+        {
+          for (uint32_t i = firstFree; i < part.size (); i++)
+            {
+              if (part[i] == NONE)
+                {
+                  part[i] = p;
+                }
+            }
+          return;
+        }
+      double target = remaining / (n - p);
+      double weight = 0;
+      // the weight of the links from each group of the frontier to the
+      // system
+      std::map<uint32_t, double> frontier;
+      while (true)
+        {
+          uint32_t next = NONE;
+          if (frontier.empty ())
+            {
+              while (firstFree < part.size () && part[firstFree] != NONE)
+                {
+                  firstFree++;
+                }
+              if (firstFree == part.size ())
+                {
+                  break;
+                }
+              next = FindPeripheral (firstFree, part);
+            }
+          else
+            {
+              // the group whose links mostly go to the system
+              double best = 0;
+              for (std::map<uint32_t, double>::const_iterator i = frontier.begin (); i != frontier.end (); i++)
+                {
+                  double gain = 2 * i->second - linkWeight[i->first];
+                  if (next == NONE || gain > best)
+                    {
+                      next = i->first;
+                      best = gain;
+                    }
+                }
+            }
+          double w = m_groups[next].weight;
+          // stop at the weight closest to the target
+          if (weight > 0 && weight + w - target > target - weight)
+            {
+              break;
+            }
+          part[next] = p;
+          weight += w;
+          frontier.erase (next);
+          for (std::map<uint32_t, double>::const_iterator i = m_groups[next].links.begin ();
+               i != m_groups[next].links.end (); i++)
+            {
+              if (part[i->first] == NONE)
+                {
+                  frontier[i->first] += i->second;
+                }
+            }
+          if (weight >= target)
+            {
+              break;
+            }
+        }
+      remaining -= weight;
+    }
+}
+
+void
+TopologyPartitionHelper::Refine (uint32_t n, std::vector<uint32_t> &part) const
+{
+  NS_LOG_FUNCTION (this << n);
+  std::vector<double> weights (n, 0);
+  std::vector<uint32_t> sizes (n, 0);
+  double total = 0;
+  for (uint32_t i = 0; i < m_groups.size (); i++)
+    {
+      weights[part[i]] += m_groups[i].weight;
+      sizes[part[i]]++;
+      total += m_groups[i].weight;
+    }
+  double maxWeight = total / n * (1 + m_imbalance);
+  for (uint32_t pass = 0; pass < MAX_PASSES; pass++)
+    {
+      bool moved = false;
+      for (uint32_t i = 0; i < m_groups.size (); i++)
+        {
+          uint32_t a = part[i];
+          double w = m_groups[i].weight;
+          if (sizes[a] == 1)
+            {
+              continue;
+            }
+          std::map<uint32_t, double> links;
+          for (std::map<uint32_t, double>::const_iterator j = m_groups[i].links.begin ();
+               j != m_groups[i].links.end (); j++)
+            {
+              links[part[j->first]] += j->second;
+            }
+          double internal = links[a];
+          uint32_t best = a;
+          double bestGain = 0;
+          for (std::map<uint32_t, double>::const_iterator j = links.begin (); j != links.end (); j++)
+            {
+              uint32_t b = j->first;
+              double gain = j->second - internal;
+              if (b == a || weights[b] + w > maxWeight)
+                {
+                  continue;
+                }
+              // a move which does not change the cut must improve the
+              // balance
+              if (gain > bestGain
+                  || (gain == bestGain && best == a && gain == 0 && weights[a] - w > weights[b] + w))
+                {
+                  best = b;
+                  bestGain = gain;
+                }
+            }
+          if (best != a)
+            {
+              part[i] = best;
+              weights[a] -= w;
+              weights[best] += w;
+              sizes[a]--;
+              sizes[best]++;
+              moved = true;
+            }
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+}
+
+std::vector<uint32_t>
+TopologyPartitionHelper::Partition (NodeContainer nodes, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN () << n);
+  NS_ASSERT (n > 0);
+  std::vector<uint32_t> groupOf;
+  BuildGroups (nodes, groupOf);
+  std::vector<uint32_t> part;
+  if (n == 1)
+    {
+      part.assign (m_groups.size (), 0);
+    }
+  else
+    {
+      Grow (n, part);
+      Refine (n, part);
+    }
+
+  m_systemWeights.assign (n, 0);
+  m_nCutLinks = 0;
+  m_cutWeight = 0;
+  for (uint32_t i = 0; i < m_groups.size (); i++)
+    {
+      m_systemWeights[part[i]] += m_groups[i].weight;
+      for (std::map<uint32_t, double>::const_iterator j = m_groups[i].links.begin ();
+           j != m_groups[i].links.end (); j++)
+        {
+          if (part[j->first] != part[i] && i < j->first)
+            {
+              m_cutWeight += j->second;
+            }
+        }
+    }
+  std::vector<uint32_t> systems (nodes.GetN ());
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      systems[i] = part[groupOf[i]];
+    }
+  // the links between the same groups are merged above, count them one
+  // by one
+  std::set<uint32_t> seen;
+  std::map<uint32_t, uint32_t> systemOf;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      systemOf[nodes.Get (i)->GetId ()] = systems[i];
+    }
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0 || !IsCuttable (channel) || !seen.insert (channel->GetId ()).second)
+            {
+              continue;
+            }
+          std::map<uint32_t, uint32_t>::const_iterator a = systemOf.find (channel->GetDevice (0)->GetNode ()->GetId ());
+          std::map<uint32_t, uint32_t>::const_iterator b = systemOf.find (channel->GetDevice (1)->GetNode ()->GetId ());
+          if (a != systemOf.end () && b != systemOf.end () && a->second != b->second)
+            {
+              m_nCutLinks++;
+            }
+        }
+    }
+  return systems;
+}
+
+void
+TopologyPartitionHelper::ReplaceChannel (Ptr<Channel> channel)
+{
+  Ptr<PointToPointChannel> old = DynamicCast<PointToPointChannel> (channel);
+  Ptr<PointToPointNetDevice> devices[2] = { old->GetPointToPointDevice (0), old->GetPointToPointDevice (1) };
+  // as in PointToPointHelper::Install
+  bool remote = false;
+  if (MpiInterface::IsEnabled ())
+    {
+      uint32_t systemId = MpiInterface::GetSystemId ();
+      remote = devices[0]->GetNode ()->GetSystemId () != systemId
+        || devices[1]->GetNode ()->GetSystemId () != systemId;
+    }
+  NS_LOG_FUNCTION (this << channel << remote);
+  TimeValue delay;
+  old->GetAttribute ("Delay", delay);
+  ObjectFactory factory;
+  factory.SetTypeId (remote ? "ns3::PointToPointRemoteChannel" : "ns3::PointToPointChannel");
+  factory.Set ("Delay", delay);
+  Ptr<PointToPointChannel> replacement = factory.Create<PointToPointChannel> ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      devices[i]->Attach (replacement);
+      if (remote && devices[i]->GetObject<MpiReceiver> () == 0)
+        {
+          Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver> ();
+          receiver->SetReceiveCallback (MakeCallback (&PointToPointNetDevice::Receive, devices[i]));
+          devices[i]->AggregateObject (receiver);
+        }
+    }
+}
+
+void
+TopologyPartitionHelper::Install (NodeContainer nodes, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN () << n);
+  std::vector<uint32_t> systems = Partition (nodes, n);
+  std::map<uint32_t, uint32_t> previous;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      previous[nodes.Get (i)->GetId ()] = nodes.Get (i)->GetSystemId ();
+      nodes.Get (i)->SetSystemId (systems[i]);
+    }
+
+  // with MPI, the links whose ends moved are created again with the
+  // channel type of their systems
+  if (!MpiInterface::IsEnabled ())
+    {
+      return;
+    }
+  std::set<uint32_t> seen;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0 || !IsCuttable (channel) || !seen.insert (channel->GetId ()).second)
+            {
+              continue;
+            }
+          bool replace = false;
+          for (uint32_t k = 0; k < 2; k++)
+            {
+              Ptr<Node> end = channel->GetDevice (k)->GetNode ();
+              std::map<uint32_t, uint32_t>::const_iterator before = previous.find (end->GetId ());
+              if (before != previous.end () && before->second != end->GetSystemId ())
+                {
+                  replace = true;
+                }
+            }
+          if (replace)
+            {
+              ReplaceChannel (channel);
+            }
+        }
+    }
+}
+
+void
+TopologyPartitionHelper::InstallAll (uint32_t n)
+{
+  Install (NodeContainer::GetGlobal (), n);
+}
+
+uint32_t
+TopologyPartitionHelper::GetNCutLinks (void) const
+{
+  return m_nCutLinks;
+}
+
+std::vector<double>
+TopologyPartitionHelper::GetSystemWeights (void) const
+{
+  return m_systemWeights;
+}
+
+void
+TopologyPartitionHelper::PrintStatistics (std::ostream &os) const
+{
+  os << "Topology partition: " << m_systemWeights.size () << " systems, weights";
+  for (uint32_t i = 0; i < m_systemWeights.size (); i++)
+    {
+      os << " " << m_systemWeights[i];
+    }
+  os << ", " << m_nCutLinks << " links between systems, with a weight of " << m_cutWeight << std::endl;
+}
+
+} // namespace ns3
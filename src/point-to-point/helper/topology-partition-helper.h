@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TOPOLOGY_PARTITION_HELPER_H
+#define TOPOLOGY_PARTITION_HELPER_H
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "ns3/node-container.h"
+#include "ns3/channel.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+/**
+ * \brief Split a topology which is already built among the systems of a
+ * parallel simulation
+ *
+ * The nodes are assigned to the systems so that the systems carry about
+ * the same weight of nodes while the links between systems carry as
+ * little traffic as possible.  Only the point-to-point links with a
+ * positive delay may be cut: the nodes joined by any other channel, such
+ * as a Csma LAN with its bridge, or by a point-to-point link without
+ * delay, always stay on the same system.  In a fat-tree with Csma edge
+ * links, an edge switch, its bridge and its hosts thus move together,
+ * and the pods are the natural result.
+ *
+ * The partition grows each system from a peripheral node, adding the
+ * nodes most strongly linked to it until it reaches its share of the
+ * weight, then moves the nodes at the boundaries between systems as long
+ * as this reduces the traffic of the cut links without unbalancing the
+ * systems.  It only depends on the topology and the weights, so that
+ * every process of a distributed simulation computes the same one.
+ *
+ * Install then sets the system id of every node.  When MPI is enabled,
+ * it also creates the channels of the links whose ends moved again, so
+ * that they become PointToPointRemoteChannels, as with
+ * PointToPointHelper, or plain ones.  Otherwise they stay
+ * PointToPointChannels, which read the system ids of their nodes at
+ * each transmission and which the MultithreadedSimulatorImpl handles.
+ * The same scenario can thus run sequentially, in threads, or over MPI
+ * by changing only the number of systems and the simulator
+ * implementation.
+ */
+class TopologyPartitionHelper
+{
+public:
+  TopologyPartitionHelper ();
+
+  /**
+   * \param node a node of the topology
+   * \param weight the load expected on the node, proportional to the
+   *        number of events it processes.  The default is the number of
+   *        devices of the node.
+   */
+  void SetNodeWeight (Ptr<Node> node, double weight);
+  /**
+   * \param channel a channel of the topology
+   * \param weight the traffic expected on the channel.  The default is 1.
+   */
+  void SetChannelWeight (Ptr<Channel> channel, double weight);
+  /**
+   * \param imbalance the fraction by which the weight of a system may
+   *        exceed its share when a boundary node is moved.  The default
+   *        is 0.05.
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * Compute the partition of the nodes without changing them.
+   *
+   * \param nodes the nodes to split, the links to other nodes are ignored
+   * \param n the number of systems
+   * \returns the system of each node of the container, in order
+   */
+  std::vector<uint32_t> Partition (NodeContainer nodes, uint32_t n);
+  /**
+   * Split the nodes among the systems, then update their system ids and
+   * the channels of the links between systems.  This must be done before
+   * the simulation starts.
+   *
+   * \param nodes the nodes to split, the links to other nodes are ignored
+   * \param n the number of systems, which must be MpiInterface::GetSize ()
+   *        in a distributed simulation
+   */
+  void Install (NodeContainer nodes, uint32_t n);
+  /**
+   * Split all the nodes of the simulation, see Install.
+   *
+   * \param n the number of systems
+   */
+  void InstallAll (uint32_t n);
+
+  /**
+   * \returns the number of links between systems of the last partition
+   */
+  uint32_t GetNCutLinks (void) const;
+  /**
+   * \returns the weight of each system of the last partition
+   */
+  std::vector<double> GetSystemWeights (void) const;
+  /**
+   * \param os the output stream
+   *
+   * Print the weight of each system and the links between systems of the
+   * last partition.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
+private:
+  // the nodes which must stay on the same system, with the links from
+  // them to the other groups
+  struct Group
+  {
+    double weight;
+    std::map<uint32_t, double> links;
+  };
+
+  uint32_t FindGroup (std::vector<uint32_t> &parent, uint32_t i) const;
+  bool IsCuttable (Ptr<Channel> channel) const;
+  double GetNodeWeight (Ptr<Node> node) const;
+  double GetChannelWeight (Ptr<Channel> channel) const;
+  void BuildGroups (NodeContainer nodes, std::vector<uint32_t> &groupOf);
+  uint32_t FindPeripheral (uint32_t start, const std::vector<uint32_t> &part) const;
+  void Grow (uint32_t n, std::vector<uint32_t> &part) const;
+  void Refine (uint32_t n, std::vector<uint32_t> &part) const;
+  void ReplaceChannel (Ptr<Channel> channel);
+
+  std::map<uint32_t, double> m_nodeWeights;
+  std::map<uint32_t, double> m_channelWeights;
+  double m_imbalance;
+  std::vector<Group> m_groups;
+  std::vector<double> m_systemWeights;
+  uint32_t m_nCutLinks;
+  double m_cutWeight;
+};
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_PARTITION_HELPER_H */
@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointChannel");
 
@@ -53,7 +54,8 @@ PointToPointChannel::PointToPointChannel()
   :
     Channel (),
     m_delay (Seconds (0.)),
-    m_nDevices (0)
+    m_nDevices (0),
+    m_destinationsFound (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -76,9 +78,33 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      FindDestinations ();
     }
 }
 
+bool
+PointToPointChannel::FindDestinations (void)
+{
+  Ptr<Node> nodes[N_DEVICES];
+  for (uint32_t i = 0; i < N_DEVICES; i++)
+    {
+      nodes[i] = m_link[i].m_src->GetNode ();
+      if (nodes[i] == 0)
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < N_DEVICES; i++)
+    {
+      Ptr<Node> dst = nodes[N_DEVICES - 1 - i];
+      m_link[i].m_srcNode = PeekPointer (nodes[i]);
+      m_link[i].m_dstNode = PeekPointer (dst);
+      m_link[i].m_dstId = dst->GetId ();
+    }
+  m_destinationsFound = true;
+  return true;
+}
+
 bool
 PointToPointChannel::TransmitStart (
   Ptr<Packet> p,
@@ -92,8 +118,32 @@ PointToPointChannel::TransmitStart (
   NS_ASSERT (m_link[1].m_state != INITIALIZING);
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  if (!m_destinationsFound && !FindDestinations ())
+    {
+      NS_FATAL_ERROR ("The devices of the channel must be added to nodes before transmitting");
+    }
+
+  // the system ids are read at each transmission, as they may change
+  // until the simulation starts
+  if (m_link[wire].m_srcNode->GetSystemId () != m_link[wire].m_dstNode->GetSystemId ())
+    {
+      // the destination may run in another thread, the partition of its
+      // system in a multithreaded simulation: it receives a copy of the
+      // packet which shares no data with the sender, and the reference
+      // counts of the destination are left untouched unless the animation
+      // trace is connected
+      Ptr<Packet> copy = p->DeepCopy ();
+      Simulator::ScheduleWithContext (m_link[wire].m_dstId,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), copy);
+      if (!m_txrxPointToPoint.IsEmpty ())
+        {
+          m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+        }
+      return true;
+    }
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  Simulator::ScheduleWithContext (m_link[wire].m_dstId,
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
 
@@ -30,6 +30,7 @@ namespace ns3 {
 
 class PointToPointNetDevice;
 class Packet;
+class Node;
 
 /**
  * \ingroup point-to-point
@@ -155,13 +156,28 @@ private:
   class Link
   {
 public:
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_srcNode (0), m_dstNode (0), m_dstId (0) {}
     WireState                  m_state;
     Ptr<PointToPointNetDevice> m_src;
     Ptr<PointToPointNetDevice> m_dst;
+    // the nodes of m_src and m_dst, whose system ids tell at each
+    // transmission whether the wire links two systems, and the id of
+    // the node of m_dst
+    Node                      *m_srcNode;
+    Node                      *m_dstNode;
+    uint32_t                   m_dstId;
   };
 
+  /**
+   * Find the nodes of the destinations of the wires, once both devices
+   * are attached to their nodes.
+   *
+   * \returns true if the nodes are known
+   */
+  bool FindDestinations (void);
+
   Link    m_link[N_DEVICES];
+  bool    m_destinationsFound;
 };
 
 } // namespace ns3
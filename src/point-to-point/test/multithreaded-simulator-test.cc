@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/string.h"
+#include "ns3/random-variable.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/core-config.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/*
+ * Packets travel around a ring of nodes spread over four partitions, and
+ * every node counts the packets it receives and the time of their
+ * arrival, which must not depend on the simulator implementation.  Each
+ * arrival also draws from a new random variable, whose values must be
+ * the same in two multithreaded runs.
+ */
+class MultithreadedSimulatorTest : public TestCase
+{
+public:
+  MultithreadedSimulatorTest (std::string name, Time stop);
+
+  virtual void DoRun (void);
+
+private:
+  struct Result
+  {
+    uint32_t nReceived;
+    uint64_t timeSum;
+    uint32_t nErrors;
+    double randomSum;
+  };
+
+  void Run (Ptr<SimulatorImpl> impl, std::vector<Result> &results);
+  void Start (Ptr<Node> node);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  Time m_stop;
+  bool m_multithreaded;
+  std::vector<Result> *m_results;
+};
+
+MultithreadedSimulatorTest::MultithreadedSimulatorTest (std::string name, Time stop)
+  : TestCase (name),
+    m_stop (stop),
+    m_multithreaded (false),
+    m_results (0)
+{
+}
+
+void
+MultithreadedSimulatorTest::Start (Ptr<Node> node)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddPacketTag (FlowIdTag (node->GetId ()));
+  p->AddByteTag (FlowIdTag (node->GetId ()));
+  Ptr<NetDevice> device = node->GetDevice (1);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+MultithreadedSimulatorTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                     uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  Result &result = (*m_results)[node->GetId ()];
+  result.nReceived++;
+  result.timeSum += Simulator::Now ().GetTimeStep ();
+  result.randomSum += UniformVariable ().GetValue ();
+  // the test macros are not thread-safe, the errors are checked after
+  // the run
+  FlowIdTag packetTag;
+  FlowIdTag byteTag;
+  ByteTagIterator i = packet->GetByteTagIterator ();
+  // the default simulator runs every system id
+  if ((m_multithreaded && Simulator::GetSystemId () != node->GetSystemId ())
+      || Simulator::GetContext () != node->GetId ()
+      || !packet->PeekPacketTag (packetTag)
+      || !i.HasNext ()
+      || packet->GetSize () != 100)
+    {
+      result.nErrors++;
+      return true;
+    }
+  i.Next ().GetTag (byteTag);
+  if (packetTag.GetFlowId () != byteTag.GetFlowId ())
+    {
+      result.nErrors++;
+    }
+  if (Simulator::Now () < MilliSeconds (5))
+    {
+      Ptr<NetDevice> next = node->GetDevice (1 - device->GetIfIndex ());
+      next->Send (packet->Copy (), next->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorTest::Run (Ptr<SimulatorImpl> impl, std::vector<Result> &results)
+{
+  m_multithreaded = impl != 0;
+  if (m_multithreaded)
+    {
+      Simulator::SetImplementation (impl);
+    }
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      nodes.Add (CreateObject<Node> (i / 2));
+    }
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      PointToPointHelper p2p;
+      p2p.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+      p2p.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10 + 5 * i)));
+      p2p.Install (nodes.Get (i), nodes.Get ((i + 1) % 8));
+    }
+  Result zero = { 0, 0, 0, 0 };
+  results.assign (nodes.GetN (), zero);
+  m_results = &results;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          node->GetDevice (j)->SetReceiveCallback (MakeCallback (&MultithreadedSimulatorTest::Receive, this));
+        }
+      Simulator::ScheduleWithContext (i, Seconds (0), &MultithreadedSimulatorTest::Start, this, node);
+    }
+  if (!m_stop.IsZero ())
+    {
+      Simulator::Stop (m_stop);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedSimulatorTest::DoRun (void)
+{
+  std::vector<Result> expected;
+  Run (0, expected);
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  std::vector<Result> results;
+  Run (impl, results);
+
+  std::vector<Result> again;
+  Run (CreateObject<MultithreadedSimulatorImpl> (), again);
+
+  NS_TEST_ASSERT_MSG_EQ (impl->GetNPartitions (), 4, "One partition per system id");
+  NS_TEST_EXPECT_MSG_GT (impl->GetNWindows (), 1, "The partitions did not synchronize");
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_GT (expected[i].nReceived, 0, "Node " << i << " received nothing");
+      NS_TEST_EXPECT_MSG_EQ (expected[i].nErrors, 0, "Bad packet received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (results[i].nErrors, 0, "Bad packet received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (results[i].nReceived, expected[i].nReceived, "Node " << i);
+      NS_TEST_EXPECT_MSG_EQ (results[i].timeSum, expected[i].timeSum, "Node " << i);
+      NS_TEST_EXPECT_MSG_EQ (again[i].randomSum, results[i].randomSum, "Random values of node " << i);
+    }
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("multithreaded-simulator", SYSTEM)
+{
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new MultithreadedSimulatorTest ("Run to the end", Seconds (0)));
+  AddTestCase (new MultithreadedSimulatorTest ("Stop at 2ms", MilliSeconds (2)));
+#endif
+}
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite;
+
+} // namespace ns3
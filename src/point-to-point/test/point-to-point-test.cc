@@ -15,13 +15,33 @@ public:
 
 private:
   void SendOnePacket (Ptr<PointToPointNetDevice> device);
+  void TxRx (Ptr<const Packet> p, Ptr<NetDevice> tx, Ptr<NetDevice> rx, Time txTime, Time rxTime);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  uint32_t m_nTxRx;
+  uint32_t m_nReceived;
 };
 
 PointToPointTest::PointToPointTest ()
-  : TestCase ("PointToPoint")
+  : TestCase ("PointToPoint"),
+    m_nTxRx (0),
+    m_nReceived (0)
 {
 }
 
+void
+PointToPointTest::TxRx (Ptr<const Packet> p, Ptr<NetDevice> tx, Ptr<NetDevice> rx, Time txTime, Time rxTime)
+{
+  m_nTxRx++;
+}
+
+bool
+PointToPointTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_nReceived++;
+  return true;
+}
+
 void
 PointToPointTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
 {
@@ -49,9 +69,23 @@ PointToPointTest::DoRun (void)
   a->AddDevice (devA);
   b->AddDevice (devB);
 
+  channel->TraceConnectWithoutContext ("TxRxPointToPoint", MakeCallback (&PointToPointTest::TxRx, this));
+  devB->SetReceiveCallback (MakeCallback (&PointToPointTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointTest::SendOnePacket, this, devA);
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nTxRx, 1, "The transmission was not traced");
+  NS_TEST_EXPECT_MSG_EQ (m_nReceived, 1, "The packet was not received");
+
+  // the channel learns that b moved to another system when it transmits,
+  // and still traces the transmission
+  b->SetSystemId (1);
   Simulator::Schedule (Seconds (1.0), &PointToPointTest::SendOnePacket, this, devA);
 
   Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nTxRx, 2, "The transmission to another system was not traced");
+  NS_TEST_EXPECT_MSG_EQ (m_nReceived, 2, "The packet was not received by the other system");
 
   Simulator::Destroy ();
 }
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/topology-partition-helper.h"
+
+namespace ns3 {
+
+/*
+ * Four clusters of four fully linked nodes, joined in a chain by single
+ * links.  The links inside the clusters have no delay, so that the
+ * clusters cannot be split, and the best partition in two systems cuts
+ * the chain in its middle.
+ */
+class TopologyPartitionHelperTest : public TestCase
+{
+public:
+  TopologyPartitionHelperTest ();
+
+  virtual void DoRun (void);
+};
+
+TopologyPartitionHelperTest::TopologyPartitionHelperTest ()
+  : TestCase ("Cut a chain of clusters")
+{
+}
+
+void
+TopologyPartitionHelperTest::DoRun (void)
+{
+  NodeContainer clusters[4];
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", TimeValue (Seconds (0)));
+  for (uint32_t c = 0; c < 4; c++)
+    {
+      clusters[c].Create (4);
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          for (uint32_t j = i + 1; j < 4; j++)
+            {
+              p2p.Install (clusters[c].Get (i), clusters[c].Get (j));
+            }
+        }
+    }
+  p2p.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  NetDeviceContainer links[3];
+  for (uint32_t c = 0; c < 3; c++)
+    {
+      links[c] = p2p.Install (clusters[c].Get (3), clusters[c + 1].Get (0));
+    }
+  Ptr<Channel> cutChannel = links[1].Get (0)->GetChannel ();
+  Ptr<Channel> channel = links[0].Get (0)->GetChannel ();
+
+  NodeContainer nodes (clusters[0], clusters[1], clusters[2], clusters[3]);
+  TopologyPartitionHelper partition;
+  partition.Install (nodes, 2);
+
+  NS_TEST_EXPECT_MSG_EQ (partition.GetNCutLinks (), 1, "Only the middle link should be cut");
+  uint32_t systemId = clusters[0].Get (0)->GetSystemId ();
+  for (uint32_t c = 0; c < 4; c++)
+    {
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          bool same = clusters[c].Get (i)->GetSystemId () == systemId;
+          NS_TEST_EXPECT_MSG_EQ (same, (c < 2), "Node " << i << " of cluster " << c);
+        }
+    }
+  // without MPI, the channels read the system ids of their nodes when
+  // they transmit and are kept
+  NS_TEST_EXPECT_MSG_EQ (links[1].Get (0)->GetChannel (), cutChannel, "The cut link was created again");
+  NS_TEST_EXPECT_MSG_EQ (links[0].Get (0)->GetChannel (), channel, "The link inside a system was created again");
+
+  std::vector<double> weights = partition.GetSystemWeights ();
+  NS_TEST_ASSERT_MSG_EQ (weights.size (), 2, "Two systems");
+  // 3 devices per node, plus one at each end of the links between clusters
+  NS_TEST_EXPECT_MSG_EQ (weights[0], 27, "Weight of the first system");
+  NS_TEST_EXPECT_MSG_EQ (weights[1], 27, "Weight of the second system");
+
+  Simulator::Destroy ();
+}
+
+class TopologyPartitionHelperTestSuite : public TestSuite
+{
+public:
+  TopologyPartitionHelperTestSuite ();
+};
+
+TopologyPartitionHelperTestSuite::TopologyPartitionHelperTestSuite ()
+  : TestSuite ("topology-partition-helper", UNIT)
+{
+  AddTestCase (new TopologyPartitionHelperTest);
+}
+
+static TopologyPartitionHelperTestSuite g_topologyPartitionHelperTestSuite;
+
+} // namespace ns3
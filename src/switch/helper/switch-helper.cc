@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+
+#include "ns3/log.h"
+#include "ns3/queue.h"
+#include "ns3/config.h"
+#include "ns3/packet.h"
+#include "ns3/switch-net-device.h"
+#include "ns3/switch-channel.h"
+#include "switch-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("SwitchHelper");
+
+namespace ns3 {
+
+SwitchHelper::SwitchHelper ()
+{
+  m_queueFactory.SetTypeId ("ns3::DropTailQueue");
+  m_portQueueFactory.SetTypeId ("ns3::DropTailQueue");
+  m_deviceFactory.SetTypeId ("ns3::SwitchNetDevice");
+  m_channelFactory.SetTypeId ("ns3::SwitchChannel");
+}
+
+void
+SwitchHelper::SetQueue (std::string type,
+                        std::string n1, const AttributeValue &v1,
+                        std::string n2, const AttributeValue &v2,
+                        std::string n3, const AttributeValue &v3,
+                        std::string n4, const AttributeValue &v4)
+{
+  m_queueFactory.SetTypeId (type);
+  m_queueFactory.Set (n1, v1);
+  m_queueFactory.Set (n2, v2);
+  m_queueFactory.Set (n3, v3);
+  m_queueFactory.Set (n4, v4);
+}
+
+void
+SwitchHelper::SetPortQueue (std::string type,
+                            std::string n1, const AttributeValue &v1,
+                            std::string n2, const AttributeValue &v2,
+                            std::string n3, const AttributeValue &v3,
+                            std::string n4, const AttributeValue &v4)
+{
+  m_portQueueFactory.SetTypeId (type);
+  m_portQueueFactory.Set (n1, v1);
+  m_portQueueFactory.Set (n2, v2);
+  m_portQueueFactory.Set (n3, v3);
+  m_portQueueFactory.Set (n4, v4);
+}
+
+void
+SwitchHelper::SetDeviceAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_deviceFactory.Set (n1, v1);
+}
+
+void
+SwitchHelper::SetChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_channelFactory.Set (n1, v1);
+}
+
+void
+SwitchHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
+{
+  Ptr<SwitchNetDevice> device = nd->GetObject<SwitchNetDevice> ();
+  if (device == 0)
+    {
+      NS_LOG_INFO ("SwitchHelper::EnablePcapInternal(): Device " << device << " not of type ns3::SwitchNetDevice");
+      return;
+    }
+
+  PcapHelper pcapHelper;
+  std::string filename;
+  if (explicitFilename)
+    {
+      filename = prefix;
+    }
+  else
+    {
+      filename = pcapHelper.GetFilenameFromDevice (prefix, device);
+    }
+
+  Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (filename, std::ios::out,
+                                                     PcapHelper::DLT_EN10MB);
+  if (promiscuous)
+    {
+      pcapHelper.HookDefaultSink<SwitchNetDevice> (device, "PromiscSniffer", file);
+    }
+  else
+    {
+      pcapHelper.HookDefaultSink<SwitchNetDevice> (device, "Sniffer", file);
+    }
+}
+
+void
+SwitchHelper::EnableAsciiInternal (
+  Ptr<OutputStreamWrapper> stream,
+  std::string prefix,
+  Ptr<NetDevice> nd,
+  bool explicitFilename)
+{
+  Ptr<SwitchNetDevice> device = nd->GetObject<SwitchNetDevice> ();
+  if (device == 0)
+    {
+      NS_LOG_INFO ("SwitchHelper::EnableAsciiInternal(): Device " << device << " not of type ns3::SwitchNetDevice");
+      return;
+    }
+
+  Packet::EnablePrinting ();
+
+  //
+  // Same hooks as for a CsmaNetDevice: "r" events from MacRx, and "+", "-"
+  // and "d" events from the transmit queue.
+  //
+  if (stream == 0)
+    {
+      AsciiTraceHelper asciiTraceHelper;
+      std::string filename;
+      if (explicitFilename)
+        {
+          filename = prefix;
+        }
+      else
+        {
+          filename = asciiTraceHelper.GetFilenameFromDevice (prefix, device);
+        }
+
+      Ptr<OutputStreamWrapper> theStream = asciiTraceHelper.CreateFileStream (filename);
+      asciiTraceHelper.HookDefaultReceiveSinkWithoutContext<SwitchNetDevice> (device, "MacRx", theStream);
+
+      Ptr<Queue> queue = device->GetQueue ();
+      asciiTraceHelper.HookDefaultEnqueueSinkWithoutContext<Queue> (queue, "Enqueue", theStream);
+      asciiTraceHelper.HookDefaultDropSinkWithoutContext<Queue> (queue, "Drop", theStream);
+      asciiTraceHelper.HookDefaultDequeueSinkWithoutContext<Queue> (queue, "Dequeue", theStream);
+      return;
+    }
+
+  uint32_t nodeid = nd->GetNode ()->GetId ();
+  uint32_t deviceid = nd->GetIfIndex ();
+  std::ostringstream oss;
+
+  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::SwitchNetDevice/MacRx";
+  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
+
+  oss.str ("");
+  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::SwitchNetDevice/TxQueue/Enqueue";
+  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
+
+  oss.str ("");
+  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::SwitchNetDevice/TxQueue/Dequeue";
+  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
+
+  oss.str ("");
+  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::SwitchNetDevice/TxQueue/Drop";
+  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+}
+
+NetDeviceContainer
+SwitchHelper::Install (const NodeContainer &c) const
+{
+  Ptr<SwitchChannel> channel = m_channelFactory.Create ()->GetObject<SwitchChannel> ();
+  return Install (c, channel);
+}
+
+NetDeviceContainer
+SwitchHelper::Install (Ptr<Node> node, Ptr<SwitchChannel> channel) const
+{
+  return NetDeviceContainer (InstallPriv (node, channel));
+}
+
+NetDeviceContainer
+SwitchHelper::Install (const NodeContainer &c, Ptr<SwitchChannel> channel) const
+{
+  NetDeviceContainer devs;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++)
+    {
+      devs.Add (InstallPriv (*i, channel));
+    }
+  return devs;
+}
+
+Ptr<NetDevice>
+SwitchHelper::InstallPriv (Ptr<Node> node, Ptr<SwitchChannel> channel) const
+{
+  Ptr<SwitchNetDevice> device = m_deviceFactory.Create<SwitchNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  device->SetQueue (m_queueFactory.Create<Queue> ());
+  device->Attach (channel, m_portQueueFactory.Create<Queue> ());
+  return device;
+}
+
+} // namespace ns3
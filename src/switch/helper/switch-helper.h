@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWITCH_HELPER_H
+#define SWITCH_HELPER_H
+
+#include <string>
+
+#include "ns3/attribute.h"
+#include "ns3/object-factory.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/switch-channel.h"
+#include "ns3/trace-helper.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup switch
+ *
+ * \brief build a set of SwitchNetDevice objects attached to a SwitchChannel
+ *
+ * The helper is used like a CsmaHelper: the nodes given to one Install
+ * call are the hosts of one switch.  Pcap traces are Ethernet traces, as
+ * on a CSMA segment.
+ */
+class SwitchHelper : public PcapHelperForDevice, public AsciiTraceHelperForDevice
+{
+public:
+  SwitchHelper ();
+  virtual ~SwitchHelper () {}
+
+  /**
+   * Set the type and attributes of the transmit queue of each
+   * SwitchNetDevice created through SwitchHelper::Install.
+   */
+  void SetQueue (std::string type,
+                 std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+                 std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+                 std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),
+                 std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue ());
+
+  /**
+   * Set the type and attributes of the output queue of the switch port
+   * created for each SwitchNetDevice.
+   */
+  void SetPortQueue (std::string type,
+                     std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+                     std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+                     std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),
+                     std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue ());
+
+  /**
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   *
+   * Set an attribute of each ns3::SwitchNetDevice created by
+   * SwitchHelper::Install
+   */
+  void SetDeviceAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   *
+   * Set an attribute of each ns3::SwitchChannel created by
+   * SwitchHelper::Install
+   */
+  void SetChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \param c the hosts of a new switch
+   * \returns the devices of the hosts, in the order of the ports
+   */
+  NetDeviceContainer Install (const NodeContainer &c) const;
+
+  /**
+   * \param node a node to connect to a new port of a switch
+   * \param channel the switch
+   * \returns the device of the node
+   */
+  NetDeviceContainer Install (Ptr<Node> node, Ptr<SwitchChannel> channel) const;
+
+  /**
+   * \param c nodes to connect to new ports of a switch
+   * \param channel the switch
+   * \returns the devices of the nodes, in the order of the ports
+   */
+  NetDeviceContainer Install (const NodeContainer &c, Ptr<SwitchChannel> channel) const;
+
+private:
+  Ptr<NetDevice> InstallPriv (Ptr<Node> node, Ptr<SwitchChannel> channel) const;
+
+  virtual void EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename);
+  virtual void EnableAsciiInternal (Ptr<OutputStreamWrapper> stream,
+                                    std::string prefix,
+                                    Ptr<NetDevice> nd,
+                                    bool explicitFilename);
+
+  ObjectFactory m_queueFactory;
+  ObjectFactory m_portQueueFactory;
+  ObjectFactory m_deviceFactory;
+  ObjectFactory m_channelFactory;
+};
+
+} // namespace ns3
+
+#endif /* SWITCH_HELPER_H */
@@ -0,0 +1,273 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/queue.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/trace-source-accessor.h"
+#include "switch-channel.h"
+#include "switch-net-device.h"
+
+NS_LOG_COMPONENT_DEFINE ("SwitchChannel");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (SwitchChannel);
+
+TypeId
+SwitchChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SwitchChannel")
+    .SetParent<Channel> ()
+    .AddConstructor<SwitchChannel> ()
+    .AddAttribute ("DataRate",
+                   "The data rate of the links between the devices and the switch",
+                   DataRateValue (DataRate (0xffffffff)),
+                   MakeDataRateAccessor (&SwitchChannel::m_bps),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Delay", "The propagation delay of the links between the devices and the switch",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SwitchChannel::m_delay),
+                   MakeTimeChecker ())
+    .AddAttribute ("ExpirationTime",
+                   "Time it takes for learned MAC state entry to expire.",
+                   TimeValue (Seconds (300)),
+                   MakeTimeAccessor (&SwitchChannel::SetExpirationTime,
+                                     &SwitchChannel::GetExpirationTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("SweepInterval",
+                   "Minimum time between two removals of the expired learned MAC state entries.",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&SwitchChannel::SetSweepInterval,
+                                     &SwitchChannel::GetSweepInterval),
+                   MakeTimeChecker ())
+    .AddTraceSource ("PortDrop",
+                     "Trace source indicating a frame has been dropped by an output port of the switch",
+                     MakeTraceSourceAccessor (&SwitchChannel::m_portDropTrace))
+  ;
+  return tid;
+}
+
+SwitchChannel::SwitchChannel ()
+  : m_nFlooded (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+SwitchChannel::~SwitchChannel ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SwitchChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_ports.clear ();
+  m_learnState.Clear ();
+  Channel::DoDispose ();
+}
+
+uint32_t
+SwitchChannel::Attach (Ptr<SwitchNetDevice> device, Ptr<Queue> queue)
+{
+  NS_LOG_FUNCTION (this << device << queue);
+  NS_ASSERT (device != 0 && queue != 0);
+  Port port;
+  port.device = device;
+  port.queue = queue;
+  port.busy = false;
+  m_ports.push_back (port);
+  return m_ports.size () - 1;
+}
+
+void
+SwitchChannel::TransmitStart (Ptr<Packet> p, uint32_t port, Time txTime)
+{
+  NS_LOG_FUNCTION (this << p << port << txTime);
+  NS_ASSERT (port < m_ports.size ());
+  Simulator::Schedule (txTime + m_delay, &SwitchChannel::Forward, this, p, port);
+}
+
+void
+SwitchChannel::Forward (Ptr<Packet> p, uint32_t port)
+{
+  NS_LOG_FUNCTION (this << p << port);
+  EthernetHeader header (false);
+  p->PeekHeader (header);
+  Mac48Address src = header.GetSource ();
+  Mac48Address dst = header.GetDestination ();
+  m_learnState.Learn (src, port, Simulator::Now ());
+
+  uint32_t outPort;
+  if (!dst.IsGroup () && m_learnState.Lookup (dst, outPort, Simulator::Now ()))
+    {
+      // a frame for the port it came from is filtered; the receiver
+      // gets its own copy, as from a CsmaChannel
+      if (outPort != port)
+        {
+          Enqueue (p->Copy (), outPort);
+        }
+      return;
+    }
+  NS_LOG_LOGIC ("Flooding " << src << " => " << dst);
+  m_nFlooded++;
+  for (uint32_t i = 0; i < m_ports.size (); ++i)
+    {
+      if (i != port)
+        {
+          Enqueue (p->Copy (), i);
+        }
+    }
+}
+
+void
+SwitchChannel::Enqueue (Ptr<Packet> p, uint32_t port)
+{
+  Port &out = m_ports[port];
+  if (!out.queue->Enqueue (p))
+    {
+      m_portDropTrace (p);
+      return;
+    }
+  if (!out.busy)
+    {
+      PortTransmitStart (out.queue->Dequeue (), port);
+    }
+}
+
+void
+SwitchChannel::PortTransmitStart (Ptr<Packet> p, uint32_t port)
+{
+  NS_LOG_FUNCTION (this << p << port);
+  Port &out = m_ports[port];
+  out.busy = true;
+  Time txTime = Seconds (m_bps.CalculateTxTime (p->GetSize ()));
+  Simulator::Schedule (txTime, &SwitchChannel::PortTransmitComplete, this, port);
+  Simulator::ScheduleWithContext (out.device->GetNode ()->GetId (), txTime + m_delay,
+                                  &SwitchNetDevice::Receive, out.device, p);
+}
+
+void
+SwitchChannel::PortTransmitComplete (uint32_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  Port &out = m_ports[port];
+  out.busy = false;
+  Ptr<Packet> p = out.queue->Dequeue ();
+  if (p != 0)
+    {
+      PortTransmitStart (p, port);
+    }
+}
+
+void
+SwitchChannel::SetExpirationTime (Time expirationTime)
+{
+  m_expirationTime = expirationTime;
+  m_learnState.SetExpirationTime (expirationTime);
+}
+
+Time
+SwitchChannel::GetExpirationTime (void) const
+{
+  return m_expirationTime;
+}
+
+void
+SwitchChannel::SetSweepInterval (Time sweepInterval)
+{
+  m_sweepInterval = sweepInterval;
+  m_learnState.SetSweepInterval (sweepInterval);
+}
+
+Time
+SwitchChannel::GetSweepInterval (void) const
+{
+  return m_sweepInterval;
+}
+
+uint64_t
+SwitchChannel::GetNLearned (void) const
+{
+  return m_learnState.GetNLearned ();
+}
+
+uint64_t
+SwitchChannel::GetNAgedOut (void) const
+{
+  return m_learnState.GetNAgedOut ();
+}
+
+uint64_t
+SwitchChannel::GetNFlooded (void) const
+{
+  return m_nFlooded;
+}
+
+void
+SwitchChannel::PrintStatistics (std::ostream &os) const
+{
+  os << "Switch: " << GetNLearned () << " learned, "
+     << GetNAgedOut () << " aged out, "
+     << GetNFlooded () << " flooded, "
+     << m_learnState.GetNEntries () << " entries" << std::endl;
+}
+
+uint32_t
+SwitchChannel::GetNDevices (void) const
+{
+  return m_ports.size ();
+}
+
+Ptr<NetDevice>
+SwitchChannel::GetDevice (uint32_t i) const
+{
+  return GetSwitchDevice (i);
+}
+
+Ptr<SwitchNetDevice>
+SwitchChannel::GetSwitchDevice (uint32_t i) const
+{
+  NS_ASSERT (i < m_ports.size ());
+  return m_ports[i].device;
+}
+
+Ptr<Queue>
+SwitchChannel::GetPortQueue (uint32_t i) const
+{
+  NS_ASSERT (i < m_ports.size ());
+  return m_ports[i].queue;
+}
+
+DataRate
+SwitchChannel::GetDataRate (void) const
+{
+  return m_bps;
+}
+
+Time
+SwitchChannel::GetDelay (void) const
+{
+  return m_delay;
+}
+
+} // namespace ns3
@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWITCH_CHANNEL_H
+#define SWITCH_CHANNEL_H
+
+#include <vector>
+#include <ostream>
+
+#include "ns3/channel.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/mac48-address.h"
+#include "ns3/mac-learning-table.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class Packet;
+class Queue;
+class SwitchNetDevice;
+
+/**
+ * \ingroup switch
+ *
+ * \brief A store-and-forward Ethernet switch seen as a channel
+ *
+ * Each SwitchNetDevice attached to the channel is connected to its own
+ * port of a learning switch by a full-duplex link of the channel data
+ * rate and delay.  A frame sent by a device reaches the switch once it is
+ * fully received, after its transmission time and the link delay.  The
+ * switch learns the port of the source address, then queues the frame on
+ * the output port of the destination address, or on every other port
+ * when the destination is a group address or is not known yet.  Each
+ * output port sends its queue at the channel data rate, so that the
+ * queueing delay of each port is kept.
+ *
+ * Unlike a CsmaChannel to a BridgeNetDevice, the switch is neither a
+ * node nor a device: a unicast frame costs the end of its transmission,
+ * its arrival at the switch, the end of its transmission by the output
+ * port and its reception, whatever the number of ports.
+ */
+class SwitchChannel : public Channel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  SwitchChannel ();
+  virtual ~SwitchChannel ();
+
+  /**
+   * \brief Attach a device to a new port of the switch
+   *
+   * \param device the device to attach
+   * \param queue the output queue of the port, toward the device
+   * \returns the index of the port
+   */
+  uint32_t Attach (Ptr<SwitchNetDevice> device, Ptr<Queue> queue);
+
+  /**
+   * \brief Start the transmission of a frame by the device of a port
+   *
+   * \param p the frame, with its Ethernet header and trailer
+   * \param port the port of the sending device
+   * \param txTime the transmission time of the frame
+   */
+  void TransmitStart (Ptr<Packet> p, uint32_t port, Time txTime);
+
+  /**
+   * \returns the number of ports of the switch
+   */
+  virtual uint32_t GetNDevices (void) const;
+
+  /**
+   * \param i the index of a port
+   * \returns the device attached to the port
+   */
+  virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
+
+  /**
+   * \param i the index of a port
+   * \returns the device attached to the port
+   */
+  Ptr<SwitchNetDevice> GetSwitchDevice (uint32_t i) const;
+
+  /**
+   * \param i the index of a port
+   * \returns the output queue of the port
+   */
+  Ptr<Queue> GetPortQueue (uint32_t i) const;
+
+  /**
+   * \returns the number of source addresses learned while unknown or
+   *          expired
+   */
+  uint64_t GetNLearned (void) const;
+
+  /**
+   * \returns the number of learned entries which expired
+   */
+  uint64_t GetNAgedOut (void) const;
+
+  /**
+   * \returns the number of frames sent through all ports but the
+   *          incoming one: broadcast, multicast, and unicast to an
+   *          address with no learned state
+   */
+  uint64_t GetNFlooded (void) const;
+
+  /**
+   * \param os the output stream
+   *
+   * Print the counters on a single line.
+   */
+  void PrintStatistics (std::ostream &os) const;
+
+  /**
+   * \returns the data rate of the links
+   */
+  DataRate GetDataRate (void) const;
+
+  /**
+   * \returns the delay of the links
+   */
+  Time GetDelay (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Port
+  {
+    Ptr<SwitchNetDevice> device;
+    Ptr<Queue> queue;
+    bool busy;
+  };
+
+  /**
+   * The frame is fully received by the switch from a port.
+   */
+  void Forward (Ptr<Packet> p, uint32_t port);
+  void Enqueue (Ptr<Packet> p, uint32_t port);
+  void PortTransmitStart (Ptr<Packet> p, uint32_t port);
+  void PortTransmitComplete (uint32_t port);
+
+  void SetExpirationTime (Time expirationTime);
+  Time GetExpirationTime (void) const;
+  void SetSweepInterval (Time sweepInterval);
+  Time GetSweepInterval (void) const;
+
+  DataRate m_bps;
+  Time m_delay;
+  Time m_expirationTime;
+  Time m_sweepInterval;
+  std::vector<Port> m_ports;
+  MacLearningTable m_learnState;
+  uint64_t m_nFlooded;
+
+  /**
+   * The trace source fired when an output port of the switch drops a frame
+   * because its queue is full
+   */
+  TracedCallback<Ptr<const Packet> > m_portDropTrace;
+};
+
+} // namespace ns3
+
+#endif /* SWITCH_CHANNEL_H */
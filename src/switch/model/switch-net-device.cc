@@ -0,0 +1,431 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/queue.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ethernet-trailer.h"
+#include "ns3/trace-source-accessor.h"
+#include "switch-net-device.h"
+#include "switch-channel.h"
+
+NS_LOG_COMPONENT_DEFINE ("SwitchNetDevice");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (SwitchNetDevice);
+
+TypeId
+SwitchNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SwitchNetDevice")
+    .SetParent<NetDevice> ()
+    .AddConstructor<SwitchNetDevice> ()
+    .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
+                   UintegerValue (DEFAULT_MTU),
+                   MakeUintegerAccessor (&SwitchNetDevice::SetMtu,
+                                         &SwitchNetDevice::GetMtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Address",
+                   "The MAC address of this device.",
+                   Mac48AddressValue (Mac48Address ("ff:ff:ff:ff:ff:ff")),
+                   MakeMac48AddressAccessor (&SwitchNetDevice::m_address),
+                   MakeMac48AddressChecker ())
+    .AddAttribute ("TxQueue",
+                   "A queue to use as the transmit queue in the device.",
+                   PointerValue (),
+                   MakePointerAccessor (&SwitchNetDevice::m_queue),
+                   MakePointerChecker<Queue> ())
+    .AddTraceSource ("MacTx",
+                     "Trace source indicating a packet has arrived for transmission by this device",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_macTxTrace))
+    .AddTraceSource ("MacTxDrop",
+                     "Trace source indicating a packet has been dropped by the device before transmission",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_macTxDropTrace))
+    .AddTraceSource ("MacPromiscRx",
+                     "A packet has been received by this device, has been passed up from the physical layer "
+                     "and is being forwarded up the local protocol stack.  This is a promiscuous trace,",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_macPromiscRxTrace))
+    .AddTraceSource ("MacRx",
+                     "A packet has been received by this device, has been passed up from the physical layer "
+                     "and is being forwarded up the local protocol stack.  This is a non-promiscuous trace,",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_macRxTrace))
+    .AddTraceSource ("PhyTxBegin",
+                     "Trace source indicating a packet has begun transmitting over the channel",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_phyTxBeginTrace))
+    .AddTraceSource ("PhyTxEnd",
+                     "Trace source indicating a packet has been completely transmitted over the channel",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_phyTxEndTrace))
+    .AddTraceSource ("PhyRxEnd",
+                     "Trace source indicating a packet has been completely received by the device",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_phyRxEndTrace))
+    .AddTraceSource ("PhyRxDrop",
+                     "Trace source indicating a packet has been dropped by the device during reception",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_phyRxDropTrace))
+    .AddTraceSource ("Sniffer",
+                     "Trace source simulating a non-promiscuous packet sniffer attached to the device",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_snifferTrace))
+    .AddTraceSource ("PromiscSniffer",
+                     "Trace source simulating a promiscuous packet sniffer attached to the device",
+                     MakeTraceSourceAccessor (&SwitchNetDevice::m_promiscSnifferTrace))
+  ;
+  return tid;
+}
+
+SwitchNetDevice::SwitchNetDevice ()
+  : m_port (0),
+    m_ifIndex (0),
+    m_linkUp (false),
+    m_busy (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SwitchNetDevice::~SwitchNetDevice ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+SwitchNetDevice::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_node = 0;
+  m_channel = 0;
+  m_queue = 0;
+  m_currentPkt = 0;
+  NetDevice::DoDispose ();
+}
+
+bool
+SwitchNetDevice::Attach (Ptr<SwitchChannel> ch, Ptr<Queue> queue)
+{
+  NS_LOG_FUNCTION (this << ch << queue);
+  m_channel = ch;
+  m_port = ch->Attach (this, queue);
+  m_linkUp = true;
+  m_linkChangeCallbacks ();
+  return true;
+}
+
+void
+SwitchNetDevice::SetQueue (Ptr<Queue> queue)
+{
+  NS_LOG_FUNCTION (this << queue);
+  m_queue = queue;
+}
+
+Ptr<Queue>
+SwitchNetDevice::GetQueue (void) const
+{
+  return m_queue;
+}
+
+void
+SwitchNetDevice::TransmitStart (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  NS_ASSERT_MSG (!m_busy, "Must be idle to transmit");
+  m_busy = true;
+  m_currentPkt = p;
+  m_snifferTrace (p);
+  m_promiscSnifferTrace (p);
+  m_phyTxBeginTrace (p);
+
+  Time txTime = Seconds (m_channel->GetDataRate ().CalculateTxTime (p->GetSize ()));
+  Simulator::Schedule (txTime, &SwitchNetDevice::TransmitComplete, this);
+  m_channel->TransmitStart (p, m_port, txTime);
+}
+
+void
+SwitchNetDevice::TransmitComplete (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ASSERT_MSG (m_busy, "Must be busy if transmitting");
+  m_busy = false;
+  m_phyTxEndTrace (m_currentPkt);
+  m_currentPkt = 0;
+
+  Ptr<Packet> p = m_queue->Dequeue ();
+  if (p != 0)
+    {
+      TransmitStart (p);
+    }
+}
+
+void
+SwitchNetDevice::Receive (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  m_phyRxEndTrace (packet);
+
+  //
+  // Trace sinks will expect complete packets, not packets without some of the
+  // headers.
+  //
+  Ptr<Packet> originalPacket = packet->Copy ();
+
+  EthernetTrailer trailer;
+  packet->RemoveTrailer (trailer);
+  if (Node::ChecksumEnabled ())
+    {
+      trailer.EnableFcs (true);
+    }
+  if (!trailer.CheckFcs (packet))
+    {
+      NS_LOG_INFO ("CRC error on Packet " << packet);
+      m_phyRxDropTrace (packet);
+      return;
+    }
+
+  EthernetHeader header (false);
+  packet->RemoveHeader (header);
+  uint16_t protocol = header.GetLengthType ();
+
+  PacketType packetType;
+  if (header.GetDestination ().IsBroadcast ())
+    {
+      packetType = PACKET_BROADCAST;
+    }
+  else if (header.GetDestination ().IsGroup ())
+    {
+      packetType = PACKET_MULTICAST;
+    }
+  else if (header.GetDestination () == m_address)
+    {
+      packetType = PACKET_HOST;
+    }
+  else
+    {
+      packetType = PACKET_OTHERHOST;
+    }
+
+  m_promiscSnifferTrace (originalPacket);
+  if (!m_promiscRxCallback.IsNull ())
+    {
+      m_macPromiscRxTrace (originalPacket);
+      m_promiscRxCallback (this, packet, protocol, header.GetSource (), header.GetDestination (), packetType);
+    }
+
+  //
+  // Frames flooded by the switch to an unknown address reach the other
+  // hosts too, which only pass them to the promiscuous callback.
+  //
+  if (packetType != PACKET_OTHERHOST)
+    {
+      m_snifferTrace (originalPacket);
+      m_macRxTrace (originalPacket);
+      m_rxCallback (this, packet, protocol, header.GetSource ());
+    }
+}
+
+void
+SwitchNetDevice::SetIfIndex (const uint32_t index)
+{
+  m_ifIndex = index;
+}
+
+uint32_t
+SwitchNetDevice::GetIfIndex (void) const
+{
+  return m_ifIndex;
+}
+
+Ptr<Channel>
+SwitchNetDevice::GetChannel (void) const
+{
+  return m_channel;
+}
+
+void
+SwitchNetDevice::SetAddress (Address address)
+{
+  m_address = Mac48Address::ConvertFrom (address);
+}
+
+Address
+SwitchNetDevice::GetAddress (void) const
+{
+  return m_address;
+}
+
+bool
+SwitchNetDevice::SetMtu (const uint16_t mtu)
+{
+  NS_LOG_FUNCTION (this << mtu);
+  m_mtu = mtu;
+  return true;
+}
+
+uint16_t
+SwitchNetDevice::GetMtu (void) const
+{
+  return m_mtu;
+}
+
+bool
+SwitchNetDevice::IsLinkUp (void) const
+{
+  return m_linkUp;
+}
+
+void
+SwitchNetDevice::AddLinkChangeCallback (Callback<void> callback)
+{
+  m_linkChangeCallbacks.ConnectWithoutContext (callback);
+}
+
+bool
+SwitchNetDevice::IsBroadcast (void) const
+{
+  return true;
+}
+
+Address
+SwitchNetDevice::GetBroadcast (void) const
+{
+  return Mac48Address ("ff:ff:ff:ff:ff:ff");
+}
+
+bool
+SwitchNetDevice::IsMulticast (void) const
+{
+  return true;
+}
+
+Address
+SwitchNetDevice::GetMulticast (Ipv4Address multicastGroup) const
+{
+  return Mac48Address::GetMulticast (multicastGroup);
+}
+
+Address
+SwitchNetDevice::GetMulticast (Ipv6Address addr) const
+{
+  return Mac48Address::GetMulticast (addr);
+}
+
+bool
+SwitchNetDevice::IsPointToPoint (void) const
+{
+  return false;
+}
+
+bool
+SwitchNetDevice::IsBridge (void) const
+{
+  return false;
+}
+
+bool
+SwitchNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+  return SendFrom (packet, m_address, dest, protocolNumber);
+}
+
+bool
+SwitchNetDevice::SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (packet << source << dest << protocolNumber);
+
+  if (!m_linkUp)
+    {
+      m_macTxDropTrace (packet);
+      return false;
+    }
+
+  //
+  // Frames are DIX encapsulated and padded to the minimum Ethernet payload
+  // of 46 bytes, as by a CsmaNetDevice.
+  //
+  if (packet->GetSize () < 46)
+    {
+      packet->AddAtEnd (Create<Packet> (46 - packet->GetSize ()));
+    }
+  EthernetHeader header (false);
+  header.SetSource (Mac48Address::ConvertFrom (source));
+  header.SetDestination (Mac48Address::ConvertFrom (dest));
+  header.SetLengthType (protocolNumber);
+  packet->AddHeader (header);
+
+  EthernetTrailer trailer;
+  if (Node::ChecksumEnabled ())
+    {
+      trailer.EnableFcs (true);
+    }
+  trailer.CalcFcs (packet);
+  packet->AddTrailer (trailer);
+
+  m_macTxTrace (packet);
+
+  //
+  // Even if the transmitter is immediately available, we still enqueue and
+  // dequeue the packet to hit the tracing hooks.
+  //
+  if (!m_queue->Enqueue (packet))
+    {
+      m_macTxDropTrace (packet);
+      return false;
+    }
+  if (!m_busy)
+    {
+      TransmitStart (m_queue->Dequeue ());
+    }
+  return true;
+}
+
+Ptr<Node>
+SwitchNetDevice::GetNode (void) const
+{
+  return m_node;
+}
+
+void
+SwitchNetDevice::SetNode (Ptr<Node> node)
+{
+  m_node = node;
+}
+
+bool
+SwitchNetDevice::NeedsArp (void) const
+{
+  return true;
+}
+
+void
+SwitchNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
+{
+  m_rxCallback = cb;
+}
+
+void
+SwitchNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
+{
+  m_promiscRxCallback = cb;
+}
+
+bool
+SwitchNetDevice::SupportsSendFrom (void) const
+{
+  return true;
+}
+
+} // namespace ns3
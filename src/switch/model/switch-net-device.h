@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWITCH_NET_DEVICE_H
+#define SWITCH_NET_DEVICE_H
+
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include "ns3/mac48-address.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class Queue;
+class SwitchChannel;
+
+/**
+ * \defgroup switch Switch
+ * This section documents the API of the ns-3 switch module: full-duplex
+ * Ethernet links to a store-and-forward learning switch.
+ */
+
+/**
+ * \ingroup switch
+ * \class SwitchNetDevice
+ * \brief A full-duplex Ethernet device connected to a port of a SwitchChannel
+ *
+ * The device sends Ethernet (DIX) frames at the data rate of its channel,
+ * one at a time from its transmit queue, and never collides since the
+ * link to the switch is full-duplex.  Frames are received from the switch
+ * like on a CsmaNetDevice, so that the two devices are interchangeable
+ * for the protocols above them and in pcap traces.
+ */
+class SwitchNetDevice : public NetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+
+  SwitchNetDevice ();
+  virtual ~SwitchNetDevice ();
+
+  /**
+   * Attach the device to a new port of a switch.
+   *
+   * \param ch the switch
+   * \param queue the output queue of the switch port toward this device
+   * \returns true
+   */
+  bool Attach (Ptr<SwitchChannel> ch, Ptr<Queue> queue);
+
+  /**
+   * \param queue the transmit queue of the device
+   */
+  void SetQueue (Ptr<Queue> queue);
+
+  /**
+   * \returns the transmit queue of the device
+   */
+  Ptr<Queue> GetQueue (void) const;
+
+  /**
+   * Receive a frame from the switch.
+   *
+   * \param p the frame, with its Ethernet header and trailer
+   */
+  void Receive (Ptr<Packet> p);
+
+  // inherited from NetDevice base class.
+  virtual void SetIfIndex (const uint32_t index);
+  virtual uint32_t GetIfIndex (void) const;
+  virtual Ptr<Channel> GetChannel (void) const;
+  virtual void SetAddress (Address address);
+  virtual Address GetAddress (void) const;
+  virtual bool SetMtu (const uint16_t mtu);
+  virtual uint16_t GetMtu (void) const;
+  virtual bool IsLinkUp (void) const;
+  virtual void AddLinkChangeCallback (Callback<void> callback);
+  virtual bool IsBroadcast (void) const;
+  virtual Address GetBroadcast (void) const;
+  virtual bool IsMulticast (void) const;
+  virtual Address GetMulticast (Ipv4Address multicastGroup) const;
+  virtual Address GetMulticast (Ipv6Address addr) const;
+  virtual bool IsPointToPoint (void) const;
+  virtual bool IsBridge (void) const;
+  virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber);
+  virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual Ptr<Node> GetNode (void) const;
+  virtual void SetNode (Ptr<Node> node);
+  virtual bool NeedsArp (void) const;
+  virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
+  virtual void SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb);
+  virtual bool SupportsSendFrom (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  SwitchNetDevice (const SwitchNetDevice &);
+  SwitchNetDevice &operator = (const SwitchNetDevice &);
+
+  void TransmitStart (Ptr<Packet> p);
+  void TransmitComplete (void);
+
+  Ptr<Node> m_node;
+  Ptr<SwitchChannel> m_channel;
+  Ptr<Queue> m_queue;
+  uint32_t m_port;
+  uint32_t m_ifIndex;
+  Mac48Address m_address;
+  uint16_t m_mtu;
+  bool m_linkUp;
+  bool m_busy;
+  Ptr<Packet> m_currentPkt;
+  NetDevice::ReceiveCallback m_rxCallback;
+  NetDevice::PromiscReceiveCallback m_promiscRxCallback;
+  TracedCallback<> m_linkChangeCallbacks;
+
+  TracedCallback<Ptr<const Packet> > m_macTxTrace;
+  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
+  TracedCallback<Ptr<const Packet> > m_macPromiscRxTrace;
+  TracedCallback<Ptr<const Packet> > m_macRxTrace;
+  TracedCallback<Ptr<const Packet> > m_phyTxBeginTrace;
+  TracedCallback<Ptr<const Packet> > m_phyTxEndTrace;
+  TracedCallback<Ptr<const Packet> > m_phyRxEndTrace;
+  TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+  TracedCallback<Ptr<const Packet> > m_snifferTrace;
+  TracedCallback<Ptr<const Packet> > m_promiscSnifferTrace;
+
+  static const uint16_t DEFAULT_MTU = 1500;
+};
+
+} // namespace ns3
+
+#endif /* SWITCH_NET_DEVICE_H */
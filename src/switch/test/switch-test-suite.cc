@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/data-rate.h"
+#include "ns3/switch-helper.h"
+#include "ns3/switch-net-device.h"
+#include "ns3/switch-channel.h"
+
+namespace ns3 {
+
+// three hosts on a switch of 8Mbps links, where a byte takes 1us, and a
+// frame of 100 bytes of payload takes 118us with its header and trailer
+class SwitchTestCase : public TestCase
+{
+public:
+  SwitchTestCase (std::string name);
+
+protected:
+  void Build (void);
+  void Send (uint32_t from, uint32_t to);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  bool PromiscReceive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                       const Address &from, const Address &to, NetDevice::PacketType type);
+  uint32_t GetIndex (Ptr<NetDevice> device) const;
+
+  NodeContainer m_nodes;
+  NetDeviceContainer m_devices;
+  std::vector<uint32_t> m_rx;
+  std::vector<uint32_t> m_promiscRx;
+  std::vector<Time> m_rxTimes;
+  uint32_t m_wrongSize;
+};
+
+SwitchTestCase::SwitchTestCase (std::string name)
+  : TestCase (name),
+    m_wrongSize (0)
+{
+}
+
+void
+SwitchTestCase::Build (void)
+{
+  m_nodes.Create (3);
+  SwitchHelper helper;
+  helper.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+  helper.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  m_devices = helper.Install (m_nodes);
+  for (uint32_t i = 0; i < m_devices.GetN (); ++i)
+    {
+      m_devices.Get (i)->SetReceiveCallback (MakeCallback (&SwitchTestCase::Receive, this));
+      m_devices.Get (i)->SetPromiscReceiveCallback (MakeCallback (&SwitchTestCase::PromiscReceive, this));
+    }
+  m_rx.assign (3, 0);
+  m_promiscRx.assign (3, 0);
+}
+
+void
+SwitchTestCase::Send (uint32_t from, uint32_t to)
+{
+  Address dest = to < m_devices.GetN () ? m_devices.Get (to)->GetAddress () : m_devices.Get (from)->GetBroadcast ();
+  m_devices.Get (from)->Send (Create<Packet> (100), dest, 0x0800);
+}
+
+uint32_t
+SwitchTestCase::GetIndex (Ptr<NetDevice> device) const
+{
+  for (uint32_t i = 0; i < m_devices.GetN (); ++i)
+    {
+      if (m_devices.Get (i) == device)
+        {
+          return i;
+        }
+    }
+  return m_devices.GetN ();
+}
+
+bool
+SwitchTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rx[GetIndex (device)]++;
+  m_rxTimes.push_back (Simulator::Now ());
+  if (p->GetSize () != 100 || protocol != 0x0800)
+    {
+      m_wrongSize++;
+    }
+  return true;
+}
+
+bool
+SwitchTestCase::PromiscReceive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_promiscRx[GetIndex (device)]++;
+  return true;
+}
+
+class SwitchLearningTestCase : public SwitchTestCase
+{
+public:
+  SwitchLearningTestCase ();
+  virtual void DoRun (void);
+};
+
+SwitchLearningTestCase::SwitchLearningTestCase ()
+  : SwitchTestCase ("Switch floods unknown and broadcast frames and forwards learned ones")
+{
+}
+
+void
+SwitchLearningTestCase::DoRun (void)
+{
+  Build ();
+  // 0 => 1 is flooded, then the addresses of 0 and 1 are known
+  Simulator::Schedule (MilliSeconds (0), &SwitchLearningTestCase::Send, this, 0, 1);
+  Simulator::Schedule (MilliSeconds (1), &SwitchLearningTestCase::Send, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (2), &SwitchLearningTestCase::Send, this, 0, 1);
+  Simulator::Schedule (MilliSeconds (3), &SwitchLearningTestCase::Send, this, 2, 3);
+  Simulator::Run ();
+  Ptr<SwitchChannel> channel = DynamicCast<SwitchChannel> (m_devices.Get (0)->GetChannel ());
+  NS_TEST_ASSERT_MSG_EQ (channel->GetNLearned (), 3, "Each host address is learned once");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetNFlooded (), 2, "The first frame and the broadcast are flooded");
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rx[0], 2, "Host 0 receives the reply and the broadcast");
+  NS_TEST_ASSERT_MSG_EQ (m_rx[1], 3, "Host 1 receives both frames and the broadcast");
+  NS_TEST_ASSERT_MSG_EQ (m_rx[2], 0, "Host 2 receives no frame for itself");
+  NS_TEST_ASSERT_MSG_EQ (m_promiscRx[0], 2, "Host 0 sees the frames for itself only");
+  NS_TEST_ASSERT_MSG_EQ (m_promiscRx[1], 3, "Host 1 sees the frames for itself only");
+  NS_TEST_ASSERT_MSG_EQ (m_promiscRx[2], 1, "Host 2 sees the flooded frame only");
+  NS_TEST_ASSERT_MSG_EQ (m_wrongSize, 0, "Headers and trailers are removed");
+}
+
+class SwitchQueueingTestCase : public SwitchTestCase
+{
+public:
+  SwitchQueueingTestCase ();
+  virtual void DoRun (void);
+};
+
+SwitchQueueingTestCase::SwitchQueueingTestCase ()
+  : SwitchTestCase ("Switch output ports queue frames from several input ports")
+{
+}
+
+void
+SwitchQueueingTestCase::DoRun (void)
+{
+  Build ();
+  // the broadcast teaches the address of host 1 to the switch
+  Simulator::Schedule (MilliSeconds (0), &SwitchQueueingTestCase::Send, this, 1, 3);
+  // 0 and 2 send to 1 at the same time: the second frame waits for the
+  // first one on the output port to 1
+  Simulator::Schedule (MilliSeconds (1), &SwitchQueueingTestCase::Send, this, 0, 1);
+  Simulator::Schedule (MilliSeconds (1), &SwitchQueueingTestCase::Send, this, 2, 1);
+  // 0 sends twice in a row: the frames are queued by the device, and
+  // pipelined through the switch
+  Simulator::Schedule (MilliSeconds (2), &SwitchQueueingTestCase::Send, this, 0, 1);
+  Simulator::Schedule (MilliSeconds (2), &SwitchQueueingTestCase::Send, this, 0, 1);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 6, "Wrong number of frames received");
+  // store-and-forward: two transmissions and two link delays, up to the
+  // rounding of the transmission times
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_rxTimes[0], MicroSeconds (2 * 118 + 20), NanoSeconds (10), "Wrong broadcast delay");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_rxTimes[2], MicroSeconds (1000 + 2 * 118 + 20), NanoSeconds (10), "Wrong delay of the first frame");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_rxTimes[3], MicroSeconds (1000 + 3 * 118 + 20), NanoSeconds (10), "Wrong queueing delay of the second frame");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_rxTimes[4], MicroSeconds (2000 + 2 * 118 + 20), NanoSeconds (10), "Wrong delay of the first frame");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_rxTimes[5], MicroSeconds (2000 + 3 * 118 + 20), NanoSeconds (10), "Wrong delay of the second frame");
+}
+
+static class SwitchTestSuite : public TestSuite
+{
+public:
+  SwitchTestSuite ()
+    : TestSuite ("switch", UNIT)
+  {
+    AddTestCase (new SwitchLearningTestCase);
+    AddTestCase (new SwitchQueueingTestCase);
+  }
+} g_switchTestSuite;
+
+} // namespace ns3
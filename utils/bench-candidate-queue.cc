@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// Compare the CandidateQueue of the global routing SPF with the sorted
+// list it replaced, on the Dijkstra runs of a random graph: each vertex is
+// pushed once, found by ID for each of its links, and has its distance
+// decreased when a shorter path shows up.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/candidate-queue.h"
+#include "ns3/global-route-manager-impl.h"
+#include <iostream>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace ns3;
+
+static bool
+CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+// the former CandidateQueue: a sorted list, searched linearly and sorted
+// again after each change of distance
+class ListCandidateQueue
+{
+public:
+  void Push (SPFVertex *v)
+  {
+    m_candidates.insert (std::upper_bound (m_candidates.begin (), m_candidates.end (), v, &CompareSPFVertex), v);
+  }
+  SPFVertex* Pop (void)
+  {
+    SPFVertex *v = m_candidates.front ();
+    m_candidates.pop_front ();
+    return v;
+  }
+  bool Empty (void) const
+  {
+    return m_candidates.empty ();
+  }
+  SPFVertex* Find (Ipv4Address addr) const
+  {
+    for (std::list<SPFVertex*>::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+      {
+        if ((*i)->GetVertexId () == addr)
+          {
+            return *i;
+          }
+      }
+    return 0;
+  }
+  void DecreaseKey (SPFVertex *v)
+  {
+    m_candidates.sort (&CompareSPFVertex);
+  }
+private:
+  std::list<SPFVertex*> m_candidates;
+};
+
+struct Link
+{
+  uint32_t to;
+  uint32_t metric;
+};
+
+typedef std::vector<std::vector<Link> > Graph;
+
+static void
+MakeGraph (Graph &graph, uint32_t n, uint32_t degree)
+{
+  graph.assign (n, std::vector<Link> ());
+  for (uint32_t a = 0; a < n; ++a)
+    {
+      for (uint32_t d = 0; d < degree / 2; ++d)
+        {
+          Link link;
+          link.to = d == 0 ? (a + 1) % n : rand () % n;
+          link.metric = 1 + rand () % 10;
+          graph[a].push_back (link);
+          uint32_t b = link.to;
+          link.to = a;
+          graph[b].push_back (link);
+        }
+    }
+}
+
+// run the Dijkstra algorithm from a root, and return a checksum of the
+// order of the vertices
+template <typename Queue>
+static uint64_t
+Dijkstra (const Graph &graph, uint32_t root)
+{
+  Queue candidate;
+  std::vector<bool> done (graph.size (), false);
+  std::vector<SPFVertex*> vertices;
+  SPFVertex *v = new SPFVertex;
+  v->SetVertexId (Ipv4Address (root + 1));
+  v->SetDistanceFromRoot (0);
+  candidate.Push (v);
+  vertices.push_back (v);
+  uint64_t checksum = 0;
+  while (!candidate.Empty ())
+    {
+      v = candidate.Pop ();
+      uint32_t a = v->GetVertexId ().Get () - 1;
+      done[a] = true;
+      checksum = checksum * 31 + a;
+      for (std::vector<Link>::const_iterator l = graph[a].begin (); l != graph[a].end (); l++)
+        {
+          if (done[l->to])
+            {
+              continue;
+            }
+          uint32_t distance = v->GetDistanceFromRoot () + l->metric;
+          SPFVertex *w = candidate.Find (Ipv4Address (l->to + 1));
+          if (w == 0)
+            {
+              w = new SPFVertex;
+              w->SetVertexId (Ipv4Address (l->to + 1));
+              w->SetVertexType (SPFVertex::VertexRouter);
+              w->SetDistanceFromRoot (distance);
+              candidate.Push (w);
+              vertices.push_back (w);
+            }
+          else if (distance < w->GetDistanceFromRoot ())
+            {
+              w->SetDistanceFromRoot (distance);
+              candidate.DecreaseKey (w);
+            }
+        }
+    }
+  for (uint32_t i = 0; i < vertices.size (); ++i)
+    {
+      delete vertices[i];
+    }
+  return checksum;
+}
+
+template <typename Queue>
+static void
+Bench (const char *name, const Graph &graph, uint32_t runs)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  uint64_t checksum = 0;
+  for (uint32_t r = 0; r < runs; ++r)
+    {
+      checksum ^= Dijkstra<Queue> (graph, r % graph.size ());
+    }
+  double elapsed = time.End () / 1000.0;
+  std::cout << name << ": " << runs << " runs on " << graph.size () << " vertices, time="
+            << elapsed << "s, " << elapsed / runs << "s/run, checksum=" << checksum << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 2000;
+  uint32_t degree = 8;
+  uint32_t runs = 10;
+  bool list = true;
+  for (argc--, argv++; argc > 0; argc--, argv++)
+    {
+      if (strncmp ("--n=", argv[0], strlen ("--n=")) == 0)
+        {
+          n = atoi (argv[0] + strlen ("--n="));
+        }
+      else if (strncmp ("--degree=", argv[0], strlen ("--degree=")) == 0)
+        {
+          degree = atoi (argv[0] + strlen ("--degree="));
+        }
+      else if (strncmp ("--runs=", argv[0], strlen ("--runs=")) == 0)
+        {
+          runs = atoi (argv[0] + strlen ("--runs="));
+        }
+      else if (strcmp ("--no-list", argv[0]) == 0)
+        {
+          list = false;
+        }
+      else
+        {
+          std::cout << "bench-candidate-queue [--n=vertices] [--degree=links] [--runs=n] [--no-list]" << std::endl;
+          return 0;
+        }
+    }
+  Graph graph;
+  MakeGraph (graph, n, degree);
+  Bench<CandidateQueue> ("heap", graph, runs);
+  if (list)
+    {
+      Bench<ListCandidateQueue> ("list", graph, runs);
+    }
+  return 0;
+}
@@ -23,10 +23,60 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <stdlib.h> // for exit ()
+#include <new>
 
 using namespace ns3;
 
+// every allocation of the program is counted, to report the number of
+// allocations per packet of each benchmark
+static uint64_t g_nAllocations = 0;
+
+static void *
+CountedAllocate (size_t size)
+{
+  g_nAllocations++;
+  void *p = malloc (size ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+// not inlined, so that the compiler does not pair the free with the
+// new expressions of the callers
+static void __attribute__ ((noinline))
+CountedFree (void *p)
+{
+  free (p);
+}
+
+void *
+operator new (size_t size) throw (std::bad_alloc)
+{
+  return CountedAllocate (size);
+}
+
+void *
+operator new[] (size_t size) throw (std::bad_alloc)
+{
+  return CountedAllocate (size);
+}
+
+void
+operator delete (void *p) throw ()
+{
+  CountedFree (p);
+}
+
+void
+operator delete[] (void *p) throw ()
+{
+  CountedFree (p);
+}
+
 template <int N>
 class BenchHeader : public Header
 {
@@ -241,18 +291,81 @@ benchC (uint32_t n)
   }
 }
 
+// the path of a datagram over point-to-point links: the headers are
+// added by the sender, the device queues a copy while 63 other packets
+// are in flight, and the receiver removes the headers
+static void
+benchE (uint32_t n)
+{
+  BenchHeader<2> ppp;
+  BenchHeader<20> ipv4;
+  BenchHeader<8> udp;
+  std::vector<Ptr<Packet> > inFlight (64);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1024);
+    p->AddHeader (udp);
+    p->AddHeader (ipv4);
+    p->AddHeader (ppp);
+    inFlight[i % inFlight.size ()] = p->Copy ();
+    Ptr<Packet> o = inFlight[(i + 1) % inFlight.size ()];
+    if (o != 0)
+      {
+        o->RemoveHeader (ppp);
+        o->RemoveHeader (ipv4);
+        o->RemoveHeader (udp);
+        inFlight[(i + 1) % inFlight.size ()] = 0;
+      }
+  }
+}
+
+// the same path with the tags of a flow monitor: a packet tag with the
+// flow and packet identifiers, and a byte tag of the same size
+static void
+benchF (uint32_t n)
+{
+  BenchHeader<2> ppp;
+  BenchHeader<20> ipv4;
+  BenchHeader<8> udp;
+  BenchTag<12> probeTag;
+  BenchTag<16> flowTag;
+  std::vector<Ptr<Packet> > inFlight (64);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1024);
+    p->AddByteTag (flowTag);
+    p->AddHeader (udp);
+    p->AddHeader (ipv4);
+    p->AddPacketTag (probeTag);
+    p->AddHeader (ppp);
+    inFlight[i % inFlight.size ()] = p->Copy ();
+    Ptr<Packet> o = inFlight[(i + 1) % inFlight.size ()];
+    if (o != 0)
+      {
+        o->RemoveHeader (ppp);
+        o->RemovePacketTag (probeTag);
+        o->RemoveHeader (ipv4);
+        o->RemoveHeader (udp);
+        o->FindFirstMatchingByteTag (flowTag);
+        inFlight[(i + 1) % inFlight.size ()] = 0;
+      }
+  }
+}
 
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
 {
   SystemWallClockMs time;
+  uint64_t nAllocations = g_nAllocations;
   time.Start ();
   (*bench) (n);
   uint64_t deltaMs = time.End ();
+  nAllocations = g_nAllocations - nAllocations;
   double ps = n;
   ps *= 1000;
   ps /= deltaMs;
-  std::cout << name<<"=" << ps << " packets/s" << std::endl;
+  std::cout << name<<"=" << ps << " packets/s, "
+            << double (nAllocations) / n << " allocations/packet" << std::endl;
 }
 
 int main (int argc, char *argv[])
@@ -285,6 +398,9 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, "b");
   runBench (&benchC, n, "c");
   runBench (&benchD, n, "d");
+  runBench (&benchE, n, "e");
+  runBench (&benchF, n, "f");
+  Buffer::PrintStatistics (std::cout);
 
   return 0;
 }
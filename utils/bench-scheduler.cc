@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-module.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace ns3;
+
+// Replay the operations on the events of a simulation, as recorded by
+// "Fat-tree --schedulerTrace=file", against each scheduler
+
+struct Operation
+{
+  char type;    // 'i' insert, 'r' remove the next event, 'x' remove
+  uint64_t ts;
+  uint32_t uid;
+};
+
+static void
+ReadTrace (std::istream &input, std::vector<Operation> &trace)
+{
+  Operation op;
+  while (input >> op.type)
+    {
+      op.ts = 0;
+      op.uid = 0;
+      if (op.type != 'r')
+        {
+          input >> op.ts >> op.uid;
+        }
+      trace.push_back (op);
+    }
+}
+
+static void
+RunBench (std::string type, const std::vector<Operation> &trace)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  uint32_t maxSize = 0;
+  uint32_t size = 0;
+  uint64_t checksum = 0;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (std::vector<Operation>::const_iterator i = trace.begin (); i != trace.end (); i++)
+    {
+      Scheduler::Event ev = { 0, { i->ts, i->uid, 0}};
+      switch (i->type)
+        {
+        case 'i':
+          scheduler->Insert (ev);
+          size++;
+          maxSize = std::max (maxSize, size);
+          break;
+        case 'r':
+          ev = scheduler->RemoveNext ();
+          // the order of the removed events must match for every scheduler
+          checksum = checksum * 31 + ev.key.m_uid;
+          size--;
+          break;
+        case 'x':
+          scheduler->Remove (ev);
+          size--;
+          break;
+        }
+    }
+  double elapsed = time.End ();
+  elapsed /= 1000;
+
+  std::cout << type << ": n=" << trace.size () << ", max size=" << maxSize
+            << ", time=" << elapsed << "s, " << ((double)trace.size ()) / elapsed
+            << " op/s, checksum=" << checksum << std::endl;
+}
+
+void
+PrintHelp (void)
+{
+  std::cout << "bench-scheduler filename [options]" << std::endl;
+  std::cout << "  filename: a trace recorded by \"Fat-tree --schedulerTrace=filename\". \"-\" represents stdin." << std::endl;
+  std::cout << "  Options:" << std::endl;
+  std::cout << "      --scheduler=type: only replay against this scheduler, eg. ns3::LadderScheduler" << std::endl;
+  std::cout << "      --n=runs: number of runs for each scheduler" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  if (argc == 1)
+    {
+      PrintHelp ();
+      return 0;
+    }
+  char const *filename = argv[1];
+  argc -= 2;
+  argv += 2;
+  std::vector<std::string> types;
+  uint32_t n = 1;
+  while (argc > 0)
+    {
+      if (strncmp ("--scheduler=", argv[0], strlen ("--scheduler=")) == 0)
+        {
+          types.push_back (argv[0] + strlen ("--scheduler="));
+        }
+      else if (strncmp ("--n=", argv[0], strlen ("--n=")) == 0)
+        {
+          n = atoi (argv[0] + strlen ("--n="));
+        }
+      argc--;
+      argv++;
+    }
+  if (types.empty ())
+    {
+      types.push_back ("ns3::ListScheduler");
+      types.push_back ("ns3::MapScheduler");
+      types.push_back ("ns3::HeapScheduler");
+      types.push_back ("ns3::CalendarScheduler");
+      types.push_back ("ns3::Ns2CalendarScheduler");
+      types.push_back ("ns3::LadderScheduler");
+    }
+
+  std::vector<Operation> trace;
+  if (strcmp (filename, "-") == 0)
+    {
+      ReadTrace (std::cin, trace);
+    }
+  else
+    {
+      std::ifstream input (filename);
+      ReadTrace (input, trace);
+    }
+
+  for (std::vector<std::string>::const_iterator i = types.begin (); i != types.end (); i++)
+    {
+      for (uint32_t j = 0; j < n; j++)
+        {
+          RunBench (*i, trace);
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Nanyang Technological University
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// Read the binary output of FlowMonitor::SerializeToBinaryFile, print the
+// statistics aggregated over all the flows, the way
+// flowmon-parse-results.py computes them per flow from the XML output,
+// and optionally convert each table to a CSV file.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/column-table.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+
+using namespace ns3;
+
+static void
+WriteCsv (const ColumnTable &table, std::string fileName)
+{
+  std::ofstream os (fileName.c_str ());
+  os << std::setprecision (17);
+  for (uint32_t column = 0; column < table.GetNColumns (); column++)
+    {
+      os << (column ? "," : "") << table.GetColumnName (column);
+    }
+  os << std::endl;
+  for (uint64_t row = 0; row < table.GetNRows (); row++)
+    {
+      for (uint32_t column = 0; column < table.GetNColumns (); column++)
+        {
+          if (column)
+            {
+              os << ",";
+            }
+          std::string name = table.GetColumnName (column);
+          switch (table.GetColumnType (column))
+            {
+            case ColumnTable::INT64:
+              os << table.GetSigned (column, row);
+              break;
+            case ColumnTable::DOUBLE:
+              os << table.GetDouble (column, row);
+              break;
+            case ColumnTable::UINT32:
+              if (name.size () > 7 && name.substr (name.size () - 7) == "Address")
+                {
+                  uint64_t a = table.GetUnsigned (column, row);
+                  os << ((a >> 24) & 0xff) << "." << ((a >> 16) & 0xff) << "."
+                     << ((a >> 8) & 0xff) << "." << (a & 0xff);
+                  break;
+                }
+            // fall through
+            default:
+              os << table.GetUnsigned (column, row);
+              break;
+            }
+        }
+      os << std::endl;
+    }
+}
+
+static void
+PrintAggregates (const ColumnTable &flows)
+{
+  uint32_t timeFirstTxPacket = flows.FindColumn ("timeFirstTxPacket");
+  uint32_t timeFirstRxPacket = flows.FindColumn ("timeFirstRxPacket");
+  uint32_t timeLastTxPacket = flows.FindColumn ("timeLastTxPacket");
+  uint32_t timeLastRxPacket = flows.FindColumn ("timeLastRxPacket");
+  uint32_t delaySum = flows.FindColumn ("delaySum");
+  uint32_t jitterSum = flows.FindColumn ("jitterSum");
+  uint32_t txBytes = flows.FindColumn ("txBytes");
+  uint32_t rxBytes = flows.FindColumn ("rxBytes");
+  uint32_t txPackets = flows.FindColumn ("txPackets");
+  uint32_t rxPackets = flows.FindColumn ("rxPackets");
+  uint32_t lostPackets = flows.FindColumn ("lostPackets");
+  uint32_t timesForwarded = flows.FindColumn ("timesForwarded");
+  uint32_t untrackedTxPackets = flows.FindColumn ("untrackedTxPackets");
+  uint32_t untrackedRxPackets = flows.FindColumn ("untrackedRxPackets");
+
+  uint64_t nTxBytes = 0;
+  uint64_t nRxBytes = 0;
+  uint64_t nTxPackets = 0;
+  uint64_t nRxPackets = 0;
+  uint64_t nLostPackets = 0;
+  uint64_t nUntrackedTxPackets = 0;
+  uint64_t nUntrackedRxPackets = 0;
+  uint64_t nTimesForwarded = 0;
+  uint64_t nJitterSamples = 0;
+  int64_t delayNs = 0;
+  int64_t jitterNs = 0;
+  double txBitrateSum = 0;
+  double rxBitrateSum = 0;
+  uint32_t nTxBitrates = 0;
+  uint32_t nRxBitrates = 0;
+  for (uint64_t row = 0; row < flows.GetNRows (); row++)
+    {
+      uint64_t untrackedRx = flows.GetUnsigned (untrackedRxPackets, row);
+      // the untracked packets have no delay
+      uint64_t rx = flows.GetUnsigned (rxPackets, row) - untrackedRx;
+      nTxBytes += flows.GetUnsigned (txBytes, row);
+      nRxBytes += flows.GetUnsigned (rxBytes, row);
+      nTxPackets += flows.GetUnsigned (txPackets, row);
+      nRxPackets += rx + untrackedRx;
+      nUntrackedTxPackets += flows.GetUnsigned (untrackedTxPackets, row);
+      nUntrackedRxPackets += untrackedRx;
+      nLostPackets += flows.GetUnsigned (lostPackets, row);
+      nTimesForwarded += flows.GetUnsigned (timesForwarded, row);
+      nJitterSamples += rx > 1 ? rx - 1 : 0;
+      delayNs += flows.GetSigned (delaySum, row);
+      jitterNs += flows.GetSigned (jitterSum, row);
+      int64_t txDuration = flows.GetSigned (timeLastTxPacket, row) - flows.GetSigned (timeFirstTxPacket, row);
+      int64_t rxDuration = flows.GetSigned (timeLastRxPacket, row) - flows.GetSigned (timeFirstRxPacket, row);
+      if (txDuration > 0)
+        {
+          txBitrateSum += flows.GetUnsigned (txBytes, row) * 8 / (txDuration * 1e-9);
+          nTxBitrates++;
+        }
+      if (rxDuration > 0)
+        {
+          rxBitrateSum += flows.GetUnsigned (rxBytes, row) * 8 / (rxDuration * 1e-9);
+          nRxBitrates++;
+        }
+    }
+
+  std::cout << std::setprecision (9)
+            << "Flows: " << flows.GetNRows () << std::endl
+            << "TX packets: " << nTxPackets << std::endl
+            << "RX packets: " << nRxPackets << std::endl
+            << "Lost packets: " << nLostPackets << std::endl
+            << "Untracked TX packets: " << nUntrackedTxPackets << std::endl
+            << "Untracked RX packets: " << nUntrackedRxPackets << std::endl
+            << "TX bytes: " << nTxBytes << std::endl
+            << "RX bytes: " << nRxBytes << std::endl;
+  if (nRxPackets > nUntrackedRxPackets)
+    {
+      uint64_t nDelays = nRxPackets - nUntrackedRxPackets;
+      std::cout << "Mean delay: " << delayNs * 1e-9 / nDelays << " s" << std::endl
+                << "Mean hop count: " << double (nTimesForwarded) / nDelays + 1 << std::endl
+                << "Packet loss ratio: " << double (nLostPackets) / (nRxPackets + nLostPackets) << std::endl;
+    }
+  if (nJitterSamples)
+    {
+      std::cout << "Mean jitter: " << jitterNs * 1e-9 / nJitterSamples << " s" << std::endl;
+    }
+  if (nTxBitrates)
+    {
+      std::cout << "Mean TX bitrate: " << txBitrateSum / nTxBitrates * 1e-3 << " kbit/s" << std::endl;
+    }
+  if (nRxBitrates)
+    {
+      std::cout << "Mean RX bitrate: " << rxBitrateSum / nRxBitrates * 1e-3 << " kbit/s" << std::endl;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string csv;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "Binary output of FlowMonitor to read", input);
+  cmd.AddValue ("csv", "If not empty, write each table to <csv>-<table>.csv", csv);
+  cmd.Parse (argc, argv);
+
+  std::ifstream is (input.c_str (), std::ios::in|std::ios::binary);
+  std::vector<ColumnTable> tables;
+  if (!is.is_open () || !ColumnTable::ReadFile (is, tables))
+    {
+      std::cerr << "Cannot read the tables of " << input << std::endl;
+      return 1;
+    }
+
+  for (std::vector<ColumnTable>::const_iterator i = tables.begin (); i != tables.end (); i++)
+    {
+      if (i->GetName () == "FlowStats")
+        {
+          PrintAggregates (*i);
+        }
+      if (!csv.empty ())
+        {
+          WriteCsv (*i, csv + "-" + i->GetName () + ".csv");
+        }
+    }
+  return 0;
+}